@@ -160,6 +160,55 @@ int getJstacks(std::unique_ptr<minifi::io::Socket> socket, std::ostream &out) {
   return 0;
 }
 
+/**
+ * Prints the lines the agent describes the given subject with, e.g. the metrics or the provenance events
+ * @param socket socket ptr
+ * @param what subject of the describe operation
+ * @param argument argument of the subject, e.g. the name of the metrics node or the provenance query
+ */
+int getDescribedLines(std::unique_ptr<minifi::io::Socket> socket, std::ostream &out, const std::string &what, const std::string &argument) {
+  socket->initialize();
+  uint8_t op = minifi::c2::Operation::DESCRIBE;
+  minifi::io::BufferStream stream;
+  stream.write(&op, 1);
+  stream.write(what);
+  stream.write(argument);
+  if (socket->write(const_cast<uint8_t*>(stream.getBuffer()), gsl::narrow<int>(stream.size())) < 0) {
+    return -1;
+  }
+  // read the response
+  uint8_t resp = 0;
+  socket->read(&resp, 1);
+  if (resp == minifi::c2::Operation::DESCRIBE) {
+    uint64_t size = 0;
+    socket->read(size);
+    for (uint64_t i = 0; i < size; i++) {
+      std::string line;
+      socket->read(line);
+      out << line << std::endl;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Prints the metrics the agent keeps under the given name, one "path = value" line each
+ * @param socket socket ptr
+ * @param name name of the metrics node, e.g. ProcessorProfileMetrics
+ */
+int getMetrics(std::unique_ptr<minifi::io::Socket> socket, std::ostream &out, const std::string &name) {
+  return getDescribedLines(std::move(socket), out, "metrics", name);
+}
+
+/**
+ * Prints the provenance events matching the query, one line each
+ * @param socket socket ptr
+ * @param query "key=value" criteria joined by '&', e.g. "component=<id>&since=1 hour"
+ */
+int getProvenance(std::unique_ptr<minifi::io::Socket> socket, std::ostream &out, const std::string &query) {
+  return getDescribedLines(std::move(socket), out, "provenance", query);
+}
+
 /**
  * Prints the connection size for the provided connection.
  * @param socket socket ptr
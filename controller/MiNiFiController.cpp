@@ -100,6 +100,8 @@ int main(int argc, char **argv) {
   ("updateflow", "Updates the flow of the agent using the provided flow file", cxxopts::value<std::string>())  //NOLINT
   ("getfull", "Reports a list of full connections")  //NOLINT
   ("jstack", "Returns backtraces from the agent")  //NOLINT
+  ("profile", "Returns the onTrigger latency, CPU time, commit time and throughput of each processor")  //NOLINT
+  ("provenance", "Returns the provenance events matching the query, e.g. \"flowfile=<uuid>&lineage=true\" or \"component=<id>&since=1 hour\"", cxxopts::value<std::string>())  //NOLINT
   ("manifest", "Generates a manifest for the current binary")  //NOLINT
   ("noheaders", "Removes headers from output streams");
 
@@ -207,6 +209,19 @@ int main(int argc, char **argv) {
         std::cout << "Could not connect to remote host " << host << ":" << port << std::endl;
     }
 
+    if (result.count("profile") > 0) {
+      auto socket = secure_context != nullptr ? stream_factory_->createSecureSocket(host, port, secure_context) : stream_factory_->createSocket(host, port);
+      if (getMetrics(std::move(socket), std::cout, "ProcessorProfileMetrics") < 0)
+        std::cout << "Could not connect to remote host " << host << ":" << port << std::endl;
+    }
+
+    if (result.count("provenance") > 0) {
+      auto& query = result["provenance"].as<std::string>();
+      auto socket = secure_context != nullptr ? stream_factory_->createSecureSocket(host, port, secure_context) : stream_factory_->createSocket(host, port);
+      if (getProvenance(std::move(socket), std::cout, query) < 0)
+        std::cout << "Could not connect to remote host " << host << ":" << port << std::endl;
+    }
+
     if (result.count("updateflow") > 0) {
       auto& flow_file = result["updateflow"].as<std::string>();
       auto socket = secure_context != nullptr ? stream_factory_->createSecureSocket(host, port, secure_context) : stream_factory_->createSocket(host, port);
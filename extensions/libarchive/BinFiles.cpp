@@ -279,25 +279,24 @@ void BinFiles::onTrigger(const std::shared_ptr<core::ProcessContext> &context, c
     }
   }
 
-  for (size_t i = 0; i < batchSize_; ++i) {
-    auto flow = session->get();
-
-    if (flow == nullptr) {
-      break;
-    }
-
+  bool offerFailed = false;
+  for (const auto& flow : session->get(batchSize_)) {
     preprocessFlowFile(context.get(), session.get(), flow);
     std::string groupId = getGroupId(context.get(), flow);
 
     bool offer = this->binManager_.offer(groupId, flow);
     if (!offer) {
       session->transfer(flow, Failure);
-      context->yield();
-      return;
+      offerFailed = true;
+      continue;
     }
     // assuming ownership over the incoming flowFile
     session->transfer(flow, Self);
   }
+  if (offerFailed) {
+    context->yield();
+    return;
+  }
 
   // migrate bin to ready bin
   this->binManager_.gatherReadyBins();
@@ -18,13 +18,18 @@
 
 #include "DatabaseContentRepository.h"
 
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "RocksDbStream.h"
 #include "rocksdb/merge_operator.h"
 #include "utils/GeneralUtils.h"
 #include "utils/gsl.h"
+#include "utils/StringUtils.h"
 #include "Exception.h"
 
 namespace org {
@@ -34,6 +39,68 @@ namespace minifi {
 namespace core {
 namespace repository {
 
+namespace {
+
+/**
+ * Writes the content staged for an append in chunks, each under its own key, so that publishing
+ * it moves one chunk at a time instead of reading the whole staged content into memory.
+ */
+class StagedChunkStream : public io::BaseStream {
+ public:
+  StagedChunkStream(std::string prefix, gsl::not_null<minifi::internal::RocksDatabase*> db)
+      : prefix_(std::move(prefix)),
+        db_(db) {
+  }
+
+  using BaseStream::read;
+  using BaseStream::write;
+
+  int write(const uint8_t *value, int size) override {
+    gsl_Expects(size >= 0);
+    if (size == 0) {
+      return 0;
+    }
+    auto opendb = db_->open();
+    if (!opendb) {
+      return -1;
+    }
+    // the chunks are made durable by publish
+    const rocksdb::Status status = opendb->Put(rocksdb::WriteOptions(), getChunkKey(next_chunk_index_++), rocksdb::Slice(reinterpret_cast<const char*>(value), size));
+    if (!status.ok()) {
+      return -1;
+    }
+    size_ += size;
+    return size;
+  }
+
+  int read(uint8_t* /*buf*/, int /*buflen*/) override {
+    return -1;
+  }
+
+  size_t size() const override {
+    return size_;
+  }
+
+ private:
+  std::string getChunkKey(uint64_t index) const {
+    // zero padded, so that the chunks are iterated in the order they were written
+    char suffix[21];
+    std::snprintf(suffix, sizeof(suffix), "%020" PRIu64, index);
+    return prefix_ + suffix;
+  }
+
+  // shared by the streams, so that the chunks appended to a staging claim by a later stream sort after the earlier ones
+  static std::atomic<uint64_t> next_chunk_index_;
+
+  const std::string prefix_;
+  gsl::not_null<minifi::internal::RocksDatabase*> db_;
+  size_t size_ = 0;
+};
+
+std::atomic<uint64_t> StagedChunkStream::next_chunk_index_{0};
+
+}  // namespace
+
 bool DatabaseContentRepository::initialize(const std::shared_ptr<minifi::Configure> &configuration) {
   std::string value;
   if (configuration->get(Configure::nifi_dbcontent_repository_directory_default, value)) {
@@ -48,6 +115,7 @@ bool DatabaseContentRepository::initialize(const std::shared_ptr<minifi::Configu
   options.merge_operator = std::make_shared<StringAppender>();
   options.error_if_exists = false;
   options.max_successive_merges = 0;
+  initializeSessionOptions(*configuration);
   db_ = utils::make_unique<minifi::internal::RocksDatabase>(options, directory_);
   if (db_->open()) {
     logger_->log_debug("NiFi Content DB Repository database open %s success", directory_);
@@ -72,6 +140,9 @@ void DatabaseContentRepository::stop() {
 DatabaseContentRepository::Session::Session(std::shared_ptr<ContentRepository> repository) : ContentSession(std::move(repository)) {}
 
 std::shared_ptr<ContentSession> DatabaseContentRepository::createSession() {
+  if (streaming_sessions_) {
+    return ContentRepository::createSession();
+  }
   return std::make_shared<Session>(sharedFromThis());
 }
 
@@ -143,6 +214,59 @@ bool DatabaseContentRepository::exists(const minifi::ResourceClaim &streamId) {
   }
 }
 
+std::shared_ptr<minifi::ResourceClaim> DatabaseContentRepository::createStagingClaim(const std::shared_ptr<minifi::ResourceClaim> &claim, bool append) {
+  if (!append) {
+    // new content is invisible until a FlowFile referencing it is committed, so we stream it to its final key
+    return claim;
+  }
+  return ContentRepository::createStagingClaim(claim, append);
+}
+
+bool DatabaseContentRepository::publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) {
+  if (staging.getContentFullPath() == target.getContentFullPath()) {
+    return true;
+  }
+  if (!is_valid_ || !db_)
+    return false;
+  auto opendb = db_->open();
+  if (!opendb) {
+    return false;
+  }
+  // each chunk is moved to the target in a batch of its own, so at most a chunk is held in memory
+  const std::string prefix = getChunkPrefix(staging);
+  std::unique_ptr<rocksdb::Iterator> it = opendb->NewIterator(rocksdb::ReadOptions());
+  bool overwrite = !append;
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+    rocksdb::WriteBatch batch;
+    if (overwrite) {
+      batch.Put(target.getContentFullPath(), it->value());
+      overwrite = false;
+    } else {
+      batch.Merge(target.getContentFullPath(), it->value());
+    }
+    batch.Delete(it->key());
+    rocksdb::Status status = opendb->Write(rocksdb::WriteOptions(), &batch);
+    if (!status.ok()) {
+      logger_->log_error("Failed to publish %s as %s: %s", staging.getContentFullPath(), target.getContentFullPath(), status.ToString());
+      return false;
+    }
+  }
+  if (!it->status().ok()) {
+    logger_->log_error("Could not read staged content %s: %s", staging.getContentFullPath(), it->status().ToString());
+    return false;
+  }
+  if (overwrite && !opendb->Put(rocksdb::WriteOptions(), target.getContentFullPath(), "").ok()) {
+    logger_->log_error("Failed to publish %s as %s", staging.getContentFullPath(), target.getContentFullPath());
+    return false;
+  }
+  rocksdb::Status status = opendb->FlushWAL(true);
+  if (!status.ok()) {
+    logger_->log_error("Failed to sync the published content %s: %s", target.getContentFullPath(), status.ToString());
+    return false;
+  }
+  return true;
+}
+
 bool DatabaseContentRepository::remove(const minifi::ResourceClaim &claim) {
   if (!is_valid_ || !db_)
     return false;
@@ -150,6 +274,15 @@ bool DatabaseContentRepository::remove(const minifi::ResourceClaim &claim) {
   if (!opendb) {
     return false;
   }
+  if (isStagingClaim(claim)) {
+    const std::string prefix = getChunkPrefix(claim);
+    rocksdb::WriteBatch batch;
+    std::unique_ptr<rocksdb::Iterator> it = opendb->NewIterator(rocksdb::ReadOptions());
+    for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+      batch.Delete(it->key());
+    }
+    return it->status().ok() && opendb->Write(rocksdb::WriteOptions(), &batch).ok();
+  }
   rocksdb::Status status;
   status = opendb->Delete(rocksdb::WriteOptions(), claim.getContentFullPath());
   if (status.ok()) {
@@ -166,10 +299,21 @@ std::shared_ptr<io::BaseStream> DatabaseContentRepository::write(const minifi::R
   // we can simply return a nullptr, which is also valid from the API when this stream is not valid.
   if (!is_valid_ || !db_)
     return nullptr;
+  if (isStagingClaim(claim)) {
+    return std::make_shared<StagedChunkStream>(getChunkPrefix(claim), gsl::make_not_null<minifi::internal::RocksDatabase*>(db_.get()));
+  }
   // append is already supported in all modes
   return std::make_shared<io::RocksDbStream>(claim.getContentFullPath(), gsl::make_not_null<minifi::internal::RocksDatabase*>(db_.get()), true, batch);
 }
 
+bool DatabaseContentRepository::isStagingClaim(const minifi::ResourceClaim &claim) {
+  return utils::StringUtils::endsWith(claim.getContentFullPath(), STAGING_EXTENSION);
+}
+
+std::string DatabaseContentRepository::getChunkPrefix(const minifi::ResourceClaim &staging) {
+  return staging.getContentFullPath() + "/";
+}
+
 } /* namespace repository */
 } /* namespace core */
 } /* namespace minifi */
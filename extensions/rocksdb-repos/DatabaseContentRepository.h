@@ -107,6 +107,10 @@ class DatabaseContentRepository : public core::ContentRepository, public core::C
 
   bool exists(const minifi::ResourceClaim &streamId) override;
 
+  std::shared_ptr<minifi::ResourceClaim> createStagingClaim(const std::shared_ptr<minifi::ResourceClaim> &claim, bool append) override;
+
+  bool publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) override;
+
   void yield() override {
 
   }
@@ -129,6 +133,13 @@ class DatabaseContentRepository : public core::ContentRepository, public core::C
  private:
   std::shared_ptr<io::BaseStream> write(const minifi::ResourceClaim &claim, bool append, rocksdb::WriteBatch* batch);
 
+  /**
+   * The content staged for an append is kept in chunks, see StagedChunkStream.
+   */
+  static bool isStagingClaim(const minifi::ResourceClaim &claim);
+
+  static std::string getChunkPrefix(const minifi::ResourceClaim &staging);
+
   bool is_valid_;
   std::unique_ptr<minifi::internal::RocksDatabase> db_;
   std::shared_ptr<logging::Logger> logger_;
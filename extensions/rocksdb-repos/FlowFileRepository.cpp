@@ -17,12 +17,16 @@
  */
 #include "FlowFileRepository.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 #include <list>
+#include <map>
+#include <thread>
 
 #include "rocksdb/options.h"
 #include "rocksdb/write_batch.h"
@@ -42,56 +46,148 @@ void FlowFileRepository::flush() {
   if (!opendb) {
     return;
   }
-  rocksdb::WriteBatch batch;
   rocksdb::ReadOptions options;
 
   std::vector<std::shared_ptr<FlowFile>> purgeList;
+  std::vector<ResourceClaim::Path> claimsToRelease;
 
   std::vector<rocksdb::Slice> keys;
   std::list<std::string> keystrings;
   std::vector<std::string> values;
 
-  while (keys_to_delete.size_approx() > 0) {
+  // the keys with a known content claim are deleted blindly, only the rest are read back for their claim
+  std::vector<std::string> deletedKeys;
+  {
+    std::lock_guard<std::mutex> lock(content_claims_mutex_);
     std::string key;
-    if (keys_to_delete.try_dequeue(key)) {
-      keystrings.push_back(std::move(key));  // rocksdb::Slice doesn't copy the string, only grabs ptrs. Hacky, but have to ensure the required lifetime of the strings.
-      keys.push_back(keystrings.back());
+    while (keys_to_delete.try_dequeue(key)) {
+      auto claim = content_claims_.find(key);
+      if (claim != content_claims_.end()) {
+        if (!claim->second.empty()) {
+          claimsToRelease.push_back(claim->second);
+        }
+        deletedKeys.push_back(std::move(key));
+      } else {
+        keystrings.push_back(std::move(key));  // rocksdb::Slice doesn't copy the string, only grabs ptrs. Hacky, but have to ensure the required lifetime of the strings.
+        keys.push_back(keystrings.back());
+      }
     }
   }
 
-  auto multistatus = opendb->MultiGet(options, keys, &values);
+  std::vector<rocksdb::Slice> readKeys;
+  if (!keys.empty()) {
+    auto multistatus = opendb->MultiGet(options, keys, &values);
 
-  for(size_t i=0; i<keys.size() && i<values.size() && i<multistatus.size(); ++i) {
-    if(!multistatus[i].ok()) {
-      logger_->log_error("Failed to read key from rocksdb: %s! DB is most probably in an inconsistent state!", keys[i].data());
-      keystrings.remove(keys[i].data());
-      continue;
-    }
+    for (size_t i = 0; i < keys.size() && i < values.size() && i < multistatus.size(); ++i) {
+      if (!multistatus[i].ok()) {
+        logger_->log_error("Failed to read key from rocksdb: %s! DB is most probably in an inconsistent state!", keys[i].data());
+        keystrings.remove(keys[i].data());
+        continue;
+      }
 
-    utils::Identifier containerId;
-    auto eventRead = FlowFileRecord::DeSerialize(reinterpret_cast<const uint8_t *>(values[i].data()), gsl::narrow<int>(values[i].size()), content_repo_, containerId);
-    if (eventRead) {
-      purgeList.push_back(eventRead);
+      utils::Identifier containerId;
+      auto eventRead = FlowFileRecord::DeSerialize(reinterpret_cast<const uint8_t *>(values[i].data()), gsl::narrow<int>(values[i].size()), content_repo_, containerId);
+      if (eventRead) {
+        purgeList.push_back(eventRead);
+        logger_->log_debug("Issuing batch delete, including %s, Content path %s", eventRead->getUUIDStr(), eventRead->getContentFullPath());
+      }
+      readKeys.push_back(keys[i]);
     }
-    logger_->log_debug("Issuing batch delete, including %s, Content path %s", eventRead->getUUIDStr(), eventRead->getContentFullPath());
-    batch.Delete(keys[i]);
   }
 
-  auto operation = [&batch, &opendb]() { return opendb->Write(rocksdb::WriteOptions(), &batch); };
+  if (deletedKeys.empty() && readKeys.empty()) {
+    return;
+  }
+
+  const bool deleted = commit([&deletedKeys, &readKeys](rocksdb::WriteBatch& batch) {
+    for (const auto& key : deletedKeys) {
+      batch.Delete(key);
+    }
+    for (const auto& key : readKeys) {
+      batch.Delete(key);
+    }
+    return true;
+  });
 
-  if (!ExecuteWithRetry(operation)) {
-    for (const auto& key: keystrings) {
+  if (!deleted) {
+    for (const auto& key : keystrings) {
       keys_to_delete.enqueue(key);  // Push back the values that we could get but couldn't delete
     }
+    for (const auto& key : deletedKeys) {
+      keys_to_delete.enqueue(key);
+    }
     return;  // Stop here - don't delete from content repo while we have records in FF repo
   }
 
+  {
+    std::lock_guard<std::mutex> lock(content_claims_mutex_);
+    for (const auto& key : deletedKeys) {
+      content_claims_.erase(key);
+    }
+  }
+
   if (content_repo_) {
     for (const auto &ffr : purgeList) {
       auto claim = ffr->getResourceClaim();
       if (claim) claim->decreaseFlowFileRecordOwnedCount();
     }
+    for (const auto& path : claimsToRelease) {
+      ResourceClaim claim(path, content_repo_);
+      claim.decreaseFlowFileRecordOwnedCount();
+    }
+  }
+}
+
+bool FlowFileRepository::commit(std::function<bool(rocksdb::WriteBatch&)> append) {
+  PendingWrite write{std::move(append)};
+  std::unique_lock<std::mutex> lock(group_commit_mutex_);
+  pending_writes_.push_back(&write);
+  while (!write.done) {
+    if (group_commit_leader_active_) {
+      group_commit_cv_.wait(lock);
+      continue;
+    }
+    group_commit_leader_active_ = true;
+    if (group_commit_window_.count() > 0) {
+      // give the concurrent sessions a chance to join this batch
+      lock.unlock();
+      std::this_thread::sleep_for(group_commit_window_);
+      lock.lock();
+    }
+    std::vector<PendingWrite*> group;
+    group.swap(pending_writes_);
+    lock.unlock();
+
+    // a writer failing to append its operations is left out of the batch, without failing the others
+    rocksdb::WriteBatch batch;
+    std::vector<PendingWrite*> appended;
+    for (auto pending : group) {
+      batch.SetSavePoint();
+      if (pending->append(batch)) {
+        batch.PopSavePoint();
+        appended.push_back(pending);
+      } else {
+        batch.RollbackToSavePoint();
+      }
+    }
+    bool success = !appended.empty();
+    if (success) {
+      auto opendb = db_->open();
+      success = opendb && ExecuteWithRetry([&batch, &opendb]() { return opendb->Write(rocksdb::WriteOptions(), &batch); });
+    }
+    logger_->log_trace("Group commit of %zu out of %zu writes %s", appended.size(), group.size(), success ? "succeeded" : "failed");
+
+    lock.lock();
+    for (auto pending : group) {
+      pending->done = true;
+    }
+    for (auto pending : appended) {
+      pending->success = success;
+    }
+    group_commit_leader_active_ = false;
+    group_commit_cv_.notify_all();
   }
+  return write.success;
 }
 
 void FlowFileRepository::printStats() {
@@ -129,29 +225,83 @@ void FlowFileRepository::run() {
   flush();
 }
 
+size_t FlowFileRepository::getDefaultRecoveryThreads() {
+  return (std::max)(1U, (std::min)(8U, std::thread::hardware_concurrency()));
+}
+
 void FlowFileRepository::prune_stored_flowfiles() {
-  rocksdb::Options options;
-  options.create_if_missing = true;
-  options.use_direct_io_for_flush_and_compaction = true;
-  options.use_direct_reads = true;
-  minifi::internal::RocksDatabase checkpointDB(options, checkpoint_dir_, minifi::internal::RocksDatabase::Mode::ReadOnly);
-  utils::optional<minifi::internal::OpenRocksDB> opendb;
-  if (nullptr != checkpoint_) {
-    opendb = checkpointDB.open();
-    if (!opendb) {
-      opendb = db_->open();
-    }
-    if (!opendb) {
-      logger_->log_trace("Could not open neither the checkpoint nor the live database.");
-      return;
-    }
-  } else {
-    logger_->log_trace("Could not open checkpoint as object doesn't exist. Likely not needed or file system error.");
+  auto opendb = db_->open();
+  if (!opendb) {
+    logger_->log_error("Could not open the database, the stored flow files cannot be recovered");
+    return;
+  }
+  // the snapshot hides the changes made by the processors already working on the recovered flow files
+  const rocksdb::Snapshot* snapshot = opendb->get()->GetSnapshot();
+  const auto release_snapshot = gsl::finally([&opendb, snapshot] { opendb->get()->ReleaseSnapshot(snapshot); });
+
+  // split the keyspace of the uuid keys on their first hex digit
+  static const std::string HEX_DIGITS = "0123456789abcdef";
+  const size_t partitions = (std::min)(recovery_threads_, HEX_DIGITS.size());
+  std::vector<std::string> bounds{""};
+  for (size_t i = 1; i < partitions; ++i) {
+    bounds.push_back(std::string(1, HEX_DIGITS[i * HEX_DIGITS.size() / partitions]));
+  }
+  bounds.push_back("");
+
+  recovered_count_ = 0;
+  recovering_ = true;
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+    workers.emplace_back(&FlowFileRepository::recover_flowfiles, this, snapshot, bounds[i], bounds[i + 1]);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  recovering_ = false;
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  logger_->log_info("Recovered %" PRIu64 " flow files using %zu threads in %" PRId64 " ms", recovered_count_.load(), workers.size(), static_cast<int64_t>(elapsed.count()));
+}
+
+void FlowFileRepository::recover_flowfiles(const rocksdb::Snapshot* snapshot, const std::string& lower_bound, const std::string& upper_bound) {
+  auto opendb = db_->open();
+  if (!opendb) {
+    logger_->log_error("Could not open the database, the flow files in [%s, %s) cannot be recovered", lower_bound, upper_bound);
     return;
   }
+  rocksdb::ReadOptions options;
+  options.snapshot = snapshot;
+  const rocksdb::Slice upper_bound_slice(upper_bound);
+  if (!upper_bound.empty()) {
+    options.iterate_upper_bound = &upper_bound_slice;
+  }
 
-  auto it = opendb->NewIterator(rocksdb::ReadOptions());
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+  // the flow files are restored in batches, so that each connection is locked and notified once per batch
+  std::map<std::shared_ptr<core::Connectable>, std::vector<std::shared_ptr<core::FlowFile>>> batches;
+  size_t batched = 0;
+  const auto restore_batches = [&] {
+    for (auto& batch : batches) {
+      auto connection = std::dynamic_pointer_cast<minifi::Connection>(batch.first);
+      if (connection) {
+        connection->multiPut(batch.second);
+      } else {
+        for (const auto& flow_file : batch.second) {
+          batch.first->restore(flow_file);
+        }
+      }
+    }
+    recovered_count_ += batched;
+    batches.clear();
+    batched = 0;
+  };
+
+  auto it = opendb->NewIterator(options);
+  if (lower_bound.empty()) {
+    it->SeekToFirst();
+  } else {
+    it->Seek(lower_bound);
+  }
+  for (; it->Valid(); it->Next()) {
     utils::Identifier containerId;
     auto eventRead = FlowFileRecord::DeSerialize(reinterpret_cast<const uint8_t *>(it->value().data()), gsl::narrow<int>(it->value().size()), content_repo_, containerId);
     std::string key = it->key().ToString();
@@ -159,6 +309,7 @@ void FlowFileRepository::prune_stored_flowfiles() {
       // on behalf of the just resurrected persisted instance
       auto claim = eventRead->getResourceClaim();
       if (claim) claim->increaseFlowFileRecordOwnedCount();
+      registerContentClaim(key, claim);
       bool found = false;
       auto search = containers.find(containerId.to_string());
       found = (search != containers.end());
@@ -172,7 +323,10 @@ void FlowFileRepository::prune_stored_flowfiles() {
         eventRead->setStoredToRepository(true);
         // we found the connection for the persistent flowFile
         // even if a processor immediately marks it for deletion, flush only happens after prune_stored_flowfiles
-        search->second->restore(eventRead);
+        batches[search->second].push_back(eventRead);
+        if (++batched >= FLOWFILE_REPOSITORY_RECOVERY_BATCH_SIZE) {
+          restore_batches();
+        }
       } else {
         logger_->log_warn("Could not find connection for %s, path %s ", containerId.to_string(), eventRead->getContentFullPath());
         keys_to_delete.enqueue(key);
@@ -182,6 +336,7 @@ void FlowFileRepository::prune_stored_flowfiles() {
       keys_to_delete.enqueue(key);
     }
   }
+  restore_batches();
 }
 
 bool FlowFileRepository::ExecuteWithRetry(std::function<rocksdb::Status()> operation) {
@@ -199,44 +354,12 @@ bool FlowFileRepository::ExecuteWithRetry(std::function<rocksdb::Status()> opera
   return false;
 }
 
-/**
- * Returns True if there is data to interrogate.
- * @return true if our db has data stored.
- */
-bool FlowFileRepository::need_checkpoint(minifi::internal::OpenRocksDB& opendb){
-  auto it = opendb.NewIterator(rocksdb::ReadOptions());
-  it->SeekToFirst();
-  return it->Valid();
-}
-void FlowFileRepository::initialize_repository() {
-  auto opendb = db_->open();
-  if (!opendb) {
-    logger_->log_trace("Couldn't open database, no way to checkpoint");
-    return;
-  }
-  // first we need to establish a checkpoint iff it is needed.
-  if (!need_checkpoint(*opendb)){
-    logger_->log_trace("Do not need checkpoint");
-    return;
-  }
-  rocksdb::Checkpoint *checkpoint;
-  // delete any previous copy
-  if (utils::file::FileUtils::delete_dir(checkpoint_dir_) >= 0 && opendb->NewCheckpoint(&checkpoint).ok()) {
-    if (checkpoint->CreateCheckpoint(checkpoint_dir_).ok()) {
-      checkpoint_ = std::unique_ptr<rocksdb::Checkpoint>(checkpoint);
-      logger_->log_trace("Created checkpoint directory");
-    } else {
-      logger_->log_trace("Could not create checkpoint. Corrupt?");
-    }
-  } else
-    logger_->log_trace("Could not create checkpoint directory. Not properly deleted?");
-}
-
 void FlowFileRepository::loadComponent(const std::shared_ptr<core::ContentRepository> &content_repo) {
   content_repo_ = content_repo;
   repo_size_ = 0;
 
-  initialize_repository();
+  // the stored flow files are recovered from a snapshot of the live database, only earlier versions created a checkpoint
+  utils::file::FileUtils::delete_dir(checkpoint_dir_);
 }
 
 } /* namespace repository */
@@ -18,17 +18,29 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_REPOSITORY_FLOWFILEREPOSITORY_H_
 #define LIBMINIFI_INCLUDE_CORE_REPOSITORY_FLOWFILEREPOSITORY_H_
 
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "utils/file/FileUtils.h"
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
-#include "rocksdb/utilities/checkpoint.h"
 #include "core/Repository.h"
 #include "core/Core.h"
 #include "Connection.h"
 #include "core/logging/LoggerConfiguration.h"
 #include "concurrentqueue.h"
 #include "RocksDatabase.h"
+#include "utils/gsl.h"
 
 namespace org {
 namespace apache {
@@ -48,6 +60,7 @@ namespace repository {
 #define MAX_FLOWFILE_REPOSITORY_ENTRY_LIFE_TIME (600000)  // 10 minute
 #define FLOWFILE_REPOSITORY_PURGE_PERIOD (2000)  // 2000 msec
 #define FLOWFILE_REPOSITORY_RETRY_INTERVAL_INCREMENTS (500)  // msec
+#define FLOWFILE_REPOSITORY_RECOVERY_BATCH_SIZE (1000)
 
 /**
  * Flow File repository
@@ -66,8 +79,8 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
       : core::SerializableComponent(repo_name),
         Repository(repo_name.length() > 0 ? repo_name : core::getClassName<FlowFileRepository>(), directory, maxPartitionMillis, maxPartitionBytes, purgePeriod),
         checkpoint_dir_(checkpoint_dir),
+        recovery_threads_(getDefaultRecoveryThreads()),
         content_repo_(nullptr),
-        checkpoint_(nullptr),
         logger_(logging::LoggerFactory<FlowFileRepository>::getLogger()) {
     db_ = NULL;
   }
@@ -76,6 +89,10 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
     return false;
   }
 
+  virtual bool isDurable() const {
+    return true;
+  }
+
   virtual void flush();
 
   virtual void printStats();
@@ -98,6 +115,25 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
       }
     }
     logger_->log_debug("NiFi FlowFile Max Storage Time: [%d] ms", max_partition_millis_);
+    if (configure->get(Configure::nifi_flowfile_repository_recovery_threads, value)) {
+      uint64_t recovery_threads = 0;
+      if (Property::StringToInt(value, recovery_threads) && recovery_threads > 0) {
+        recovery_threads_ = gsl::narrow<size_t>(recovery_threads);
+      } else {
+        logger_->log_warn("Invalid number of recovery threads: %s", value);
+      }
+    }
+    logger_->log_debug("NiFi FlowFile Repository recovery threads: %zu", recovery_threads_);
+    if (configure->get(Configure::nifi_flowfile_repository_group_commit_window, value)) {
+      uint64_t window = 0;
+      TimeUnit unit;
+      if (Property::StringToTime(value, window, unit) && Property::ConvertTimeUnitToMS(window, unit, window)) {
+        group_commit_window_ = std::chrono::milliseconds(window);
+      } else {
+        logger_->log_warn("Invalid group commit window: %s", value);
+      }
+    }
+    logger_->log_debug("NiFi FlowFile Repository group commit window: %" PRId64 " ms", static_cast<int64_t>(group_commit_window_.count()));
     rocksdb::Options options;
     options.create_if_missing = true;
     options.use_direct_io_for_flush_and_compaction = true;
@@ -124,35 +160,38 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
 
   virtual void run();
 
+  virtual void registerContentClaim(const std::string& key, const std::shared_ptr<ResourceClaim>& claim) {
+    std::lock_guard<std::mutex> lock(content_claims_mutex_);
+    content_claims_[key] = claim ? claim->getContentFullPath() : "";
+  }
+
+  virtual bool isRecovering() const {
+    return recovering_;
+  }
+
+  virtual uint64_t getRecoveredCount() const {
+    return recovered_count_;
+  }
+
   virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen) {
     // persistent to the DB
-    auto opendb = db_->open();
-    if (!opendb) {
-      return false;
-    }
     rocksdb::Slice value((const char *) buf, bufLen);
-    auto operation = [&key, &value, &opendb]() { return opendb->Put(rocksdb::WriteOptions(), key, value); };
-    return ExecuteWithRetry(operation);
+    return commit([&key, &value](rocksdb::WriteBatch& batch) { return batch.Put(key, value).ok(); });
   }
 
   virtual bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>>& data) {
-    auto opendb = db_->open();
-    if (!opendb) {
-      return false;
-    }
-    rocksdb::WriteBatch batch;
-    for (const auto &item: data) {
-      rocksdb::Slice value((const char *) item.second->getBuffer(), item.second->size());
-      if (!batch.Put(item.first, value).ok()) {
-        logger_->log_error("Failed to add item to batch operation");
-        return false;
+    return commit([this, &data](rocksdb::WriteBatch& batch) {
+      for (const auto &item : data) {
+        rocksdb::Slice value((const char *) item.second->getBuffer(), item.second->size());
+        if (!batch.Put(item.first, value).ok()) {
+          logger_->log_error("Failed to add item to batch operation");
+          return false;
+        }
       }
-    }
-    auto operation = [&batch, &opendb]() { return opendb->Write(rocksdb::WriteOptions(), &batch); };
-    return ExecuteWithRetry(operation);
+      return true;
+    });
   }
 
-
   /**
    *
    * Deletes the key
@@ -188,31 +227,58 @@ class FlowFileRepository : public core::Repository, public std::enable_shared_fr
     logger_->log_debug("%s Repository Monitor Thread Start", getName());
   }
 
+ protected:
+  /**
+   * Writes the operations added by append to the database, together with the writes of the concurrent callers.
+   * The first caller becomes the leader: it waits for the group commit window, then writes every pending
+   * operation in one batch. The others block until the batch holding their operations has been written.
+   * The operations of a caller whose append fails are left out of the batch, failing that caller alone.
+   * @return true if the operations have been written
+   */
+  bool commit(std::function<bool(rocksdb::WriteBatch&)> append);
+
  private:
 
   bool ExecuteWithRetry(std::function<rocksdb::Status()> operation);
 
-  /**
-   * Initialize the repository
-   */
-  void initialize_repository();
+  // a write waiting to be committed, owned by the thread waiting for it
+  struct PendingWrite {
+    explicit PendingWrite(std::function<bool(rocksdb::WriteBatch&)> append)
+        : append(std::move(append)) {}
+
+    std::function<bool(rocksdb::WriteBatch&)> append;
+    bool done = false;
+    bool success = false;
+  };
+
+  static size_t getDefaultRecoveryThreads();
 
   /**
-   * Returns true if a checkpoint is needed at startup
-   * @return true if a checkpoint is needed.
+   * Prunes stored flow files: restores them into their connections, or deletes them if their connection no longer exists.
+   * The keyspace is split into ranges which are recovered in parallel from a snapshot of the database.
    */
-  bool need_checkpoint(minifi::internal::OpenRocksDB& opendb);
+  void prune_stored_flowfiles();
 
   /**
-   * Prunes stored flow files.
+   * Recovers the flow files stored in [lower_bound, upper_bound) of the snapshot. An empty bound leaves the range open.
    */
-  void prune_stored_flowfiles();
+  void recover_flowfiles(const rocksdb::Snapshot* snapshot, const std::string& lower_bound, const std::string& upper_bound);
 
   std::string checkpoint_dir_;
+  size_t recovery_threads_;
+  std::atomic<bool> recovering_{false};
+  std::atomic<uint64_t> recovered_count_{0};
   moodycamel::ConcurrentQueue<std::string> keys_to_delete;
+  std::chrono::milliseconds group_commit_window_{0};
+  std::mutex group_commit_mutex_;
+  std::condition_variable group_commit_cv_;
+  std::vector<PendingWrite*> pending_writes_;
+  bool group_commit_leader_active_ = false;
+  // content claim path of the stored flow files, empty if the flow file has no content
+  std::mutex content_claims_mutex_;
+  std::unordered_map<std::string, ResourceClaim::Path> content_claims_;
   std::shared_ptr<core::ContentRepository> content_repo_;
   std::unique_ptr<minifi::internal::RocksDatabase> db_;
-  std::unique_ptr<rocksdb::Checkpoint> checkpoint_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
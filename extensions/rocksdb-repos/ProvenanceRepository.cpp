@@ -17,13 +17,379 @@
  */
 
 #include "ProvenanceRepository.h"
+
+#include <deque>
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_set>
+
+#include "utils/TimeUtil.h"
+
 namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
 namespace provenance {
 
+const char* const ProvenanceRepository::EVENTS_COLUMN_FAMILY = "events";
+
+namespace {
+
+// the key of an event: its event time and a sequence number, both big endian so that the keys sort in time order
+constexpr size_t EVENT_KEY_SIZE = 16;
+
+// the event times in milliseconds start with a zero byte, so the events sort before the index entries
+const rocksdb::Slice EVENTS_END("\x01", 1);
+
+// kept in the default column family, so that the sequence numbers go on once all the events have expired
+const char* const NEXT_SEQUENCE_NUMBER_KEY = "next_sequence_number";
+
+// the prefixes of the index entries
+constexpr char LOOKUP_PREFIX = 'k';
+constexpr char FLOW_FILE_PREFIX = 'f';
+constexpr char COMPONENT_PREFIX = 'c';
+constexpr char EVENT_TYPE_PREFIX = 't';
+constexpr char SEQUENCE_PREFIX = 's';
+
+void appendBigEndian(std::string &key, uint64_t value) {
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    key.push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+uint64_t readBigEndian(const char *data) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value = (value << 8) | static_cast<uint8_t>(data[i]);
+  }
+  return value;
+}
+
+std::string eventKey(uint64_t event_time, uint64_t sequence_number) {
+  std::string key;
+  key.reserve(EVENT_KEY_SIZE);
+  appendBigEndian(key, event_time);
+  appendBigEndian(key, sequence_number);
+  return key;
+}
+
+std::string sequenceKey(uint64_t sequence_number) {
+  std::string key(1, SEQUENCE_PREFIX);
+  appendBigEndian(key, sequence_number);
+  return key;
+}
+
+std::string flowFilePrefix(const utils::Identifier &flow_file_uuid) {
+  return FLOW_FILE_PREFIX + std::string(flow_file_uuid.to_string());
+}
+
+std::string componentPrefix(const std::string &component_id) {
+  // terminated, so that a component id is not the prefix of another one
+  return COMPONENT_PREFIX + component_id + '\0';
+}
+
+std::string eventTypePrefix(ProvenanceEventRecord::ProvenanceEventType event_type) {
+  return std::string(1, EVENT_TYPE_PREFIX) + static_cast<char>(event_type);
+}
+
+}  // namespace
+
+std::string ProvenanceRepository::lookupKey(const std::string &key) {
+  return LOOKUP_PREFIX + key;
+}
+
+bool ProvenanceRepository::open(const rocksdb::Options &options) {
+  std::vector<std::string> existing_column_families;
+  rocksdb::DB::ListColumnFamilies(options, directory_, &existing_column_families);
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
+  // the entries of the default column family do not expire
+  rocksdb::ColumnFamilyOptions default_options(options);
+  default_options.compaction_style = rocksdb::CompactionStyle::kCompactionStyleLevel;
+  default_options.ttl = 0;
+  column_families.emplace_back(rocksdb::kDefaultColumnFamilyName, default_options);
+  // the index entries are written along with their event, so they are in the same table file and are dropped along with it
+  column_families.emplace_back(EVENTS_COLUMN_FAMILY, rocksdb::ColumnFamilyOptions(options));
+  // any other column family is left over from an earlier layout, all of them are to be opened to open the database
+  for (const auto &name : existing_column_families) {
+    if (name != rocksdb::kDefaultColumnFamilyName && name != EVENTS_COLUMN_FAMILY) {
+      column_families.emplace_back(name, rocksdb::ColumnFamilyOptions(options));
+    }
+  }
+  std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  rocksdb::DB* db;
+  rocksdb::Status status = rocksdb::DB::Open(rocksdb::DBOptions(options), directory_, column_families, &handles, &db);
+  if (!status.ok()) {
+    logger_->log_error("MiNiFi Provenance Repository database open %s failed: %s", directory_, status.ToString());
+    return false;
+  }
+  logger_->log_debug("MiNiFi Provenance Repository database open %s success", directory_);
+  db_.reset(db);
+  default_.reset(handles[0]);
+  events_.reset(handles[1]);
+  for (size_t i = 2; i < handles.size(); ++i) {
+    std::unique_ptr<rocksdb::ColumnFamilyHandle> handle(handles[i]);
+    logger_->log_info("Dropping the column family %s of an earlier provenance repository layout", handle->GetName());
+    db_->DropColumnFamily(handle.get());
+  }
+
+  next_sequence_number_ = 0;
+  std::string next_sequence_number;
+  if (db_->Get(rocksdb::ReadOptions(), default_.get(), NEXT_SEQUENCE_NUMBER_KEY, &next_sequence_number).ok() && next_sequence_number.size() == 8) {
+    next_sequence_number_ = readBigEndian(next_sequence_number.data());
+  }
+
+  return migrateEventsKeyedById();
+}
+
+std::unique_ptr<rocksdb::Iterator> ProvenanceRepository::newEventIterator() const {
+  rocksdb::ReadOptions read_options;
+  read_options.iterate_upper_bound = &EVENTS_END;
+  return std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(read_options, events_.get()));
+}
+
+bool ProvenanceRepository::migrateEventsKeyedById() {
+  static const size_t BATCH_SIZE = 1000;
+  size_t migrated = 0;
+  // the pending events refer to these
+  std::deque<std::string> values;
+  std::vector<PendingEvent> events;
+  rocksdb::WriteBatch batch;
+  // the default column family only holds the events of the earlier layouts, each of them is moved along with its index entries
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions(), default_.get()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    if (it->key() == rocksdb::Slice(NEXT_SEQUENCE_NUMBER_KEY)) {
+      continue;
+    }
+    values.push_back(it->value().ToString());
+    events.push_back(prepare(it->key().ToString(), reinterpret_cast<const uint8_t*>(values.back().data()), values.back().size()));
+    if (!batch.Delete(default_.get(), it->key()).ok()) {
+      return false;
+    }
+    if (++migrated % BATCH_SIZE == 0) {
+      if (!write(events, batch)) {
+        return false;
+      }
+      batch.Clear();
+      events.clear();
+      values.clear();
+    }
+  }
+  if (migrated == 0) {
+    return true;
+  }
+  logger_->log_info("Re-keyed %llu provenance events by their event time", migrated);
+  return write(events, batch);
+}
+
+bool ProvenanceRepository::MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>>& data, const std::vector<ProvenanceEventIndex> &indexes) {
+  if (data.size() != indexes.size()) {
+    logger_->log_error("Got %llu provenance events with %llu indexes", data.size(), indexes.size());
+    return false;
+  }
+  std::vector<PendingEvent> events;
+  events.reserve(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    events.push_back(prepare(data[i].first, data[i].second->getBuffer(), data[i].second->size(), indexes[i]));
+  }
+  rocksdb::WriteBatch batch;
+  return write(events, batch);
+}
+
+ProvenanceRepository::PendingEvent ProvenanceRepository::prepare(const std::string &key, const uint8_t *buffer, size_t size, const ProvenanceEventIndex &index) {
+  PendingEvent pending;
+  pending.key = key;
+  pending.value = rocksdb::Slice(reinterpret_cast<const char*>(buffer), size);
+  pending.event_time = index.event_time;
+  pending.index_prefixes.insert(flowFilePrefix(index.flow_file_uuid));
+  for (const auto &uuid : index.lineage_uuids) {
+    pending.index_prefixes.insert(flowFilePrefix(uuid));
+  }
+  pending.index_prefixes.insert(componentPrefix(index.component_id));
+  pending.index_prefixes.insert(eventTypePrefix(index.event_type));
+  return pending;
+}
+
+ProvenanceRepository::PendingEvent ProvenanceRepository::prepare(const std::string &key, const uint8_t *buffer, size_t size) {
+  ProvenanceEventRecord event;
+  if (!event.DeSerialize(buffer, size)) {
+    // anything but an event is stored as of now and is reachable by its key and sequence number only
+    PendingEvent pending;
+    pending.key = key;
+    pending.value = rocksdb::Slice(reinterpret_cast<const char*>(buffer), size);
+    return pending;
+  }
+  return prepare(key, buffer, size, event.getIndex());
+}
+
+bool ProvenanceRepository::write(const std::vector<PendingEvent> &events, rocksdb::WriteBatch &batch) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  uint64_t sequence_number = next_sequence_number_;
+  for (const auto &event : events) {
+    const std::string event_key = eventKey(event.event_time ? *event.event_time : utils::timeutils::getTimeMillis(), sequence_number);
+    if (!batch.Put(events_.get(), event_key, event.value).ok()
+        || !batch.Put(events_.get(), lookupKey(event.key), event_key).ok()
+        || !batch.Put(events_.get(), sequenceKey(sequence_number), event_key).ok()) {
+      return false;
+    }
+    for (const auto &prefix : event.index_prefixes) {
+      if (!batch.Put(events_.get(), prefix + event_key, rocksdb::Slice()).ok()) {
+        return false;
+      }
+    }
+    ++sequence_number;
+  }
+  std::string next_sequence_number;
+  appendBigEndian(next_sequence_number, sequence_number);
+  if (!batch.Put(default_.get(), NEXT_SEQUENCE_NUMBER_KEY, next_sequence_number).ok()) {
+    return false;
+  }
+  if (!db_->Write(rocksdb::WriteOptions(), &batch).ok()) {
+    return false;
+  }
+  next_sequence_number_ = sequence_number;
+  return true;
+}
+
+std::shared_ptr<ProvenanceEventRecord> ProvenanceRepository::readEvent(const rocksdb::Slice &event_key) {
+  std::string value;
+  if (!db_->Get(rocksdb::ReadOptions(), events_.get(), event_key, &value).ok()) {
+    // dropped by the compaction meanwhile
+    return nullptr;
+  }
+  auto event = std::make_shared<ProvenanceEventRecord>();
+  if (!event->DeSerialize(reinterpret_cast<const uint8_t*>(value.data()), value.size())) {
+    return nullptr;
+  }
+  return event;
+}
+
+void ProvenanceRepository::scanIndex(const std::string &prefix, uint64_t start_time, uint64_t end_time, const std::function<bool(const rocksdb::Slice&)> &consumer) {
+  const std::string end_key = prefix + eventKey(end_time, 0);
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions(), events_.get()));
+  for (it->Seek(prefix + eventKey(start_time, 0)); it->Valid(); it->Next()) {
+    const rocksdb::Slice key = it->key();
+    if (!key.starts_with(prefix) || key.compare(end_key) >= 0) {
+      break;
+    }
+    if (key.size() != prefix.size() + EVENT_KEY_SIZE) {
+      continue;
+    }
+    if (!consumer(rocksdb::Slice(key.data() + prefix.size(), EVENT_KEY_SIZE))) {
+      break;
+    }
+  }
+}
+
+uint64_t ProvenanceRepository::readEventsFrom(uint64_t cursor, size_t max_events, const std::function<void(ProvenanceEventRecord&)> &consumer) {
+  const std::string prefix(1, SEQUENCE_PREFIX);
+  size_t read = 0;
+  std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions(), events_.get()));
+  for (it->Seek(sequenceKey(cursor)); it->Valid() && read < max_events; it->Next()) {
+    const rocksdb::Slice key = it->key();
+    if (!key.starts_with(prefix)) {
+      break;
+    }
+    if (key.size() != prefix.size() + 8) {
+      continue;
+    }
+    cursor = readBigEndian(key.data() + prefix.size()) + 1;
+    // the values which are no events are skipped
+    auto event = readEvent(it->value());
+    if (event) {
+      consumer(*event);
+      ++read;
+    }
+  }
+  return cursor;
+}
+
+std::vector<std::shared_ptr<ProvenanceEventRecord>> ProvenanceRepository::query(const ProvenanceQuery &query) {
+  std::vector<std::shared_ptr<ProvenanceEventRecord>> events;
+  if (query.max_results == 0 || query.start_time >= query.end_time) {
+    return events;
+  }
+  if (query.flow_file_uuid && query.lineage) {
+    return queryLineage(query);
+  }
+
+  const auto collect = [this, &query, &events](const rocksdb::Slice &event_key) {
+    auto event = readEvent(event_key);
+    if (event && query.matches(*event)) {
+      events.push_back(event);
+    }
+    return events.size() < query.max_results;
+  };
+  // seek by the most selective criterion, the rest is checked on the events
+  if (query.flow_file_uuid) {
+    scanIndex(flowFilePrefix(*query.flow_file_uuid), query.start_time, query.end_time, collect);
+  } else if (query.component_id) {
+    scanIndex(componentPrefix(*query.component_id), query.start_time, query.end_time, collect);
+  } else if (query.event_type) {
+    scanIndex(eventTypePrefix(*query.event_type), query.start_time, query.end_time, collect);
+  } else {
+    const std::string end_key = eventKey(query.end_time, 0);
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
+    for (it->Seek(eventKey(query.start_time, 0)); it->Valid() && events.size() < query.max_results; it->Next()) {
+      if (it->key().compare(end_key) >= 0) {
+        break;
+      }
+      auto event = std::make_shared<ProvenanceEventRecord>();
+      if (event->DeSerialize(reinterpret_cast<const uint8_t*>(it->value().data()), it->value().size()) && query.matches(*event)) {
+        events.push_back(event);
+      }
+    }
+  }
+  return events;
+}
+
+std::vector<std::shared_ptr<ProvenanceEventRecord>> ProvenanceRepository::queryLineage(const ProvenanceQuery &query) {
+  // ordered by event key, hence by event time
+  std::map<std::string, std::shared_ptr<ProvenanceEventRecord>> events;
+  std::set<std::string> visited_events;
+  std::unordered_set<std::string> visited_flow_files{query.flow_file_uuid->to_string()};
+  std::deque<utils::Identifier> pending_flow_files{*query.flow_file_uuid};
+  const auto follow = [&visited_flow_files, &pending_flow_files](const utils::Identifier &flow_file_uuid) {
+    if (visited_flow_files.insert(flow_file_uuid.to_string()).second) {
+      pending_flow_files.push_back(flow_file_uuid);
+    }
+  };
+
+  // the lineage is followed through all the events, the other criteria only select the events to return
+  while (!pending_flow_files.empty() && events.size() < query.max_results) {
+    const utils::Identifier flow_file_uuid = pending_flow_files.front();
+    pending_flow_files.pop_front();
+    scanIndex(flowFilePrefix(flow_file_uuid), query.start_time, query.end_time, [&](const rocksdb::Slice &event_key) {
+      if (!visited_events.insert(event_key.ToString()).second) {
+        return true;
+      }
+      auto event = readEvent(event_key);
+      if (!event) {
+        return true;
+      }
+      follow(event->getFlowFileUuid());
+      for (const auto &parent : event->getParentUuids()) {
+        follow(parent);
+      }
+      for (const auto &child : event->getChildrenUuids()) {
+        follow(child);
+      }
+      if (query.matches(*event)) {
+        events.emplace(event_key.ToString(), event);
+      }
+      return events.size() < query.max_results;
+    });
+  }
+
+  std::vector<std::shared_ptr<ProvenanceEventRecord>> result;
+  result.reserve(events.size());
+  for (const auto &event : events) {
+    result.push_back(event.second);
+  }
+  return result;
+}
+
 void ProvenanceRepository::printStats() {
   std::string key_count;
   db_->GetProperty("rocksdb.estimate-num-keys", &key_count);
@@ -17,12 +17,23 @@
 #ifndef LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEREPOSITORY_H_
 #define LIBMINIFI_INCLUDE_PROVENANCE_PROVENANCEREPOSITORY_H_
 
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "rocksdb/db.h"
 #include "rocksdb/options.h"
 #include "rocksdb/slice.h"
+#include "rocksdb/write_batch.h"
 #include "core/Repository.h"
 #include "core/Core.h"
 #include "provenance/Provenance.h"
+#include "provenance/ProvenanceQuery.h"
+#include "utils/OptionalUtils.h"
 #include "core/logging/LoggerConfiguration.h"
 namespace org {
 namespace apache {
@@ -35,7 +46,16 @@ namespace provenance {
 #define MAX_PROVENANCE_ENTRY_LIFE_TIME (60000)  // 1 minute
 #define PROVENANCE_PURGE_PERIOD (2500)  // 2500 msec
 
-class ProvenanceRepository : public core::Repository, public std::enable_shared_from_this<ProvenanceRepository> {
+/**
+ * Keeps the events in time order, under the key of their event time and a sequence number, so that a time range is
+ * read by a single seek. The index entries are stored next to the events, in the "events" column family: they map the
+ * keys the events are put with (their UUIDs) to these keys and index the events by FlowFile (including the parents and
+ * children of forks, clones and joins), by component and by event type, which lets the queries seek to the matching
+ * events instead of scanning the repository. They also map the sequence numbers, assigned in the order the events are
+ * written, to the events for the readers keeping a cursor. An event and its index entries are written in one batch,
+ * so they end up in the same table file and the FIFO compaction drops them together.
+ */
+class ProvenanceRepository : public core::Repository, public QueryableProvenanceRepository, public std::enable_shared_from_this<ProvenanceRepository> {
  public:
   ProvenanceRepository(std::string name, utils::Identifier /*uuid*/)
       : ProvenanceRepository(name){
@@ -50,8 +70,8 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
                        uint64_t purgePeriod = PROVENANCE_PURGE_PERIOD)
       : core::SerializableComponent(repo_name),
         Repository(repo_name.length() > 0 ? repo_name : core::getClassName<ProvenanceRepository>(), directory, maxPartitionMillis, maxPartitionBytes, purgePeriod),
+        next_sequence_number_(0),
         logger_(logging::LoggerFactory<ProvenanceRepository>::getLogger()) {
-    db_ = NULL;
   }
 
   void printStats();
@@ -87,6 +107,7 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
     logger_->log_debug("MiNiFi Provenance Max Storage Time: [%d] ms", max_partition_millis_);
     rocksdb::Options options;
     options.create_if_missing = true;
+    options.create_missing_column_families = true;
     options.use_direct_io_for_flush_and_compaction = true;
     options.use_direct_reads = true;
     // Rocksdb write buffers act as a log of database operation: grow till reaching the limit, serialized after
@@ -106,36 +127,30 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
     logger_->log_info("Max partition bytes: %llu", max_partition_bytes_);
     logger_->log_info("Ttl: %llu", options.ttl);
 
-    rocksdb::DB* db;
-    rocksdb::Status status = rocksdb::DB::Open(options, directory_, &db);
-    if (status.ok()) {
-      logger_->log_debug("MiNiFi Provenance Repository database open %s success", directory_);
-      db_.reset(db);
-    } else {
-      logger_->log_error("MiNiFi Provenance Repository database open %s failed: %s", directory_, status.ToString());
-      return false;
-    }
-
-    return true;
+    return open(options);
   }
-  // Put
+  // Put, the value is stored as it is, without an index, the events are put along with theirs
   virtual bool Put(std::string key, const uint8_t *buf, size_t bufLen) {
     // persist to the DB
-    rocksdb::Slice value((const char *) buf, bufLen);
-    return db_->Put(rocksdb::WriteOptions(), key, value).ok();
+    std::vector<PendingEvent> events(1);
+    events.back().key = std::move(key);
+    events.back().value = rocksdb::Slice(reinterpret_cast<const char*>(buf), bufLen);
+    rocksdb::WriteBatch batch;
+    return write(events, batch);
   }
 
   virtual bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>>& data) {
-    rocksdb::WriteBatch batch;
-    for (const auto &item: data) {
-      rocksdb::Slice value((const char *) item.second->getBuffer(), item.second->size());
-      if (!batch.Put(item.first, value).ok()) {
-        return false;
-      }
+    std::vector<PendingEvent> events(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      events[i].key = data[i].first;
+      events[i].value = rocksdb::Slice(reinterpret_cast<const char*>(data[i].second->getBuffer()), data[i].second->size());
     }
-    return db_->Write(rocksdb::WriteOptions(), &batch).ok();
+    rocksdb::WriteBatch batch;
+    return write(events, batch);
   }
 
+  bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>>& data, const std::vector<ProvenanceEventIndex> &indexes) override;
+
   // Delete
   virtual bool Delete(std::string /*key*/) {
     // The repo is cleaned up by itself, there is no need to delete items.
@@ -143,15 +158,23 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
   }
   // Get
   virtual bool Get(const std::string &key, std::string &value) {
-    return db_->Get(rocksdb::ReadOptions(), key, &value).ok();
+    std::string event_key;
+    if (!db_->Get(rocksdb::ReadOptions(), events_.get(), lookupKey(key), &event_key).ok()) {
+      return false;
+    }
+    return db_->Get(rocksdb::ReadOptions(), events_.get(), event_key, &value).ok();
   }
 
+  std::vector<std::shared_ptr<ProvenanceEventRecord>> query(const ProvenanceQuery &query) override;
+
+  uint64_t readEventsFrom(uint64_t cursor, size_t max_events, const std::function<void(ProvenanceEventRecord&)> &consumer) override;
+
   virtual bool Serialize(const std::string &key, const uint8_t *buffer, const size_t bufferSize) {
     return Put(key, buffer, bufferSize);
   }
 
   virtual bool get(std::vector<std::shared_ptr<core::CoreComponent>> &store, size_t max_size) {
-    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
       std::shared_ptr<ProvenanceEventRecord> eventRead = std::make_shared<ProvenanceEventRecord>();
       std::string key = it->key().ToString();
@@ -165,7 +188,7 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
   }
 
   virtual bool DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &records, size_t &max_size, std::function<std::shared_ptr<core::SerializableComponent>()> lambda) {
-    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
     size_t requested_batch = max_size;
     max_size = 0;
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
@@ -184,7 +207,7 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
 
   //! get record
   void getProvenanceRecord(std::vector<std::shared_ptr<ProvenanceEventRecord>> &records, int maxSize) {
-    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
       std::shared_ptr<ProvenanceEventRecord> eventRead = std::make_shared<ProvenanceEventRecord>();
       std::string key = it->key().ToString();
@@ -197,7 +220,7 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
   }
 
   virtual bool DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size) {
-    std::unique_ptr<rocksdb::Iterator> it(db_->NewIterator(rocksdb::ReadOptions()));
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
     max_size = 0;
     for (it->SeekToFirst(); it->Valid(); it->Next()) {
       std::shared_ptr<ProvenanceEventRecord> eventRead = std::make_shared<ProvenanceEventRecord>();
@@ -214,16 +237,21 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
 
   // destroy
   void destroy() {
+    events_.reset();
+    default_.reset();
     db_.reset();
   }
   // Run function for the thread
   void run();
 
+  // the number of events, without their index entries
   uint64_t getKeyCount() const {
-    std::string key_count;
-    db_->GetProperty("rocksdb.estimate-num-keys", &key_count);
-
-    return std::stoull(key_count);
+    uint64_t key_count = 0;
+    std::unique_ptr<rocksdb::Iterator> it = newEventIterator();
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      ++key_count;
+    }
+    return key_count;
   }
 
   // Prevent default copy constructor and assignment operation
@@ -232,7 +260,54 @@ class ProvenanceRepository : public core::Repository, public std::enable_shared_
   ProvenanceRepository &operator=(const ProvenanceRepository &parent) = delete;
 
  private:
+  static const char* const EVENTS_COLUMN_FAMILY;
+
+  bool open(const rocksdb::Options &options);
+
+  // iterates over the events only, without the index entries stored after them
+  std::unique_ptr<rocksdb::Iterator> newEventIterator() const;
+
+  // re-keys the events of a repository written before the events were keyed by time
+  bool migrateEventsKeyedById();
+
+  // an event with the index entries to put along with it
+  struct PendingEvent {
+    std::string key;
+    rocksdb::Slice value;
+    utils::optional<uint64_t> event_time;
+    std::set<std::string> index_prefixes;
+  };
+
+  // indexes the event by the given index, the key is expected to be a fresh event id
+  static PendingEvent prepare(const std::string &key, const uint8_t *buffer, size_t size, const ProvenanceEventIndex &index);
+
+  // indexes the serialized event by deserializing it, for the events of the earlier layouts only
+  static PendingEvent prepare(const std::string &key, const uint8_t *buffer, size_t size);
+
+  // numbers the events in the order they are written and writes them and their index entries along with the batch
+  bool write(const std::vector<PendingEvent> &events, rocksdb::WriteBatch &batch);
+
+  std::shared_ptr<ProvenanceEventRecord> readEvent(const rocksdb::Slice &event_key);
+
+  /**
+   * Calls the consumer with the keys of the events under the index prefix in the given time range, in time order,
+   * until it returns false.
+   */
+  void scanIndex(const std::string &prefix, uint64_t start_time, uint64_t end_time, const std::function<bool(const rocksdb::Slice&)> &consumer);
+
+  std::vector<std::shared_ptr<ProvenanceEventRecord>> queryLineage(const ProvenanceQuery &query);
+
+  static std::string lookupKey(const std::string &key);
+
   std::unique_ptr<rocksdb::DB> db_;
+  // the column family handles are to be destroyed before the database
+  std::unique_ptr<rocksdb::ColumnFamilyHandle> default_;
+  std::unique_ptr<rocksdb::ColumnFamilyHandle> events_;
+  // the sequence numbers are assigned in the order the events are written, so that the events read
+  // from a cursor never fall behind it
+  std::mutex write_mutex_;
+  // numbers the events in the order they are written
+  uint64_t next_sequence_number_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
@@ -86,6 +86,10 @@ class GenerateFlowFile : public core::Processor {
   // Initialize, over write by NiFi GenerateFlowFile
   void initialize(void) override;
 
+  bool supportsBatching() const override {
+    return true;
+  }
+
  protected:
   std::vector<char> data_;
 
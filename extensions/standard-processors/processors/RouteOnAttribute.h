@@ -67,6 +67,10 @@ class RouteOnAttribute : public core::Processor {
   virtual void onTrigger(core::ProcessContext *context, core::ProcessSession *session);
   virtual void initialize(void);
 
+  bool supportsBatching() const override {
+    return true;
+  }
+
  private:
   std::shared_ptr<logging::Logger> logger_;
   std::map<std::string, core::Property> route_properties_;
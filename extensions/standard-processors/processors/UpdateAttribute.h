@@ -65,6 +65,10 @@ class UpdateAttribute : public core::Processor {
                          core::ProcessSession *session);
   virtual void initialize(void);
 
+  bool supportsBatching() const override {
+    return true;
+  }
+
  private:
   std::shared_ptr<logging::Logger> logger_;
   std::vector<core::Property> attributes_;
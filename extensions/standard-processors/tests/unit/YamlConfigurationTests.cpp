@@ -747,3 +747,230 @@ TEST_CASE("Test Regex Property 2", "[YamlConfigurationRegexProperty2]") {
 }
 
 #endif  // YAML_CONFIGURATION_USE_REGEX
+
+TEST_CASE("Test YAML Thread Pools", "[YamlConfigurationThreadPools]") {
+  TestController test_controller;
+
+  std::shared_ptr<core::Repository> testProvRepo = core::createRepository("provenancerepository", true);
+  std::shared_ptr<core::Repository> testFlowFileRepo = core::createRepository("flowfilerepository", true);
+  std::shared_ptr<minifi::Configure> configuration = std::make_shared<minifi::Configure>();
+  std::shared_ptr<minifi::io::StreamFactory> streamFactory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  core::YamlConfiguration yamlConfig(testProvRepo, testFlowFileRepo, content_repo, streamFactory, configuration);
+
+  static const std::string TEST_CONFIG_YAML =
+      R"(
+Flow Controller:
+  name: MiNiFi Flow
+  thread pool: cpu
+Thread Pools:
+  - name: cpu
+    max threads: 2
+    cpu affinity: 0, 2-3
+  - name: io
+    max threads: 8
+Processors:
+  - name: Generator
+    class: org.apache.nifi.processors.standard.GenerateFlowFile
+  - name: Putter
+    class: org.apache.nifi.processors.standard.PutFile
+    thread pool: io
+Process Groups:
+  - name: Child
+    Processors:
+      - name: ChildLogger
+        class: org.apache.nifi.processors.standard.LogAttribute
+    Process Groups:
+      - name: GrandChild
+        thread pool: io
+        Processors:
+          - name: GrandChildLogger
+            class: org.apache.nifi.processors.standard.LogAttribute
+)";
+
+  std::unique_ptr<core::ProcessGroup> root = yamlConfig.getRootFromPayload(TEST_CONFIG_YAML);
+  REQUIRE(root);
+
+  const auto& definitions = yamlConfig.getThreadPoolDefinitions();
+  REQUIRE(2 == definitions.size());
+  REQUIRE("cpu" == definitions[0].name);
+  REQUIRE(2 == definitions[0].max_threads);
+  REQUIRE((std::vector<int>{0, 2, 3}) == definitions[0].cpu_affinity);
+  REQUIRE("io" == definitions[1].name);
+  REQUIRE(8 == definitions[1].max_threads);
+  REQUIRE(definitions[1].cpu_affinity.empty());
+
+  REQUIRE("cpu" == root->getThreadPoolName());
+  REQUIRE("cpu" == root->findProcessorByName("Generator")->getThreadPoolName());
+  REQUIRE("io" == root->findProcessorByName("Putter")->getThreadPoolName());
+  REQUIRE("cpu" == root->findProcessorByName("ChildLogger")->getThreadPoolName());
+  REQUIRE("io" == root->findProcessorByName("GrandChildLogger")->getThreadPoolName());
+}
+
+TEST_CASE("Test YAML Thread Pool with invalid CPU affinity", "[YamlConfigurationThreadPools]") {
+  TestController test_controller;
+
+  std::shared_ptr<core::Repository> testProvRepo = core::createRepository("provenancerepository", true);
+  std::shared_ptr<core::Repository> testFlowFileRepo = core::createRepository("flowfilerepository", true);
+  std::shared_ptr<minifi::Configure> configuration = std::make_shared<minifi::Configure>();
+  std::shared_ptr<minifi::io::StreamFactory> streamFactory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  core::YamlConfiguration yamlConfig(testProvRepo, testFlowFileRepo, content_repo, streamFactory, configuration);
+
+  static const std::string TEST_CONFIG_YAML =
+      R"(
+Flow Controller:
+  name: MiNiFi Flow
+Thread Pools:
+  - name: cpu
+    max threads: 2
+    cpu affinity: 3-1
+Processors:
+  - name: Generator
+    class: org.apache.nifi.processors.standard.GenerateFlowFile
+)";
+
+  REQUIRE_THROWS_AS(yamlConfig.getRootFromPayload(TEST_CONFIG_YAML), std::invalid_argument);
+}
+
+TEST_CASE("Test YAML Processor with CPU affinity", "[YamlConfigurationThreadPools]") {
+  TestController test_controller;
+
+  std::shared_ptr<core::Repository> testProvRepo = core::createRepository("provenancerepository", true);
+  std::shared_ptr<core::Repository> testFlowFileRepo = core::createRepository("flowfilerepository", true);
+  std::shared_ptr<minifi::Configure> configuration = std::make_shared<minifi::Configure>();
+  std::shared_ptr<minifi::io::StreamFactory> streamFactory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  core::YamlConfiguration yamlConfig(testProvRepo, testFlowFileRepo, content_repo, streamFactory, configuration);
+
+  SECTION("The processor gets a pinned thread pool of its own") {
+    static const std::string TEST_CONFIG_YAML =
+        R"(
+Flow Controller:
+  name: MiNiFi Flow
+Processors:
+  - name: Compressor
+    id: 2438e3c8-015a-1001-79ca-83af40ec1991
+    class: org.apache.nifi.processors.standard.LogAttribute
+    max concurrent tasks: 3
+    cpu affinity: 4-5
+  - name: Logger
+    class: org.apache.nifi.processors.standard.LogAttribute
+)";
+
+    std::unique_ptr<core::ProcessGroup> root = yamlConfig.getRootFromPayload(TEST_CONFIG_YAML);
+    REQUIRE(root);
+
+    const auto& definitions = yamlConfig.getThreadPoolDefinitions();
+    REQUIRE(1 == definitions.size());
+    REQUIRE("processor:2438e3c8-015a-1001-79ca-83af40ec1991" == definitions[0].name);
+    REQUIRE(3 == definitions[0].max_threads);
+    REQUIRE((std::vector<int>{4, 5}) == definitions[0].cpu_affinity);
+    REQUIRE("processor:2438e3c8-015a-1001-79ca-83af40ec1991" == root->findProcessorByName("Compressor")->getThreadPoolName());
+    REQUIRE(root->findProcessorByName("Logger")->getThreadPoolName().empty());
+  }
+
+  SECTION("Pinned processors with the same name get a thread pool each, without shadowing the pool named like them") {
+    static const std::string TEST_CONFIG_YAML =
+        R"(
+Flow Controller:
+  name: MiNiFi Flow
+Thread Pools:
+  - name: io
+    max threads: 2
+Processors:
+  - name: io
+    id: 2438e3c8-015a-1001-79ca-83af40ec1991
+    class: org.apache.nifi.processors.standard.LogAttribute
+    cpu affinity: 4
+  - name: io
+    id: 2438e3c8-015a-1001-79ca-83af40ec1992
+    class: org.apache.nifi.processors.standard.LogAttribute
+    cpu affinity: 5
+)";
+
+    std::unique_ptr<core::ProcessGroup> root = yamlConfig.getRootFromPayload(TEST_CONFIG_YAML);
+    REQUIRE(root);
+
+    const auto& definitions = yamlConfig.getThreadPoolDefinitions();
+    REQUIRE(3 == definitions.size());
+    REQUIRE("io" == definitions[0].name);
+    REQUIRE(2 == definitions[0].max_threads);
+    REQUIRE("processor:2438e3c8-015a-1001-79ca-83af40ec1991" == definitions[1].name);
+    REQUIRE((std::vector<int>{4}) == definitions[1].cpu_affinity);
+    REQUIRE("processor:2438e3c8-015a-1001-79ca-83af40ec1992" == definitions[2].name);
+    REQUIRE((std::vector<int>{5}) == definitions[2].cpu_affinity);
+  }
+
+  SECTION("The thread pools of the flow cannot use the prefix reserved for the pinned processors") {
+    static const std::string TEST_CONFIG_YAML =
+        R"(
+Flow Controller:
+  name: MiNiFi Flow
+Thread Pools:
+  - name: processor:2438e3c8-015a-1001-79ca-83af40ec1991
+    max threads: 2
+Processors:
+  - name: Logger
+    class: org.apache.nifi.processors.standard.LogAttribute
+)";
+
+    REQUIRE_THROWS_AS(yamlConfig.getRootFromPayload(TEST_CONFIG_YAML), std::invalid_argument);
+  }
+
+  SECTION("A processor cannot be bound to a thread pool and pinned at the same time") {
+    static const std::string TEST_CONFIG_YAML =
+        R"(
+Flow Controller:
+  name: MiNiFi Flow
+Thread Pools:
+  - name: io
+    max threads: 2
+Processors:
+  - name: Compressor
+    class: org.apache.nifi.processors.standard.LogAttribute
+    thread pool: io
+    cpu affinity: 4-5
+)";
+
+    REQUIRE_THROWS_AS(yamlConfig.getRootFromPayload(TEST_CONFIG_YAML), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Test YAML Provenance Reporting with an id", "[YamlConfigurationProvenanceReporting]") {
+  TestController test_controller;
+
+  std::shared_ptr<core::Repository> testProvRepo = core::createRepository("provenancerepository", true);
+  std::shared_ptr<core::Repository> testFlowFileRepo = core::createRepository("flowfilerepository", true);
+  std::shared_ptr<minifi::Configure> configuration = std::make_shared<minifi::Configure>();
+  std::shared_ptr<minifi::io::StreamFactory> streamFactory = minifi::io::StreamFactory::getInstance(configuration);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  core::YamlConfiguration yamlConfig(testProvRepo, testFlowFileRepo, content_repo, streamFactory, configuration);
+
+  const auto config = [](const std::string &id) {
+    return R"(
+Flow Controller:
+  name: MiNiFi Flow
+Processors: []
+Provenance Reporting:
+  id: )" + id + R"(
+  scheduling strategy: TIMER_DRIVEN
+  scheduling period: 1 sec
+  url: http://localhost:8080/nifi
+  port uuid: 471deef6-2a6e-4a7d-912a-81cc17e3a204
+  batch size: 100
+)";
+  };
+
+  SECTION("The reporting task keeps the id, and with it its state, across restarts") {
+    std::unique_ptr<core::ProcessGroup> root = yamlConfig.getRootFromPayload(config("5d86c2a4-0172-1000-9a43-0242ac110002"));
+    REQUIRE(root);
+    auto report_task = root->findProcessorByName(core::reporting::SiteToSiteProvenanceReportingTask::ReportTaskName);
+    REQUIRE(report_task);
+    REQUIRE("5d86c2a4-0172-1000-9a43-0242ac110002" == report_task->getUUIDStr());
+  }
+
+  SECTION("An invalid id is rejected") {
+    REQUIRE_THROWS_AS(yamlConfig.getRootFromPayload(config("not an id")), std::invalid_argument);
+  }
+}
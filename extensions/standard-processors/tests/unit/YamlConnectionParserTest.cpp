@@ -110,6 +110,36 @@ TEST_CASE("Connections components are parsed from yaml", "[YamlConfiguration]")
       REQUIRE(false == yaml_connection_parser.getDropEmptyFromYaml());
     }
   }
+  SECTION("Prioritizers are read") {
+    SECTION("Single prioritizer") {
+      YAML::Node connection_node = YAML::Load(std::string { "prioritizers: PriorityAttributePrioritizer\n" });
+      YamlConnectionParser yaml_connection_parser(connection_node, "test_node", parent_ptr, logger);
+      const auto prioritizers = yaml_connection_parser.getPrioritizersFromYaml();
+      REQUIRE(1 == prioritizers.size());
+      REQUIRE(std::dynamic_pointer_cast<core::PriorityAttributePrioritizer>(prioritizers[0]));
+    }
+    SECTION("List of prioritizers") {
+      YAML::Node connection_node = YAML::Load(std::string {
+          "prioritizers:\n"
+          "- org.apache.nifi.prioritizer.NewestFlowFileFirstPrioritizer\n"
+          "- SmallestFlowFileFirstPrioritizer\n" });
+      YamlConnectionParser yaml_connection_parser(connection_node, "test_node", parent_ptr, logger);
+      const auto prioritizers = yaml_connection_parser.getPrioritizersFromYaml();
+      REQUIRE(2 == prioritizers.size());
+      REQUIRE(std::dynamic_pointer_cast<core::NewestFlowFileFirstPrioritizer>(prioritizers[0]));
+      REQUIRE(std::dynamic_pointer_cast<core::SmallestFlowFileFirstPrioritizer>(prioritizers[1]));
+    }
+    SECTION("Unknown prioritizer") {
+      YAML::Node connection_node = YAML::Load(std::string { "prioritizers: NoSuchPrioritizer\n" });
+      YamlConnectionParser yaml_connection_parser(connection_node, "test_node", parent_ptr, logger);
+      REQUIRE_THROWS(yaml_connection_parser.getPrioritizersFromYaml());
+    }
+    SECTION("No prioritizers") {
+      YAML::Node connection_node = YAML::Load(std::string { "drop empty: false\n" });
+      YamlConnectionParser yaml_connection_parser(connection_node, "test_node", parent_ptr, logger);
+      REQUIRE(yaml_connection_parser.getPrioritizersFromYaml().empty());
+    }
+  }
   SECTION("Errors are handled properly when configuration lines are missing") {
     const auto connection = std::make_shared<minifi::Connection>(nullptr, nullptr, "name");
     SECTION("With empty configuration") {
@@ -0,0 +1,84 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CONCURRENCYCONTROLLER_H_
+#define LIBMINIFI_INCLUDE_CONCURRENCYCONTROLLER_H_
+
+#include <chrono>
+#include <memory>
+
+#include "core/Processor.h"
+#include "properties/Configure.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+
+/**
+ * Chooses the number of concurrent tasks of the processors in adaptive concurrency mode. Once per period the
+ * concurrency of each of them is moved by one towards what its incoming queues call for:
+ *  - it grows if the incoming connections are filling up towards their back pressure thresholds, or if processing
+ *    the queued FlowFiles at the measured onTrigger latency would take longer than a period,
+ *  - it shrinks if the backlog can be processed in a fraction of a period,
+ *  - it shrinks regardless of the queues while the process uses more CPU than the configured share of the machine,
+ *    so that adding workers does not oversubscribe it.
+ */
+class ConcurrencyController {
+ public:
+  static constexpr std::chrono::milliseconds DEFAULT_PERIOD{1000};
+  static constexpr int DEFAULT_MAX_CPU_PERCENT = 90;
+  // fill ratio of the incoming connections above which the concurrency grows
+  static constexpr double HIGH_WATERMARK = 0.5;
+  // fill ratio of the incoming connections below which the concurrency may shrink
+  static constexpr double LOW_WATERMARK = 0.1;
+
+  struct Sample {
+    core::Processor::IncomingQueueStatus queue;
+    // average duration of the onTrigger calls since the previous sample, zero if there was none
+    std::chrono::nanoseconds trigger_latency{0};
+    // share of the CPU capacity of the machine used by the process since the previous sample, between 0 and 1
+    double cpu_utilization = 0.0;
+  };
+
+  explicit ConcurrencyController(const std::shared_ptr<Configure> &configuration);
+
+  std::chrono::milliseconds getPeriod() const {
+    return period_;
+  }
+
+  /**
+   * Returns the concurrency for the next period, between min_tasks and max_tasks.
+   */
+  int decide(int current_tasks, int min_tasks, int max_tasks, const Sample &sample) const;
+
+  /**
+   * Returns the share of the CPU capacity of the machine the process used since the previous call.
+   */
+  double measureCpuUtilization();
+
+ private:
+  std::chrono::milliseconds period_;
+  double max_cpu_utilization_;
+  std::chrono::steady_clock::time_point last_wall_time_;
+  std::chrono::nanoseconds last_cpu_time_;
+};
+
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
+#endif  // LIBMINIFI_INCLUDE_CONCURRENCYCONTROLLER_H_
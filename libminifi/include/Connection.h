@@ -28,13 +28,17 @@
 #include <mutex>
 #include <atomic>
 #include <algorithm>
+#include <deque>
+#include <utility>
 #include "core/Core.h"
 #include "core/Connectable.h"
 #include "core/logging/Logger.h"
 #include "core/Relationship.h"
 #include "core/FlowFile.h"
+#include "core/FlowFilePrioritizer.h"
 #include "core/Repository.h"
 #include "utils/FlowFileQueue.h"
+#include "concurrentqueue.h"
 
 namespace org {
 namespace apache {
@@ -44,6 +48,10 @@ namespace minifi {
 
 class Connection : public core::Connectable, public std::enable_shared_from_this<Connection> {
  public:
+  // Once full, the queue has to drain to this fraction of its back pressure thresholds before its source is woken up,
+  // so that a throttled source produces a batch of flow files per wake up instead of a single one
+  static constexpr double BACK_PRESSURE_RESUME_RATIO = 0.8;
+
   // Constructor
   /*
    * Create a new processor
@@ -131,6 +139,28 @@ class Connection : public core::Connectable, public std::enable_shared_from_this
   uint64_t getFlowExpirationDuration() {
     return expired_duration_;
   }
+  /**
+   * Sets the number of flow files kept in memory. The flow files queued beyond it are swapped out,
+   * keeping only their key in the flow file repository, and swapped back in once the queue drains.
+   * 0 disables swapping.
+   */
+  void setSwapThreshold(uint64_t threshold) {
+    swap_threshold_ = threshold;
+  }
+  uint64_t getSwapThreshold() const {
+    return swap_threshold_;
+  }
+  // Get the number of queued flow files that are swapped out
+  uint64_t getSwappedQueueSize();
+
+  /**
+   * Sets the prioritizers deciding the order in which the queued flow files are polled.
+   * An empty list restores the default FIFO order.
+   */
+  void setPrioritizers(std::vector<std::shared_ptr<core::FlowFilePrioritizer>> prioritizers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.setPrioritizers(std::move(prioritizers));
+  }
 
   void setDropEmptyFlowFiles(bool drop) {
     drop_empty_ = drop;
@@ -146,8 +176,7 @@ class Connection : public core::Connectable, public std::enable_shared_from_this
   bool isFull();
   // Get queue size
   uint64_t getQueueSize() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
+    return queued_count_;
   }
   // Get queue data size
   uint64_t getQueueDataSize() {
@@ -161,15 +190,18 @@ class Connection : public core::Connectable, public std::enable_shared_from_this
   void multiPut(std::vector<std::shared_ptr<core::FlowFile>>& flows);
   // Poll the flow file from queue, the expired flow file record also being returned
   std::shared_ptr<core::FlowFile> poll(std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords);
+  /**
+   * Polls up to max flow files from the queue under a single lock, stopping early once the size of the
+   * polled flow files reaches maxBytes. The expired flow file records are also being returned.
+   * @return number of flow files appended to flowFiles
+   */
+  size_t pollBatch(std::vector<std::shared_ptr<core::FlowFile>> &flowFiles, size_t max, uint64_t maxBytes, std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords);
   // Drain the flow records
   void drain(bool delete_permanently);
 
   void yield() override {}
 
-  bool isWorkAvailable() override {
-    const std::lock_guard<std::mutex> lock{mutex_};
-    return queue_.isWorkAvailable();
-  }
+  bool isWorkAvailable() override;
 
   bool isRunning() override {
     return true;
@@ -199,12 +231,53 @@ class Connection : public core::Connectable, public std::enable_shared_from_this
 
  private:
   bool drop_empty_;
-  // Mutex for protection
+  // Mutex for protection of the consumer side: queue_ and swapped_
   mutable std::mutex mutex_;
+  // Number of the flow files in incoming_, queue_ and swapped_
+  std::atomic<uint64_t> queued_count_{0};
   // Queued data size
   std::atomic<uint64_t> queued_data_size_;
+  struct IncomingFlowFile {
+    uint64_t sequence_number;
+    std::shared_ptr<core::FlowFile> flow_file;
+  };
+  // Flow files put by the producers, moved into queue_ by the consumers, so that putting never waits for mutex_
+  moodycamel::ConcurrentQueue<IncomingFlowFile> incoming_;
+  // Numbers the puts, as incoming_ only keeps the order of the flow files put by the same producer
+  std::atomic<uint64_t> next_incoming_sequence_number_{0};
+  // The flow files taken from incoming_ by transferIncoming, kept to reuse its capacity, mutex_ must be held
+  std::vector<IncomingFlowFile> transfer_buffer_;
   // Queue for the Flow File
   utils::FlowFileQueue queue_;
+  // Set once the queue is found full, cleared when its source is notified of the queue having drained
+  std::atomic<bool> back_pressure_applied_{false};
+  // Notify the source if the queue drained below the resume threshold since it was found full, mutex_ must not be held by the caller
+  void checkBackPressureRelieved();
+  // Move the flow files put since the last call from incoming_ to queue_, mutex_ must be held by the caller
+  void transferIncoming();
+  // Poll the next flow file, mutex_ must be held by the caller
+  std::shared_ptr<core::FlowFile> pollLocked(const std::shared_ptr<core::Connectable> &connectable, std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords);
+
+  struct SwappedFlowFile {
+    utils::Identifier uuid;
+    uint64_t size;
+    // the position reserved in queue_, so that the flow file keeps its place in FIFO order once swapped in
+    uint64_t sequence_number;
+    std::shared_ptr<ResourceClaim> claim;
+  };
+  // Flow files beyond swap_threshold_ in queuing order, only referenced by their key in the flow file repository
+  std::deque<SwappedFlowFile> swapped_;
+  std::atomic<uint64_t> swap_threshold_{0};
+  // Number of the flow files being swapped in by the consumers
+  size_t swapping_in_ = 0;
+  // Queue the flow file either in memory or swapped out, mutex_ must be held by the caller
+  void enqueue(const std::shared_ptr<core::FlowFile> &flow);
+  /**
+   * Swap in the oldest swapped out flow files. mutex_ must be held by the caller through lock,
+   * it is released while the flow files are read from the flow file repository.
+   * @return false if there were no swapped out flow files
+   */
+  bool swapIn(std::unique_lock<std::mutex> &lock);
   // flow repository
   // Logger
   std::shared_ptr<logging::Logger> logger_;
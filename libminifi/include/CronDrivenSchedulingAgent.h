@@ -20,10 +20,12 @@
 #ifndef LIBMINIFI_INCLUDE_CRONDRIVENSCHEDULINGAGENT_H_
 #define LIBMINIFI_INCLUDE_CRONDRIVENSCHEDULINGAGENT_H_
 
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "core/logging/Logger.h"
 #include "core/ProcessContext.h"
@@ -31,6 +33,7 @@
 #include "core/ProcessSessionFactory.h"
 #include "Cron.h"
 #include "ThreadedSchedulingAgent.h"
+#include "utils/TimerService.h"
 
 namespace org {
 namespace apache {
@@ -38,6 +41,11 @@ namespace nifi {
 namespace minifi {
 
 // CronDrivenSchedulingAgent Class
+/**
+ * Triggers processors at the times given by their cron expressions. The next fire time of each processor is
+ * precomputed and kept in a TimerService, which wakes up the parked workers of the processor when it is due,
+ * so that the workers of idle cron processors cost nothing between two fire times.
+ */
 class CronDrivenSchedulingAgent : public ThreadedSchedulingAgent {
  public:
   // Constructor
@@ -50,21 +58,45 @@ class CronDrivenSchedulingAgent : public ThreadedSchedulingAgent {
       : ThreadedSchedulingAgent(controller_service_provider, repo, flow_repo, content_repo, configuration, thread_pool) {
   }
   // Destructor
-  virtual ~CronDrivenSchedulingAgent() = default;
+  virtual ~CronDrivenSchedulingAgent();
+
+  /**
+   * Sets the timer service firing the cron schedules, shared with the other timers of the agent.
+   * Without it, a timer service of its own is started when the first processor is scheduled.
+   */
+  void setTimerService(std::shared_ptr<utils::TimerService> timer_service) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timer_service_ = std::move(timer_service);
+  }
+
+  void schedule(std::shared_ptr<core::Processor> processor) override;
+
+  void unschedule(std::shared_ptr<core::Processor> processor) override;
+
   // Run function for the thread
   utils::TaskRescheduleInfo run(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
       const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) override;
 
-  void stop() override {
-    std::lock_guard<std::mutex> locK(mutex_);
-    schedules_.clear();
-    last_exec_.clear();
-  }
+  void stop() override;
 
  private:
+  struct CronSchedule {
+    explicit CronSchedule(const std::string &expression)
+        : cron(expression) {
+    }
+
+    Bosma::Cron cron;
+    utils::TimerService::TimerId timer = 0;
+    // set by the timer, cleared by the worker triggering the processor
+    std::atomic<bool> due{false};
+  };
+
+  // The first time the cron expression matches after from, on the clock of the timer service
+  static utils::TimerService::Clock::time_point nextFireTime(const Bosma::Cron &cron, std::chrono::system_clock::time_point from);
+
   std::mutex mutex_;
-  std::map<utils::Identifier, Bosma::Cron> schedules_;
-  std::map<utils::Identifier, std::chrono::system_clock::time_point> last_exec_;
+  std::shared_ptr<utils::TimerService> timer_service_;
+  std::map<utils::Identifier, std::shared_ptr<CronSchedule>> schedules_;
   // Prevent default copy constructor and assignment operation
   // Only support pass by reference or pointer
   CronDrivenSchedulingAgent(const CronDrivenSchedulingAgent &parent);
@@ -44,8 +44,11 @@
 #include "core/ProcessSession.h"
 #include "core/Property.h"
 #include "core/Relationship.h"
+#include "core/ThreadPoolDefinition.h"
 #include "core/state/nodes/FlowInformation.h"
 #include "core/state/nodes/MetricsBase.h"
+#include "core/state/nodes/ProcessorProfileMetrics.h"
+#include "core/state/nodes/ThreadPoolMetrics.h"
 #include "core/state/UpdateController.h"
 #include "c2/C2Client.h"
 #include "CronDrivenSchedulingAgent.h"
@@ -85,7 +88,7 @@ class FlowController : public core::controller::ForwardingControllerServiceProvi
   ~FlowController() override;
 
   // Get the provenance repository
-  virtual std::shared_ptr<core::Repository> getProvenanceRepository() {
+  std::shared_ptr<core::Repository> getProvenanceRepository() override {
     return this->provenance_repo_;
   }
 
@@ -206,6 +209,21 @@ class FlowController : public core::controller::ForwardingControllerServiceProvi
 
   utils::optional<std::chrono::milliseconds> loadShutdownTimeoutFromConfiguration();
 
+  std::vector<std::shared_ptr<state::response::ResponseNode>> getComponentMetricsNodes() const override;
+
+  std::shared_ptr<state::response::ResponseNode> getMetricsNode(const std::string& name) const override;
+
+  /**
+   * Returns the thread pools declared in minifi.properties and in the flow, the latter taking precedence.
+   */
+  std::vector<core::ThreadPoolDefinition> getThreadPoolDefinitions();
+  /**
+   * (Re)creates the named thread pools, binds them to the scheduling agents and registers them in the metrics.
+   */
+  void reloadThreadPools(const std::shared_ptr<core::controller::ControllerServiceProvider> &controller_service_provider);
+  std::vector<int> getCpuAffinity(const std::string &property);
+  std::string getStrategyThreadPool(const char *property);
+
  private:
   template <typename T, typename = typename std::enable_if<std::is_base_of<SchedulingAgent, T>::value>::type>
   void conditionalReloadScheduler(std::shared_ptr<T>& scheduler, const bool condition) {
@@ -226,6 +244,13 @@ class FlowController : public core::controller::ForwardingControllerServiceProvi
   std::atomic<bool> initialized_;
   // Thread pool for schedulers
   utils::ThreadPool<utils::TaskRescheduleInfo> thread_pool_;
+  // Named thread pools processors and process groups can be bound to. Pools dropped from the configuration are
+  // only shut down, as the scheduling agents and the metrics keep pointers to them.
+  std::map<std::string, std::unique_ptr<utils::ThreadPool<utils::TaskRescheduleInfo>>> thread_pools_;
+  // the named thread pools of the current configuration
+  std::map<std::string, utils::ThreadPool<utils::TaskRescheduleInfo>*> active_thread_pools_;
+  std::shared_ptr<state::response::ThreadPoolMetrics> thread_pool_metrics_;
+  std::shared_ptr<state::response::ProcessorProfileMetrics> processor_profile_metrics_;
   // Flow Timer Scheduler
   std::shared_ptr<TimerDrivenSchedulingAgent> timer_scheduler_;
   // Flow Event Scheduler
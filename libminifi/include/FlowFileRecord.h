@@ -58,6 +58,11 @@ class FlowFileRecord : public core::FlowFile {
  public:
   FlowFileRecord();
 
+  /**
+   * Serializes the record in the compact format: the fields are varint encoded, the common attribute
+   * keys are replaced by their index in a fixed dictionary and the content path is stored relative to
+   * the storage path of the content repository. DeSerialize reads both this and the legacy format.
+   */
   bool Serialize(io::OutputStream &outStream);
 
   //! Serialize and Persistent to the repository
@@ -82,6 +87,10 @@ class FlowFileRecord : public core::FlowFile {
   static std::atomic<uint64_t> local_flow_seq_number_;
 
  private:
+  static std::shared_ptr<FlowFileRecord> DeSerializeCompact(io::InputStream &inStream, const std::shared_ptr<core::ContentRepository> &content_repo, utils::Identifier& container);
+  static std::shared_ptr<FlowFileRecord> DeSerializeLegacy(uint8_t first_byte, io::InputStream &inStream, const std::shared_ptr<core::ContentRepository> &content_repo,
+      utils::Identifier& container);
+
   static std::shared_ptr<logging::Logger> logger_;
 };
 
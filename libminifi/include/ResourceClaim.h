@@ -78,6 +78,23 @@ class ResourceClaim {
     return _contentFullPath;
   }
 
+  // Get the directory of the claims created by the owning manager
+  std::string getStoragePath() const {
+    return claim_manager_ ? claim_manager_->getStoragePath() : "";
+  }
+
+  /**
+   * Marks the claim as holding the contents of several FlowFiles, each of which refers to a slice of it.
+   * The mark is not persisted, claims recovered from the FlowFile repository are not marked.
+   */
+  void setPacked() {
+    packed_ = true;
+  }
+
+  bool isPacked() const {
+    return packed_;
+  }
+
   bool exists() {
     if (claim_manager_ == nullptr) {
       return false;
@@ -101,6 +118,8 @@ class ResourceClaim {
 
   std::shared_ptr<core::StreamManager<ResourceClaim>> claim_manager_;
 
+  std::atomic<bool> packed_{false};
+
  private:
   // Logger
   std::shared_ptr<logging::Logger> logger_;
@@ -28,7 +28,9 @@
 #include <mutex>
 #include <atomic>
 #include <algorithm>
+#include <functional>
 #include <thread>
+#include <utility>
 #include "utils/CallBackTimer.h"
 #include "utils/Monitors.h"
 #include "utils/TimeUtil.h"
@@ -89,6 +91,13 @@ class SchedulingAgent {
 
   // onTrigger, return whether the yield is need
   bool onTrigger(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext, const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory);
+  /**
+   * Triggers the processor repeatedly until its run duration elapses, it yields or it runs out of work. Processors
+   * supporting batching share one session across these calls. Returns whether the yield is needed, i.e. whether
+   * the first trigger found nothing to do.
+   */
+  bool onTriggerForRunDuration(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
+      const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory);
   // Whether agent has work to do
   bool hasWorkToDo(const std::shared_ptr<core::Processor>& processor);
   // Whether the outgoing need to be backpressure
@@ -107,6 +116,16 @@ class SchedulingAgent {
 
   virtual std::future<utils::TaskRescheduleInfo> enableControllerService(std::shared_ptr<core::controller::ControllerServiceNode> &serviceNode);
   virtual std::future<utils::TaskRescheduleInfo> disableControllerService(std::shared_ptr<core::controller::ControllerServiceNode> &serviceNode);
+  /**
+   * Sets the named thread pools processors can be bound to. Processors which are not bound to any of them run in
+   * the pool named default_pool_name, or in the thread pool of the agent if that is empty. Must be called before
+   * scheduling processors.
+   */
+  void setThreadPools(std::map<std::string, utils::ThreadPool<utils::TaskRescheduleInfo>*> thread_pools, const std::string &default_pool_name = "") {
+    thread_pools_ = std::move(thread_pools);
+    default_thread_pool_name_ = default_pool_name;
+  }
+
   // schedule, overwritten by different DrivenSchedulingAgent
   virtual void schedule(std::shared_ptr<core::Processor> processor) = 0;
   // unschedule, overwritten by different DrivenSchedulingAgent
@@ -116,6 +135,9 @@ class SchedulingAgent {
   SchedulingAgent &operator=(const SchedulingAgent &parent) = delete;
 
  protected:
+  // Runs trigger in place of the onTrigger of the processor, with the checks and the bookkeeping around it
+  bool triggerProcessor(const std::shared_ptr<core::Processor> &processor, const std::function<void()> &trigger);
+
   // Mutex for protection
   std::mutex mutex_;
   // Whether it is running
@@ -137,6 +159,12 @@ class SchedulingAgent {
   // controller service provider reference
   gsl::not_null<core::controller::ControllerServiceProvider*> controller_service_provider_;
 
+  /**
+   * Returns the thread pool the processor is bound to, falling back to thread_pool_ if there is no
+   * such pool.
+   */
+  utils::ThreadPool<utils::TaskRescheduleInfo>& getThreadPool(const core::Processor& processor);
+
  private:
   struct SchedulingInfo {
     std::chrono::time_point<std::chrono::steady_clock> start_time_ = std::chrono::steady_clock::now();
@@ -160,6 +188,10 @@ class SchedulingAgent {
   std::set<SchedulingInfo> scheduled_processors_;  // set was chosen to avoid iterator invalidation
   std::unique_ptr<utils::CallBackTimer> watchDogTimer_;
   std::chrono::milliseconds alert_time_;
+  // named thread pools, by name
+  std::map<std::string, utils::ThreadPool<utils::TaskRescheduleInfo>*> thread_pools_;
+  // pool of the processors which are not bound to any
+  std::string default_thread_pool_name_;
 };
 
 }  // namespace minifi
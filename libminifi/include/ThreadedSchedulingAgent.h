@@ -20,8 +20,9 @@
 #ifndef LIBMINIFI_INCLUDE_THREADEDSCHEDULINGAGENT_H_
 #define LIBMINIFI_INCLUDE_THREADEDSCHEDULINGAGENT_H_
 
+#include <atomic>
 #include <memory>
-#include <set>
+#include <map>
 #include <string>
 #include <chrono>
 #include "properties/Configure.h"
@@ -29,7 +30,12 @@
 #include "core/Processor.h"
 #include "core/Repository.h"
 #include "core/ProcessContext.h"
+#include "ConcurrencyController.h"
 #include "SchedulingAgent.h"
+#include "utils/CallBackTimer.h"
+
+// Upper bound on parking, so that work or drained connections not announced to the processor (e.g. expiring penalties) are picked up eventually
+#define MAX_PARK_TIME_MS 1000
 
 namespace org {
 namespace apache {
@@ -51,10 +57,14 @@ class ThreadedSchedulingAgent : public SchedulingAgent {
         std::shared_ptr<core::Repository> flow_repo, std::shared_ptr<core::ContentRepository> content_repo,
         std::shared_ptr<Configure> configuration,  utils::ThreadPool<utils::TaskRescheduleInfo> &thread_pool)
       : SchedulingAgent(controller_service_provider, repo, flow_repo, content_repo, configuration, thread_pool),
-        logger_(logging::LoggerFactory<ThreadedSchedulingAgent>::getLogger()) {
+        logger_(logging::LoggerFactory<ThreadedSchedulingAgent>::getLogger()),
+        concurrency_controller_(configuration) {
   }
   // Destructor
-  virtual ~ThreadedSchedulingAgent() = default;
+  virtual ~ThreadedSchedulingAgent() {
+    // the timer has to be stopped before the members it uses are destroyed
+    concurrency_timer_.reset();
+  }
 
   // Run function for the thread
   virtual utils::TaskRescheduleInfo run(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
@@ -73,9 +83,32 @@ class ThreadedSchedulingAgent : public SchedulingAgent {
   // Only support pass by reference or pointer
   ThreadedSchedulingAgent(const ThreadedSchedulingAgent &parent);
   ThreadedSchedulingAgent &operator=(const ThreadedSchedulingAgent &parent);
+  struct ScheduledProcessor {
+    std::shared_ptr<core::Processor> processor;
+    std::shared_ptr<core::ProcessContext> context;
+    std::shared_ptr<core::ProcessSessionFactory> session_factory;
+    utils::ThreadPool<utils::TaskRescheduleInfo>* thread_pool;
+    // number of workers submitted to the thread pool, they retire while it is above the concurrency of the processor
+    std::atomic<int> workers{0};
+    // onTrigger statistics at the previous concurrency adjustment
+    uint64_t last_trigger_count = 0;
+    std::chrono::nanoseconds last_trigger_duration{0};
+  };
+
+  void submitWorker(const std::shared_ptr<ScheduledProcessor>& scheduled);
+
+  /**
+   * Adjusts the concurrency of the processors in adaptive concurrency mode, called periodically by concurrency_timer_.
+   */
+  void adjustConcurrency();
+
   std::shared_ptr<logging::Logger> logger_;
 
-  std::set<utils::Identifier> processors_running_;  // Set just for easy usage
+  std::map<utils::Identifier, std::shared_ptr<ScheduledProcessor>> processors_running_;
+
+  ConcurrencyController concurrency_controller_;
+  // created when the first processor in adaptive concurrency mode is scheduled
+  std::unique_ptr<utils::CallBackTimer> concurrency_timer_;
 };
 
 }  // namespace minifi
@@ -40,6 +40,7 @@
 #include "utils/Id.h"
 #include "utils/MinifiConcurrentQueue.h"
 #include "utils/ThreadPool.h"
+#include "utils/TimerService.h"
 #include "utils/file/FileSystem.h"
 
 namespace org {
@@ -68,8 +69,12 @@ class C2Agent : public state::UpdateController {
           state::Pausable *pause_handler,
           const std::shared_ptr<state::StateMonitor> &updateSink,
           const std::shared_ptr<Configure> &configure,
-          const std::shared_ptr<utils::file::FileSystem> &filesystem = std::make_shared<utils::file::FileSystem>());
+          const std::shared_ptr<utils::file::FileSystem> &filesystem = std::make_shared<utils::file::FileSystem>(),
+          std::shared_ptr<utils::TimerService> timer_service = nullptr);
   virtual ~C2Agent() noexcept {
+    if (heartbeat_timer_ != 0) {
+      timer_service_->cancel(heartbeat_timer_);
+    }
     delete protocol_.load();
   }
 
@@ -239,6 +244,11 @@ class C2Agent : public state::UpdateController {
 
   std::vector<utils::Identifier> task_ids_;
 
+  // fires the heartbeats at a steady pace when set, otherwise the producer reschedules itself
+  std::shared_ptr<utils::TimerService> timer_service_;
+
+  std::atomic<utils::TimerService::TimerId> heartbeat_timer_{0};
+
   bool manifest_sent_;
 
   const uint64_t C2RESPONSE_POLL_MS = 100;
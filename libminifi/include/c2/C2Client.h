@@ -28,6 +28,7 @@
 #include "properties/Configure.h"
 #include "core/logging/Logger.h"
 #include "core/state/nodes/MetricsBase.h"
+#include "utils/TimerService.h"
 #include "core/Repository.h"
 #include "core/ContentRepository.h"
 #include "core/ProcessGroup.h"
@@ -59,6 +60,13 @@ class C2Client : public core::Flow, public state::response::NodeReporter {
  protected:
   bool isC2Enabled() const;
   utils::optional<std::string> fetchFlow(const std::string& uri) const;
+  /**
+   * Returns the metrics of the components owned by the agent itself (rather than by the flow), which can be
+   * referenced by name in the C2 response node definitions just like the metrics of the processors.
+   */
+  virtual std::vector<std::shared_ptr<state::response::ResponseNode>> getComponentMetricsNodes() const {
+    return {};
+  }
 
  private:
   void initializeComponentMetrics();
@@ -68,6 +76,8 @@ class C2Client : public core::Flow, public state::response::NodeReporter {
  protected:
   std::shared_ptr<Configure> configuration_;
   std::shared_ptr<utils::file::FileSystem> filesystem_;
+  // Fires the timers of the agent, i.e. the C2 heartbeats and the cron schedules of the processors
+  std::shared_ptr<utils::TimerService> timer_service_;
 
  private:
   std::unique_ptr<C2Agent> c2_agent_;
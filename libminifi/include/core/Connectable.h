@@ -26,6 +26,7 @@
 #include <set>
 #include <unordered_set>
 #include <unordered_map>
+#include <functional>
 #include "Core.h"
 #include <condition_variable>
 #include "core/logging/Logger.h"
@@ -136,6 +137,37 @@ class Connectable : public CoreComponent {
 
   void notifyWork();
 
+  /**
+   * Sets the callback used to wake up this connectable once it has been parked.
+   * @param wake_up_callback invoked by notifyWork() from the producer's thread; an empty function disables waking up
+   */
+  void setWakeUpCallback(std::function<void()> wake_up_callback);
+
+  /**
+   * Parks this connectable: the next notifyWork() that finds work available will invoke the wake up callback.
+   * @return false if work became available in the meantime and the caller should carry on instead of parking
+   */
+  bool park();
+
+  /**
+   * Whether an outgoing connection of this connectable is full, so that it should not produce any more for now.
+   */
+  virtual bool isThrottledByBackpressure() const {
+    return false;
+  }
+
+  /**
+   * Parks this connectable while it is throttled by back pressure: the next notifyBackPressureRelieved() will invoke
+   * the wake up callback.
+   * @return false if the back pressure was relieved in the meantime and the caller should carry on instead of parking
+   */
+  bool parkOnBackPressure();
+
+  /**
+   * Notify this connectable that an outgoing connection drained below its resume threshold
+   */
+  void notifyBackPressureRelieved();
+
   /**
    * Determines if work is available by this connectable
    * @return boolean if work is available.
@@ -190,10 +222,19 @@ class Connectable : public CoreComponent {
   std::atomic<SchedulingStrategy> strategy_;
   // Concurrent condition variable for whether there is incoming work to do
   std::condition_variable work_condition_;
+  // Whether the scheduler is waiting for a notification before running this connectable again
+  std::atomic<bool> parked_{false};
+  // Set while parked by parkOnBackPressure(), kept apart from parked_ so that incoming work does not wake up a throttled connectable
+  std::atomic<bool> parked_on_back_pressure_{false};
+  // Reschedules this connectable once it is parked, guarded by work_available_mutex_
+  std::function<void()> wake_up_callback_;
   // version under which this connectable was created.
   std::shared_ptr<state::FlowIdentifier> connectable_version_;
 
  private:
+  // Invokes the wake up callback, if any
+  void wakeUp();
+
   std::shared_ptr<logging::Logger> logger_;
 };
 
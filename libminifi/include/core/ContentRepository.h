@@ -42,6 +42,10 @@ namespace core {
  */
 class ContentRepository : public StreamManager<minifi::ResourceClaim>, public utils::EnableSharedFromThis<ContentRepository> {
  public:
+  static constexpr const char *STAGING_EXTENSION = ".staging";
+  static constexpr size_t DEFAULT_SESSION_BUFFER_SIZE = 64 * 1024;
+  static constexpr uint64_t DEFAULT_MAX_FLOW_FILES_PER_CLAIM = 100;
+
   virtual ~ContentRepository() = default;
 
   /**
@@ -66,9 +70,61 @@ class ContentRepository : public StreamManager<minifi::ResourceClaim>, public ut
 
   virtual StreamState decrementStreamCount(const minifi::ResourceClaim &streamId);
 
+  /**
+   * Creates the claim into which a streaming session stages the content written to
+   * (or appended to) the given claim until the session is committed.
+   * @param claim claim the session writes to
+   * @param append true if the staged content will be appended to existing content
+   * @return staging claim, which is not reference counted by this repository
+   */
+  virtual std::shared_ptr<minifi::ResourceClaim> createStagingClaim(const std::shared_ptr<minifi::ResourceClaim> &claim, bool append);
+
+  /**
+   * Makes the staged content visible under the target claim and releases the staging claim.
+   * The default implementation streams the staged content into the target.
+   * @param staging claim returned by createStagingClaim
+   * @param target claim the content is published to
+   * @param append true if the staged content is appended to the existing content of target
+   * @return result of operation.
+   */
+  virtual bool publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append);
+
+  /**
+   * Called before a FlowFile referencing the claim is persisted to a durable FlowFile repository,
+   * repositories which keep content in memory write it to durable storage here.
+   * @param claim claim referenced by the persisted FlowFile
+   */
+  virtual void makeDurable(const minifi::ResourceClaim& /*claim*/) {
+  }
+
+  /**
+   * Sessions pack new contents into a shared claim until it reaches this size, 0 disables packing.
+   */
+  uint64_t getMaxAppendableClaimSize() const {
+    return max_appendable_claim_size_;
+  }
+
+  uint64_t getMaxFlowFilesPerClaim() const {
+    return max_flow_files_per_claim_;
+  }
+
  protected:
+  /**
+   * Reads the content session options from the configuration, repositories that
+   * support streaming sessions call this from initialize.
+   */
+  void initializeSessionOptions(const Configure &configure);
+
   std::string directory_;
 
+  bool streaming_sessions_ = false;
+
+  size_t session_buffer_size_ = DEFAULT_SESSION_BUFFER_SIZE;
+
+  uint64_t max_appendable_claim_size_ = 0;
+
+  uint64_t max_flow_files_per_claim_ = DEFAULT_MAX_FLOW_FILES_PER_CLAIM;
+
   std::mutex count_map_mutex_;
 
   std::map<std::string, uint32_t> count_map_;
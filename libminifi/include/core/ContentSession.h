@@ -40,15 +40,25 @@ class ContentSession {
 
   explicit ContentSession(std::shared_ptr<ContentRepository> repository);
 
-  std::shared_ptr<ResourceClaim> create();
+  virtual std::shared_ptr<ResourceClaim> create();
 
-  std::shared_ptr<io::BaseStream> write(const std::shared_ptr<ResourceClaim>& resourceId, WriteMode mode = WriteMode::OVERWRITE);
+  virtual std::shared_ptr<io::BaseStream> write(const std::shared_ptr<ResourceClaim>& resourceId, WriteMode mode = WriteMode::OVERWRITE);
 
-  std::shared_ptr<io::BaseStream> read(const std::shared_ptr<ResourceClaim>& resourceId);
+  virtual std::shared_ptr<io::BaseStream> read(const std::shared_ptr<ResourceClaim>& resourceId);
+
+  /**
+   * Reads the content written to a resource created by this session, which is not yet committed.
+   */
+  virtual std::shared_ptr<io::BaseStream> readOwned(const std::shared_ptr<ResourceClaim>& resourceId);
+
+  /**
+   * Returns whether the resource was created by this session, in which case its stream holds the whole content.
+   */
+  virtual bool owns(const std::shared_ptr<ResourceClaim>& resourceId) const;
 
   virtual void commit();
 
-  void rollback();
+  virtual void rollback();
 
   virtual ~ContentSession() = default;
 
@@ -37,6 +37,7 @@
 #include "core/ProcessContext.h"
 #include "core/ProcessSession.h"
 #include "core/ProcessGroup.h"
+#include "core/ThreadPoolDefinition.h"
 #include "io/StreamFactory.h"
 #include "core/state/nodes/FlowInformation.h"
 #include "utils/file/FileSystem.h"
@@ -145,6 +146,13 @@ class FlowConfiguration : public CoreComponent {
     return nullptr;
   }
 
+  /**
+   * Returns the thread pools declared in the last parsed flow.
+   */
+  const std::vector<ThreadPoolDefinition>& getThreadPoolDefinitions() const {
+    return thread_pool_definitions_;
+  }
+
   std::shared_ptr<core::controller::StandardControllerServiceProvider> &getControllerServiceProvider() {
     return service_provider_;
   }
@@ -185,6 +193,8 @@ class FlowConfiguration : public CoreComponent {
   std::shared_ptr<io::StreamFactory> stream_factory_;
   std::shared_ptr<Configure> configuration_;
   std::shared_ptr<state::response::FlowVersion> flow_version_;
+  // thread pools declared in the flow
+  std::vector<ThreadPoolDefinition> thread_pool_definitions_;
 
   std::shared_ptr<utils::file::FileSystem> filesystem_;
 
@@ -159,7 +159,7 @@ class FlowFile : public CoreComponent, public ReferenceContainer {
    * setAttribute, if attribute already there, update it, else, add it
    */
   bool setAttribute(const std::string& key, const std::string& value) {
-    return attributes_.insert_or_assign(key, value).second;
+    return getMutableAttributes().insert_or_assign(key, value).second;
   }
 
   /**
@@ -167,15 +167,21 @@ class FlowFile : public CoreComponent, public ReferenceContainer {
    * @return attributes.
    */
   std::map<std::string, std::string> getAttributes() const {
-    return {attributes_.begin(), attributes_.end()};
+    return {attributes_->begin(), attributes_->end()};
   }
 
   /**
-   * Returns the map of attributes
-   * @return attributes.
+   * Returns the map of attributes without copying it, valid until the attributes are modified
    */
-  AttributeMap *getAttributesPtr() {
-    return &attributes_;
+  const AttributeMap& getAttributeMap() const {
+    return *attributes_;
+  }
+
+  /**
+   * Returns the attributes as they are now, shared with the record until it modifies them
+   */
+  std::shared_ptr<const AttributeMap> getAttributeSnapshot() const {
+    return attributes_;
   }
 
   /**
@@ -248,6 +254,11 @@ class FlowFile : public CoreComponent, public ReferenceContainer {
   }
 
  protected:
+  /**
+   * Returns the attributes for modification, copying them first if they are shared with another record
+   */
+  AttributeMap& getMutableAttributes();
+
   bool stored;
   // Mark for deletion
   bool marked_delete_;
@@ -268,8 +279,8 @@ class FlowFile : public CoreComponent, public ReferenceContainer {
   uint64_t offset_;
   // Penalty expiration
   std::chrono::time_point<std::chrono::steady_clock> to_be_processed_after_;
-  // Attributes key/values pairs for the flow record
-  AttributeMap attributes_;
+  // Attributes key/values pairs for the flow record, shared with the copies of the record until either of them is modified
+  std::shared_ptr<AttributeMap> attributes_;
   // Pointer to the associated content resource claim
   std::shared_ptr<ResourceClaim> claim_;
   // Pointers to stashed content resource claims
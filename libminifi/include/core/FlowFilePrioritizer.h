@@ -0,0 +1,110 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "core/FlowFile.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+/**
+ * Decides the order in which the FlowFiles queued in a connection are handed to the downstream processor.
+ * Prioritizers can be chained: when a prioritizer considers two FlowFiles equal, the next one in the chain
+ * decides, and if none of them can, the FlowFiles are polled in the order they were queued.
+ */
+class FlowFilePrioritizer {
+ public:
+  virtual ~FlowFilePrioritizer() = default;
+
+  /**
+   * Returns a negative value if left should be polled before right, a positive value if right should
+   * be polled first, and 0 if this prioritizer has no preference.
+   */
+  virtual int compare(const FlowFile& left, const FlowFile& right) const = 0;
+
+  /**
+   * Creates a prioritizer from its name, as used in the flow configuration (e.g. "PriorityAttributePrioritizer").
+   * The org.apache.nifi.prioritizer. package prefix of the NiFi prioritizers is accepted, too.
+   * @return nullptr if there is no prioritizer with the given name
+   */
+  static std::shared_ptr<FlowFilePrioritizer> create(const std::string& name);
+};
+
+/**
+ * Polls FlowFiles in the order they were queued. This is the default behavior of connections, so using it at the end
+ * of a chain is a noop; it exists so that flows exported from NiFi can be loaded as-is.
+ */
+class FirstInFirstOutPrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& /*left*/, const FlowFile& /*right*/) const override {
+    return 0;
+  }
+};
+
+/**
+ * Polls the FlowFile with the oldest lineage first.
+ */
+class OldestFlowFileFirstPrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& left, const FlowFile& right) const override;
+};
+
+/**
+ * Polls the FlowFile with the newest lineage first.
+ */
+class NewestFlowFileFirstPrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& left, const FlowFile& right) const override;
+};
+
+/**
+ * Polls FlowFiles by their "priority" attribute. FlowFiles having the attribute come before the ones that don't,
+ * numeric values are compared numerically (lower value first) and come before non-numeric ones, which are compared
+ * lexicographically.
+ */
+class PriorityAttributePrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& left, const FlowFile& right) const override;
+};
+
+/**
+ * Polls the FlowFile with the smallest content first.
+ */
+class SmallestFlowFileFirstPrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& left, const FlowFile& right) const override;
+};
+
+/**
+ * Polls the FlowFile with the largest content first.
+ */
+class LargestFlowFileFirstPrioritizer : public FlowFilePrioritizer {
+ public:
+  int compare(const FlowFile& left, const FlowFile& right) const override;
+};
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -157,6 +157,17 @@ class ProcessGroup : public CoreComponent {
     return onschedule_retry_msec_;
   }
 
+  /**
+   * Sets the thread pool the processors of this group are bound to, unless they name one themselves.
+   */
+  void setThreadPoolName(const std::string &name) {
+    thread_pool_name_ = name;
+  }
+
+  const std::string& getThreadPoolName() const {
+    return thread_pool_name_;
+  }
+
   // getVersion
   int getVersion() {
     return config_version_;
@@ -259,6 +270,8 @@ class ProcessGroup : public CoreComponent {
   std::atomic<uint64_t> yield_period_msec_;
   std::atomic<uint64_t> timeOut_;
   std::atomic<int64_t> onschedule_retry_msec_;
+  // thread pool of the processors in this group
+  std::string thread_pool_name_;
 
   // URL
   std::string url_;
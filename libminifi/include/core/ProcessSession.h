@@ -28,6 +28,7 @@
 #include <atomic>
 #include <algorithm>
 #include <set>
+#include <limits>
 
 #include "ProcessContext.h"
 #include "FlowFileRecord.h"
@@ -51,14 +52,7 @@ class ProcessSession : public ReferenceContainer {
   /*!
    * Create a new process session
    */
-  ProcessSession(std::shared_ptr<ProcessContext> processContext = nullptr) // NOLINT
-      : process_context_(std::move(processContext)),
-        logger_(logging::LoggerFactory<ProcessSession>::getLogger()) {
-    logger_->log_trace("ProcessSession created for %s", process_context_->getProcessorNode()->getName());
-    auto repo = process_context_->getProvenanceRepository();
-    provenance_report_ = std::make_shared<provenance::ProvenanceReporter>(repo, process_context_->getProcessorNode()->getName(), process_context_->getProcessorNode()->getName());
-    content_session_ = process_context_->getContentRepository()->createSession();
-  }
+  ProcessSession(std::shared_ptr<ProcessContext> processContext = nullptr); // NOLINT
 
   // Destructor
   virtual ~ProcessSession();
@@ -76,6 +70,11 @@ class ProcessSession : public ReferenceContainer {
 
   // Get the FlowFile from the highest priority queue
   virtual std::shared_ptr<core::FlowFile> get();
+  /**
+   * Gets up to max FlowFiles from the incoming connections, polling each connection under a single lock.
+   * Stops early once the size of the FlowFiles reaches maxBytes.
+   */
+  std::vector<std::shared_ptr<core::FlowFile>> get(size_t max, uint64_t maxBytes = (std::numeric_limits<uint64_t>::max)());
   // Create a new UUID FlowFile with no content resource claim and inherit all attributes from parent
   std::shared_ptr<core::FlowFile> create(const std::shared_ptr<core::FlowFile> &parent = {});
   // Add a FlowFile to the session
@@ -171,11 +170,35 @@ class ProcessSession : public ReferenceContainer {
       std::map<std::shared_ptr<Connectable>, std::vector<std::shared_ptr<core::FlowFile>>>& transactionMap,
       const std::map<utils::Identifier, FlowFileUpdate>& modifiedFlowFiles);
 
+  // Reports and deletes the expired FlowFiles polled from a connection
+  void expire(const std::set<std::shared_ptr<core::FlowFile>> &expired);
+
+  // Takes a snapshot of the FlowFile polled from a connection, so that it can be restored on rollback
+  void addPolledFlowFile(const std::shared_ptr<core::FlowFile> &flow);
+
   void ensureNonNullResourceClaim(
       const std::map<std::shared_ptr<Connectable>, std::vector<std::shared_ptr<core::FlowFile>>>& transactionMap);
 
   // Clone the flow file during transfer to multiple connections for a relationship
   std::shared_ptr<core::FlowFile> cloneDuringTransfer(const std::shared_ptr<core::FlowFile> &parent);
+
+  /**
+   * Returns the claim new contents are packed into, or nullptr if the content should get a claim of its own.
+   */
+  std::shared_ptr<ResourceClaim> getPackedClaim();
+
+  /**
+   * Returns whether the content of a FlowFile with a claim not created by this session is followed
+   * by other contents in its claim, so that appending to the claim would not extend the content.
+   */
+  bool isSharedContent(const std::shared_ptr<core::FlowFile> &flow);
+
+  /**
+   * Moves the content of a FlowFile out of the packed claim to a new claim, so that it can be appended to.
+   */
+  void unpackContent(const std::shared_ptr<core::FlowFile> &flow);
+
+  void releasePackedClaims();
   // ProcessContext
   std::shared_ptr<ProcessContext> process_context_;
   // Logger
@@ -185,6 +208,14 @@ class ProcessSession : public ReferenceContainer {
 
   std::shared_ptr<ContentSession> content_session_;
 
+  // Claim shared by the small contents written in this session, see nifi.content.claim.max.appendable.size
+  std::shared_ptr<ResourceClaim> packed_claim_;
+  uint64_t packed_claim_flow_files_ = 0;
+  // set while a content is being written to the packed claim
+  bool packing_ = false;
+  // The claims not created by this session which contents were appended to since the last commit
+  std::set<std::shared_ptr<ResourceClaim>> extended_claims_;
+
   static std::shared_ptr<utils::IdGenerator> id_generator_;
 };
 
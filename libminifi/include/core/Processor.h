@@ -44,6 +44,7 @@
 #include "ProcessContext.h"
 #include "ProcessSession.h"
 #include "ProcessSessionFactory.h"
+#include "ProcessorProfile.h"
 #include "Property.h"
 #include "Relationship.h"
 #include "Scheduling.h"
@@ -150,6 +151,77 @@ class Processor : public Connectable, public ConfigurableComponent, public std::
   uint8_t getMaxConcurrentTasks() const {
     return (max_concurrent_tasks_);
   }
+  /**
+   * Sets the lower bound of the concurrent tasks in adaptive concurrency mode, which is enabled
+   * by a minimum lower than the maximum concurrent tasks. Zero disables the adaptive mode.
+   */
+  void setMinConcurrentTasks(uint8_t tasks) {
+    min_concurrent_tasks_ = tasks;
+  }
+  uint8_t getMinConcurrentTasks() const {
+    return min_concurrent_tasks_;
+  }
+  bool isAdaptiveConcurrency() const {
+    return min_concurrent_tasks_ > 0 && min_concurrent_tasks_ < getMaxConcurrentTasks();
+  }
+  /**
+   * The number of concurrent tasks chosen by the scheduling agent, zero when the processor is not scheduled.
+   */
+  void setConcurrentTasks(uint8_t tasks) {
+    concurrent_tasks_ = tasks;
+  }
+  uint8_t getConcurrentTasks() const {
+    return concurrent_tasks_;
+  }
+  // Profile of the onTrigger calls and session commits of the processor
+  ProcessorProfile& getProfile() {
+    return profile_;
+  }
+  const ProcessorProfile& getProfile() const {
+    return profile_;
+  }
+  // Number of onTrigger calls since the processor was created
+  uint64_t getTriggerCount() const {
+    return profile_.getTriggerLatency().getCount();
+  }
+  // Total duration of the onTrigger calls since the processor was created
+  std::chrono::nanoseconds getTotalTriggerDuration() const {
+    return std::chrono::nanoseconds(profile_.getTriggerLatency().getSum());
+  }
+
+  struct IncomingQueueStatus {
+    uint64_t size = 0;
+    uint64_t data_size = 0;
+    // fullness of the fullest incoming connection relative to its back pressure thresholds
+    double fill_ratio = 0.0;
+  };
+  // Returns the amount of FlowFiles waiting in the incoming connections
+  IncomingQueueStatus getIncomingQueueStatus();
+
+  /**
+   * Binds the processor to the named thread pool of the flow controller, an empty name
+   * stands for the pool of its scheduling strategy.
+   */
+  void setThreadPoolName(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_pool_name_ = name;
+  }
+
+  std::string getThreadPoolName() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thread_pool_name_;
+  }
+
+  /**
+   * How much provenance the sessions of the processor record, set before it is scheduled.
+   */
+  void setProvenanceGranularity(provenance::ProvenanceGranularity granularity) {
+    provenance_granularity_ = granularity;
+  }
+
+  provenance::ProvenanceGranularity getProvenanceGranularity() const {
+    return provenance_granularity_;
+  }
   // Set Trigger when empty
   void setTriggerWhenEmpty(bool value) {
     _triggerWhenEmpty = value;
@@ -247,7 +319,15 @@ class Processor : public Connectable, public ConfigurableComponent, public std::
     return false;
   }
 
-  bool isThrottledByBackpressure() const;
+  /**
+   * Whether the onTrigger calls within the run duration of the processor may share a session, which is committed
+   * once at the end of the run. Processors keeping no state outside of the session can opt in.
+   */
+  virtual bool supportsBatching() const {
+    return false;
+  }
+
+  bool isThrottledByBackpressure() const override;
 
   std::shared_ptr<Connectable> pickIncomingConnection() override;
 
@@ -271,6 +351,10 @@ class Processor : public Connectable, public ConfigurableComponent, public std::
 
   // Active Tasks
   std::atomic<uint8_t> active_tasks_;
+  // Adaptive concurrency
+  std::atomic<uint8_t> min_concurrent_tasks_{0};
+  std::atomic<uint8_t> concurrent_tasks_{0};
+  ProcessorProfile profile_;
   // Trigger the Processor even if the incoming connection is empty
   std::atomic<bool> _triggerWhenEmpty;
 
@@ -281,6 +365,9 @@ class Processor : public Connectable, public ConfigurableComponent, public std::
   mutable std::mutex mutex_;
   // Yield Expiration
   std::atomic<uint64_t> yield_expiration_;
+  // name of the thread pool the processor runs in
+  std::string thread_pool_name_;
+  std::atomic<provenance::ProvenanceGranularity> provenance_granularity_{provenance::ProvenanceGranularity::FULL};
 
   // Prevent default copy constructor and assignment operation
   // Only support pass by reference or pointer
@@ -43,11 +43,14 @@ struct ProcessorConfig {
   std::string name;
   std::string javaClass;
   std::string maxConcurrentTasks;
+  std::string minConcurrentTasks;
   std::string schedulingStrategy;
   std::string schedulingPeriod;
   std::string penalizationPeriod;
   std::string yieldPeriod;
   std::string runDurationNanos;
+  std::string threadPool;
+  std::string provenanceGranularity;
   std::vector<std::string> autoTerminatedRelationships;
   std::vector<core::Property> properties;
 };
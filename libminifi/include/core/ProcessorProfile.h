@@ -0,0 +1,102 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "utils/Histogram.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+/**
+ * Always-on profile of a processor since its creation: the latency and the CPU time of its onTrigger calls,
+ * the duration of its session commits and the FlowFiles and bytes flowing through them.
+ * The scheduling agents record the triggers, the process sessions the commits.
+ */
+class ProcessorProfile {
+ public:
+  void recordTrigger(std::chrono::nanoseconds latency, std::chrono::nanoseconds cpu_time) {
+    trigger_latency_.record(toNanos(latency));
+    trigger_cpu_time_.record(toNanos(cpu_time));
+  }
+
+  void recordCommit(std::chrono::nanoseconds duration, uint64_t flow_files_in, uint64_t bytes_in, uint64_t flow_files_out, uint64_t bytes_out) {
+    commit_latency_.record(toNanos(duration));
+    flow_files_in_.fetch_add(flow_files_in, std::memory_order_relaxed);
+    bytes_in_.fetch_add(bytes_in, std::memory_order_relaxed);
+    flow_files_out_.fetch_add(flow_files_out, std::memory_order_relaxed);
+    bytes_out_.fetch_add(bytes_out, std::memory_order_relaxed);
+  }
+
+  // onTrigger latencies in nanoseconds
+  const utils::Histogram& getTriggerLatency() const {
+    return trigger_latency_;
+  }
+
+  // CPU time of the thread in the onTrigger calls in nanoseconds
+  const utils::Histogram& getTriggerCpuTime() const {
+    return trigger_cpu_time_;
+  }
+
+  // session commit durations in nanoseconds
+  const utils::Histogram& getCommitLatency() const {
+    return commit_latency_;
+  }
+
+  uint64_t getFlowFilesIn() const {
+    return flow_files_in_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getBytesIn() const {
+    return bytes_in_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getFlowFilesOut() const {
+    return flow_files_out_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getBytesOut() const {
+    return bytes_out_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static uint64_t toNanos(std::chrono::nanoseconds duration) {
+    return duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+  }
+
+  utils::Histogram trigger_latency_;
+  utils::Histogram trigger_cpu_time_;
+  utils::Histogram commit_latency_;
+  std::atomic<uint64_t> flow_files_in_{0};
+  std::atomic<uint64_t> bytes_in_{0};
+  std::atomic<uint64_t> flow_files_out_{0};
+  std::atomic<uint64_t> bytes_out_{0};
+};
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -88,6 +88,13 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
     return true;
   }
 
+  /**
+   * @return whether the records put into this repository survive a restart
+   */
+  virtual bool isDurable() const {
+    return false;
+  }
+
   virtual void flush();
 
   // initialize
@@ -108,6 +115,13 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
     return true;
   }
 
+  /**
+   * Records the content claim referenced by the value stored under key, so that the repository
+   * can release the claim once the key is deleted without reading the value back.
+   */
+  virtual void registerContentClaim(const std::string& /*key*/, const std::shared_ptr<ResourceClaim>& /*claim*/) {
+  }
+
   virtual bool Delete(std::vector<std::shared_ptr<core::SerializableComponent>> &storedValues) {
     bool found = true;
     for (auto storedValue : storedValues) {
@@ -152,6 +166,14 @@ class Repository : public virtual core::SerializableComponent, public core::Trac
   virtual bool isRunning() {
     return running_;
   }
+  // whether the repo is restoring the entries stored by a previous run
+  virtual bool isRecovering() const {
+    return false;
+  }
+  // the number of stored entries restored so far
+  virtual uint64_t getRecoveredCount() const {
+    return 0;
+  }
 
   /**
    * Specialization that allows us to serialize max_size objects into store.
@@ -0,0 +1,127 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "ContentSession.h"
+#include "ResourceClaim.h"
+#include "io/BaseStream.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+/**
+ * Content session that writes through to a staging claim of the repository instead of
+ * buffering the whole content in memory. At most buffer_size bytes are kept in memory
+ * per written claim, commit publishes the staged content while rollback discards it.
+ */
+class StreamingContentSession : public ContentSession {
+ public:
+  StreamingContentSession(std::shared_ptr<ContentRepository> repository, size_t buffer_size);
+
+  std::shared_ptr<ResourceClaim> create() override;
+
+  std::shared_ptr<io::BaseStream> write(const std::shared_ptr<ResourceClaim>& resourceId, WriteMode mode = WriteMode::OVERWRITE) override;
+
+  std::shared_ptr<io::BaseStream> read(const std::shared_ptr<ResourceClaim>& resourceId) override;
+
+  std::shared_ptr<io::BaseStream> readOwned(const std::shared_ptr<ResourceClaim>& resourceId) override;
+
+  bool owns(const std::shared_ptr<ResourceClaim>& resourceId) const override;
+
+  void commit() override;
+
+  void rollback() override;
+
+  ~StreamingContentSession() override;
+
+ private:
+  /**
+   * Write-only stream that collects the written data into a bounded buffer and
+   * flushes it to the underlying staging stream once the buffer is full.
+   */
+  class StagingStream : public io::BaseStream {
+   public:
+    StagingStream(std::shared_ptr<io::BaseStream> target, size_t buffer_size);
+
+    using BaseStream::read;
+    using BaseStream::write;
+
+    int write(const uint8_t* value, int len) override;
+
+    int read(uint8_t* /*buffer*/, int /*len*/) override {
+      return -1;
+    }
+
+    /**
+     * The stream only supports appending, seeking to or past its end is a noop.
+     * @throws Exception when seeking back into the staged content
+     */
+    void seek(uint64_t offset) override;
+
+    size_t size() const override {
+      return size_;
+    }
+
+    // the stream remains usable for further appends, see finish
+    void close() override;
+
+    /**
+     * Flushes the buffered data and closes the underlying stream.
+     * @return false if the staged content is incomplete
+     */
+    bool finish();
+
+   private:
+    bool flush();
+
+    std::shared_ptr<io::BaseStream> target_;
+    std::vector<uint8_t> buffer_;
+    size_t buffer_size_;
+    size_t size_ = 0;
+    bool failed_ = false;
+  };
+
+  struct StagedResource {
+    std::shared_ptr<ResourceClaim> staging;
+    std::shared_ptr<StagingStream> stream;
+  };
+
+  StagedResource stage(const std::shared_ptr<ResourceClaim>& resourceId, bool append);
+
+  void discard(StagedResource& resource);
+
+  void publish(std::map<std::shared_ptr<ResourceClaim>, StagedResource>& resources, bool append);
+
+  std::map<std::shared_ptr<ResourceClaim>, StagedResource> stagedResources_;
+  std::map<std::shared_ptr<ResourceClaim>, StagedResource> stagedExtensions_;
+  size_t buffer_size_;
+};
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
+
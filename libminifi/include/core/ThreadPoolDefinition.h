@@ -0,0 +1,65 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CORE_THREADPOOLDEFINITION_H_
+#define LIBMINIFI_INCLUDE_CORE_THREADPOOLDEFINITION_H_
+
+#include <string>
+#include <vector>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+/**
+ * A named thread pool of the flow controller, which processors and process groups can be bound to,
+ * so that e.g. blocking I/O does not starve the CPU-bound parts of the flow.
+ */
+struct ThreadPoolDefinition {
+  std::string name;
+  int max_threads = 1;
+  // CPUs the worker threads are restricted to, empty if there is no restriction
+  std::vector<int> cpu_affinity;
+
+  /**
+   * @return the name of the thread pool dedicated to the processor with the given id
+   */
+  static std::string getProcessorPoolName(const std::string& processor_id) {
+    return getProcessorPoolPrefix() + processor_id;
+  }
+
+  /**
+   * @return whether the name is reserved for the thread pools dedicated to a processor
+   */
+  static bool isProcessorPoolName(const std::string& name) {
+    const std::string prefix = getProcessorPoolPrefix();
+    return name.compare(0, prefix.size(), prefix) == 0;
+  }
+
+  static std::string getProcessorPoolPrefix() {
+    return "processor:";
+  }
+};
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
+
+#endif  // LIBMINIFI_INCLUDE_CORE_THREADPOOLDEFINITION_H_
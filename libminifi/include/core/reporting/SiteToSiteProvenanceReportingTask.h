@@ -20,15 +20,20 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_REPORTING_SITETOSITEPROVENANCEREPORTINGTASK_H_
 #define LIBMINIFI_INCLUDE_CORE_REPORTING_SITETOSITEPROVENANCEREPORTINGTASK_H_
 
+#include <cstdint>
 #include <mutex>
 #include <memory>
 #include <stack>
+#include <string>
+#include <vector>
 #include "FlowFileRecord.h"
 #include "core/Processor.h"
 #include "core/ProcessSession.h"
 #include "RemoteProcessorGroupPort.h"
 #include "io/StreamFactory.h"
 #include "core/logging/LoggerConfiguration.h"
+#include "core/CoreComponentState.h"
+#include "provenance/ProvenanceQuery.h"
 
 namespace org {
 namespace apache {
@@ -46,6 +51,7 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
    */
   SiteToSiteProvenanceReportingTask(const std::shared_ptr<io::StreamFactory> &stream_factory, std::shared_ptr<Configure> configure)
       : minifi::RemoteProcessorGroupPort(stream_factory, ReportTaskName, "", configure),
+        cursor_(0),
         logger_(logging::LoggerFactory<SiteToSiteProvenanceReportingTask>::getLogger()) {
     this->setTriggerWhenEmpty(true);
     batch_size_ = 100;
@@ -55,6 +61,8 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
   //! Report Task Name
   static constexpr char const* ReportTaskName = "SiteToSiteProvenanceReportingTask";
   static const char *ProvenanceAppStr;
+  // the state of the reporting task holds the cursor of the provenance events reported so far
+  static const char *CURSOR_STATE_KEY;
 
  public:
   //! Get provenance json report
@@ -85,8 +93,22 @@ class SiteToSiteProvenanceReportingTask : public minifi::RemoteProcessorGroupPor
     port_uuid = protocol_uuid_;
   }
 
+ protected:
+  /**
+   * Sends the JSON report of the events to the remote port, yielding if it could not be sent.
+   * @return whether the report was sent
+   */
+  virtual bool transmitReport(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, const std::string &report);
+
  private:
+  // reports the events of a queryable repository after the cursor, with no intermediate records
+  void reportFromCursor(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session, provenance::QueryableProvenanceRepository &repo);
+
+  void saveCursor(uint64_t cursor);
+
   int batch_size_;
+  uint64_t cursor_;
+  std::shared_ptr<core::CoreComponentStateManager> state_manager_;
 
   std::shared_ptr<logging::Logger> logger_;
 };
@@ -254,6 +254,21 @@ class AtomicEntry {
     return true;
   }
 
+  /**
+   * Copies the key of the value into the argument
+   * @return whether or not this atomic entry has a value.
+   */
+  bool getKey(T &key) {
+    try_lock();
+    if (!has_value_) {
+      try_unlock();
+      return false;
+    }
+    key = value_.getKey();
+    try_unlock();
+    return true;
+  }
+
   /**
    * Moved the value into the argument
    * @param value the previous value will be moved into this parameter
@@ -447,7 +462,7 @@ class AtomicEntry {
    */
   inline void try_unlock() {
     bool lock = true;
-    while (!write_pending_.compare_exchange_weak(lock, false, std::memory_order_acquire)) {
+    while (!write_pending_.compare_exchange_weak(lock, false, std::memory_order_release)) {
       lock = true;
       // attempt again
     }
@@ -59,7 +59,14 @@ class FileSystemRepository : public core::ContentRepository, public core::CoreCo
 
   virtual bool remove(const minifi::ResourceClaim &claim);
 
+  virtual bool publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append);
+
  private:
+  /**
+   * Removes the staged content of sessions that did not complete before the last shutdown.
+   */
+  void removeStagedContent();
+
   std::shared_ptr<logging::Logger> logger_;
 };
 
@@ -0,0 +1,179 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/Core.h"
+#include "core/ContentRepository.h"
+#include "properties/Configure.h"
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+/**
+ * TieredContentRepository keeps the content of the claims in a bounded memory arena, in front of a durable backend
+ * (the file system or RocksDB based content repository). The claims are spilled to the backend
+ *   - in the background, once they are older than the spill age or the arena is filled past its watermark,
+ *   - in the committing thread, before a FlowFile referencing them is persisted to a durable FlowFile repository,
+ *   - in the writing thread, once they grow larger than the maximum claim size or the arena is full.
+ * Reading a claim reads it from the tier it is in, and a claim removed while in memory never reaches the backend.
+ */
+class TieredContentRepository : public core::ContentRepository, public core::CoreComponent {
+ public:
+  static constexpr const char *DEFAULT_BACKEND = "FileSystemRepository";
+  static constexpr uint64_t DEFAULT_MEMORY_MAX_SIZE = 64 * 1024 * 1024;
+  static constexpr uint64_t DEFAULT_MEMORY_WATERMARK_PERCENT = 75;
+  static constexpr uint64_t DEFAULT_CLAIM_MAX_SIZE = 1024 * 1024;
+  static constexpr uint64_t DEFAULT_SPILL_AGE_MS = 10000;
+
+  explicit TieredContentRepository(std::string name = getClassName<TieredContentRepository>());
+
+  ~TieredContentRepository() override;
+
+  bool initialize(const std::shared_ptr<minifi::Configure> &configuration) override;
+
+  void stop() override;
+
+  std::shared_ptr<io::BaseStream> write(const minifi::ResourceClaim &claim, bool append = false) override;
+
+  std::shared_ptr<io::BaseStream> read(const minifi::ResourceClaim &claim) override;
+
+  bool close(const minifi::ResourceClaim &claim) override {
+    return remove(claim);
+  }
+
+  bool remove(const minifi::ResourceClaim &claim) override;
+
+  bool exists(const minifi::ResourceClaim &claim) override;
+
+  bool publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) override;
+
+  void makeDurable(const minifi::ResourceClaim &claim) override;
+
+  /**
+   * @return the size of the content kept in memory
+   */
+  uint64_t getMemoryUsage() const {
+    return memory_usage_;
+  }
+
+  /**
+   * @return the number of claims spilled to the backend
+   */
+  uint64_t getSpilledCount() const {
+    return spilled_count_;
+  }
+
+  std::shared_ptr<core::ContentRepository> getBackend() const {
+    return backend_;
+  }
+
+ private:
+  enum class Tier {
+    MEMORY,
+    BACKEND,
+    REMOVED
+  };
+
+  struct Entry {
+    explicit Entry(std::string path)
+        : path(std::move(path)),
+          created(std::chrono::steady_clock::now()) {
+    }
+
+    const std::string path;
+    const std::chrono::steady_clock::time_point created;
+    std::mutex mutex;
+    Tier tier = Tier::MEMORY;
+    // kept until the last stream reading or writing it is destroyed, even if the entry is spilled or removed meanwhile
+    std::vector<uint8_t> data;
+    // the size of data while in memory, for the spill thread which does not lock the entry
+    std::atomic<size_t> size{0};
+    uint32_t open_streams = 0;
+  };
+
+  class MemoryStream;
+
+  /**
+   * @return a stream reading the claim from memory, or nullptr if it is not in memory
+   */
+  std::shared_ptr<io::BaseStream> readMemory(const minifi::ResourceClaim &claim);
+
+  std::shared_ptr<Entry> findEntry(const std::string &path);
+
+  std::shared_ptr<Entry> createEntry(const std::string &path);
+
+  /**
+   * Writes the content of the entry to the backend, the mutex of the entry must be held.
+   * @return whether the entry was in memory and is on the backend now
+   */
+  bool spill(Entry &entry);
+
+  bool spillEntry(const std::shared_ptr<Entry> &entry);
+
+  /**
+   * Called by the streams of the entry when they are destroyed, the mutex of the entry must be held.
+   */
+  void releaseStream(Entry &entry);
+
+  void run();
+
+  std::shared_ptr<core::ContentRepository> backend_;
+  uint64_t memory_max_size_;
+  uint64_t memory_watermark_;
+  uint64_t claim_max_size_;
+  std::chrono::milliseconds spill_age_;
+
+  // guards the arena, acquired before the mutex of an entry but never while holding one
+  std::mutex mutex_;
+  // notified when the memory usage exceeds the watermark and on stop
+  std::condition_variable condition_;
+  bool running_;
+  std::thread thread_;
+  // the entries of the claims written since the start, the spilled ones are kept until removed to forward them to the backend
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+  // the entries in the order of their creation, so that the oldest ones are spilled first
+  std::deque<std::weak_ptr<Entry>> spill_order_;
+  std::atomic<uint64_t> memory_usage_;
+  std::atomic<uint64_t> spilled_count_;
+  std::shared_ptr<logging::Logger> logger_;
+};
+
+}  // namespace repository
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -18,6 +18,7 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_REPOSITORY_VOLATILEPROVENANCEREPOSITORY_H_
 #define LIBMINIFI_INCLUDE_CORE_REPOSITORY_VOLATILEPROVENANCEREPOSITORY_H_
 
+#include <mutex>
 #include <string>
 
 #include "VolatileRepository.h"
@@ -46,6 +47,7 @@ class VolatileProvenanceRepository : public VolatileRepository<std::string> {
   }
  protected:
   virtual void emplace(RepoValue<std::string> &old_value) {
+    std::lock_guard<std::mutex> lock(purge_mutex_);
     purge_list_.push_back(old_value.getKey());
   }
  private:
@@ -18,11 +18,19 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_REPOSITORY_VOLATILEREPOSITORY_H_
 #define LIBMINIFI_INCLUDE_CORE_REPOSITORY_VOLATILEREPOSITORY_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cinttypes>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -31,6 +39,7 @@
 #include "core/Core.h"
 #include "core/Repository.h"
 #include "core/SerializableComponent.h"
+#include "utils/OptionalUtils.h"
 #include "utils/StringUtils.h"
 
 namespace org {
@@ -48,7 +57,10 @@ namespace repository {
 #endif
 /**
  * Flow File repository
- * Design: Extends Repository and implements the run function, using RocksDB as the primary substrate.
+ * Design: Extends Repository and implements the run function, keeping the values in a fixed number of slots in memory.
+ * A striped hash index maps each key to its slot, so that Put, Get and Delete cost O(1) regardless of the number of slots.
+ * Once every slot is taken, or the size of the values exceeds the maximum, Put evicts the entries in the order of
+ * their slots (round robin), handing each evicted value to emplace() and counting it in getEvictedCount().
  */
 template<typename T>
 class VolatileRepository : public core::Repository, public utils::EnableSharedFromThis<VolatileRepository<T>> {
@@ -68,6 +80,9 @@ class VolatileRepository : public core::Repository, public utils::EnableSharedFr
         current_index_(0),
         max_count_(10000),
         max_size_(static_cast<size_t>(maxPartitionBytes * 0.75)),
+        entry_count_(0),
+        evicted_count_(0),
+        evicted_size_(0),
         logger_(logging::LoggerFactory<VolatileRepository>::getLogger()) {
     purge_required_ = false;
   }
@@ -144,7 +159,24 @@ class VolatileRepository : public core::Repository, public utils::EnableSharedFr
     return current_size_;
   }
 
+  /**
+   * @return the number of entries dropped by Put to make room for new ones
+   */
+  uint64_t getEvictedCount() const {
+    return evicted_count_;
+  }
+
+  /**
+   * @return the total size of the entries dropped by Put to make room for new ones
+   */
+  uint64_t getEvictedSize() const {
+    return evicted_size_;
+  }
+
  protected:
+  /**
+   * Receives the value of an entry which is deleted or evicted.
+   */
   virtual void emplace(RepoValue<T> &old_value) {
     std::lock_guard<std::mutex> lock(purge_mutex_);
     purge_list_.push_back(old_value.getKey());
@@ -155,7 +187,7 @@ class VolatileRepository : public core::Repository, public utils::EnableSharedFr
    * if the new prospectiveSize is inserted.
    * @param prospectiveSize size of item to be added.
    */
-  inline bool exceedsCapacity(uint32_t prospectiveSize) {
+  inline bool exceedsCapacity(size_t prospectiveSize) {
     if (current_size_ + prospectiveSize > max_size_)
       return true;
     else
@@ -165,14 +197,14 @@ class VolatileRepository : public core::Repository, public utils::EnableSharedFr
   std::map<std::string, std::shared_ptr<minifi::Connection>> connectionMap;
   // current size of the volatile repo.
   std::atomic<size_t> current_size_;
-  // current index.
-  std::atomic<uint16_t> current_index_;
+  // the next slot to evict from, grows without bounds and wraps around max_count_
+  std::atomic<uint64_t> current_index_;
   // value vector that exists for non blocking iteration over
   // objects that store data for this repo instance.
   std::vector<AtomicEntry<T>*> value_vector_;
 
   // max count we are allowed to store.
-  uint32_t max_count_;
+  uint64_t max_count_;
   // maximum estimated size
   size_t max_size_;
 
@@ -183,6 +215,49 @@ class VolatileRepository : public core::Repository, public utils::EnableSharedFr
   std::vector<T> purge_list_;
 
  private:
+  struct IndexStripe {
+    std::mutex mutex;
+    std::unordered_map<T, uint64_t> slots;
+  };
+
+  IndexStripe &getStripe(const T &key) {
+    return index_[std::hash<T>()(key) % index_.size()];
+  }
+
+  /**
+   * Takes the value out of the slot if the slot is indexed by the key it holds, i.e. it is neither free nor being
+   * set or released by another thread.
+   * @param release whether to release the slot for reuse, or leave it to the caller
+   */
+  bool takeSlot(uint64_t slot, RepoValue<T> &value, bool release = true);
+
+  /**
+   * Releases a slot which is no longer indexed, so that Put can reuse it.
+   */
+  void releaseSlot(uint64_t slot);
+
+  /**
+   * Returns a slot which is not indexed, evicting the entry of the next slot if no slot is free.
+   */
+  uint64_t acquireSlot();
+
+  /**
+   * Evicts the entry of the next taken slot, wrapping around the slots at most once.
+   * @param slot the slot of the evicted entry
+   * @param release whether to release the slot for reuse, or leave it to the caller
+   * @return whether an entry was evicted
+   */
+  bool evictNext(uint64_t &slot, bool release);
+
+  // maps the keys to their slots, striped by the hash of the keys so that operations on different keys rarely contend
+  std::array<IndexStripe, 16> index_;
+  std::mutex free_slots_mutex_;
+  // the slots which are neither indexed nor being set, taken from the back
+  std::vector<uint64_t> free_slots_;
+  // the number of indexed entries
+  std::atomic<uint64_t> entry_count_;
+  std::atomic<uint64_t> evicted_count_;
+  std::atomic<uint64_t> evicted_size_;
   std::shared_ptr<logging::Logger> logger_;
 };
 
@@ -215,8 +290,8 @@ bool VolatileRepository<T>::initialize(const std::shared_ptr<Configure> &configu
     std::stringstream strstream;
     strstream << Configure::nifi_volatile_repository_options << getName() << "." << volatile_repo_max_count;
     if (configure->get(strstream.str(), value)) {
-      if (core::Property::StringToInt(value, max_cnt)) {
-        max_count_ = gsl::narrow<uint32_t>(max_cnt);
+      if (core::Property::StringToInt(value, max_cnt) && max_cnt > 0) {
+        max_count_ = gsl::narrow<uint64_t>(max_cnt);
       }
     }
 
@@ -238,12 +313,87 @@ bool VolatileRepository<T>::initialize(const std::shared_ptr<Configure> &configu
   logging::LOG_INFO(logger_) << "Resizing value_vector_ for " << getName() << " count is " << max_count_;
   logging::LOG_INFO(logger_) << "Using a maximum size for " << getName() << " of  " << max_size_;
   value_vector_.reserve(max_count_);
-  for (uint32_t i = 0; i < max_count_; i++) {
+  for (uint64_t i = 0; i < max_count_; i++) {
     value_vector_.emplace_back(new AtomicEntry<T>(&current_size_, &max_size_));
   }
+  std::lock_guard<std::mutex> lock(free_slots_mutex_);
+  free_slots_.reserve(max_count_);
+  for (uint64_t slot = max_count_; slot > 0; --slot) {
+    free_slots_.push_back(slot - 1);
+  }
+  return true;
+}
+
+template<typename T>
+bool VolatileRepository<T>::takeSlot(uint64_t slot, RepoValue<T> &value, bool release) {
+  T key;
+  if (!value_vector_.at(slot)->getKey(key)) {
+    return false;
+  }
+  {
+    IndexStripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.slots.find(key);
+    if (it == stripe.slots.end() || it->second != slot || !value_vector_.at(slot)->getValue(key, value)) {
+      return false;
+    }
+    stripe.slots.erase(it);
+  }
+  --entry_count_;
+  if (release) {
+    releaseSlot(slot);
+  }
   return true;
 }
 
+template<typename T>
+void VolatileRepository<T>::releaseSlot(uint64_t slot) {
+  std::lock_guard<std::mutex> lock(free_slots_mutex_);
+  free_slots_.push_back(slot);
+}
+
+template<typename T>
+uint64_t VolatileRepository<T>::acquireSlot() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(free_slots_mutex_);
+      if (!free_slots_.empty()) {
+        const uint64_t slot = free_slots_.back();
+        free_slots_.pop_back();
+        return slot;
+      }
+    }
+    uint64_t slot = 0;
+    if (evictNext(slot, false)) {
+      return slot;
+    } else {
+      // every slot is being set or released by other threads
+      std::this_thread::yield();
+    }
+  }
+}
+
+template<typename T>
+bool VolatileRepository<T>::evictNext(uint64_t &slot, bool release) {
+  for (uint64_t attempt = 0; attempt < max_count_; ++attempt) {
+    slot = current_index_.fetch_add(1) % max_count_;
+    RepoValue<T> value;
+    if (!takeSlot(slot, value, release)) {
+      continue;
+    }
+    const size_t size = value.size();
+    current_size_ -= (std::min)(size, current_size_.load());
+    evicted_size_ += size;
+    if (evicted_count_++ == 0) {
+      logger_->log_warn("%s is full, evicting its oldest entries to make room for new ones", getName());
+    }
+    logger_->log_debug("Evicted %s of %zu bytes from %s", value.getKey(), size, getName());
+    emplace(value);
+    return true;
+  }
+  return false;
+}
+
 /**
  * Places a new object into the volatile memory area
  * @param key key to add to the repository
@@ -252,44 +402,52 @@ bool VolatileRepository<T>::initialize(const std::shared_ptr<Configure> &configu
 template<typename T>
 bool VolatileRepository<T>::Put(T key, const uint8_t *buf, size_t bufLen) {
   RepoValue<T> new_value(key, buf, bufLen);
-
   const size_t size = new_value.size();
-  bool updated = false;
-  size_t reclaimed_size = 0;
   RepoValue<T> old_value;
-  do {
-    uint16_t private_index = current_index_.fetch_add(1);
-    // round robin through the beginning
-    if (private_index >= max_count_) {
-      uint16_t new_index = 0;
-      if (current_index_.compare_exchange_weak(new_index, 0)) {
-        private_index = 0;
-      } else {
-        continue;
-      }
-    }
+  size_t reclaimed_size = 0;
 
-    updated = value_vector_.at(private_index)->setRepoValue(new_value, old_value, reclaimed_size);
-    logger_->log_debug("Set repo value at %u out of %u updated %u current_size %u, adding %u to  %u", private_index, max_count_, updated == true, reclaimed_size, size, current_size_.load());
-    if (updated && reclaimed_size > 0) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      emplace(old_value);
-    }
-    if (reclaimed_size > 0) {
-      /**
-       * this is okay since current_size_ is really an estimate.
-       * we don't need precise counts.
-       */
-      if (current_size_ < reclaimed_size) {
-        current_size_ = 0;
-      } else {
-        current_size_ -= reclaimed_size;
+  IndexStripe &stripe = getStripe(key);
+  {
+    // an indexed slot is only ever released under the lock of its stripe, so it can be overwritten in place
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.slots.find(key);
+    if (it != stripe.slots.end()) {
+      while (!value_vector_.at(it->second)->setRepoValue(new_value, old_value, reclaimed_size)) {
       }
+      current_size_ -= (std::min)(reclaimed_size, current_size_.load());
+      current_size_ += size;
+      return true;
     }
-  } while (!updated);
+  }
+
+  uint64_t evicted_slot = 0;
+  while (exceedsCapacity(size) && entry_count_ > 0 && evictNext(evicted_slot, true)) {
+  }
+  const uint64_t slot = acquireSlot();
+  // the slot is not indexed yet, so no other thread touches it
+  while (!value_vector_.at(slot)->setRepoValue(new_value, old_value, reclaimed_size)) {
+  }
   current_size_ += size;
 
-  logger_->log_debug("VolatileRepository -- put %u %u", current_size_.load(), current_index_.load());
+  utils::optional<uint64_t> replaced_slot;
+  {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto result = stripe.slots.emplace(key, slot);
+    if (!result.second) {
+      // the key was put concurrently, the later put wins
+      replaced_slot = result.first->second;
+      result.first->second = slot;
+      RepoValue<T> replaced_value;
+      value_vector_.at(*replaced_slot)->getValue(key, replaced_value);
+      current_size_ -= (std::min)(replaced_value.size(), current_size_.load());
+    }
+  }
+  if (replaced_slot) {
+    releaseSlot(*replaced_slot);
+  } else {
+    ++entry_count_;
+  }
+  logger_->log_debug("VolatileRepository -- put %s into slot %" PRIu64 " of %" PRIu64 ", current size %zu", key, slot, max_count_, current_size_.load());
   return true;
 }
 
@@ -310,17 +468,25 @@ bool VolatileRepository<T>::MultiPut(const std::vector<std::pair<T, std::unique_
 template<typename T>
 bool VolatileRepository<T>::Delete(T key) {
   logger_->log_debug("Delete from volatile");
-  for (auto ent : value_vector_) {
-    // let the destructor do the cleanup
-    RepoValue<T> value;
-    if (ent->getValue(key, value)) {
-      current_size_ -= value.size();
-      logger_->log_debug("Delete and pushed into purge_list from volatile");
-      emplace(value);
-      return true;
+  RepoValue<T> value;
+  uint64_t slot = 0;
+  {
+    IndexStripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.slots.find(key);
+    if (it == stripe.slots.end()) {
+      return false;
     }
+    slot = it->second;
+    value_vector_.at(slot)->getValue(key, value);
+    stripe.slots.erase(it);
   }
-  return false;
+  --entry_count_;
+  releaseSlot(slot);
+  current_size_ -= (std::min)(value.size(), current_size_.load());
+  logger_->log_debug("Delete and pushed into purge_list from volatile");
+  emplace(value);
+  return true;
 }
 /**
  * Sets the value from the provided key. Once the item is retrieved
@@ -329,34 +495,42 @@ bool VolatileRepository<T>::Delete(T key) {
  */
 template<typename T>
 bool VolatileRepository<T>::Get(const T &key, std::string &value) {
-  for (auto ent : value_vector_) {
-    // let the destructor do the cleanup
-    RepoValue<T> repo_value;
-    if (ent->getValue(key, repo_value)) {
-      current_size_ -= value.size();
-      repo_value.emplace(value);
-      return true;
+  RepoValue<T> repo_value;
+  uint64_t slot = 0;
+  {
+    IndexStripe &stripe = getStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.slots.find(key);
+    if (it == stripe.slots.end()) {
+      return false;
     }
+    slot = it->second;
+    value_vector_.at(slot)->getValue(key, repo_value);
+    stripe.slots.erase(it);
   }
-  return false;
+  --entry_count_;
+  releaseSlot(slot);
+  current_size_ -= (std::min)(repo_value.size(), current_size_.load());
+  repo_value.emplace(value);
+  return true;
 }
 
 template<typename T>
 bool VolatileRepository<T>::DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size, std::function<std::shared_ptr<core::SerializableComponent>()> lambda) {
   size_t requested_batch = max_size;
   max_size = 0;
-  for (auto ent : value_vector_) {
+  for (uint64_t slot = 0; slot < value_vector_.size(); ++slot) {
     // let the destructor do the cleanup
     RepoValue<T> repo_value;
 
-    if (ent->getValue(repo_value)) {
+    if (takeSlot(slot, repo_value)) {
       std::shared_ptr<core::SerializableComponent> newComponent = lambda();
       // we've taken ownership of this repo value
       newComponent->DeSerialize(repo_value.getBuffer(), repo_value.getBufferSize());
 
       store.push_back(newComponent);
 
-      current_size_ -= repo_value.getBufferSize();
+      current_size_ -= (std::min)(repo_value.getBufferSize(), current_size_.load());
 
       if (max_size++ >= requested_batch) {
         break;
@@ -372,19 +546,17 @@ bool VolatileRepository<T>::DeSerialize(std::vector<std::shared_ptr<core::Serial
 
 template<typename T>
 bool VolatileRepository<T>::DeSerialize(std::vector<std::shared_ptr<core::SerializableComponent>> &store, size_t &max_size) {
-  logger_->log_debug("VolatileRepository -- DeSerialize %u", current_size_.load());
+  logger_->log_debug("VolatileRepository -- DeSerialize %zu", current_size_.load());
   max_size = 0;
-  for (auto ent : value_vector_) {
+  for (uint64_t slot = 0; slot < value_vector_.size() && max_size < store.size(); ++slot) {
     // let the destructor do the cleanup
     RepoValue<T> repo_value;
 
-    if (ent->getValue(repo_value)) {
+    if (takeSlot(slot, repo_value)) {
       // we've taken ownership of this repo value
       store.at(max_size)->DeSerialize(repo_value.getBuffer(), repo_value.getBufferSize());
-      current_size_ -= repo_value.getBufferSize();
-      if (max_size++ >= store.size()) {
-        break;
-      }
+      current_size_ -= (std::min)(repo_value.getBufferSize(), current_size_.load());
+      ++max_size;
     }
   }
   if (max_size > 0) {
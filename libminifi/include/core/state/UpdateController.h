@@ -29,8 +29,17 @@ namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
+
+namespace core {
+class Repository;
+}  // namespace core
+
 namespace state {
 
+namespace response {
+class ResponseNode;
+}  // namespace response
+
 enum class UpdateState {
   INITIATE,
   FULLY_APPLIED,
@@ -229,6 +238,22 @@ class StateMonitor : public StateController {
    */
   virtual std::vector<BackTrace> getTraces() = 0;
 
+  /**
+   * Returns the metrics node of the given name the state monitor keeps about its components.
+   * @return metrics node or nullptr if there is none with that name
+   */
+  virtual std::shared_ptr<response::ResponseNode> getMetricsNode(const std::string& /*name*/) const {
+    return nullptr;
+  }
+
+  /**
+   * Returns the provenance repository, which answers the provenance queries if it is queryable.
+   * @return provenance repository or nullptr if there is none
+   */
+  virtual std::shared_ptr<core::Repository> getProvenanceRepository() {
+    return nullptr;
+  }
+
 
  protected:
   std::atomic<bool> controller_running_;
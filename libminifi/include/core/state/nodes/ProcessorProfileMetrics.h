@@ -0,0 +1,127 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CORE_STATE_NODES_PROCESSORPROFILEMETRICS_H_
+#define LIBMINIFI_INCLUDE_CORE_STATE_NODES_PROCESSORPROFILEMETRICS_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../nodes/MetricsBase.h"
+#include "core/Processor.h"
+#include "utils/Histogram.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace state {
+namespace response {
+
+/**
+ * Justification and Purpose: Provides the profile of each processor: the latency and the CPU time of its
+ * onTrigger calls, the duration of its session commits and its FlowFile and byte throughput, so that the hot
+ * processor of an agent can be found without attaching a profiler, and its current number of concurrent tasks.
+ * Durations are in nanoseconds.
+ */
+class ProcessorProfileMetrics : public ResponseNode {
+ public:
+  ProcessorProfileMetrics(const std::string &name, const utils::Identifier &uuid)
+      : ResponseNode(name, uuid) {
+  }
+
+  explicit ProcessorProfileMetrics(const std::string &name)
+      : ResponseNode(name) {
+  }
+
+  ProcessorProfileMetrics()
+      : ResponseNode("ProcessorProfileMetrics") {
+  }
+
+  std::string getName() const override {
+    return "ProcessorProfileMetrics";
+  }
+
+  void setProcessors(std::vector<std::shared_ptr<core::Processor>> processors) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    processors_ = std::move(processors);
+  }
+
+  std::vector<SerializedResponseNode> serialize() override {
+    std::vector<SerializedResponseNode> serialized;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& processor : processors_) {
+      const auto& profile = processor->getProfile();
+      SerializedResponseNode parent;
+      parent.name = processor->getName();
+
+      SerializedResponseNode uuid;
+      uuid.name = "uuid";
+      uuid.value = std::string(processor->getUUIDStr());
+      parent.children.push_back(uuid);
+
+      parent.children.push_back(serializeHistogram("triggerlatency", profile.getTriggerLatency()));
+      parent.children.push_back(serializeHistogram("cputime", profile.getTriggerCpuTime()));
+      parent.children.push_back(serializeHistogram("commitlatency", profile.getCommitLatency()));
+      parent.children.push_back(serializeCounter("flowfilesin", profile.getFlowFilesIn()));
+      parent.children.push_back(serializeCounter("bytesin", profile.getBytesIn()));
+      parent.children.push_back(serializeCounter("flowfilesout", profile.getFlowFilesOut()));
+      parent.children.push_back(serializeCounter("bytesout", profile.getBytesOut()));
+      // chosen by the scheduling agent in adaptive concurrency mode
+      parent.children.push_back(serializeCounter("concurrenttasks", processor->getConcurrentTasks()));
+
+      serialized.push_back(parent);
+    }
+    return serialized;
+  }
+
+ private:
+  static SerializedResponseNode serializeCounter(const std::string &name, uint64_t value) {
+    SerializedResponseNode node;
+    node.name = name;
+    node.value = value;
+    return node;
+  }
+
+  static SerializedResponseNode serializeHistogram(const std::string &name, const utils::Histogram &histogram) {
+    SerializedResponseNode node;
+    node.name = name;
+    node.children.push_back(serializeCounter("count", histogram.getCount()));
+    node.children.push_back(serializeCounter("total", histogram.getSum()));
+    node.children.push_back(serializeCounter("mean", histogram.getMean()));
+    node.children.push_back(serializeCounter("p50", histogram.getPercentile(50)));
+    node.children.push_back(serializeCounter("p90", histogram.getPercentile(90)));
+    node.children.push_back(serializeCounter("p99", histogram.getPercentile(99)));
+    node.children.push_back(serializeCounter("max", histogram.getMax()));
+    return node;
+  }
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<core::Processor>> processors_;
+};
+
+}  // namespace response
+}  // namespace state
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
+
+#endif  // LIBMINIFI_INCLUDE_CORE_STATE_NODES_PROCESSORPROFILEMETRICS_H_
@@ -85,6 +85,13 @@ class RepositoryMetrics : public ResponseNode {
       parent.children.push_back(datasizemax);
       parent.children.push_back(queuesize);
 
+      if (repo->isRecovering()) {
+        SerializedResponseNode recovered;
+        recovered.name = "recovered";
+        recovered.value = std::to_string(repo->getRecoveredCount());
+        parent.children.push_back(recovered);
+      }
+
       serialized.push_back(parent);
     }
     return serialized;
@@ -18,12 +18,19 @@
 #ifndef LIBMINIFI_INCLUDE_CORE_STATE_NODES_SYSTEMMETRICS_H_
 #define LIBMINIFI_INCLUDE_CORE_STATE_NODES_SYSTEMMETRICS_H_
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "core/Resource.h"
+#include "utils/OsUtils.h"
 
 #ifndef _WIN32
 #include <sys/utsname.h>
@@ -104,10 +111,65 @@ class SystemInformation : public DeviceInformation {
 #endif
     serialized.push_back(identifier);
 
+    auto threads = serializeThreads();
+    if (!threads.children.empty()) {
+      serialized.push_back(threads);
+    }
+
     return serialized;
   }
 
  protected:
+  /**
+   * Reports the CPU time of each thread of the agent and its utilization since the previous report, so that
+   * a busy worker thread of a (pinned) thread pool can be told apart from the rest of the process.
+   */
+  SerializedResponseNode serializeThreads() {
+    SerializedResponseNode threads;
+    threads.name = "threads";
+    threads.array = true;
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto usages = utils::OsUtils::getThreadCpuUsage();
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    const std::chrono::duration<double> elapsed = now - previous_sample_time_;
+    std::unordered_map<uint64_t, std::chrono::nanoseconds> cpu_times;
+    for (const auto& usage : usages) {
+      SerializedResponseNode thread;
+      thread.name = usage.name;
+
+      SerializedResponseNode name;
+      name.name = "name";
+      name.value = usage.name;
+      thread.children.push_back(name);
+
+      SerializedResponseNode cpu_time;
+      cpu_time.name = "cpuTime";
+      cpu_time.value = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(usage.cpu_time).count());
+      thread.children.push_back(cpu_time);
+
+      const auto previous = previous_cpu_times_.find(usage.id);
+      if (previous != previous_cpu_times_.end() && elapsed.count() > 0) {
+        const std::chrono::duration<double> used = usage.cpu_time - previous->second;
+        SerializedResponseNode utilization;
+        utilization.name = "cpuUtilization";
+        // in percents of one CPU
+        utilization.value = static_cast<uint64_t>(std::lround((std::max)(0.0, 100.0 * used.count() / elapsed.count())));
+        thread.children.push_back(utilization);
+      }
+
+      cpu_times.emplace(usage.id, usage.cpu_time);
+      threads.children.push_back(thread);
+    }
+    // the threads gone since the previous report are dropped
+    previous_cpu_times_ = std::move(cpu_times);
+    previous_sample_time_ = now;
+    return threads;
+  }
+
+  std::mutex threads_mutex_;
+  std::unordered_map<uint64_t, std::chrono::nanoseconds> previous_cpu_times_;
+  std::chrono::steady_clock::time_point previous_sample_time_;
 };
 
 REGISTER_RESOURCE(SystemInformation, "Node part of an AST that defines the System information and metrics subtree");
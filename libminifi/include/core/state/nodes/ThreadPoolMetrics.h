@@ -0,0 +1,110 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBMINIFI_INCLUDE_CORE_STATE_NODES_THREADPOOLMETRICS_H_
+#define LIBMINIFI_INCLUDE_CORE_STATE_NODES_THREADPOOLMETRICS_H_
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../nodes/MetricsBase.h"
+#include "utils/ThreadPool.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace state {
+namespace response {
+
+/**
+ * Justification and Purpose: Provides the size and load of the thread pools of the flow controller,
+ * so that the C2 server can tell which pool is saturated.
+ *
+ * The thread pools must outlive this node or be removed from it before they are destroyed.
+ */
+class ThreadPoolMetrics : public ResponseNode {
+ public:
+  ThreadPoolMetrics(const std::string &name, const utils::Identifier &uuid)
+      : ResponseNode(name, uuid) {
+  }
+
+  explicit ThreadPoolMetrics(const std::string &name)
+      : ResponseNode(name) {
+  }
+
+  ThreadPoolMetrics()
+      : ResponseNode("ThreadPoolMetrics") {
+  }
+
+  std::string getName() const override {
+    return "ThreadPoolMetrics";
+  }
+
+  void setThreadPools(std::vector<utils::ThreadPool<utils::TaskRescheduleInfo>*> thread_pools) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_pools_ = std::move(thread_pools);
+  }
+
+  std::vector<SerializedResponseNode> serialize() override {
+    std::vector<SerializedResponseNode> serialized;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto thread_pool : thread_pools_) {
+      SerializedResponseNode parent;
+      parent.name = thread_pool->getName();
+
+      SerializedResponseNode max_threads;
+      max_threads.name = "maxthreads";
+      max_threads.value = thread_pool->getMaxConcurrentTasks();
+
+      SerializedResponseNode running_threads;
+      running_threads.name = "runningthreads";
+      running_threads.value = thread_pool->isRunning() ? thread_pool->getCurrentWorkers() : 0;
+
+      SerializedResponseNode queued_tasks;
+      queued_tasks.name = "queuedtasks";
+      queued_tasks.value = thread_pool->getQueuedTaskCount();
+
+      SerializedResponseNode delayed_tasks;
+      delayed_tasks.name = "delayedtasks";
+      delayed_tasks.value = thread_pool->getDelayedTaskCount();
+
+      parent.children.push_back(max_threads);
+      parent.children.push_back(running_threads);
+      parent.children.push_back(queued_tasks);
+      parent.children.push_back(delayed_tasks);
+
+      serialized.push_back(parent);
+    }
+    return serialized;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<utils::ThreadPool<utils::TaskRescheduleInfo>*> thread_pools_;
+};
+
+}  // namespace response
+}  // namespace state
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
+
+#endif  // LIBMINIFI_INCLUDE_CORE_STATE_NODES_THREADPOOLMETRICS_H_
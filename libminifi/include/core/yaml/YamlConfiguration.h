@@ -48,6 +48,7 @@ namespace core {
 #define CONFIG_YAML_REMOTE_PROCESS_GROUP_KEY "Remote Processing Groups"
 #define CONFIG_YAML_REMOTE_PROCESS_GROUP_KEY_V3 "Remote Process Groups"
 #define CONFIG_YAML_PROVENANCE_REPORT_KEY "Provenance Reporting"
+#define CONFIG_YAML_THREAD_POOLS_KEY "Thread Pools"
 
 #define YAML_CONFIGURATION_USE_REGEX
 
@@ -160,7 +161,12 @@ class YamlConfiguration : public FlowConfiguration {
 
   std::unique_ptr<core::ProcessGroup> createProcessGroup(const YAML::Node& headerNode, bool is_root = false);
 
-  std::unique_ptr<core::ProcessGroup> parseProcessGroupYaml(const YAML::Node& headerNode, const YAML::Node& yamlNode, bool is_root = false);
+  /**
+   * Parses a process group and its children. A group without a "thread pool" of its own
+   * is bound to the thread pool of its parent.
+   */
+  std::unique_ptr<core::ProcessGroup> parseProcessGroupYaml(const YAML::Node& headerNode, const YAML::Node& yamlNode, bool is_root = false,
+      const std::string& parent_thread_pool = "");
   /**
    * Parses a processor from its corresponding YAML config node and adds
    * it to a parent ProcessGroup. The processorNode argument must point
@@ -206,6 +212,12 @@ class YamlConfiguration : public FlowConfiguration {
    */
   void parseControllerServices(const YAML::Node& controllerServicesNode);
 
+  /**
+   * Parses the Thread Pools section of a configuration YAML into thread_pool_definitions_.
+   * @param threadPoolsNode thread pools YAML node.
+   */
+  void parseThreadPoolsYaml(const YAML::Node& threadPoolsNode);
+
   /**
    * Parses the Connections section of a configuration YAML.
    * The resulting Connections are added to the parent ProcessGroup.
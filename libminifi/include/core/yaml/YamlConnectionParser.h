@@ -20,7 +20,9 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "core/FlowFilePrioritizer.h"
 #include "core/ProcessGroup.h"
 #include "core/logging/LoggerConfiguration.h"
 
@@ -51,6 +53,7 @@ class YamlConnectionParser {
   utils::Identifier getDestinationUUIDFromYaml() const;
   uint64_t getFlowFileExpirationFromYaml() const;
   bool getDropEmptyFromYaml() const;
+  std::vector<std::shared_ptr<core::FlowFilePrioritizer>> getPrioritizersFromYaml() const;
  private:
   const YAML::Node& connectionNode_;
   const std::string& name_;
@@ -0,0 +1,67 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include "BaseStream.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+/**
+ * Exposes the [offset, offset + size) range of the underlying stream as a stream of its own,
+ * used for contents that share their resource claim with other contents.
+ * Writes are appended to the underlying stream and extend the slice.
+ */
+class StreamSlice : public BaseStream {
+ public:
+  StreamSlice(std::shared_ptr<BaseStream> stream, uint64_t offset, uint64_t size);
+
+  using BaseStream::read;
+  using BaseStream::write;
+
+  int write(const uint8_t* value, int len) override;
+
+  int read(uint8_t* value, int len) override;
+
+  void seek(uint64_t offset) override;
+
+  size_t size() const override {
+    return size_;
+  }
+
+  // the underlying stream may still be in use by the other contents
+  void close() override {}
+
+ private:
+  std::shared_ptr<BaseStream> stream_;
+  uint64_t offset_;
+  uint64_t size_;
+  uint64_t position_ = 0;
+};
+
+}  // namespace io
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -41,6 +41,15 @@ class Configuration : public Properties {
   static constexpr const char *nifi_flow_engine_threads = "nifi.flow.engine.threads";
   static constexpr const char *nifi_flow_engine_alert_period = "nifi.flow.engine.alert.period";
   static constexpr const char *nifi_flow_engine_event_driven_time_slice = "nifi.flow.engine.event.driven.time.slice";
+  static constexpr const char *nifi_flow_engine_cpu_affinity = "nifi.flow.engine.cpu.affinity";
+  // comma separated names of the thread pools, configured by nifi.flow.engine.thread.pool.<name>.threads and .cpu.affinity
+  static constexpr const char *nifi_flow_engine_thread_pools = "nifi.flow.engine.thread.pools";
+  static constexpr const char *nifi_flow_engine_thread_pool_prefix = "nifi.flow.engine.thread.pool.";
+  static constexpr const char *nifi_flow_engine_timer_driven_thread_pool = "nifi.flow.engine.timer.driven.thread.pool";
+  static constexpr const char *nifi_flow_engine_event_driven_thread_pool = "nifi.flow.engine.event.driven.thread.pool";
+  static constexpr const char *nifi_flow_engine_cron_driven_thread_pool = "nifi.flow.engine.cron.driven.thread.pool";
+  static constexpr const char *nifi_flow_engine_adaptive_concurrency_period = "nifi.flow.engine.adaptive.concurrency.period";
+  static constexpr const char *nifi_flow_engine_adaptive_concurrency_max_cpu = "nifi.flow.engine.adaptive.concurrency.max.cpu.percent";
   static constexpr const char *nifi_administrative_yield_duration = "nifi.administrative.yield.duration";
   static constexpr const char *nifi_bored_yield_duration = "nifi.bored.yield.duration";
   static constexpr const char *nifi_graceful_shutdown_seconds = "nifi.flowcontroller.graceful.shutdown.period";
@@ -60,7 +69,19 @@ class Configuration : public Properties {
   static constexpr const char *nifi_flowfile_repository_max_storage_size = "nifi.flowfile.repository.max.storage.size";
   static constexpr const char *nifi_flowfile_repository_max_storage_time = "nifi.flowfile.repository.max.storage.time";
   static constexpr const char *nifi_flowfile_repository_directory_default = "nifi.flowfile.repository.directory.default";
+  static constexpr const char *nifi_flowfile_repository_recovery_threads = "nifi.flowfile.repository.recovery.threads";
+  static constexpr const char *nifi_flowfile_repository_group_commit_window = "nifi.flowfile.repository.group.commit.window";
   static constexpr const char *nifi_dbcontent_repository_directory_default = "nifi.database.content.repository.directory.default";
+  static constexpr const char *nifi_content_repository_session_streaming = "nifi.content.repository.session.streaming";
+  static constexpr const char *nifi_content_repository_session_buffer_size = "nifi.content.repository.session.buffer.size";
+  static constexpr const char *nifi_content_claim_max_appendable_size = "nifi.content.claim.max.appendable.size";
+  static constexpr const char *nifi_content_claim_max_flow_files = "nifi.content.claim.max.flow.files";
+  static constexpr const char *nifi_content_repository_tiered_backend = "nifi.content.repository.tiered.backend";
+  static constexpr const char *nifi_content_repository_tiered_memory_max_size = "nifi.content.repository.tiered.memory.max.size";
+  static constexpr const char *nifi_content_repository_tiered_memory_watermark = "nifi.content.repository.tiered.memory.watermark";
+  static constexpr const char *nifi_content_repository_tiered_claim_max_size = "nifi.content.repository.tiered.claim.max.size";
+  static constexpr const char *nifi_content_repository_tiered_spill_age = "nifi.content.repository.tiered.spill.age";
+  static constexpr const char *nifi_queue_swap_threshold = "nifi.queue.swap.threshold";
   static constexpr const char *nifi_remote_input_secure = "nifi.remote.input.secure";
   static constexpr const char *nifi_remote_input_http = "nifi.remote.input.http.enabled";
   static constexpr const char *nifi_security_need_ClientAuth = "nifi.security.need.ClientAuth";
@@ -28,6 +28,8 @@
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "core/Core.h"
 #include "core/SerializableComponent.h"
@@ -37,6 +39,7 @@
 #include "Connection.h"
 #include "FlowFileRecord.h"
 #include "core/logging/LoggerConfiguration.h"
+#include "io/BufferStream.h"
 #include "ResourceClaim.h"
 #include "utils/gsl.h"
 #include "utils/Id.h"
@@ -50,6 +53,9 @@ namespace provenance {
 // Provenance Event Record Serialization Seg Size
 #define PROVENANCE_EVENT_RECORD_SEG_SIZE 2048
 
+struct ProvenanceEventIndex;
+class QueryableProvenanceRepository;
+
 // Provenance Event Record
 class ProvenanceEventRecord : public core::SerializableComponent {
  public:
@@ -183,14 +189,26 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   std::map<std::string, std::string> getAttributes() {
     return _attributes;
   }
+  // Set Attributes
+  void setAttributes(std::map<std::string, std::string> attributes) {
+    _attributes = std::move(attributes);
+  }
   // Get Size
   uint64_t getFileSize() {
     return _size;
   }
+  // Set Size
+  void setFileSize(uint64_t size) {
+    _size = size;
+  }
   // ! Get Offset
   uint64_t getFileOffset() {
     return _offset;
   }
+  // Set Offset
+  void setFileOffset(uint64_t offset) {
+    _offset = offset;
+  }
   // ! Get Entry Date
   uint64_t getFlowFileEntryDate() {
     return _entryDate;
@@ -203,6 +221,10 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   uint64_t getEventTime() {
     return _eventTime;
   }
+  // Set Event Time
+  void setEventTime(uint64_t event_time) {
+    _eventTime = event_time;
+  }
   // ! Get Event Duration
   uint64_t getEventDuration() {
     return _eventDuration;
@@ -231,6 +253,10 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   std::string getContentFullPath() {
     return _contentFullPath;
   }
+  // Set content full path
+  void setContentFullPath(std::string path) {
+    _contentFullPath = std::move(path);
+  }
   // Get LineageIdentifiers
   std::vector<utils::Identifier> getLineageIdentifiers() {
     return _lineageIdentifiers;
@@ -260,6 +286,8 @@ class ProvenanceEventRecord : public core::SerializableComponent {
     _sourceSystemFlowFileIdentifier = identifier;
   }
   // Get Parent UUIDs
+  // What the event is indexed by in a queryable repository
+  ProvenanceEventIndex getIndex();
   std::vector<utils::Identifier> getParentUuids() {
     return _parentUuids;
   }
@@ -441,6 +469,36 @@ class ProvenanceEventRecord : public core::SerializableComponent {
   static std::shared_ptr<utils::IdGenerator> id_generator_;
 };
 
+/**
+ * What a queryable repository indexes an event by, put along with the serialized event so that the repository does
+ * not deserialize it.
+ */
+struct ProvenanceEventIndex {
+  uint64_t event_time;
+  utils::Identifier flow_file_uuid;
+  // the parents and children of a FORK, CLONE or JOIN, the other events are not indexed by them
+  std::vector<utils::Identifier> lineage_uuids;
+  std::string component_id;
+  ProvenanceEventRecord::ProvenanceEventType event_type;
+};
+
+/**
+ * How much provenance the sessions of a processor record:
+ *   NONE records no events,
+ *   SUMMARY folds the attribute and content modifications of a FlowFile within a session into one event of each type,
+ *   FULL records every event.
+ */
+enum class ProvenanceGranularity {
+  NONE,
+  SUMMARY,
+  FULL
+};
+
+/**
+ * Parses none, summary or full, throws std::invalid_argument on anything else.
+ */
+ProvenanceGranularity parseProvenanceGranularity(const std::string &value);
+
 // Provenance Reporter
 class ProvenanceReporter {
  public:
@@ -448,24 +506,22 @@ class ProvenanceReporter {
   /*!
    * Create a new provenance reporter associated with the process session
    */
-  ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType)
-      : logger_(logging::LoggerFactory<ProvenanceReporter>::getLogger()) {
-    _componentId = componentId;
-    _componentType = componentType;
-    repo_ = repo;
-  }
+  ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType, ProvenanceGranularity granularity = ProvenanceGranularity::FULL);
 
   // Destructor
   virtual ~ProvenanceReporter() {
     clear();
   }
-  // Get events
-  std::set<std::shared_ptr<ProvenanceEventRecord>> getEvents() {
-    return _events;
-  }
+  /**
+   * Get events, the events captured by the session are converted to records on each call,
+   * so this is meant for inspecting the events rather than for the hot path
+   */
+  std::set<std::shared_ptr<ProvenanceEventRecord>> getEvents();
   // Add event
   void add(const std::shared_ptr<ProvenanceEventRecord> &event) {
-    _events.insert(event);
+    if (granularity_ != ProvenanceGranularity::NONE) {
+      _events.insert(event);
+    }
   }
   // Remove event
   void remove(const std::shared_ptr<ProvenanceEventRecord> &event) {
@@ -475,19 +531,27 @@ class ProvenanceReporter {
   }
   //
   // clear
-  void clear() {
-    _events.clear();
-  }
-  // commit
+  void clear();
+  // commit the events captured since the last commit
   void commit();
+  // discard the events captured since the last commit
+  void rollback();
   // create
   void create(std::shared_ptr<core::FlowFile> flow, std::string detail);
+  // create, with the details of the session formatted on commit
+  void create(const std::shared_ptr<core::FlowFile> &flow);
   // route
   void route(std::shared_ptr<core::FlowFile> flow, core::Relationship relation, std::string detail, uint64_t processingDuration);
   // modifyAttributes
   void modifyAttributes(std::shared_ptr<core::FlowFile> flow, std::string detail);
+  // modifyAttributes of a single attribute set by the session, with the details formatted on commit
+  void modifyAttribute(const std::shared_ptr<core::FlowFile> &flow, const std::string &key, const std::string &value);
+  // modifyAttributes of a single attribute removed by the session, with the details formatted on commit
+  void removeAttribute(const std::shared_ptr<core::FlowFile> &flow, const std::string &key);
   // modifyContent
   void modifyContent(std::shared_ptr<core::FlowFile> flow, std::string detail, uint64_t processingDuration);
+  // modifyContent, with the details of the session formatted on commit
+  void modifyContent(const std::shared_ptr<core::FlowFile> &flow, uint64_t processingDuration);
   // clone
   void clone(std::shared_ptr<core::FlowFile> parent, std::shared_ptr<core::FlowFile> child);
   // join
@@ -496,8 +560,12 @@ class ProvenanceReporter {
   void fork(std::vector<std::shared_ptr<core::FlowFile> > child, std::shared_ptr<core::FlowFile> parent, std::string detail, uint64_t processingDuration);
   // expire
   void expire(std::shared_ptr<core::FlowFile> flow, std::string detail);
+  // expire, with the details of the session formatted on commit
+  void expire(const std::shared_ptr<core::FlowFile> &flow);
   // drop
   void drop(std::shared_ptr<core::FlowFile> flow, std::string reason);
+  // drop of a FlowFile removed by the session, with the details formatted on commit
+  void drop(const std::shared_ptr<core::FlowFile> &flow);
   // send
   void send(std::shared_ptr<core::FlowFile> flow, std::string transitUri, std::string detail, uint64_t processingDuration, bool force);
   // fetch
@@ -505,19 +573,79 @@ class ProvenanceReporter {
   // receive
   void receive(std::shared_ptr<core::FlowFile> flow, std::string transitUri, std::string sourceSystemFlowFileIdentifier, std::string detail, uint64_t processingDuration);
 
+  ProvenanceGranularity getGranularity() const {
+    return granularity_;
+  }
+
  protected:
-  // allocate
-  std::shared_ptr<ProvenanceEventRecord> allocate(ProvenanceEventRecord::ProvenanceEventType eventType, std::shared_ptr<core::FlowFile> flow) {
-    if (repo_->isNoop()) {
-      return nullptr;
-    }
+  // how the details of a captured event are formatted when it is serialized
+  enum class DetailsFormat {
+    // the text as given
+    TEXT,
+    CREATE,
+    // the text is the attribute key, the value its new value
+    MODIFY_ATTRIBUTE,
+    // the text is the attribute key
+    REMOVE_ATTRIBUTE,
+    MODIFY_CONTENT,
+    EXPIRE,
+    // the text is the reason
+    DROP,
+    REMOVE
+  };
 
-    auto event = std::make_shared<ProvenanceEventRecord>(eventType, _componentId, _componentType);
-    if (event)
-      event->fromFlowFile(flow);
+  /**
+   * An event as captured during the session: it refers to its FlowFiles instead of copying their attributes, lineage and
+   * content claim, which are read from the FlowFiles when the event is serialized on commit, and keeps the parts of its
+   * details instead of formatting them. The slots are reused by the following events of the session, so that their
+   * strings and vectors keep their capacity.
+   */
+  struct CapturedEvent {
+    ProvenanceEventRecord::ProvenanceEventType type;
+    // assigned when the event is first serialized or converted to a record
+    utils::Identifier id;
+    uint64_t event_time;
+    uint64_t duration;
+    std::shared_ptr<core::FlowFile> flow_file;
+    // the state of the FlowFile when the event happened, the attributes are shared with it until it modifies them
+    std::shared_ptr<const core::FlowFile::AttributeMap> attributes;
+    uint64_t size;
+    uint64_t offset;
+    std::shared_ptr<ResourceClaim> claim;
+    std::shared_ptr<core::Connectable> connection;
+    // the parent and the clone of a CLONE, the parent and the children of a FORK, the parents and the child of a JOIN
+    std::vector<std::shared_ptr<core::FlowFile>> parents;
+    std::vector<std::shared_ptr<core::FlowFile>> children;
+    DetailsFormat details_format;
+    std::string details;
+    std::string attribute_value;
+    std::string transit_uri;
+    std::string source_system_flow_file_identifier;
+    std::string relationship;
+  };
 
-    return event;
-  }
+  // allocate, nullptr if the event is not recorded
+  CapturedEvent *allocate(ProvenanceEventRecord::ProvenanceEventType eventType, const std::shared_ptr<core::FlowFile> &flow);
+
+  // allocate an ATTRIBUTES_MODIFIED or CONTENT_MODIFIED event, or with SUMMARY granularity return the one already captured for the FlowFile
+  CapturedEvent *allocateModification(ProvenanceEventRecord::ProvenanceEventType eventType, const std::shared_ptr<core::FlowFile> &flow);
+
+  // takes the state of the FlowFile of the event
+  static void snapshot(CapturedEvent &event);
+
+  // releases the FlowFiles of the event and their state
+  static void release(CapturedEvent &event);
+
+  void formatDetails(const CapturedEvent &event, std::string &details) const;
+
+  // what the event is indexed by, the index is expected to be freshly constructed
+  void index(const CapturedEvent &event, ProvenanceEventIndex &index) const;
+
+  const utils::Identifier &getEventId(CapturedEvent &event);
+
+  std::shared_ptr<ProvenanceEventRecord> toRecord(CapturedEvent &event);
+
+  bool serialize(CapturedEvent &event, io::BufferStream &stream);
 
   // Component ID
   std::string _componentId;
@@ -526,10 +654,28 @@ class ProvenanceReporter {
 
  private:
   std::shared_ptr<logging::Logger> logger_;
-  // Incoming connection Iterator
+  // the events added as records
   std::set<std::shared_ptr<ProvenanceEventRecord>> _events;
   // provenance repository.
   std::shared_ptr<core::Repository> repo_;
+  // the provenance repository if it indexes the events, they are put along with their index then
+  QueryableProvenanceRepository *indexing_repo_;
+  const ProvenanceGranularity granularity_;
+  // the events captured by the session, the slots after captured_count_ are free
+  std::vector<CapturedEvent> captured_;
+  size_t captured_count_;
+  // the captured events before this one are in the repository
+  size_t committed_count_;
+  // with SUMMARY granularity, the index of the event each modification of a FlowFile is folded into, by event type
+  std::unordered_map<const core::FlowFile*, std::pair<size_t, size_t>> modifications_;
+  // buffers reused by the serialization of the events
+  std::string details_buffer_;
+  std::vector<utils::Identifier> parent_uuids_buffer_;
+  std::vector<utils::Identifier> children_uuids_buffer_;
+  std::vector<std::unique_ptr<io::BufferStream>> stream_pool_;
+  std::vector<ProvenanceEventIndex> indexes_buffer_;
+
+  static std::shared_ptr<utils::IdGenerator> id_generator_;
 
   // Prevent default copy constructor and assignment operation
   // Only support pass by reference or pointer
@@ -0,0 +1,111 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "io/BufferStream.h"
+#include "provenance/Provenance.h"
+#include "utils/Id.h"
+#include "utils/OptionalUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace provenance {
+
+/**
+ * Selects provenance events by any combination of FlowFile, component, event type and event time.
+ */
+struct ProvenanceQuery {
+  static constexpr size_t DEFAULT_MAX_RESULTS = 1000;
+
+  // the events of this FlowFile, and of its whole lineage (the FlowFiles it was forked, cloned or joined from and into) if lineage is set
+  utils::optional<utils::Identifier> flow_file_uuid;
+  bool lineage = false;
+  utils::optional<std::string> component_id;
+  utils::optional<ProvenanceEventRecord::ProvenanceEventType> event_type;
+  // event time range in milliseconds since the epoch, the start is inclusive, the end is exclusive
+  uint64_t start_time = 0;
+  uint64_t end_time = (std::numeric_limits<uint64_t>::max)();
+  size_t max_results = DEFAULT_MAX_RESULTS;
+
+  /**
+   * Parses the query from the arguments of a C2 or controller socket request:
+   *   flowfile=<uuid>, lineage=true, component=<id>, type=<event type, e.g. SEND>,
+   *   since=<time period, e.g. 1 hour>, start=<ms since epoch>, end=<ms since epoch>, limit=<max results>
+   * Throws std::invalid_argument on an unknown or malformed argument.
+   */
+  static ProvenanceQuery parse(const std::map<std::string, std::string> &arguments, uint64_t now_millis);
+
+  /**
+   * Parses the "key=value&key=value" form of the arguments.
+   */
+  static ProvenanceQuery parse(const std::string &query, uint64_t now_millis);
+
+  /**
+   * Whether the event matches every criterion of the query, following the lineage is up to the repository.
+   */
+  bool matches(ProvenanceEventRecord &event) const;
+};
+
+/**
+ * Implemented by the provenance repositories which can answer queries without scanning all their events.
+ */
+class QueryableProvenanceRepository {
+ public:
+  virtual ~QueryableProvenanceRepository() = default;
+
+  /**
+   * @return the matching events ordered by event time, at most query.max_results of them
+   */
+  virtual std::vector<std::shared_ptr<ProvenanceEventRecord>> query(const ProvenanceQuery &query) = 0;
+
+  /**
+   * Reads the events in the order they were put, starting from the cursor, without removing them. The events are
+   * in time order, except for the ones of sessions committed after later events.
+   * @param cursor 0 or a cursor returned by a previous call
+   * @param consumer called with each event
+   * @return the cursor to continue from after the events read
+   */
+  virtual uint64_t readEventsFrom(uint64_t cursor, size_t max_events, const std::function<void(ProvenanceEventRecord&)> &consumer) = 0;
+
+  /**
+   * Puts the serialized events under their ids, indexed by what the indexes at the same positions tell.
+   */
+  virtual bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<io::BufferStream>>> &data, const std::vector<ProvenanceEventIndex> &indexes) = 0;
+};
+
+/**
+ * One line summary of an event: time, type, component, FlowFile and event id, and details.
+ */
+std::string toQueryResultLine(ProvenanceEventRecord &event);
+
+}  // namespace provenance
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
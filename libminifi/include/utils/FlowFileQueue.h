@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "core/FlowFile.h"
+#include "core/FlowFilePrioritizer.h"
 
 namespace org {
 namespace apache {
@@ -28,23 +29,59 @@ namespace nifi {
 namespace minifi {
 namespace utils {
 
+/**
+ * Queue of FlowFiles which keeps the penalized FlowFiles apart from the ones that can be processed:
+ * the former are ordered by the expiration of their penalty, the latter by the prioritizers of the queue,
+ * falling back to FIFO order. A FlowFile becomes available for processing once its penalty expires.
+ */
 class FlowFileQueue {
  public:
   using value_type = std::shared_ptr<core::FlowFile>;
 
+  void setPrioritizers(std::vector<std::shared_ptr<core::FlowFilePrioritizer>> prioritizers);
   value_type pop();
   void push(const value_type& element);
   void push(value_type&& element);
+  /**
+   * Reserves a position in FIFO order for a FlowFile kept out of the queue for now
+   * @return the sequence number to push it with
+   */
+  uint64_t reserve();
+  // Push a FlowFile at the position reserved for it
+  void pushReserved(value_type element, uint64_t sequence_number);
   bool isWorkAvailable() const;
   bool empty() const;
   size_t size() const;
 
  private:
+  struct QueuedFlowFile {
+    value_type flow_file;
+    uint64_t sequence_number;
+  };
+
+  class PrioritizerComparator {
+   public:
+    explicit PrioritizerComparator(const std::vector<std::shared_ptr<core::FlowFilePrioritizer>>& prioritizers)
+        : prioritizers_(&prioritizers) {}
+
+    // returns true if right should be polled before left, as std::*_heap keep the largest element in front
+    bool operator()(const QueuedFlowFile& left, const QueuedFlowFile& right) const;
+
+   private:
+    const std::vector<std::shared_ptr<core::FlowFilePrioritizer>>* prioritizers_;
+  };
+
   struct FlowFilePenaltyExpirationComparator {
-    bool operator()(const value_type& left, const value_type& right);
+    bool operator()(const value_type& left, const value_type& right) const;
   };
 
-  std::priority_queue<value_type, std::vector<value_type>, FlowFilePenaltyExpirationComparator> queue_;
+  void enqueue(value_type element, uint64_t sequence_number);
+  void releaseExpiredPenalties();
+
+  std::vector<std::shared_ptr<core::FlowFilePrioritizer>> prioritizers_;
+  std::vector<QueuedFlowFile> queue_;
+  std::priority_queue<value_type, std::vector<value_type>, FlowFilePenaltyExpirationComparator> penalized_;
+  uint64_t next_sequence_number_ = 0;
 };
 
 }  // namespace utils
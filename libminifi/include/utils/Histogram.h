@@ -0,0 +1,155 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+/**
+ * Lock-free histogram of non-negative values with logarithmic buckets, each power of two being split into 8 linear
+ * sub-buckets, like HdrHistogram with one significant digit: the values are recorded with a relative error
+ * of at most 12.5% over the whole 64 bit range, in a fixed 4 KB of memory. Recording is wait-free except for
+ * tracking the maximum, so it can be done on every call of hot paths from any number of threads.
+ */
+class Histogram {
+ public:
+  Histogram() {
+    reset();
+  }
+
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  void record(uint64_t value) {
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  uint64_t getCount() const {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getSum() const {
+    return sum_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getMax() const {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t getMean() const {
+    const uint64_t count = getCount();
+    return count > 0 ? getSum() / count : 0;
+  }
+
+  /**
+   * Returns the value below which the given percentage of the recorded values fall, rounded up to the
+   * upper bound of its bucket, or 0 if nothing was recorded.
+   */
+  uint64_t getPercentile(double percentile) const {
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+    if (total == 0) {
+      return 0;
+    }
+    const double clamped = percentile < 0.0 ? 0.0 : (percentile > 100.0 ? 100.0 : percentile);
+    const uint64_t rank = (std::max)(static_cast<uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(total))), uint64_t{1});
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return (std::min)(bucketUpperBound(i), getMax());
+      }
+    }
+    return getMax();
+  }
+
+  void reset() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr unsigned SUB_BUCKET_BITS = 3;
+  static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+  // the values below SUB_BUCKETS are counted exactly, then each power of two has SUB_BUCKETS buckets
+  static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  static unsigned log2(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned result = 0;
+    while (value >>= 1) {
+      ++result;
+    }
+    return result;
+#endif
+  }
+
+  static size_t bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+      return static_cast<size_t>(value);
+    }
+    const unsigned shift = log2(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1)));
+  }
+
+  static uint64_t bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+      return index;
+    }
+    const unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS - 1);
+    const uint64_t lower_bound = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower_bound + ((uint64_t{1} << shift) - 1);
+  }
+
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+}  // namespace utils
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -124,6 +124,13 @@ struct TaskRescheduleInfo {
     return TaskRescheduleInfo(false, std::chrono::milliseconds(0));
   }
 
+  /**
+   * Waits without a deadline until the task is woken up by ThreadPool::wakeUp, e.g. by a TimerService.
+   */
+  static TaskRescheduleInfo Park() {
+    return TaskRescheduleInfo(false, (std::chrono::milliseconds::max)());
+  }
+
 #if defined(WIN32)
 // https://developercommunity.visualstudio.com/content/problem/60897/c-shared-state-futuresstate-default-constructs-the.html
 // Because of this bug we need to have this object default constructible, which makes no sense otherwise. Hack.
@@ -17,7 +17,9 @@
 #ifndef LIBMINIFI_INCLUDE_UTILS_OSUTILS_H_
 #define LIBMINIFI_INCLUDE_UTILS_OSUTILS_H_
 
+#include <chrono>
 #include <string>
+#include <vector>
 
 namespace org {
 namespace apache {
@@ -32,6 +34,31 @@ extern std::string userIdToUsername(const std::string &uid);
 /// Returns memory usage in bytes, including shared memory
 uint64_t getMemoryUsage();
 
+/// Returns the CPU time (user and system) consumed by all threads of the process so far
+std::chrono::nanoseconds getProcessCpuTime();
+
+/// Returns the CPU time (user and system) consumed by the calling thread so far
+std::chrono::nanoseconds getCurrentThreadCpuTime();
+
+/// Parses a list of CPU indexes and ranges, e.g. "0,2,4-7"; throws std::invalid_argument on malformed input
+std::vector<int> parseCpuList(const std::string &cpu_list);
+
+/// Restricts the calling thread to the given CPUs, returns false if this is not supported or fails
+bool setCurrentThreadAffinity(const std::vector<int> &cpus);
+
+/// Names the calling thread for debuggers and top -H; on Linux the name is truncated to 15 characters, keeping a "#<index>" suffix
+void setCurrentThreadName(const std::string &name);
+
+struct ThreadCpuUsage {
+  uint64_t id;
+  std::string name;
+  // CPU time (user and system) consumed by the thread so far
+  std::chrono::nanoseconds cpu_time;
+};
+
+/// Returns the CPU time consumed by each live thread of the process, or nothing if this is not supported
+std::vector<ThreadCpuUsage> getThreadCpuUsage();
+
 #ifdef WIN32
 /// Resolves common identifiers
 extern std::string resolve_common_identifiers(const std::string &id);
@@ -29,14 +29,18 @@
 #include <map>
 #include <unordered_map>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <future>
 #include <thread>
 #include <functional>
+#include <condition_variable>
+#include <iterator>
 
 #include "BackTrace.h"
 #include "MinifiConcurrentQueue.h"
 #include "Monitors.h"
+#include "OptionalUtils.h"
+#include "TimerWheel.h"
 #include "core/expect.h"
 #include "controllers/ThreadManagementService.h"
 #include "core/controller/ControllerService.h"
@@ -48,6 +52,8 @@ namespace minifi {
 namespace utils {
 
 using TaskId = std::string;
+// Dense integer handle of a TaskId, resolved once when the task is submitted
+using TaskHandle = uint64_t;
 
 /**
  * Worker task
@@ -104,7 +110,13 @@ class Worker {
       promise->set_value(result);
       return false;
     }
-    next_exec_time_ = std::max(next_exec_time_ + run_determinant_->wait_time(), std::chrono::steady_clock::now());
+    const auto wait_time = run_determinant_->wait_time();
+    if (wait_time == (std::chrono::milliseconds::max)()) {
+      // parked until woken up
+      next_exec_time_ = (std::chrono::steady_clock::time_point::max)();
+      return true;
+    }
+    next_exec_time_ = std::max(next_exec_time_ + wait_time, std::chrono::steady_clock::now());
     return true;
   }
 
@@ -120,6 +132,13 @@ class Worker {
     return run_determinant_->wait_time();
   }
 
+  /**
+   * Makes the task eligible to run right away, regardless of the wait time requested by its last run.
+   */
+  void resetNextExecutionTime() {
+    next_exec_time_ = std::chrono::steady_clock::now();
+  }
+
   Worker<T>(const Worker<T>&) = delete;
   Worker<T>& operator= (const Worker<T>&) = delete;
 
@@ -139,14 +158,6 @@ class Worker {
   std::shared_ptr<std::promise<T>> promise;
 };
 
-template<typename T>
-class DelayedTaskComparator {
- public:
-  bool operator()(Worker<T> &a, Worker<T> &b) {
-    return a.getNextExecutionTime() > b.getNextExecutionTime();
-  }
-};
-
 template<typename T>
 Worker<T>& Worker<T>::operator =(Worker<T> && other) noexcept {
   task = std::move(other.task);
@@ -167,22 +178,29 @@ class WorkerThread {
   explicit WorkerThread(std::thread thread, const std::string &name = "NamelessWorker")
       : is_running_(false),
         thread_(std::move(thread)),
-        name_(name) {
+        name_(name),
+        queue_index_(0) {
   }
   WorkerThread(const std::string &name = "NamelessWorker") // NOLINT
       : is_running_(false),
-        name_(name) {
+        name_(name),
+        queue_index_(0) {
   }
   std::atomic<bool> is_running_;
   std::thread thread_;
   std::string name_;
+  // index of the work queue owned by this thread
+  size_t queue_index_;
 };
 
 /**
  * Thread pool
  * Purpose: Provides a thread pool with basic functionality similar to
  * ThreadPoolExecutor
- * Design: Locked control over a manager thread that controls the worker threads
+ * Design: Locked control over a manager thread that controls the worker threads.
+ * Every worker thread owns a work queue: rescheduled tasks go back to the queue of the
+ * thread that ran them, tasks submitted from outside are spread over the queues, and a worker
+ * running out of work steals from the others. Delayed tasks wait in a timer wheel.
  */
 template<typename T>
 class ThreadPool {
@@ -194,11 +212,18 @@ class ThreadPool {
         max_worker_threads_(max_worker_threads),
         adjust_threads_(false),
         running_(false),
+        paused_(false),
         controller_service_provider_(controller_service_provider),
+        queued_tasks_(0),
+        idle_workers_(0),
+        next_queue_(0),
+        next_ticket_(0),
+        timer_wakeup_time_((std::chrono::steady_clock::time_point::max)()),
         name_(name) {
     current_workers_ = 0;
     task_count_ = 0;
     thread_manager_ = nullptr;
+    resizeWorkQueues();
   }
 
   ThreadPool(const ThreadPool<T> &other) = delete;
@@ -227,6 +252,26 @@ class ThreadPool {
    */
   void stopTasks(const TaskId &identifier);
 
+  /**
+   * Moves the delayed tasks with the provided identifier to the worker queue, so that they
+   * run as soon as a worker is available. If a task is not delayed yet (e.g. it is just finishing
+   * its run), it is not going to be delayed when it finishes.
+   * @param identifier for worker tasks
+   */
+  void wakeUp(const TaskId &identifier);
+
+  /**
+   * Same as wakeUp(const TaskId&), without resolving the identifier.
+   * @param handle for worker tasks, as returned by getTaskHandle
+   */
+  void wakeUp(TaskHandle handle);
+
+  /**
+   * Returns the integer handle of the tasks with the provided identifier, which stays the same
+   * for the lifetime of the thread pool.
+   */
+  TaskHandle getTaskHandle(const TaskId &identifier);
+
   /**
    * resumes work queue processing.
    */
@@ -241,11 +286,11 @@ class ThreadPool {
    * Returns true if a task is running.
    */
   bool isTaskRunning(const TaskId &identifier) {
-    std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-    const auto iter = task_status_.find(identifier);
-    if (iter == task_status_.end())
+    std::lock_guard<std::mutex> lock(task_states_mutex_);
+    const auto iter = task_handles_.find(identifier);
+    if (iter == task_handles_.end())
       return false;
-    return iter->second;
+    return task_states_[iter->second]->running_.load();
   }
 
   bool isRunning() const {
@@ -255,7 +300,7 @@ class ThreadPool {
   std::vector<BackTrace> getTraces() {
     std::vector<BackTrace> traces;
     std::lock_guard<std::recursive_mutex> lock(manager_mutex_);
-    std::unique_lock<std::mutex> wlock(worker_queue_mutex_);
+    std::unique_lock<std::mutex> wlock(thread_queue_mutex_);
     // while we may be checking if running, we don't want to
     // use the threads outside of the manager mutex's lock -- therefore we will
     // obtain a lock so we can keep the threads in memory
@@ -293,6 +338,48 @@ class ThreadPool {
       start();
   }
 
+  /**
+   * Restricts the worker threads to the given CPUs, an empty list lets them run on any CPU.
+   * Restarts the thread pool if it is running, as the affinity is applied when the workers start.
+   */
+  void setCpuAffinity(const std::vector<int> &cpus) {
+    std::lock_guard<std::recursive_mutex> lock(manager_mutex_);
+    bool was_running = running_;
+    if (was_running) {
+      shutdown();
+    }
+    cpu_affinity_ = cpus;
+    if (was_running)
+      start();
+  }
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+  int getMaxConcurrentTasks() const {
+    return max_worker_threads_;
+  }
+
+  int getCurrentWorkers() const {
+    return current_workers_.load();
+  }
+
+  /**
+   * Returns the number of tasks waiting for a worker thread.
+   */
+  size_t getQueuedTaskCount() const {
+    return queued_tasks_.load();
+  }
+
+  /**
+   * Returns the number of tasks waiting for their next execution time.
+   */
+  size_t getDelayedTaskCount() {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    return timer_wheel_.size();
+  }
+
   void setControllerServiceProvider(std::shared_ptr<core::controller::ControllerServiceProvider> controller_service_provider) {
     std::lock_guard<std::recursive_mutex> lock(manager_mutex_);
     bool was_running = running_;
@@ -311,18 +398,67 @@ class ThreadPool {
     });
   }
 
+  /**
+   * Bookkeeping shared by the tasks submitted with the same identifier.
+   */
+  struct TaskState {
+    std::atomic<bool> running_{false};
+    // guards the fields below
+    std::mutex mutex_;
+    // tasks waiting in the timer wheel, by ticket
+    std::unordered_map<uint64_t, Worker<T>> delayed_;
+    // whether the task was woken up while it was not delayed
+    bool wake_up_pending_{false};
+  };
+
+  struct ScheduledTask {
+    std::shared_ptr<TaskState> state;
+    Worker<T> worker;
+  };
+
+  struct DelayedTask {
+    std::shared_ptr<TaskState> state;
+    uint64_t ticket;
+  };
+
+  struct WorkQueue {
+    std::mutex mutex_;
+    std::deque<ScheduledTask> tasks_;
+  };
+
   /**
    * Drain will notify tasks to stop following notification
    */
   void drain() {
-    worker_queue_.stop();
+    notifyWorkers();
     while (current_workers_ > 0) {
       // The sleeping workers were waken up and stopped, but we have to wait
-      // the ones that actually worked on something when the queue was stopped.
-      // Stopping the queue guarantees that they don't get any new task.
+      // the ones that actually worked on something when the pool was stopped.
       std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
   }
+
+  /**
+   * Queues the task in the work queue with the given index, or spreads it over the queues if there is no index.
+   */
+  void enqueue(ScheduledTask &&task, utils::optional<size_t> queue_index = utils::nullopt);
+  /**
+   * Takes a task from the given work queue, or steals one from the others.
+   */
+  bool dequeue(size_t queue_index, ScheduledTask &task);
+  /**
+   * Puts the task in the timer wheel, unless it has been stopped or woken up in the meantime.
+   * Parked tasks are only kept in their state until they are woken up.
+   */
+  void delay(ScheduledTask &&task, size_t queue_index);
+  void notifyWorkers();
+  /**
+   * Creates a work queue for each possible worker thread, keeping the tasks already queued.
+   */
+  void resizeWorkQueues();
+  std::shared_ptr<TaskState> getTaskState(const TaskId &identifier);
+  void stopTasks(TaskState &state);
+
 // determines if threads are detached
   bool daemon_threads_;
   std::atomic<int> thread_reduction_count_;
@@ -335,31 +471,55 @@ class ThreadPool {
   std::vector<std::shared_ptr<WorkerThread>> thread_queue_;
 // manager thread
   std::thread manager_thread_;
-// the thread responsible for putting delayed tasks to the worker queue when they had to be put
+// the thread responsible for putting delayed tasks to the work queues when they had to be put
   std::thread delayed_scheduler_thread_;
 // conditional that's used to adjust the threads
   std::atomic<bool> adjust_threads_;
 // atomic running boolean
   std::atomic<bool> running_;
-// controller service provider
+// whether the workers are allowed to take tasks
+  std::atomic<bool> paused_;
+// controller service provider reference
   std::shared_ptr<core::controller::ControllerServiceProvider> controller_service_provider_;
 // integrated power manager
   std::shared_ptr<controllers::ThreadManagementService> thread_manager_;
   // thread queue for the recently deceased threads.
   ConcurrentQueue<std::shared_ptr<WorkerThread>> deceased_thread_queue_;
-// worker queue of worker objects
-  ConditionConcurrentQueue<Worker<T>> worker_queue_;
-  std::priority_queue<Worker<T>, std::vector<Worker<T>>, DelayedTaskComparator<T>> delayed_worker_queue_;
-// mutex to  protect task status and delayed queue
-  std::mutex worker_queue_mutex_;
+// a work queue per worker thread, sized on start
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
+// guards resizing work_queues_ against the tasks queued from outside, the worker threads never run while it is resized
+  std::mutex work_queues_mutex_;
+// work queues whose owner thread has been stopped, protected by the thread queue mutex
+  std::vector<size_t> free_work_queues_;
+// number of tasks in the work queues
+  std::atomic<size_t> queued_tasks_;
+// number of workers waiting for tasks
+  std::atomic<int> idle_workers_;
+// round robin index of the work queue receiving the next task from outside
+  std::atomic<size_t> next_queue_;
+// mutex and condition for idle workers
+  std::mutex idle_mutex_;
+  std::condition_variable work_available_;
+// delayed tasks, protected by the timer mutex
+  TimerWheel<DelayedTask> timer_wheel_;
+  std::atomic<uint64_t> next_ticket_;
+  std::mutex timer_mutex_;
 // notification for new delayed tasks that's before the current ones
   std::condition_variable delayed_task_available_;
-// map to identify if a task should be
-  std::map<TaskId, bool> task_status_;
+// the time the delayed scheduler thread is going to wake up at
+  std::chrono::steady_clock::time_point timer_wakeup_time_;
+// state of the tasks, indexed by their handles
+  std::mutex task_states_mutex_;
+  std::unordered_map<TaskId, TaskHandle> task_handles_;
+  std::vector<std::shared_ptr<TaskState>> task_states_;
+// mutex to protect the thread queue
+  std::mutex thread_queue_mutex_;
 // manager mutex
   std::recursive_mutex manager_mutex_;
   // thread pool name
   std::string name_;
+  // CPUs the worker threads are restricted to, empty if there is no restriction
+  std::vector<int> cpu_affinity_;
 
   /**
    * Call for the manager to start worker threads
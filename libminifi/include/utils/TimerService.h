@@ -0,0 +1,125 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "core/logging/Logger.h"
+#include "utils/Histogram.h"
+#include "utils/OptionalUtils.h"
+#include "utils/TimerWheel.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+/**
+ * Fires any number of timers from a single thread, keeping their next deadlines in a hierarchical timer wheel,
+ * so that scheduling, firing and cancelling a timer costs O(1) regardless of the number of timers.
+ * The callbacks run on the thread of the service and are expected to only hand the work over to another thread
+ * (e.g. by waking up a task of a ThreadPool), returning when to fire next.
+ */
+class TimerService {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimerId = uint64_t;
+  /**
+   * Invoked with the deadline the timer fired for.
+   * @return the next deadline of the timer, or nullopt to cancel it
+   */
+  using Callback = std::function<utils::optional<Clock::time_point>(Clock::time_point)>;
+
+  explicit TimerService(std::string name = "TimerService");
+
+  TimerService(const TimerService&) = delete;
+  TimerService& operator=(const TimerService&) = delete;
+
+  ~TimerService();
+
+  void start();
+
+  /**
+   * Stops the thread of the service, the timers are kept and fire late once the service is started again.
+   */
+  void stop();
+
+  /**
+   * Schedules a new timer firing first at the given deadline.
+   */
+  TimerId schedule(Clock::time_point deadline, Callback callback);
+
+  /**
+   * Cancels the timer. If its callback is running on another thread, waits for it to return, so that the
+   * callback is never invoked once this returns.
+   */
+  void cancel(TimerId id);
+
+  size_t getTimerCount() const;
+
+  /**
+   * How late the timers fired after their deadlines in nanoseconds
+   */
+  const Histogram& getLateness() const {
+    return lateness_;
+  }
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+ private:
+  struct Expiration {
+    TimerId id;
+    Clock::time_point deadline;
+  };
+
+  void run();
+
+  const std::string name_;
+  mutable std::mutex mutex_;
+  // notified when a timer is due before the current wake up time, when a callback returns and on stop
+  std::condition_variable condition_;
+  bool running_;
+  std::thread thread_;
+  TimerWheel<Expiration> timer_wheel_;
+  // the callbacks of the active timers, a cancelled timer is dropped from here and its expiration is ignored
+  std::unordered_map<TimerId, std::shared_ptr<Callback>> timers_;
+  TimerId next_id_;
+  // the timer whose callback is running, 0 if none
+  TimerId firing_;
+  Clock::time_point wakeup_time_;
+  Histogram lateness_;
+  std::shared_ptr<core::logging::Logger> logger_;
+};
+
+}  // namespace utils
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
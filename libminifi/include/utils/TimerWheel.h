@@ -0,0 +1,196 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "utils/OptionalUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+/**
+ * Hierarchical timer wheel with millisecond resolution. Scheduling an item is O(1) regardless of the
+ * number of pending items; advancing the wheel costs O(1) per elapsed tick plus the items cascaded or expired.
+ * Items due in less than 64 ms are kept in the first level, those due in less than ~4 s in the second one and so on,
+ * items beyond the range of the last level are rescheduled when they reach its end.
+ * Not thread safe, the owner is expected to guard it.
+ */
+template<typename Item>
+class TimerWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit TimerWheel(Clock::time_point origin = Clock::now())
+      : origin_(origin),
+        current_tick_(0),
+        size_(0) {
+    level_sizes_.fill(0);
+  }
+
+  /**
+   * Schedules the item to expire at the first tick not before the deadline. Past deadlines expire at the next tick.
+   */
+  void schedule(Item item, Clock::time_point deadline) {
+    uint64_t tick = toTick(deadline);
+    if (tick <= current_tick_) {
+      tick = current_tick_ + 1;
+    }
+    insert(Entry{tick, std::move(item)});
+    ++size_;
+  }
+
+  /**
+   * Moves the wheel forward to now, passing the expired items to on_expired in the order of their deadlines.
+   */
+  template<typename Callback>
+  void advance(Clock::time_point now, Callback on_expired) {
+    const auto elapsed = now - origin_;
+    const uint64_t target_tick = elapsed.count() < 0 ? 0 : static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+    while (current_tick_ < target_tick) {
+      if (size_ == 0) {
+        current_tick_ = target_tick;
+        break;
+      }
+      ++current_tick_;
+      for (size_t level = 1; level < LEVELS && (current_tick_ & levelMask(level)) == 0; ++level) {
+        cascade(level);
+      }
+      std::vector<Entry> expired;
+      expired.swap(levels_[0][current_tick_ & SLOT_MASK]);
+      level_sizes_[0] -= expired.size();
+      for (auto& entry : expired) {
+        if (entry.tick <= current_tick_) {
+          --size_;
+          on_expired(std::move(entry.item));
+        } else {
+          insert(std::move(entry));
+        }
+      }
+    }
+  }
+
+  /**
+   * @return the time at which advance() should be called next, or nullopt if the wheel is empty
+   */
+  utils::optional<Clock::time_point> getNextExpiration() const {
+    if (size_ == 0) {
+      return utils::nullopt;
+    }
+    const bool has_upper_levels = size_ != level_sizes_[0];
+    for (uint64_t tick = current_tick_ + 1; tick <= current_tick_ + SLOTS; ++tick) {
+      if (!levels_[0][tick & SLOT_MASK].empty() || (has_upper_levels && (tick & SLOT_MASK) == 0)) {
+        return origin_ + std::chrono::milliseconds(tick);
+      }
+    }
+    return origin_ + std::chrono::milliseconds(current_tick_ + SLOTS);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    for (auto& level : levels_) {
+      for (auto& slot : level) {
+        slot.clear();
+      }
+    }
+    level_sizes_.fill(0);
+    size_ = 0;
+  }
+
+ private:
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr uint64_t SLOTS = uint64_t{1} << SLOT_BITS;
+  static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+  static constexpr size_t LEVELS = 4;
+
+  struct Entry {
+    uint64_t tick;
+    Item item;
+  };
+
+  static uint64_t levelMask(size_t level) {
+    return (uint64_t{1} << (SLOT_BITS * level)) - 1;
+  }
+
+  uint64_t toTick(Clock::time_point time) const {
+    const auto since_origin = time - origin_;
+    if (since_origin.count() <= 0) {
+      return 0;
+    }
+    // round up, so that nothing expires before its deadline
+    const auto ticks = std::chrono::duration_cast<std::chrono::milliseconds>(since_origin);
+    return static_cast<uint64_t>(ticks.count()) + (ticks < since_origin ? 1 : 0);
+  }
+
+  void insert(Entry&& entry) {
+    const uint64_t delta = entry.tick > current_tick_ ? entry.tick - current_tick_ : 0;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta > levelMask(level + 1)) {
+      ++level;
+    }
+    // entries beyond the range of the wheel wait at its end and get rescheduled from there
+    const uint64_t slot_tick = delta > levelMask(LEVELS) ? current_tick_ + levelMask(LEVELS) : (delta == 0 ? current_tick_ : entry.tick);
+    levels_[level][(slot_tick >> (SLOT_BITS * level)) & SLOT_MASK].push_back(std::move(entry));
+    ++level_sizes_[level];
+  }
+
+  void cascade(size_t level) {
+    std::vector<Entry> entries;
+    entries.swap(levels_[level][(current_tick_ >> (SLOT_BITS * level)) & SLOT_MASK]);
+    level_sizes_[level] -= entries.size();
+    for (auto& entry : entries) {
+      insert(std::move(entry));
+    }
+  }
+
+  Clock::time_point origin_;
+  uint64_t current_tick_;
+  size_t size_;
+  std::array<size_t, LEVELS> level_sizes_;
+  std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> levels_;
+};
+
+template<typename Item>
+constexpr unsigned TimerWheel<Item>::SLOT_BITS;
+template<typename Item>
+constexpr uint64_t TimerWheel<Item>::SLOTS;
+template<typename Item>
+constexpr uint64_t TimerWheel<Item>::SLOT_MASK;
+template<typename Item>
+constexpr size_t TimerWheel<Item>::LEVELS;
+
+}  // namespace utils
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
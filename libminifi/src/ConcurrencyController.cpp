@@ -0,0 +1,88 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ConcurrencyController.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#include "core/TypedValues.h"
+#include "utils/OsUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+
+constexpr std::chrono::milliseconds ConcurrencyController::DEFAULT_PERIOD;
+constexpr int ConcurrencyController::DEFAULT_MAX_CPU_PERCENT;
+constexpr double ConcurrencyController::HIGH_WATERMARK;
+constexpr double ConcurrencyController::LOW_WATERMARK;
+
+ConcurrencyController::ConcurrencyController(const std::shared_ptr<Configure> &configuration)
+    : period_(DEFAULT_PERIOD),
+      max_cpu_utilization_(DEFAULT_MAX_CPU_PERCENT / 100.0),
+      last_wall_time_(std::chrono::steady_clock::now()),
+      last_cpu_time_(utils::OsUtils::getProcessCpuTime()) {
+  std::string value;
+  if (configuration->get(Configure::nifi_flow_engine_adaptive_concurrency_period, value)) {
+    const auto period = core::TimePeriodValue::fromString(value);
+    if (period && period->getMilliseconds() > 0) {
+      period_ = std::chrono::milliseconds(period->getMilliseconds());
+    }
+  }
+  const int max_cpu_percent = configuration->getInt(Configure::nifi_flow_engine_adaptive_concurrency_max_cpu, DEFAULT_MAX_CPU_PERCENT);
+  if (max_cpu_percent > 0 && max_cpu_percent <= 100) {
+    max_cpu_utilization_ = max_cpu_percent / 100.0;
+  }
+}
+
+int ConcurrencyController::decide(int current_tasks, int min_tasks, int max_tasks, const Sample &sample) const {
+  const int current = (std::max)(current_tasks, 1);
+  // the time it would take the current workers to process the queued FlowFiles, if an onTrigger takes one
+  const auto backlog_time = sample.trigger_latency * static_cast<int64_t>(sample.queue.size) / current;
+
+  int desired = current;
+  if (sample.cpu_utilization >= max_cpu_utilization_) {
+    desired = current - 1;
+  } else if (sample.queue.fill_ratio >= HIGH_WATERMARK || backlog_time > period_) {
+    desired = current + 1;
+  } else if (sample.queue.fill_ratio < LOW_WATERMARK && backlog_time * 4 < period_) {
+    desired = current - 1;
+  }
+  return (std::min)((std::max)(desired, min_tasks), max_tasks);
+}
+
+double ConcurrencyController::measureCpuUtilization() {
+  const auto wall_time = std::chrono::steady_clock::now();
+  const auto cpu_time = utils::OsUtils::getProcessCpuTime();
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(wall_time - last_wall_time_);
+  const auto used = cpu_time - last_cpu_time_;
+  last_wall_time_ = wall_time;
+  last_cpu_time_ = cpu_time;
+
+  const unsigned cores = (std::max)(std::thread::hardware_concurrency(), 1u);
+  if (elapsed.count() <= 0) {
+    return 0.0;
+  }
+  return (std::min)(static_cast<double>(used.count()) / (static_cast<double>(elapsed.count()) * cores), 1.0);
+}
+
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -29,6 +29,14 @@ constexpr const char *Configuration::nifi_flow_configuration_file_backup_update;
 constexpr const char *Configuration::nifi_flow_engine_threads;
 constexpr const char *Configuration::nifi_flow_engine_alert_period;
 constexpr const char *Configuration::nifi_flow_engine_event_driven_time_slice;
+constexpr const char *Configuration::nifi_flow_engine_cpu_affinity;
+constexpr const char *Configuration::nifi_flow_engine_thread_pools;
+constexpr const char *Configuration::nifi_flow_engine_thread_pool_prefix;
+constexpr const char *Configuration::nifi_flow_engine_timer_driven_thread_pool;
+constexpr const char *Configuration::nifi_flow_engine_event_driven_thread_pool;
+constexpr const char *Configuration::nifi_flow_engine_cron_driven_thread_pool;
+constexpr const char *Configuration::nifi_flow_engine_adaptive_concurrency_period;
+constexpr const char *Configuration::nifi_flow_engine_adaptive_concurrency_max_cpu;
 constexpr const char *Configuration::nifi_administrative_yield_duration;
 constexpr const char *Configuration::nifi_bored_yield_duration;
 constexpr const char *Configuration::nifi_graceful_shutdown_seconds;
@@ -48,7 +56,19 @@ constexpr const char *Configuration::nifi_provenance_repository_directory_defaul
 constexpr const char *Configuration::nifi_flowfile_repository_max_storage_size;
 constexpr const char *Configuration::nifi_flowfile_repository_max_storage_time;
 constexpr const char *Configuration::nifi_flowfile_repository_directory_default;
+constexpr const char *Configuration::nifi_flowfile_repository_recovery_threads;
+constexpr const char *Configuration::nifi_flowfile_repository_group_commit_window;
 constexpr const char *Configuration::nifi_dbcontent_repository_directory_default;
+constexpr const char *Configuration::nifi_content_repository_session_streaming;
+constexpr const char *Configuration::nifi_content_repository_session_buffer_size;
+constexpr const char *Configuration::nifi_content_claim_max_appendable_size;
+constexpr const char *Configuration::nifi_content_claim_max_flow_files;
+constexpr const char *Configuration::nifi_content_repository_tiered_backend;
+constexpr const char *Configuration::nifi_content_repository_tiered_memory_max_size;
+constexpr const char *Configuration::nifi_content_repository_tiered_memory_watermark;
+constexpr const char *Configuration::nifi_content_repository_tiered_claim_max_size;
+constexpr const char *Configuration::nifi_content_repository_tiered_spill_age;
+constexpr const char *Configuration::nifi_queue_swap_threshold;
 constexpr const char *Configuration::nifi_remote_input_secure;
 constexpr const char *Configuration::nifi_remote_input_http;
 constexpr const char *Configuration::nifi_security_need_ClientAuth;
@@ -19,6 +19,7 @@
  */
 #include "Connection.h"
 #include <time.h>
+#include <cinttypes>
 #include <vector>
 #include <queue>
 #include <memory>
@@ -29,15 +30,21 @@
 #include <thread>
 #include <iostream>
 #include <list>
+#include <iterator>
+#include <algorithm>
 #include "core/FlowFile.h"
+#include "FlowFileRecord.h"
 #include "core/Processor.h"
 #include "core/logging/LoggerConfiguration.h"
+#include "utils/gsl.h"
 
 namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
 
+constexpr double Connection::BACK_PRESSURE_RESUME_RATIO;
+
 Connection::Connection(const std::shared_ptr<core::Repository> &flow_repository, const std::shared_ptr<core::ContentRepository> &content_repo, std::string name)
     : core::Connectable(name),
       flow_repository_(flow_repository),
@@ -112,40 +119,56 @@ Connection::Connection(const std::shared_ptr<core::Repository> &flow_repository,
 }
 
 bool Connection::isEmpty() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-
-  return queue_.empty();
+  return queued_count_ == 0;
 }
 
 bool Connection::isFull() {
-  std::lock_guard<std::mutex> lock(mutex_);
-
   if (max_queue_size_ <= 0 && max_data_queue_size_ <= 0)
     // No back pressure setting
     return false;
 
-  if (max_queue_size_ > 0 && queue_.size() >= max_queue_size_)
-    return true;
-
-  if (max_data_queue_size_ > 0 && queued_data_size_ >= max_data_queue_size_)
+  if ((max_queue_size_ > 0 && queued_count_ >= max_queue_size_) || (max_data_queue_size_ > 0 && queued_data_size_ >= max_data_queue_size_)) {
+    back_pressure_applied_ = true;
     return true;
+  }
 
   return false;
 }
 
+void Connection::checkBackPressureRelieved() {
+  if (!back_pressure_applied_) {
+    return;
+  }
+  const uint64_t max_queue_size = max_queue_size_;
+  if (max_queue_size > 0 && queued_count_ > static_cast<uint64_t>(max_queue_size * BACK_PRESSURE_RESUME_RATIO)) {
+    return;
+  }
+  const uint64_t max_data_queue_size = max_data_queue_size_;
+  if (max_data_queue_size > 0 && queued_data_size_ > static_cast<uint64_t>(max_data_queue_size * BACK_PRESSURE_RESUME_RATIO)) {
+    return;
+  }
+  if (back_pressure_applied_.exchange(false) && source_connectable_) {
+    logger_->log_debug("Notifying %s that connection %s drained below its back pressure thresholds", source_connectable_->getName(), name_);
+    source_connectable_->notifyBackPressureRelieved();
+  }
+}
+
 void Connection::put(const std::shared_ptr<core::FlowFile>& flow) {
   if (drop_empty_ && flow->getSize() == 0) {
     logger_->log_info("Dropping empty flow file: %s", flow->getUUIDStr());
     return;
   }
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    queue_.push(flow);
-
-    queued_data_size_ += flow->getSize();
-
-    logger_->log_debug("Enqueue flow file UUID %s to connection %s", flow->getUUIDStr(), name_);
+  ++queued_count_;
+  queued_data_size_ += flow->getSize();
+  incoming_.enqueue(IncomingFlowFile{next_incoming_sequence_number_++, flow});
+  logger_->log_debug("Enqueue flow file UUID %s to connection %s", flow->getUUIDStr(), name_);
+
+  if (swap_threshold_ > 0) {
+    // keep the number of flow files in memory bounded, unless a consumer is at it already
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (lock.owns_lock()) {
+      transferIncoming();
+    }
   }
 
   // Notify receiving processor that work may be available
@@ -156,19 +179,30 @@ void Connection::put(const std::shared_ptr<core::FlowFile>& flow) {
 }
 
 void Connection::multiPut(std::vector<std::shared_ptr<core::FlowFile>>& flows) {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    for (auto &ff : flows) {
-      if (drop_empty_ && ff->getSize() == 0) {
-        logger_->log_info("Dropping empty flow file: %s", ff->getUUIDStr());
-        continue;
-      }
-
-      queue_.push(ff);
-      queued_data_size_ += ff->getSize();
+  std::vector<IncomingFlowFile> kept;
+  kept.reserve(flows.size());
+  uint64_t size = 0;
+  for (auto &ff : flows) {
+    if (drop_empty_ && ff->getSize() == 0) {
+      logger_->log_info("Dropping empty flow file: %s", ff->getUUIDStr());
+      continue;
+    }
+    size += ff->getSize();
+    kept.push_back(IncomingFlowFile{0, ff});
+  }
+  queued_count_ += kept.size();
+  queued_data_size_ += size;
+  const uint64_t first_sequence_number = next_incoming_sequence_number_.fetch_add(kept.size());
+  for (size_t i = 0; i < kept.size(); ++i) {
+    kept[i].sequence_number = first_sequence_number + i;
+  }
+  incoming_.enqueue_bulk(std::make_move_iterator(kept.begin()), kept.size());
+  logger_->log_debug("Enqueue %zu flow files to connection %s", kept.size(), name_);
 
-      logger_->log_debug("Enqueue flow file UUID %s to connection %s", ff->getUUIDStr(), name_);
+  if (swap_threshold_ > 0) {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (lock.owns_lock()) {
+      transferIncoming();
     }
   }
 
@@ -179,10 +213,87 @@ void Connection::multiPut(std::vector<std::shared_ptr<core::FlowFile>>& flows) {
 }
 
 std::shared_ptr<core::FlowFile> Connection::poll(std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords) {
+  const std::shared_ptr<Connectable> connectable = std::static_pointer_cast<Connectable>(shared_from_this());
+  std::shared_ptr<core::FlowFile> item;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    do {
+      item = pollLocked(connectable, expiredFlowRecords);
+    } while (!item && swapIn(lock));
+  }
+  checkBackPressureRelieved();
+  return item;
+}
+
+size_t Connection::pollBatch(std::vector<std::shared_ptr<core::FlowFile>> &flowFiles, size_t max, uint64_t maxBytes, std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords) {
+  const std::shared_ptr<Connectable> connectable = std::static_pointer_cast<Connectable>(shared_from_this());
+  size_t count = 0;
+  uint64_t bytes = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (count < max && bytes < maxBytes) {
+      std::shared_ptr<core::FlowFile> item = pollLocked(connectable, expiredFlowRecords);
+      if (!item) {
+        if (swapIn(lock)) {
+          continue;
+        }
+        break;
+      }
+      bytes += item->getSize();
+      flowFiles.push_back(std::move(item));
+      ++count;
+    }
+  }
+  checkBackPressureRelieved();
+  if (count > 0) {
+    logger_->log_debug("Dequeued %zu flow files of %" PRIu64 " bytes from connection %s", count, bytes, name_);
+  }
+  return count;
+}
+
+bool Connection::isWorkAvailable() {
+  if (queued_count_ == 0) {
+    return false;
+  }
+  if (incoming_.size_approx() > 0) {
+    return true;
+  }
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    // a consumer is polling, it is worth a trigger to check what it leaves behind
+    return true;
+  }
+  // swapped out flow files are never penalized
+  return queue_.isWorkAvailable() || !swapped_.empty() || swapping_in_ > 0;
+}
+
+uint64_t Connection::getSwappedQueueSize() {
   std::lock_guard<std::mutex> lock(mutex_);
+  transferIncoming();
+  return swapped_.size();
+}
 
+void Connection::transferIncoming() {
+  IncomingFlowFile flow_files[64];
+  size_t count;
+  while ((count = incoming_.try_dequeue_bulk(flow_files, 64)) > 0) {
+    std::move(flow_files, flow_files + count, std::back_inserter(transfer_buffer_));
+  }
+  // the flow files of the producers are dequeued one producer after the other, restore the order of the puts
+  std::sort(transfer_buffer_.begin(), transfer_buffer_.end(), [](const IncomingFlowFile &left, const IncomingFlowFile &right) {
+    return left.sequence_number < right.sequence_number;
+  });
+  for (auto &incoming : transfer_buffer_) {
+    enqueue(incoming.flow_file);
+  }
+  transfer_buffer_.clear();
+}
+
+std::shared_ptr<core::FlowFile> Connection::pollLocked(const std::shared_ptr<Connectable> &connectable, std::set<std::shared_ptr<core::FlowFile>> &expiredFlowRecords) {
+  transferIncoming();
   while (queue_.isWorkAvailable()) {
     std::shared_ptr<core::FlowFile> item = queue_.pop();
+    --queued_count_;
     queued_data_size_ -= item->getSize();
 
     if (expired_duration_ > 0) {
@@ -192,13 +303,11 @@ std::shared_ptr<core::FlowFile> Connection::poll(std::set<std::shared_ptr<core::
         expiredFlowRecords.insert(item);
         logger_->log_debug("Delete flow file UUID %s from connection %s, because it expired", item->getUUIDStr(), name_);
       } else {
-        std::shared_ptr<Connectable> connectable = std::static_pointer_cast<Connectable>(shared_from_this());
         item->setConnection(connectable);
         logger_->log_debug("Dequeue flow file UUID %s from connection %s", item->getUUIDStr(), name_);
         return item;
       }
     } else {
-      std::shared_ptr<Connectable> connectable = std::static_pointer_cast<Connectable>(shared_from_this());
       item->setConnection(connectable);
       logger_->log_debug("Dequeue flow file UUID %s from connection %s", item->getUUIDStr(), name_);
       return item;
@@ -208,11 +317,78 @@ std::shared_ptr<core::FlowFile> Connection::poll(std::set<std::shared_ptr<core::
   return NULL;
 }
 
+void Connection::enqueue(const std::shared_ptr<core::FlowFile> &flow) {
+  // only the flow files persisted to the repository can be swapped out, penalized ones are kept in memory to retain their penalty
+  if (swap_threshold_ > 0 && (!swapped_.empty() || queue_.size() >= swap_threshold_)
+      && flow->isStored() && !flow->isPenalized() && !flow_repository_->isNoop()) {
+    swapped_.push_back({flow->getUUID(), flow->getSize(), queue_.reserve(), flow->getResourceClaim()});
+    logger_->log_debug("Swapped out flow file UUID %s of connection %s", flow->getUUIDStr(), name_);
+    return;
+  }
+
+  queue_.push(flow);
+}
+
+bool Connection::swapIn(std::unique_lock<std::mutex> &lock) {
+  if (swapped_.empty()) {
+    return false;
+  }
+  // swap in at least one, so that the penalized flow files filling the queue do not hold back the swapped out ones
+  const uint64_t free_slots = swap_threshold_ > queue_.size() + swapping_in_ ? swap_threshold_ - queue_.size() - swapping_in_ : 1;
+  const size_t count = gsl::narrow<size_t>((std::min<uint64_t>)(swapped_.size(), free_slots));
+  std::vector<SwappedFlowFile> batch(std::make_move_iterator(swapped_.begin()), std::make_move_iterator(swapped_.begin() + count));
+  swapped_.erase(swapped_.begin(), swapped_.begin() + count);
+  swapping_in_ += count;
+
+  // the producers and the other consumers can go on while the flow files are read from the repository
+  lock.unlock();
+  std::vector<std::shared_ptr<FlowFileRecord>> records;
+  records.reserve(count);
+  for (const auto &swapped : batch) {
+    utils::Identifier container;
+    std::shared_ptr<FlowFileRecord> record = FlowFileRecord::DeSerialize(swapped.uuid.to_string(), flow_repository_, content_repo_, container);
+    if (!record) {
+      logger_->log_error("Could not swap in flow file UUID %s of connection %s", swapped.uuid.to_string(), name_);
+      --queued_count_;
+      queued_data_size_ -= swapped.size;
+    } else {
+      record->setStoredToRepository(true);
+    }
+    records.push_back(std::move(record));
+  }
+  lock.lock();
+
+  swapping_in_ -= count;
+  for (size_t i = 0; i < count; ++i) {
+    if (records[i]) {
+      // the prioritizers order the swapped in flow files among the ones in memory
+      queue_.pushReserved(std::move(records[i]), batch[i].sequence_number);
+    }
+  }
+  logger_->log_debug("Swapped in %zu flow files to connection %s, %zu remain swapped out", count, name_, swapped_.size());
+  return true;
+}
+
 void Connection::drain(bool delete_permanently) {
+  const auto relieve_back_pressure = gsl::finally([this] { checkBackPressureRelieved(); });
   std::lock_guard<std::mutex> lock(mutex_);
 
+  transferIncoming();
+  // the swapped out flow files are deleted by their key, without reading them back
+  for (const auto &swapped : swapped_) {
+    --queued_count_;
+    queued_data_size_ -= swapped.size;
+    logger_->log_debug("Delete swapped out flow file UUID %s from connection %s", swapped.uuid.to_string(), name_);
+    if (delete_permanently && flow_repository_->Delete(swapped.uuid.to_string())) {
+      if (swapped.claim) swapped.claim->decreaseFlowFileRecordOwnedCount();
+    }
+  }
+  swapped_.clear();
+
   while (!queue_.empty()) {
     std::shared_ptr<core::FlowFile> item = queue_.pop();
+    --queued_count_;
+    queued_data_size_ -= item->getSize();
     logger_->log_debug("Delete flow file UUID %s from connection %s, because it expired", item->getUUIDStr(), name_);
     if (delete_permanently) {
       if (item->isStored() && flow_repository_->Delete(item->getUUIDStr())) {
@@ -222,7 +398,6 @@ void Connection::drain(bool delete_permanently) {
       }
     }
   }
-  queued_data_size_ = 0;
   logger_->log_debug("Drain connection %s", name_);
 }
 
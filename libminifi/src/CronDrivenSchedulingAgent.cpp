@@ -19,9 +19,12 @@
  */
 #include "CronDrivenSchedulingAgent.h"
 #include <chrono>
+#include <map>
 #include <memory>
+#include <string>
 #include <thread>
 #include <iostream>
+#include <utility>
 #include "core/Processor.h"
 #include "core/ProcessContext.h"
 #include "core/ProcessSessionFactory.h"
@@ -32,51 +35,108 @@ namespace apache {
 namespace nifi {
 namespace minifi {
 
+CronDrivenSchedulingAgent::~CronDrivenSchedulingAgent() {
+  // the timers refer to the thread pools, which may be gone before the shared timer service
+  if (timer_service_) {
+    for (const auto &schedule : schedules_) {
+      timer_service_->cancel(schedule.second->timer);
+    }
+  }
+}
+
+void CronDrivenSchedulingAgent::schedule(std::shared_ptr<core::Processor> processor) {
+  std::shared_ptr<CronSchedule> schedule;
+  try {
+    schedule = std::make_shared<CronSchedule>(processor->getCronPeriod());
+  } catch (const Bosma::BadCronExpression &exception) {
+    throw Exception(PROCESS_SCHEDULE_EXCEPTION, "Invalid cron schedule of processor " + processor->getName() + ": " + exception.what());
+  }
+
+  ThreadedSchedulingAgent::schedule(processor);
+
+  auto &thread_pool = getThreadPool(*processor);
+  if (!thread_pool.isTaskRunning(processor->getUUIDStr())) {
+    return;
+  }
+  const utils::TaskHandle task_handle = thread_pool.getTaskHandle(processor->getUUIDStr());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (schedules_.count(processor->getUUID()) > 0) {
+    return;
+  }
+  if (!timer_service_) {
+    timer_service_ = std::make_shared<utils::TimerService>("Cron timer service");
+    timer_service_->start();
+  }
+  schedule->timer = timer_service_->schedule(nextFireTime(schedule->cron, std::chrono::system_clock::now()),
+      [schedule, &thread_pool, task_handle](utils::TimerService::Clock::time_point) -> utils::optional<utils::TimerService::Clock::time_point> {
+    schedule->due = true;
+    thread_pool.wakeUp(task_handle);
+    // the clocks may disagree slightly, the timer must not fire twice for the same minute
+    return nextFireTime(schedule->cron, std::chrono::system_clock::now() + std::chrono::seconds(1));
+  });
+  schedules_.emplace(processor->getUUID(), std::move(schedule));
+}
+
+void CronDrivenSchedulingAgent::unschedule(std::shared_ptr<core::Processor> processor) {
+  std::shared_ptr<CronSchedule> schedule;
+  std::shared_ptr<utils::TimerService> timer_service;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = schedules_.find(processor->getUUID());
+    if (it != schedules_.end()) {
+      schedule = it->second;
+      schedules_.erase(it);
+    }
+    timer_service = timer_service_;
+  }
+  if (schedule && timer_service) {
+    timer_service->cancel(schedule->timer);
+  }
+  ThreadedSchedulingAgent::unschedule(processor);
+}
+
+void CronDrivenSchedulingAgent::stop() {
+  std::map<utils::Identifier, std::shared_ptr<CronSchedule>> schedules;
+  std::shared_ptr<utils::TimerService> timer_service;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedules.swap(schedules_);
+    timer_service = timer_service_;
+  }
+  if (timer_service) {
+    for (const auto &schedule : schedules) {
+      timer_service->cancel(schedule.second->timer);
+    }
+  }
+  ThreadedSchedulingAgent::stop();
+}
+
 utils::TaskRescheduleInfo CronDrivenSchedulingAgent::run(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
                                         const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
   if (this->running_ && processor->isRunning()) {
-    auto uuid = processor->getUUID();
-    std::chrono::system_clock::time_point result;
-    std::chrono::system_clock::time_point from = std::chrono::system_clock::now();
+    std::shared_ptr<CronSchedule> schedule;
     {
-      std::lock_guard<std::mutex> locK(mutex_);
-
-      auto sched_f = schedules_.find(uuid);
-      if (sched_f != std::end(schedules_)) {
-        result = last_exec_[uuid];
-        if (from >= result) {
-          result = sched_f->second.cron_to_next(from);
-          last_exec_[uuid] = result;
-        } else {
-          // we may be woken up a little early so that we can honor our time.
-          // in this case we can return the next time to run with the expectation
-          // that the wakeup mechanism gets more granular.
-          return utils::TaskRescheduleInfo::RetryIn(std::chrono::duration_cast<std::chrono::milliseconds>(result - from));
-        }
-      } else {
-        Bosma::Cron schedule(processor->getCronPeriod());
-        result = schedule.cron_to_next(from);
-        last_exec_[uuid] = result;
-        schedules_.insert(std::make_pair(uuid, schedule));
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = schedules_.find(processor->getUUID());
+      if (it != schedules_.end()) {
+        schedule = it->second;
       }
     }
-
-    if (result > from) {
-      bool shouldYield = this->onTrigger(processor, processContext, sessionFactory);
-
-      if (processor->isYield()) {
-        // Honor the yield
-        return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(processor->getYieldTime()));
-      } else if (shouldYield && this->bored_yield_duration_ > 0) {
-        // No work to do or need to apply back pressure
-        return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(this->bored_yield_duration_));
-      }
+    // every worker of the processor is woken up, only one of them triggers it
+    if (schedule && schedule->due.exchange(false)) {
+      this->onTrigger(processor, processContext, sessionFactory);
     }
-    return utils::TaskRescheduleInfo::RetryIn(std::chrono::duration_cast<std::chrono::milliseconds>(result - from));
+    // stand by until the timer of the processor fires again
+    return utils::TaskRescheduleInfo::Park();
   }
   return utils::TaskRescheduleInfo::Done();
 }
 
+utils::TimerService::Clock::time_point CronDrivenSchedulingAgent::nextFireTime(const Bosma::Cron &cron, std::chrono::system_clock::time_point from) {
+  const auto now = std::chrono::system_clock::now();
+  return utils::TimerService::Clock::now() + std::chrono::duration_cast<utils::TimerService::Clock::duration>(cron.cron_to_next(from) - now);
+}
+
 } /* namespace minifi */
 } /* namespace nifi */
 } /* namespace apache */
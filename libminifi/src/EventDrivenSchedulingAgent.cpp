@@ -42,14 +42,21 @@ utils::TaskRescheduleInfo EventDrivenSchedulingAgent::run(const std::shared_ptr<
     auto start_time = std::chrono::steady_clock::now();
     // trigger processor until it has work to do, but no more than half a sec
     while (processor->isRunning() && (std::chrono::steady_clock::now() - start_time < time_slice_)) {
-      bool shouldYield = this->onTrigger(processor, processContext, sessionFactory);
+      bool shouldYield = processor->getRunDurationNano() > 0 ? this->onTriggerForRunDuration(processor, processContext, sessionFactory)
+          : this->onTrigger(processor, processContext, sessionFactory);
       if (processor->isYield()) {
         // Honor the yield
         return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(processor->getYieldTime()));
       } else if (shouldYield) {
-        // No work to do or need to apply back pressure
-        return utils::TaskRescheduleInfo::RetryIn(
-            std::chrono::milliseconds((this->bored_yield_duration_ > 0) ? this->bored_yield_duration_ : 10));  // No work left to do, stand by
+        if (processor->isThrottledByBackpressure()) {
+          if (processor->parkOnBackPressure()) {
+            // Stand by until the full outgoing connection drains
+            return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(MAX_PARK_TIME_MS));
+          }
+        } else if (processor->park()) {
+          // No work left to do, stand by until an incoming connection notifies us
+          return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(MAX_PARK_TIME_MS));
+        }
       }
     }
     return utils::TaskRescheduleInfo::RetryImmediately();  // Let's continue work as soon as a thread is available
@@ -18,6 +18,8 @@
  * limitations under the License.
  */
 #include <time.h>
+#include <algorithm>
+#include <iterator>
 #include <vector>
 #include <map>
 #include <chrono>
@@ -50,6 +52,8 @@
 #include "utils/file/FileSystem.h"
 #include "utils/HTTPClient.h"
 #include "utils/GeneralUtils.h"
+#include "utils/OsUtils.h"
+#include "utils/StringUtils.h"
 #include "io/NetworkPrioritizer.h"
 #include "io/validation.h"
 
@@ -69,6 +73,8 @@ FlowController::FlowController(std::shared_ptr<core::Repository> provenance_repo
       updating_(false),
       initialized_(false),
       thread_pool_(2, false, nullptr, "Flowcontroller threadpool"),
+      thread_pool_metrics_(std::make_shared<state::response::ThreadPoolMetrics>()),
+      processor_profile_metrics_(std::make_shared<state::response::ProcessorProfileMetrics>()),
       logger_(logging::LoggerFactory<FlowController>::getLogger()) {
   if (provenance_repo_ == nullptr)
     throw std::runtime_error("Provenance Repo should not be null");
@@ -202,6 +208,9 @@ int16_t FlowController::stop() {
     event_scheduler_->stop();
     cron_scheduler_->stop();
     thread_pool_.shutdown();
+    for (auto& thread_pool : active_thread_pools_) {
+      thread_pool.second->shutdown();
+    }
     /* STOP! Before you change it, consider the following:
      * -Stopping the schedulers doesn't actually quit the onTrigger functions of processors
      * -They only guarantee that the processors are not scheduled any more
@@ -303,6 +312,11 @@ void FlowController::load(const std::shared_ptr<core::ProcessGroup> &root, bool
     }
 
     logger_->log_info("Loaded root processor Group");
+    std::vector<std::shared_ptr<core::Processor>> processors;
+    if (root_) {
+      root_->getAllProcessors(processors);
+    }
+    processor_profile_metrics_->setProcessors(std::move(processors));
     logger_->log_info("Initializing timers");
     controller_service_provider_impl_ = flow_configuration_->getControllerServiceProvider();
     auto base_shared_ptr = std::dynamic_pointer_cast<core::controller::ControllerServiceProvider>(shared_from_this());
@@ -310,13 +324,19 @@ void FlowController::load(const std::shared_ptr<core::ProcessGroup> &root, bool
     if (!thread_pool_.isRunning() || reload) {
       thread_pool_.shutdown();
       thread_pool_.setMaxConcurrentTasks(configuration_->getInt(Configure::nifi_flow_engine_threads, 2));
+      thread_pool_.setCpuAffinity(getCpuAffinity(Configure::nifi_flow_engine_cpu_affinity));
       thread_pool_.setControllerServiceProvider(base_shared_ptr);
       thread_pool_.start();
+      reloadThreadPools(base_shared_ptr);
     }
 
     conditionalReloadScheduler<TimerDrivenSchedulingAgent>(timer_scheduler_, !timer_scheduler_ || reload);
     conditionalReloadScheduler<EventDrivenSchedulingAgent>(event_scheduler_, !event_scheduler_ || reload);
     conditionalReloadScheduler<CronDrivenSchedulingAgent>(cron_scheduler_, !cron_scheduler_ || reload);
+    timer_scheduler_->setThreadPools(active_thread_pools_, getStrategyThreadPool(Configure::nifi_flow_engine_timer_driven_thread_pool));
+    event_scheduler_->setThreadPools(active_thread_pools_, getStrategyThreadPool(Configure::nifi_flow_engine_event_driven_thread_pool));
+    cron_scheduler_->setThreadPools(active_thread_pools_, getStrategyThreadPool(Configure::nifi_flow_engine_cron_driven_thread_pool));
+    cron_scheduler_->setTimerService(timer_service_);
 
     std::static_pointer_cast<core::controller::StandardControllerServiceProvider>(controller_service_provider_impl_)->setRootGroup(root_);
     std::static_pointer_cast<core::controller::StandardControllerServiceProvider>(controller_service_provider_impl_)->setSchedulingAgent(
@@ -343,6 +363,97 @@ void FlowController::load(const std::shared_ptr<core::ProcessGroup> &root, bool
   }
 }
 
+std::vector<core::ThreadPoolDefinition> FlowController::getThreadPoolDefinitions() {
+  std::map<std::string, core::ThreadPoolDefinition> definitions;
+  std::string pool_names;
+  if (configuration_->get(Configure::nifi_flow_engine_thread_pools, pool_names)) {
+    for (const auto& name : utils::StringUtils::splitAndTrim(pool_names, ",")) {
+      if (name.empty()) {
+        continue;
+      }
+      if (core::ThreadPoolDefinition::isProcessorPoolName(name)) {
+        logger_->log_error("Ignoring thread pool %s, the prefix %s is reserved for the thread pools of the pinned processors",
+            name, core::ThreadPoolDefinition::getProcessorPoolPrefix());
+        continue;
+      }
+      const std::string prefix = Configure::nifi_flow_engine_thread_pool_prefix + name;
+      core::ThreadPoolDefinition definition;
+      definition.name = name;
+      definition.max_threads = configuration_->getInt(prefix + ".threads", 1);
+      definition.cpu_affinity = getCpuAffinity(prefix + ".cpu.affinity");
+      definitions[name] = definition;
+    }
+  }
+  for (const auto& definition : flow_configuration_->getThreadPoolDefinitions()) {
+    definitions[definition.name] = definition;
+  }
+  std::vector<core::ThreadPoolDefinition> result;
+  for (auto& definition : definitions) {
+    result.push_back(std::move(definition.second));
+  }
+  return result;
+}
+
+void FlowController::reloadThreadPools(const std::shared_ptr<core::controller::ControllerServiceProvider> &controller_service_provider) {
+  for (auto& thread_pool : thread_pools_) {
+    thread_pool.second->shutdown();
+  }
+  active_thread_pools_.clear();
+  std::vector<utils::ThreadPool<utils::TaskRescheduleInfo>*> metered_thread_pools{&thread_pool_};
+  for (const auto& definition : getThreadPoolDefinitions()) {
+    auto& thread_pool = thread_pools_[definition.name];
+    if (!thread_pool) {
+      thread_pool = utils::make_unique<utils::ThreadPool<utils::TaskRescheduleInfo>>(definition.max_threads, false, nullptr, definition.name);
+    }
+    thread_pool->setMaxConcurrentTasks(gsl::narrow<uint16_t>((std::max)(definition.max_threads, 1)));
+    thread_pool->setCpuAffinity(definition.cpu_affinity);
+    thread_pool->setControllerServiceProvider(controller_service_provider);
+    thread_pool->start();
+    logger_->log_info("Started thread pool %s with %d threads", definition.name, definition.max_threads);
+    active_thread_pools_[definition.name] = thread_pool.get();
+    metered_thread_pools.push_back(thread_pool.get());
+  }
+  thread_pool_metrics_->setThreadPools(std::move(metered_thread_pools));
+}
+
+std::vector<int> FlowController::getCpuAffinity(const std::string &property) {
+  std::string cpu_list;
+  if (!configuration_->get(property, cpu_list)) {
+    return {};
+  }
+  try {
+    return utils::OsUtils::parseCpuList(cpu_list);
+  } catch (const std::invalid_argument& ex) {
+    logger_->log_error("Ignoring %s: %s", property, ex.what());
+    return {};
+  }
+}
+
+std::string FlowController::getStrategyThreadPool(const char *property) {
+  std::string pool_name;
+  if (!configuration_->get(property, pool_name) || pool_name.empty()) {
+    return "";
+  }
+  if (active_thread_pools_.find(pool_name) == active_thread_pools_.end()) {
+    logger_->log_error("%s refers to the undefined thread pool %s, using the default one", property, pool_name);
+    return "";
+  }
+  return pool_name;
+}
+
+std::vector<std::shared_ptr<state::response::ResponseNode>> FlowController::getComponentMetricsNodes() const {
+  return {thread_pool_metrics_, processor_profile_metrics_};
+}
+
+std::shared_ptr<state::response::ResponseNode> FlowController::getMetricsNode(const std::string& name) const {
+  for (auto& metrics_node : getComponentMetricsNodes()) {
+    if (metrics_node->getName() == name) {
+      return metrics_node;
+    }
+  }
+  return nullptr;
+}
+
 void FlowController::loadFlowRepo() {
   if (this->flow_file_repo_ != nullptr) {
     logger_->log_debug("Getting connection map");
@@ -385,6 +496,9 @@ int16_t FlowController::start() {
       this->provenance_repo_->start();
       this->flow_file_repo_->start();
       thread_pool_.start();
+      for (auto& thread_pool : active_thread_pools_) {
+        thread_pool.second->start();
+      }
       logger_->log_info("Started Flow Controller");
     }
     return 0;
@@ -400,6 +514,9 @@ int16_t FlowController::pause() {
 
   logger_->log_info("Pausing Flow Controller");
   thread_pool_.pause();
+  for (auto& thread_pool : active_thread_pools_) {
+    thread_pool.second->pause();
+  }
   return 0;
 }
 
@@ -412,6 +529,9 @@ int16_t FlowController::resume() {
 
   logger_->log_info("Resuming Flow Controller");
   thread_pool_.resume();
+  for (auto& thread_pool : active_thread_pools_) {
+    thread_pool.second->resume();
+  }
   return 0;
 }
 
@@ -507,6 +627,10 @@ uint64_t FlowController::getUptime() {
 
 std::vector<BackTrace> FlowController::getTraces() {
   std::vector<BackTrace> traces{thread_pool_.getTraces()};
+  for (auto& thread_pool : active_thread_pools_) {
+    auto pool_traces = thread_pool.second->getTraces();
+    std::move(pool_traces.begin(), pool_traces.end(), std::back_inserter(traces));
+  }
   auto prov_repo_trace = provenance_repo_->getTraces();
   traces.emplace_back(std::move(prov_repo_trace));
   auto flow_repo_trace = flow_file_repo_->getTraces();
@@ -27,17 +27,102 @@
 #include <iostream>
 #include <fstream>
 #include <cinttypes>
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include "FlowFileRecord.h"
 #include "core/logging/LoggerConfiguration.h"
 #include "core/Relationship.h"
 #include "core/Repository.h"
 #include "utils/gsl.h"
+#include "utils/StringUtils.h"
 
 namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
 
+namespace {
+
+constexpr uint8_t COMPACT_FORMAT_MARKER = 0xFF;
+constexpr uint8_t COMPACT_FORMAT_VERSION = 1;
+
+/**
+ * The attribute keys stored as an index in the compact format. Being part of the format,
+ * keys can only be appended to this list, never removed or reordered.
+ */
+const std::vector<std::string>& getAttributeKeyDictionary() {
+  static const std::vector<std::string> dictionary{
+    "filename", "path", "absolute.path", "uuid", "priority", "mime.type", "discard.reason", "alternate.identifier", "flow.id",
+    "file.size", "file.creationTime", "file.lastModifiedTime", "file.lastAccessTime", "file.owner", "file.group", "file.permissions",
+    "fragment.identifier", "fragment.index", "fragment.count", "segment.original.filename",
+    "kafka.topic", "kafka.partition", "kafka.offset", "kafka.key",
+    "http.status.code", "http.status.message", "invokehttp.status.code", "invokehttp.status.message", "invokehttp.request.url", "invokehttp.tx.id",
+    "tailfile.original.path", "s2s.host", "s2s.address", "syslog.priority", "syslog.severity", "syslog.facility", "syslog.timestamp", "syslog.hostname",
+  };
+  return dictionary;
+}
+
+void appendVarint(std::string& buffer, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    if (value != 0) {
+      byte |= 0x80;
+    }
+    buffer.push_back(static_cast<char>(byte));
+  } while (value != 0);
+}
+
+void appendString(std::string& buffer, const std::string& value) {
+  appendVarint(buffer, value.size());
+  buffer.append(value);
+}
+
+void appendIdentifier(std::string& buffer, const utils::Identifier& id) {
+  const auto& data = id.getData();
+  buffer.append(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+bool readVarint(io::InputStream& stream, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte = 0;
+    if (stream.read(&byte, 1) != 1) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool readBytes(io::InputStream& stream, uint64_t length, std::string& value) {
+  if (length > static_cast<uint64_t>((std::numeric_limits<int>::max)())) {
+    return false;
+  }
+  value.resize(gsl::narrow<size_t>(length));
+  return length == 0 || stream.read(reinterpret_cast<uint8_t*>(&value[0]), gsl::narrow<int>(length)) == gsl::narrow<int>(length);
+}
+
+bool readString(io::InputStream& stream, std::string& value) {
+  uint64_t length = 0;
+  return readVarint(stream, length) && readBytes(stream, length, value);
+}
+
+bool readIdentifier(io::InputStream& stream, utils::Identifier& id) {
+  utils::Identifier::Data data{};
+  if (stream.read(data.data(), gsl::narrow<int>(data.size())) != gsl::narrow<int>(data.size())) {
+    return false;
+  }
+  id = data;
+  return true;
+}
+
+}  // namespace
+
 std::shared_ptr<logging::Logger> FlowFileRecord::logger_ = logging::LoggerFactory<FlowFileRecord>::getLogger();
 std::atomic<uint64_t> FlowFileRecord::local_flow_seq_number_(0);
 
@@ -70,70 +155,47 @@ std::shared_ptr<FlowFileRecord> FlowFileRecord::DeSerialize(const std::string& k
 }
 
 bool FlowFileRecord::Serialize(io::OutputStream &outStream) {
-  int ret;
-
-  ret = outStream.write(event_time_);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(entry_date_);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(lineage_start_date_);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(uuid_);
-  if (ret <= 0) {
-    return false;
-  }
-
-  utils::Identifier containerId;
-  if (connection_) {
-    containerId = connection_->getUUID();
-  }
-  ret = outStream.write(containerId);
-  if (ret <= 0) {
-    return false;
-  }
-  // write flow attributes
-  uint32_t numAttributes = gsl::narrow<uint32_t>(attributes_.size());
-  ret = outStream.write(numAttributes);
-  if (ret != 4) {
-    return false;
-  }
-
-  for (auto& itAttribute : attributes_) {
-    ret = outStream.write(itAttribute.first, true);
-    if (ret <= 0) {
-      return false;
+  std::string record;
+  record.reserve(256);
+  record.push_back(static_cast<char>(COMPACT_FORMAT_MARKER));
+  record.push_back(static_cast<char>(COMPACT_FORMAT_VERSION));
+
+  appendVarint(record, event_time_);
+  appendVarint(record, entry_date_);
+  appendVarint(record, lineage_start_date_);
+  appendIdentifier(record, uuid_);
+  appendIdentifier(record, connection_ ? connection_->getUUID() : utils::Identifier{});
+
+  // the low bit of the key tag tells whether the key is stored inline or as an index into the dictionary
+  appendVarint(record, attributes_->size());
+  for (const auto& itAttribute : *attributes_) {
+    const auto& dictionary = getAttributeKeyDictionary();
+    const auto known_key = std::find(dictionary.begin(), dictionary.end(), itAttribute.first);
+    if (known_key != dictionary.end()) {
+      appendVarint(record, (static_cast<uint64_t>(std::distance(dictionary.begin(), known_key)) << 1) | 1);
+    } else {
+      appendVarint(record, static_cast<uint64_t>(itAttribute.first.size()) << 1);
+      record.append(itAttribute.first);
     }
-    ret = outStream.write(itAttribute.second, true);
-    if (ret <= 0) {
-      return false;
-    }
-  }
-
-  ret = outStream.write(getContentFullPath());
-  if (ret <= 0) {
-    return false;
+    appendString(record, itAttribute.second);
   }
 
-  ret = outStream.write(size_);
-  if (ret != 8) {
-    return false;
+  // likewise, the low bit of the path tag tells whether the path is relative to the storage path of the claim
+  std::string content_path = getContentFullPath();
+  const std::string storage_path = claim_ ? claim_->getStoragePath() : "";
+  if (!storage_path.empty() && content_path.size() > storage_path.size() && utils::StringUtils::startsWith(content_path, storage_path + "/")) {
+    content_path.erase(0, storage_path.size() + 1);
+    appendVarint(record, (static_cast<uint64_t>(content_path.size()) << 1) | 1);
+  } else {
+    appendVarint(record, static_cast<uint64_t>(content_path.size()) << 1);
   }
+  record.append(content_path);
 
-  ret = outStream.write(offset_);
-  if (ret != 8) {
-    return false;
-  }
+  appendVarint(record, size_);
+  appendVarint(record, offset_);
 
-  return true;
+  const int length = gsl::narrow<int>(record.size());
+  return outStream.write(reinterpret_cast<const uint8_t*>(record.data()), length) == length;
 }
 
 bool FlowFileRecord::Persist(const std::shared_ptr<core::Repository>& flowRepository) {
@@ -151,6 +213,7 @@ bool FlowFileRecord::Persist(const std::shared_ptr<core::Repository>& flowReposi
     logger_->log_debug("NiFi FlowFile Store event %s size " "%" PRIu64 " success", getUUIDStr(), outStream.size());
     // on behalf of the persisted record instance
     if (claim_) claim_->increaseFlowFileRecordOwnedCount();
+    flowRepository->registerContentClaim(getUUIDStr(), claim_);
     return true;
   } else {
     logger_->log_error("NiFi FlowFile Store failed %s size " "%" PRIu64, getUUIDStr(), outStream.size());
@@ -161,14 +224,95 @@ bool FlowFileRecord::Persist(const std::shared_ptr<core::Repository>& flowReposi
 }
 
 std::shared_ptr<FlowFileRecord> FlowFileRecord::DeSerialize(io::InputStream& inStream, const std::shared_ptr<core::ContentRepository>& content_repo, utils::Identifier& container) {
+  // legacy records start with a big endian timestamp in milliseconds, whose first byte is always 0
+  uint8_t first_byte = 0;
+  if (inStream.read(&first_byte, 1) != 1) {
+    return {};
+  }
+  if (first_byte != COMPACT_FORMAT_MARKER) {
+    return DeSerializeLegacy(first_byte, inStream, content_repo, container);
+  }
+  uint8_t version = 0;
+  if (inStream.read(&version, 1) != 1 || version != COMPACT_FORMAT_VERSION) {
+    logger_->log_error("Unsupported FlowFile record format version %u", static_cast<unsigned>(version));
+    return {};
+  }
+  return DeSerializeCompact(inStream, content_repo, container);
+}
+
+std::shared_ptr<FlowFileRecord> FlowFileRecord::DeSerializeCompact(io::InputStream& inStream, const std::shared_ptr<core::ContentRepository>& content_repo, utils::Identifier& container) {
+  auto file = std::make_shared<FlowFileRecord>();
+
+  if (!readVarint(inStream, file->event_time_) || !readVarint(inStream, file->entry_date_) || !readVarint(inStream, file->lineage_start_date_)
+      || !readIdentifier(inStream, file->uuid_) || !readIdentifier(inStream, container)) {
+    return {};
+  }
+
+  uint64_t numAttributes = 0;
+  if (!readVarint(inStream, numAttributes)) {
+    return {};
+  }
+  auto& attributes = file->getMutableAttributes();
+  for (uint64_t i = 0; i < numAttributes; i++) {
+    uint64_t key_tag = 0;
+    if (!readVarint(inStream, key_tag)) {
+      return {};
+    }
+    std::string key;
+    if (key_tag & 1) {
+      const auto& dictionary = getAttributeKeyDictionary();
+      if ((key_tag >> 1) >= dictionary.size()) {
+        return {};
+      }
+      key = dictionary[key_tag >> 1];
+    } else if (!readBytes(inStream, key_tag >> 1, key)) {
+      return {};
+    }
+    std::string value;
+    if (!readString(inStream, value)) {
+      return {};
+    }
+    attributes[key] = std::move(value);
+  }
+
+  uint64_t path_tag = 0;
+  std::string content_full_path;
+  if (!readVarint(inStream, path_tag) || !readBytes(inStream, path_tag >> 1, content_full_path)) {
+    return {};
+  }
+  if (path_tag & 1) {
+    std::string storage_path = content_repo ? content_repo->getStoragePath() : "";
+    if (storage_path.empty()) {
+      storage_path = default_directory_path;
+    }
+    content_full_path = storage_path + "/" + content_full_path;
+  }
+
+  if (!readVarint(inStream, file->size_) || !readVarint(inStream, file->offset_)) {
+    return {};
+  }
+
+  file->claim_ = std::make_shared<ResourceClaim>(content_full_path, content_repo);
+
+  return file;
+}
+
+std::shared_ptr<FlowFileRecord> FlowFileRecord::DeSerializeLegacy(uint8_t first_byte, io::InputStream& inStream, const std::shared_ptr<core::ContentRepository>& content_repo,
+    utils::Identifier& container) {
   int ret;
 
   auto file = std::make_shared<FlowFileRecord>();
 
-  ret = inStream.read(file->event_time_);
-  if (ret != 8) {
+  // the first byte of the event time has already been consumed to detect the format
+  uint8_t event_time_bytes[7];
+  ret = inStream.read(event_time_bytes, sizeof(event_time_bytes));
+  if (ret != sizeof(event_time_bytes)) {
     return {};
   }
+  file->event_time_ = first_byte;
+  for (uint8_t byte : event_time_bytes) {
+    file->event_time_ = (file->event_time_ << 8) | byte;
+  }
 
   ret = inStream.read(file->entry_date_);
   if (ret != 8) {
@@ -208,7 +352,7 @@ std::shared_ptr<FlowFileRecord> FlowFileRecord::DeSerialize(io::InputStream& inS
     if (ret <= 0) {
       return {};
     }
-    file->attributes_[key] = value;
+    file->getMutableAttributes()[key] = value;
   }
 
   std::string content_full_path;
@@ -22,8 +22,12 @@
 #include <thread>
 #include <utility>
 #include <memory>
+#include <string>
 #include "core/Processor.h"
+#include "core/ProcessSession.h"
+#include "core/ProcessSessionFactory.h"
 #include "utils/GeneralUtils.h"
+#include "utils/OsUtils.h"
 #include "utils/gsl.h"
 
 namespace org {
@@ -86,6 +90,67 @@ bool SchedulingAgent::hasTooMuchOutGoing(const std::shared_ptr<core::Processor>&
 
 bool SchedulingAgent::onTrigger(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
                                 const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
+  return triggerProcessor(processor, [&] {
+    processor->onTrigger(processContext, sessionFactory);
+  });
+}
+
+bool SchedulingAgent::onTriggerForRunDuration(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
+                                              const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(processor->getRunDurationNano());
+  if (!processor->supportsBatching()) {
+    bool first_trigger = true;
+    bool shouldYield = false;
+    do {
+      shouldYield = onTrigger(processor, processContext, sessionFactory);
+      if (shouldYield) {
+        return first_trigger;
+      }
+      first_trigger = false;
+    } while (running_ && processor->isRunning() && !processor->isYield() && std::chrono::steady_clock::now() < deadline);
+    return false;
+  }
+
+  const auto session = sessionFactory->createSession();
+  bool first_trigger = true;
+  bool failed = false;
+  const auto trigger = [&] {
+    try {
+      processor->onTrigger(processContext, session);
+    } catch (...) {
+      // the FlowFiles of the whole batch go back to where they came from
+      session->rollback();
+      failed = true;
+      throw;
+    }
+  };
+  do {
+    if (triggerProcessor(processor, trigger)) {
+      if (first_trigger) {
+        return true;
+      }
+      break;
+    }
+    first_trigger = false;
+  } while (!failed && running_ && processor->isRunning() && !processor->isYield() && std::chrono::steady_clock::now() < deadline);
+
+  if (!failed) {
+    try {
+      session->commit();
+    } catch (std::exception &exception) {
+      logger_->log_warn("Caught \"%s\" while committing the batched session of processor %s", exception.what(), processor->getName());
+      session->rollback();
+      processor->yield(admin_yield_duration_);
+    } catch (...) {
+      logger_->log_warn("Caught unknown exception while committing the batched session of processor %s", processor->getName());
+      session->rollback();
+      processor->yield(admin_yield_duration_);
+    }
+  }
+  return false;
+}
+
+bool SchedulingAgent::triggerProcessor(const std::shared_ptr<core::Processor> &processor, const std::function<void()> &trigger) {
   if (processor->isYield()) {
     logger_->log_debug("Not running %s since it must yield", processor->getName());
     return false;
@@ -117,8 +182,13 @@ bool SchedulingAgent::onTrigger(const std::shared_ptr<core::Processor> &processo
   });
 
   processor->incrementActiveTasks();
+  const auto trigger_start = std::chrono::steady_clock::now();
+  const auto trigger_cpu_start = utils::OsUtils::getCurrentThreadCpuTime();
+  const auto trigger_timer = gsl::finally([&processor, trigger_start, trigger_cpu_start] {
+    processor->getProfile().recordTrigger(std::chrono::steady_clock::now() - trigger_start, utils::OsUtils::getCurrentThreadCpuTime() - trigger_cpu_start);
+  });
   try {
-    processor->onTrigger(processContext, sessionFactory);
+    trigger();
     processor->decrementActiveTask();
   } catch (std::exception &exception) {
     logger_->log_debug("Caught Exception %s", exception.what());
@@ -133,6 +203,22 @@ bool SchedulingAgent::onTrigger(const std::shared_ptr<core::Processor> &processo
   return false;
 }
 
+utils::ThreadPool<utils::TaskRescheduleInfo>& SchedulingAgent::getThreadPool(const core::Processor& processor) {
+  std::string pool_name = processor.getThreadPoolName();
+  if (pool_name.empty()) {
+    pool_name = default_thread_pool_name_;
+  }
+  if (pool_name.empty()) {
+    return thread_pool_;
+  }
+  const auto it = thread_pools_.find(pool_name);
+  if (it == thread_pools_.end()) {
+    logger_->log_error("Processor %s is bound to the undefined thread pool %s, using the default one", processor.getName(), pool_name);
+    return thread_pool_;
+  }
+  return *it->second;
+}
+
 void SchedulingAgent::watchDogFunc() {
   std::lock_guard<std::mutex> lock(watchdog_mtx_);
   auto now = std::chrono::steady_clock::now();
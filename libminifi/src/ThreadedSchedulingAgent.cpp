@@ -38,6 +38,7 @@
 #include "utils/GeneralUtils.h"
 #include "utils/ValueParser.h"
 #include "utils/OptionalUtils.h"
+#include "utils/gsl.h"
 
 namespace org {
 namespace apache {
@@ -72,11 +73,17 @@ void ThreadedSchedulingAgent::schedule(std::shared_ptr<core::Processor> processo
     return;
   }
 
-  if (thread_pool_.isTaskRunning(processor->getUUIDStr())) {
+  auto &thread_pool = getThreadPool(*processor);
+  if (thread_pool.isTaskRunning(processor->getUUIDStr())) {
     logger_->log_warn("Can not schedule threads for processor %s because there are existing threads running", processor->getName());
     return;
   }
 
+  const utils::TaskHandle task_handle = thread_pool.getTaskHandle(processor->getUUIDStr());
+  processor->setWakeUpCallback([&thread_pool, task_handle] {
+    thread_pool.wakeUp(task_handle);
+  });
+
   std::shared_ptr<core::ProcessorNode> processor_node = std::make_shared<core::ProcessorNode>(processor);
 
   auto contextBuilder = core::ClassLoader::getDefaultClassLoader().instantiate<core::ProcessContextBuilder>("ProcessContextBuilder");
@@ -90,35 +97,106 @@ void ThreadedSchedulingAgent::schedule(std::shared_ptr<core::Processor> processo
 
   processor->onSchedule(processContext, sessionFactory);
 
-  std::vector<std::thread *> threads;
+  auto scheduled = std::make_shared<ScheduledProcessor>();
+  scheduled->processor = processor;
+  scheduled->context = processContext;
+  scheduled->session_factory = sessionFactory;
+  scheduled->thread_pool = &thread_pool;
+  scheduled->last_trigger_count = processor->getTriggerCount();
+  scheduled->last_trigger_duration = processor->getTotalTriggerDuration();
+
+  const bool adaptive = processor->isAdaptiveConcurrency();
+  const int concurrent_tasks = adaptive ? processor->getMinConcurrentTasks() : processor->getMaxConcurrentTasks();
+  processor->setConcurrentTasks(gsl::narrow<uint8_t>(concurrent_tasks));
+  for (int i = 0; i < concurrent_tasks; i++) {
+    submitWorker(scheduled);
+  }
+  logger_->log_debug("Scheduled thread %d concurrent workers for for process %s in %s", concurrent_tasks, processor->getName(), thread_pool.getName());
+  processors_running_[processor->getUUID()] = scheduled;
+
+  if (adaptive) {
+    if (!concurrency_timer_) {
+      concurrency_timer_ = utils::make_unique<utils::CallBackTimer>(concurrency_controller_.getPeriod(), [this] { adjustConcurrency(); });
+    }
+    if (!concurrency_timer_->is_running()) {
+      concurrency_timer_->start();
+    }
+  }
+}
+
+void ThreadedSchedulingAgent::submitWorker(const std::shared_ptr<ScheduledProcessor>& scheduled) {
+  const auto& processor = scheduled->processor;
+  // reference the disable function from serviceNode
+  processor->incrementActiveTasks();
+  ++scheduled->workers;
 
   ThreadedSchedulingAgent *agent = this;
-  for (int i = 0; i < processor->getMaxConcurrentTasks(); i++) {
-    // reference the disable function from serviceNode
-    processor->incrementActiveTasks();
-
-    std::function<utils::TaskRescheduleInfo()> f_ex = [agent, processor, processContext, sessionFactory] () {
-      return agent->run(processor, processContext, sessionFactory);
-    };
-
-    // create a functor that will be submitted to the thread pool.
-    auto monitor = utils::make_unique<utils::ComplexMonitor>();
-    utils::Worker<utils::TaskRescheduleInfo> functor(f_ex, processor->getUUIDStr(), std::move(monitor));
-    // move the functor into the thread pool. While a future is returned
-    // we aren't terribly concerned with the result.
-    std::future<utils::TaskRescheduleInfo> future;
-    thread_pool_.execute(std::move(functor), future);
+  std::function<utils::TaskRescheduleInfo()> f_ex = [agent, scheduled] () {
+    // retire the worker if the concurrency of the processor has been lowered since it was submitted
+    int workers = scheduled->workers.load();
+    while (workers > scheduled->processor->getConcurrentTasks()) {
+      if (scheduled->workers.compare_exchange_weak(workers, workers - 1)) {
+        scheduled->processor->decrementActiveTask();
+        return utils::TaskRescheduleInfo::Done();
+      }
+    }
+    return agent->run(scheduled->processor, scheduled->context, scheduled->session_factory);
+  };
+
+  // create a functor that will be submitted to the thread pool.
+  auto monitor = utils::make_unique<utils::ComplexMonitor>();
+  utils::Worker<utils::TaskRescheduleInfo> functor(f_ex, processor->getUUIDStr(), std::move(monitor));
+  // move the functor into the thread pool. While a future is returned
+  // we aren't terribly concerned with the result.
+  std::future<utils::TaskRescheduleInfo> future;
+  scheduled->thread_pool->execute(std::move(functor), future);
+}
+
+void ThreadedSchedulingAgent::adjustConcurrency() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_) {
+    return;
+  }
+  ConcurrencyController::Sample sample;
+  sample.cpu_utilization = concurrency_controller_.measureCpuUtilization();
+  for (const auto& entry : processors_running_) {
+    const auto& scheduled = entry.second;
+    const auto& processor = scheduled->processor;
+    if (!processor->isAdaptiveConcurrency()) {
+      continue;
+    }
+    const uint64_t trigger_count = processor->getTriggerCount();
+    const std::chrono::nanoseconds trigger_duration = processor->getTotalTriggerDuration();
+    const uint64_t triggers = trigger_count - scheduled->last_trigger_count;
+    sample.trigger_latency = triggers > 0 ? (trigger_duration - scheduled->last_trigger_duration) / static_cast<int64_t>(triggers) : std::chrono::nanoseconds(0);
+    scheduled->last_trigger_count = trigger_count;
+    scheduled->last_trigger_duration = trigger_duration;
+    sample.queue = processor->getIncomingQueueStatus();
+
+    const int current = processor->getConcurrentTasks();
+    const int next = concurrency_controller_.decide(current, processor->getMinConcurrentTasks(), processor->getMaxConcurrentTasks(), sample);
+    if (next == current) {
+      continue;
+    }
+    processor->setConcurrentTasks(gsl::narrow<uint8_t>(next));
+    while (scheduled->workers < next) {
+      submitWorker(scheduled);
+    }
+    logger_->log_debug("Changed the concurrent tasks of processor %s from %d to %d (queue fill ratio %.2f, onTrigger latency %" PRId64 " ns, cpu utilization %.2f)",
+        processor->getName(), current, next, sample.queue.fill_ratio, static_cast<int64_t>(sample.trigger_latency.count()), sample.cpu_utilization);
   }
-  logger_->log_debug("Scheduled thread %d concurrent workers for for process %s", processor->getMaxConcurrentTasks(), processor->getName());
-  processors_running_.insert(processor->getUUID());
 }
 
 void ThreadedSchedulingAgent::stop() {
   SchedulingAgent::stop();
+  // stopped before taking the lock, as the callback of the timer acquires it too
+  if (concurrency_timer_) {
+    concurrency_timer_->stop();
+  }
   std::lock_guard<std::mutex> lock(mutex_);
-  for (const auto& processor_id : processors_running_) {
-    logger_->log_error("SchedulingAgent is stopped before processor was unscheduled: %s", processor_id.to_string());
-    thread_pool_.stopTasks(processor_id.to_string());
+  for (const auto& processor : processors_running_) {
+    logger_->log_error("SchedulingAgent is stopped before processor was unscheduled: %s", processor.first.to_string());
+    processor.second->thread_pool->stopTasks(processor.first.to_string());
   }
 }
 
@@ -131,9 +209,13 @@ void ThreadedSchedulingAgent::unschedule(std::shared_ptr<core::Processor> proces
     return;
   }
 
-  thread_pool_.stopTasks(processor->getUUIDStr());
+  const auto running = processors_running_.find(processor->getUUID());
+  auto &thread_pool = running != processors_running_.end() ? *running->second->thread_pool : getThreadPool(*processor);
+  processor->setWakeUpCallback(nullptr);
+  thread_pool.stopTasks(processor->getUUIDStr());
 
   processor->clearActiveTask();
+  processor->setConcurrentTasks(0);
 
   processor->setScheduledState(core::STOPPED);
 
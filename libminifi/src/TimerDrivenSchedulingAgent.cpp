@@ -32,10 +32,14 @@ namespace minifi {
 utils::TaskRescheduleInfo TimerDrivenSchedulingAgent::run(const std::shared_ptr<core::Processor> &processor, const std::shared_ptr<core::ProcessContext> &processContext,
                                          const std::shared_ptr<core::ProcessSessionFactory> &sessionFactory) {
   if (this->running_ && processor->isRunning()) {
-    bool shouldYield = this->onTrigger(processor, processContext, sessionFactory);
+    bool shouldYield = processor->getRunDurationNano() > 0 ? this->onTriggerForRunDuration(processor, processContext, sessionFactory)
+        : this->onTrigger(processor, processContext, sessionFactory);
     if (processor->isYield()) {
       // Honor the yield
       return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(processor->getYieldTime()));
+    } else if (shouldYield && processor->isThrottledByBackpressure() && processor->parkOnBackPressure()) {
+      // Stand by until the full outgoing connection drains, instead of polling it every scheduling period
+      return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(MAX_PARK_TIME_MS));
     } else if (shouldYield && this->bored_yield_duration_ > 0) {
       // No work to do or need to apply back pressure
       return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(this->bored_yield_duration_));
@@ -27,11 +27,13 @@
 #include <string>
 #include <memory>
 #include <cinttypes>
+#include <stdexcept>
 
 #include "c2/ControllerSocketProtocol.h"
 #include "core/ProcessContext.h"
 #include "core/CoreComponentState.h"
 #include "core/state/UpdateController.h"
+#include "provenance/ProvenanceQuery.h"
 #include "core/logging/Logger.h"
 #include "core/logging/LoggerConfiguration.h"
 #include "utils/file/DiffUtils.h"
@@ -44,6 +46,7 @@
 #include "utils/Monitors.h"
 #include "utils/OptionalUtils.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtil.h"
 
 namespace org {
 namespace apache {
@@ -55,7 +58,8 @@ C2Agent::C2Agent(core::controller::ControllerServiceProvider *controller,
                  state::Pausable *pause_handler,
                  const std::shared_ptr<state::StateMonitor> &updateSink,
                  const std::shared_ptr<Configure> &configuration,
-                 const std::shared_ptr<utils::file::FileSystem> &filesystem)
+                 const std::shared_ptr<utils::file::FileSystem> &filesystem,
+                 std::shared_ptr<utils::TimerService> timer_service)
     : heart_beat_period_(3000),
       max_c2_responses(5),
       update_sink_(updateSink),
@@ -66,7 +70,8 @@ C2Agent::C2Agent(core::controller::ControllerServiceProvider *controller,
       filesystem_(filesystem),
       protocol_(nullptr),
       logger_(logging::LoggerFactory<C2Agent>::getLogger()),
-      thread_pool_(2, false, nullptr, "C2 threadpool") {
+      thread_pool_(2, false, nullptr, "C2 threadpool"),
+      timer_service_(std::move(timer_service)) {
   allow_updates_ = true;
 
   manifest_sent_ = false;
@@ -102,6 +107,16 @@ void C2Agent::start() {
     std::future<utils::TaskRescheduleInfo> future;
     thread_pool_.execute(std::move(functor), future);
   }
+  if (timer_service_) {
+    // the producer is the first function, it parks after each heartbeat until the timer wakes it up
+    const utils::TaskHandle producer = thread_pool_.getTaskHandle(task_ids_.front().to_string());
+    heartbeat_timer_ = timer_service_->schedule(std::chrono::steady_clock::now() + std::chrono::milliseconds(getHeartBeatDelay()),
+        [this, producer](utils::TimerService::Clock::time_point deadline) -> utils::optional<utils::TimerService::Clock::time_point> {
+      thread_pool_.wakeUp(producer);
+      // keep the pace of the heartbeats, but do not catch up on the ones missed while the agent was suspended
+      return (std::max)(deadline + std::chrono::milliseconds(getHeartBeatDelay()), utils::TimerService::Clock::now());
+    });
+  }
   controller_running_ = true;
   thread_pool_.start();
   logger_->log_info("C2 agent started");
@@ -109,6 +124,10 @@ void C2Agent::start() {
 
 void C2Agent::stop() {
   controller_running_ = false;
+  if (heartbeat_timer_ != 0) {
+    timer_service_->cancel(heartbeat_timer_);
+    heartbeat_timer_ = 0;
+  }
   for (const auto& id : task_ids_) {
     thread_pool_.stopTasks(id.to_string());
   }
@@ -561,6 +580,54 @@ void C2Agent::handle_describe(const C2ContentResponse &resp) {
     response.addPayload(std::move(states));
     enqueue_c2_response(std::move(response));
     return;
+  } else if (resp.name == "provenance") {
+    const auto repository = std::dynamic_pointer_cast<provenance::QueryableProvenanceRepository>(update_sink_->getProvenanceRepository());
+    if (repository == nullptr) {
+      C2Payload response(Operation::ACKNOWLEDGE, state::UpdateState::NOT_APPLIED, resp.ident, true);
+      response.setRawData("The provenance repository does not support queries");
+      enqueue_c2_response(std::move(response));
+      return;
+    }
+    std::map<std::string, std::string> arguments;
+    for (const auto& argument : resp.operation_arguments) {
+      arguments[argument.first] = argument.second.to_string();
+    }
+    std::vector<std::shared_ptr<provenance::ProvenanceEventRecord>> events;
+    try {
+      events = repository->query(provenance::ProvenanceQuery::parse(arguments, utils::timeutils::getTimeMillis()));
+    } catch (const std::invalid_argument& e) {
+      logger_->log_error("Invalid provenance query: %s", e.what());
+      C2Payload response(Operation::ACKNOWLEDGE, state::UpdateState::SET_ERROR, resp.ident, true);
+      response.setRawData(e.what());
+      enqueue_c2_response(std::move(response));
+      return;
+    }
+    C2Payload response(Operation::ACKNOWLEDGE, resp.ident, true);
+    response.setLabel("provenance");
+    C2Payload events_payload(Operation::ACKNOWLEDGE, resp.ident, true);
+    events_payload.setLabel("events");
+    for (const auto& event : events) {
+      C2Payload event_payload(Operation::ACKNOWLEDGE, resp.ident, true);
+      event_payload.setLabel(event->getUUIDStr());
+      const std::map<std::string, std::string> fields{
+        {"eventType", provenance::ProvenanceEventRecord::ProvenanceEventTypeStr[event->getEventType()]},
+        {"eventTime", std::to_string(event->getEventTime())},
+        {"componentId", event->getComponentId()},
+        {"componentType", event->getComponentType()},
+        {"flowFileUuid", event->getFlowFileUuid().to_string()},
+        {"details", event->getDetails()}
+      };
+      for (const auto& field : fields) {
+        C2ContentResponse entry(Operation::ACKNOWLEDGE);
+        entry.name = field.first;
+        entry.operation_arguments[field.first] = field.second;
+        event_payload.addContent(std::move(entry));
+      }
+      events_payload.addPayload(std::move(event_payload));
+    }
+    response.addPayload(std::move(events_payload));
+    enqueue_c2_response(std::move(response));
+    return;
   }
   C2Payload response(Operation::ACKNOWLEDGE, resp.ident, true);
   enqueue_c2_response(std::move(response));
@@ -729,6 +796,9 @@ utils::TaskRescheduleInfo C2Agent::produce() {
 
   checkTriggers();
 
+  if (heartbeat_timer_ != 0) {
+    return utils::TaskRescheduleInfo::Park();
+  }
   return utils::TaskRescheduleInfo::RetryIn(std::chrono::milliseconds(heart_beat_period_));
 }
 
@@ -44,7 +44,10 @@ C2Client::C2Client(
     : core::Flow(std::move(provenance_repo), std::move(flow_file_repo), std::move(content_repo), std::move(flow_configuration)),
       configuration_(std::move(configuration)),
       filesystem_(std::move(filesystem)),
-      logger_(std::move(logger)) {}
+      timer_service_(std::make_shared<utils::TimerService>("Agent timer service")),
+      logger_(std::move(logger)) {
+  timer_service_->start();
+}
 
 void C2Client::stopC2() {
   if (c2_agent_) {
@@ -120,7 +123,7 @@ void C2Client::initialize(core::controller::ControllerServiceProvider *controlle
   if (!initialized_) {
     // C2Agent is initialized once, meaning that a C2-triggered flow/configuration update
     // might not be equal to a fresh restart
-    c2_agent_ = std::unique_ptr<c2::C2Agent>(new c2::C2Agent(controller, pause_handler, update_sink, configuration_, filesystem_));
+    c2_agent_ = std::unique_ptr<c2::C2Agent>(new c2::C2Agent(controller, pause_handler, update_sink, configuration_, filesystem_, timer_service_));
     c2_agent_->start();
     initialized_ = true;
   }
@@ -137,6 +140,9 @@ void C2Client::initializeComponentMetrics() {
   {
     std::lock_guard<std::mutex> guard(metrics_mutex_);
     component_metrics_.clear();
+    for (auto& metric : getComponentMetricsNodes()) {
+      component_metrics_[metric->getName()] = metric;
+    }
   }
 
   if (root_ == nullptr) {
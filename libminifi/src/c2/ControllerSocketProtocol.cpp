@@ -19,13 +19,18 @@
 #include "c2/ControllerSocketProtocol.h"
 
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "core/state/nodes/MetricsBase.h"
+#include "provenance/ProvenanceQuery.h"
 #include "utils/gsl.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtil.h"
 
 namespace org {
 namespace apache {
@@ -216,6 +221,68 @@ void ControllerSocketProtocol::initialize(core::controller::ControllerServicePro
               resp.write(connection.first, false);
             }
             stream->write(const_cast<uint8_t*>(resp.getBuffer()), gsl::narrow<int>(resp.size()));
+          } else if (what == "metrics") {
+            std::string name;
+            int size = stream->read(name);
+            if (size == -1) {
+              logger_->log_debug("Connection broke");
+              break;
+            }
+            // flatten the metrics into "path = value" lines
+            std::vector<std::string> lines;
+            std::function<void(const state::response::SerializedResponseNode&, const std::string&)> flatten =
+                [&](const state::response::SerializedResponseNode& node, const std::string& prefix) {
+              const std::string path = prefix.empty() ? node.name : prefix + "." + node.name;
+              if (node.children.empty()) {
+                lines.push_back(path + " = " + node.value.to_string());
+              }
+              for (const auto& child : node.children) {
+                flatten(child, path);
+              }
+            };
+            const auto metrics_node = update_sink_->getMetricsNode(name);
+            if (metrics_node) {
+              for (const auto& node : metrics_node->serialize()) {
+                flatten(node, "");
+              }
+            }
+            io::BufferStream resp;
+            resp.write(&head, 1);
+            uint64_t line_count = lines.size();
+            resp.write(line_count);
+            for (const auto& line : lines) {
+              resp.write(line);
+            }
+            stream->write(const_cast<uint8_t*>(resp.getBuffer()), gsl::narrow<int>(resp.size()));
+          } else if (what == "provenance") {
+            std::string query_string;
+            int size = stream->read(query_string);
+            if (size == -1) {
+              logger_->log_debug("Connection broke");
+              break;
+            }
+            std::vector<std::string> lines;
+            const auto repository = std::dynamic_pointer_cast<provenance::QueryableProvenanceRepository>(update_sink_->getProvenanceRepository());
+            if (repository == nullptr) {
+              lines.push_back("The provenance repository does not support queries");
+            } else {
+              try {
+                const auto query = provenance::ProvenanceQuery::parse(query_string, utils::timeutils::getTimeMillis());
+                for (const auto& event : repository->query(query)) {
+                  lines.push_back(provenance::toQueryResultLine(*event));
+                }
+              } catch (const std::invalid_argument& e) {
+                lines.push_back(e.what());
+              }
+            }
+            io::BufferStream resp;
+            resp.write(&head, 1);
+            uint64_t line_count = lines.size();
+            resp.write(line_count);
+            for (const auto& line : lines) {
+              resp.write(line);
+            }
+            stream->write(const_cast<uint8_t*>(resp.getBuffer()), gsl::narrow<int>(resp.size()));
           } else if (what == "getfull") {
             std::vector<std::string> full_connections;
             {
@@ -137,10 +137,53 @@ void Connectable::notifyWork() {
 
     if (has_work_.load()) {
       work_condition_.notify_one();
+      if (parked_.exchange(false)) {
+        wakeUp();
+      }
     }
   }
 }
 
+void Connectable::setWakeUpCallback(std::function<void()> wake_up_callback) {
+  std::lock_guard<std::mutex> lock(work_available_mutex_);
+  wake_up_callback_ = std::move(wake_up_callback);
+}
+
+bool Connectable::park() {
+  parked_.store(true);
+  // a producer may have put work in our connections before it could see us parked
+  if (isWorkAvailable() && parked_.exchange(false)) {
+    return false;
+  }
+  return true;
+}
+
+bool Connectable::parkOnBackPressure() {
+  parked_on_back_pressure_.store(true);
+  // a consumer may have drained our outgoing connections before it could see us parked
+  if (!isThrottledByBackpressure() && parked_on_back_pressure_.exchange(false)) {
+    return false;
+  }
+  return true;
+}
+
+void Connectable::notifyBackPressureRelieved() {
+  if (parked_on_back_pressure_.exchange(false)) {
+    wakeUp();
+  }
+}
+
+void Connectable::wakeUp() {
+  std::function<void()> wake_up_callback;
+  {
+    std::lock_guard<std::mutex> lock(work_available_mutex_);
+    wake_up_callback = wake_up_callback_;
+  }
+  if (wake_up_callback) {
+    wake_up_callback();
+  }
+}
+
 std::set<std::shared_ptr<Connectable>> Connectable::getOutGoingConnections(const std::string &relationship) const {
   std::set<std::shared_ptr<Connectable>> empty;
 
@@ -22,6 +22,12 @@
 
 #include "core/ContentRepository.h"
 #include "core/ContentSession.h"
+#include "core/StreamingContentSession.h"
+#include "core/Property.h"
+#include "io/StreamPipe.h"
+#include "utils/Id.h"
+#include "utils/StringUtils.h"
+#include "utils/gsl.h"
 
 namespace org {
 namespace apache {
@@ -29,6 +35,10 @@ namespace nifi {
 namespace minifi {
 namespace core {
 
+constexpr const char *ContentRepository::STAGING_EXTENSION;
+constexpr size_t ContentRepository::DEFAULT_SESSION_BUFFER_SIZE;
+constexpr uint64_t ContentRepository::DEFAULT_MAX_FLOW_FILES_PER_CLAIM;
+
 std::string ContentRepository::getStoragePath() const {
   return directory_;
 }
@@ -39,9 +49,48 @@ void ContentRepository::reset() {
 }
 
 std::shared_ptr<ContentSession> ContentRepository::createSession() {
+  if (streaming_sessions_) {
+    return std::make_shared<StreamingContentSession>(sharedFromThis(), session_buffer_size_);
+  }
   return std::make_shared<ContentSession>(sharedFromThis());
 }
 
+void ContentRepository::initializeSessionOptions(const Configure &configure) {
+  std::string value;
+  if (configure.get(Configure::nifi_content_repository_session_streaming, value)) {
+    utils::StringUtils::StringToBool(value, streaming_sessions_);
+  }
+  if (configure.get(Configure::nifi_content_repository_session_buffer_size, value)) {
+    uint64_t buffer_size = 0;
+    if (core::Property::StringToInt(value, buffer_size) && buffer_size > 0) {
+      session_buffer_size_ = gsl::narrow<size_t>(buffer_size);
+    }
+  }
+}
+
+std::shared_ptr<minifi::ResourceClaim> ContentRepository::createStagingClaim(const std::shared_ptr<minifi::ResourceClaim> &claim, bool /*append*/) {
+  static std::shared_ptr<utils::IdGenerator> id_generator = utils::IdGenerator::getIdGenerator();
+  return std::make_shared<minifi::ResourceClaim>(claim->getContentFullPath() + "." + id_generator->generate().to_string() + STAGING_EXTENSION, nullptr);
+}
+
+bool ContentRepository::publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) {
+  if (staging.getContentFullPath() == target.getContentFullPath()) {
+    return true;
+  }
+  {
+    std::shared_ptr<io::BaseStream> input = read(staging);
+    std::shared_ptr<io::BaseStream> output = write(target, append);
+    if (input == nullptr || output == nullptr) {
+      return false;
+    }
+    if (minifi::internal::pipe(input, output) < 0) {
+      return false;
+    }
+  }
+  remove(staging);
+  return true;
+}
+
 uint32_t ContentRepository::getStreamCount(const minifi::ResourceClaim &streamId) {
   std::lock_guard<std::mutex> lock(count_map_mutex_);
   auto cnt = count_map_.find(streamId.getContentFullPath());
@@ -66,6 +66,18 @@ std::shared_ptr<io::BaseStream> ContentSession::read(const std::shared_ptr<Resou
   return repository_->read(*resourceId);
 }
 
+std::shared_ptr<io::BaseStream> ContentSession::readOwned(const std::shared_ptr<ResourceClaim>& resourceId) {
+  auto it = managedResources_.find(resourceId);
+  if (it == managedResources_.end()) {
+    throw Exception(REPOSITORY_EXCEPTION, "Can only read owned resource");
+  }
+  return std::make_shared<io::BufferStream>(it->second->getBuffer(), gsl::narrow<unsigned int>(it->second->size()));
+}
+
+bool ContentSession::owns(const std::shared_ptr<ResourceClaim>& resourceId) const {
+  return managedResources_.find(resourceId) != managedResources_.end();
+}
+
 void ContentSession::commit() {
   for (const auto& resource : managedResources_) {
     auto outStream = repository_->write(*resource.first);
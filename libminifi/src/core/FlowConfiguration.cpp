@@ -21,6 +21,7 @@
 #include <vector>
 #include <string>
 #include "core/ClassLoader.h"
+#include "core/Property.h"
 #include "utils/StringUtils.h"
 #include "processors/ProcessorUtils.h"
 
@@ -125,7 +126,13 @@ std::unique_ptr<core::ProcessGroup> FlowConfiguration::createRemoteProcessGroup(
 }
 
 std::shared_ptr<minifi::Connection> FlowConfiguration::createConnection(std::string name, const utils::Identifier& uuid) const {
-  return std::make_shared<minifi::Connection>(flow_file_repo_, content_repo_, name, uuid);
+  auto connection = std::make_shared<minifi::Connection>(flow_file_repo_, content_repo_, name, uuid);
+  std::string value;
+  uint64_t swap_threshold = 0;
+  if (configuration_ && configuration_->get(Configure::nifi_queue_swap_threshold, value) && core::Property::StringToInt(value, swap_threshold)) {
+    connection->setSwapThreshold(swap_threshold);
+  }
+  return connection;
 }
 
 std::shared_ptr<core::controller::ControllerServiceNode> FlowConfiguration::createControllerService(const std::string &class_name, const std::string &full_class_name, const std::string &name,
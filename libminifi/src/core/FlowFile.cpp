@@ -48,6 +48,7 @@ FlowFile::FlowFile()
       id_(0),
       offset_(0),
       to_be_processed_after_(std::chrono::steady_clock::now()),
+      attributes_(std::make_shared<AttributeMap>()),
       claim_(nullptr) {
   id_ = numeric_id_generator_->generateId();
   entry_date_ = utils::timeutils::getTimeMillis();
@@ -64,7 +65,9 @@ FlowFile& FlowFile::operator=(const FlowFile& other) {
   lineage_Identifiers_ = other.lineage_Identifiers_;
   last_queue_date_ = other.last_queue_date_;
   size_ = other.size_;
+  offset_ = other.offset_;
   to_be_processed_after_ = other.to_be_processed_after_;
+  // the attributes are only copied once either of the records modifies them
   attributes_ = other.attributes_;
   claim_ = other.claim_;
   connection_ = other.connection_;
@@ -155,8 +158,8 @@ bool FlowFile::getAttribute(const std::string& key, std::string& value) const {
 }
 
 utils::optional<std::string> FlowFile::getAttribute(const std::string& key) const {
-  auto it = attributes_.find(key);
-  if (it != attributes_.end()) {
+  auto it = attributes_->find(key);
+  if (it != attributes_->end()) {
     return it->second;
   }
   return utils::nullopt;
@@ -172,9 +175,9 @@ uint64_t FlowFile::getOffset() const {
 }
 
 bool FlowFile::removeAttribute(const std::string key) {
-  auto it = attributes_.find(key);
-  if (it != attributes_.end()) {
-    attributes_.erase(it);
+  if (attributes_->find(key) != attributes_->end()) {
+    AttributeMap& attributes = getMutableAttributes();
+    attributes.erase(attributes.find(key));
     return true;
   } else {
     return false;
@@ -182,9 +185,8 @@ bool FlowFile::removeAttribute(const std::string key) {
 }
 
 bool FlowFile::updateAttribute(const std::string key, const std::string value) {
-  auto it = attributes_.find(key);
-  if (it != attributes_.end()) {
-    it->second = value;
+  if (attributes_->find(key) != attributes_->end()) {
+    getMutableAttributes().find(key)->second = value;
     return true;
   } else {
     return false;
@@ -192,16 +194,23 @@ bool FlowFile::updateAttribute(const std::string key, const std::string value) {
 }
 
 bool FlowFile::addAttribute(const std::string& key, const std::string& value) {
-  auto it = attributes_.find(key);
-  if (it != attributes_.end()) {
+  auto it = attributes_->find(key);
+  if (it != attributes_->end()) {
     // attribute already there in the map
     return false;
   } else {
-    attributes_[key] = value;
+    getMutableAttributes()[key] = value;
     return true;
   }
 }
 
+FlowFile::AttributeMap& FlowFile::getMutableAttributes() {
+  if (attributes_.use_count() > 1) {
+    attributes_ = std::make_shared<AttributeMap>(*attributes_);
+  }
+  return *attributes_;
+}
+
 void FlowFile::setLineageStartDate(const uint64_t date) {
   lineage_start_date_ = date;
 }
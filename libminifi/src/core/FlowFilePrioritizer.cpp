@@ -0,0 +1,118 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/FlowFilePrioritizer.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include "utils/StringUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+namespace {
+
+template<typename T>
+int compareValues(const T& left, const T& right) {
+  if (left < right) {
+    return -1;
+  }
+  return right < left ? 1 : 0;
+}
+
+bool parsePriority(const std::string& value, int64_t& priority) {
+  if (value.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  const long long parsed = std::strtoll(value.c_str(), &end, 10);  // NOLINT(runtime/int)
+  if (errno != 0 || *end != '\0') {
+    return false;
+  }
+  priority = static_cast<int64_t>(parsed);
+  return true;
+}
+
+}  // namespace
+
+std::shared_ptr<FlowFilePrioritizer> FlowFilePrioritizer::create(const std::string& name) {
+  static const std::string NIFI_PACKAGE = "org.apache.nifi.prioritizer.";
+  const std::string class_name = utils::StringUtils::startsWith(name, NIFI_PACKAGE) ? name.substr(NIFI_PACKAGE.length()) : name;
+  if (class_name == "FirstInFirstOutPrioritizer") {
+    return std::make_shared<FirstInFirstOutPrioritizer>();
+  } else if (class_name == "OldestFlowFileFirstPrioritizer") {
+    return std::make_shared<OldestFlowFileFirstPrioritizer>();
+  } else if (class_name == "NewestFlowFileFirstPrioritizer") {
+    return std::make_shared<NewestFlowFileFirstPrioritizer>();
+  } else if (class_name == "PriorityAttributePrioritizer") {
+    return std::make_shared<PriorityAttributePrioritizer>();
+  } else if (class_name == "SmallestFlowFileFirstPrioritizer") {
+    return std::make_shared<SmallestFlowFileFirstPrioritizer>();
+  } else if (class_name == "LargestFlowFileFirstPrioritizer") {
+    return std::make_shared<LargestFlowFileFirstPrioritizer>();
+  }
+  return nullptr;
+}
+
+int OldestFlowFileFirstPrioritizer::compare(const FlowFile& left, const FlowFile& right) const {
+  return compareValues(left.getlineageStartDate(), right.getlineageStartDate());
+}
+
+int NewestFlowFileFirstPrioritizer::compare(const FlowFile& left, const FlowFile& right) const {
+  return compareValues(right.getlineageStartDate(), left.getlineageStartDate());
+}
+
+int PriorityAttributePrioritizer::compare(const FlowFile& left, const FlowFile& right) const {
+  std::string left_priority;
+  std::string right_priority;
+  const bool left_has_priority = left.getAttribute(SpecialFlowAttribute::priority, left_priority);
+  const bool right_has_priority = right.getAttribute(SpecialFlowAttribute::priority, right_priority);
+  if (!left_has_priority || !right_has_priority) {
+    return compareValues(!left_has_priority, !right_has_priority);
+  }
+
+  int64_t left_value = 0;
+  int64_t right_value = 0;
+  const bool left_is_numeric = parsePriority(left_priority, left_value);
+  const bool right_is_numeric = parsePriority(right_priority, right_value);
+  if (left_is_numeric && right_is_numeric) {
+    return compareValues(left_value, right_value);
+  }
+  if (left_is_numeric || right_is_numeric) {
+    return left_is_numeric ? -1 : 1;
+  }
+  return compareValues(left_priority, right_priority);
+}
+
+int SmallestFlowFileFirstPrioritizer::compare(const FlowFile& left, const FlowFile& right) const {
+  return compareValues(left.getSize(), right.getSize());
+}
+
+int LargestFlowFileFirstPrioritizer::compare(const FlowFile& left, const FlowFile& right) const {
+  return compareValues(right.getSize(), left.getSize());
+}
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -28,9 +28,12 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "core/ProcessSessionReadCallback.h"
+#include "core/Processor.h"
+#include "io/StreamSlice.h"
 #include "utils/gsl.h"
 
 /* This implementation is only for native Windows systems.  */
@@ -61,6 +64,19 @@ namespace core {
 
 std::shared_ptr<utils::IdGenerator> ProcessSession::id_generator_ = utils::IdGenerator::getIdGenerator();
 
+ProcessSession::ProcessSession(std::shared_ptr<ProcessContext> processContext)
+    : process_context_(std::move(processContext)),
+      logger_(logging::LoggerFactory<ProcessSession>::getLogger()) {
+  logger_->log_trace("ProcessSession created for %s", process_context_->getProcessorNode()->getName());
+  auto repo = process_context_->getProvenanceRepository();
+  auto granularity = provenance::ProvenanceGranularity::FULL;
+  if (const auto processor = std::dynamic_pointer_cast<Processor>(process_context_->getProcessorNode()->getProcessor())) {
+    granularity = processor->getProvenanceGranularity();
+  }
+  provenance_report_ = std::make_shared<provenance::ProvenanceReporter>(repo, process_context_->getProcessorNode()->getName(), process_context_->getProcessorNode()->getName(), granularity);
+  content_session_ = process_context_->getContentRepository()->createSession();
+}
+
 ProcessSession::~ProcessSession() {
   removeReferences();
 }
@@ -98,9 +114,7 @@ std::shared_ptr<core::FlowFile> ProcessSession::create(const std::shared_ptr<cor
   utils::Identifier uuid = record->getUUID();
   _addedFlowFiles[uuid] = record;
   logger_->log_debug("Create FlowFile with UUID %s", record->getUUIDStr());
-  std::stringstream details;
-  details << process_context_->getProcessorNode()->getName() << " creates flow record " << record->getUUIDStr();
-  provenance_report_->create(record, details.str());
+  provenance_report_->create(record);
 
   return record;
 }
@@ -179,22 +193,17 @@ std::shared_ptr<core::FlowFile> ProcessSession::clone(const std::shared_ptr<core
 void ProcessSession::remove(const std::shared_ptr<core::FlowFile> &flow) {
   flow->setDeleted(true);
   _deletedFlowFiles.push_back(flow);
-  std::string reason = process_context_->getProcessorNode()->getName() + " drop flow record " + flow->getUUIDStr();
-  provenance_report_->drop(flow, reason);
+  provenance_report_->drop(flow);
 }
 
 void ProcessSession::putAttribute(const std::shared_ptr<core::FlowFile> &flow, std::string key, std::string value) {
   flow->setAttribute(key, value);
-  std::stringstream details;
-  details << process_context_->getProcessorNode()->getName() << " modify flow record " << flow->getUUIDStr() << " attribute " << key << ":" << value;
-  provenance_report_->modifyAttributes(flow, details.str());
+  provenance_report_->modifyAttribute(flow, key, value);
 }
 
 void ProcessSession::removeAttribute(const std::shared_ptr<core::FlowFile> &flow, std::string key) {
   flow->removeAttribute(key);
-  std::stringstream details;
-  details << process_context_->getProcessorNode()->getName() << " remove flow record " << flow->getUUIDStr() << " attribute " + key;
-  provenance_report_->modifyAttributes(flow, details.str());
+  provenance_report_->removeAttribute(flow, key);
 }
 
 void ProcessSession::penalize(const std::shared_ptr<core::FlowFile> &flow) {
@@ -211,27 +220,44 @@ void ProcessSession::transfer(const std::shared_ptr<core::FlowFile> &flow, Relat
 }
 
 void ProcessSession::write(const std::shared_ptr<core::FlowFile> &flow, OutputStreamCallback *callback) {
-  std::shared_ptr<ResourceClaim> claim = content_session_->create();
+  std::shared_ptr<ResourceClaim> claim = getPackedClaim();
+  const bool packed = claim != nullptr;
+  if (!packed) {
+    claim = content_session_->create();
+  }
 
   try {
     uint64_t startTime = utils::timeutils::getTimeMillis();
-    std::shared_ptr<io::BaseStream> stream = content_session_->write(claim);
+    std::shared_ptr<io::BaseStream> stream = content_session_->write(claim, packed ? ContentSession::WriteMode::APPEND : ContentSession::WriteMode::OVERWRITE);
     // Call the callback to write the content
     if (nullptr == stream) {
       throw Exception(FILE_OPERATION_EXCEPTION, "Failed to open flowfile content for write");
     }
+    uint64_t offset = 0;
+    if (packed) {
+      offset = stream->size();
+      stream = std::make_shared<io::StreamSlice>(stream, offset, 0);
+      packing_ = true;
+    }
+    auto packing_guard = gsl::finally([this, packed] {
+      if (packed) {
+        packing_ = false;
+      }
+    });
     if (callback->process(stream) < 0) {
       throw Exception(FILE_OPERATION_EXCEPTION, "Failed to process flowfile content");
     }
 
     flow->setSize(stream->size());
-    flow->setOffset(0);
+    flow->setOffset(offset);
     flow->setResourceClaim(claim);
+    if (packed) {
+      ++packed_claim_flow_files_;
+    }
 
     stream->close();
-    std::string details = process_context_->getProcessorNode()->getName() + " modify flow record content " + flow->getUUIDStr();
     uint64_t endTime = utils::timeutils::getTimeMillis();
-    provenance_report_->modifyContent(flow, details, endTime - startTime);
+    provenance_report_->modifyContent(flow, endTime - startTime);
   } catch (std::exception &exception) {
     logger_->log_debug("Caught Exception %s", exception.what());
     throw;
@@ -250,10 +276,32 @@ void ProcessSession::append(const std::shared_ptr<core::FlowFile> &flow, OutputS
 
   try {
     uint64_t startTime = utils::timeutils::getTimeMillis();
-    std::shared_ptr<io::BaseStream> stream = content_session_->write(claim, ContentSession::WriteMode::APPEND);
+    bool packed = false;
+    if (content_session_->owns(claim)) {
+      // the claim was created by this session, its stream holds the whole content
+      const auto claim_stream = content_session_->write(claim, ContentSession::WriteMode::APPEND);
+      if ((packing_ && claim == packed_claim_) || flow->getOffset() + flow->getSize() != claim_stream->size()) {
+        // other contents follow this one in the packed claim
+        unpackContent(flow);
+      } else {
+        packed = claim->isPacked();
+      }
+    } else if (isSharedContent(flow)) {
+      unpackContent(flow);
+    }
+    std::shared_ptr<io::BaseStream> stream = content_session_->write(flow->getResourceClaim(), ContentSession::WriteMode::APPEND);
     if (nullptr == stream) {
       throw Exception(FILE_OPERATION_EXCEPTION, "Failed to open flowfile content for append");
     }
+    if (packed) {
+      stream = std::make_shared<io::StreamSlice>(stream, flow->getOffset(), flow->getSize());
+      packing_ = true;
+    }
+    auto packing_guard = gsl::finally([this, packed] {
+      if (packed) {
+        packing_ = false;
+      }
+    });
     // Call the callback to write the content
 
     size_t oldPos = stream->size();
@@ -263,12 +311,14 @@ void ProcessSession::append(const std::shared_ptr<core::FlowFile> &flow, OutputS
     if (callback->process(stream) < 0) {
       throw Exception(FILE_OPERATION_EXCEPTION, "Failed to process flowfile content");
     }
-    flow->setSize(stream->size());
+    // the stream of a claim not created by this session only holds the content appended in this session
+    flow->setSize(flow->getSize() + (stream->size() - oldPos));
+    if (!content_session_->owns(flow->getResourceClaim())) {
+      extended_claims_.insert(flow->getResourceClaim());
+    }
 
-    std::stringstream details;
-    details << process_context_->getProcessorNode()->getName() << " modify flow record content " << flow->getUUIDStr();
     uint64_t endTime = utils::timeutils::getTimeMillis();
-    provenance_report_->modifyContent(flow, details.str(), endTime - startTime);
+    provenance_report_->modifyContent(flow, endTime - startTime);
   } catch (std::exception &exception) {
     logger_->log_debug("Caught Exception %s", exception.what());
     throw;
@@ -278,6 +328,74 @@ void ProcessSession::append(const std::shared_ptr<core::FlowFile> &flow, OutputS
   }
 }
 
+bool ProcessSession::isSharedContent(const std::shared_ptr<core::FlowFile> &flow) {
+  const std::shared_ptr<ResourceClaim> claim = flow->getResourceClaim();
+  if (claim->isPacked() || flow->getOffset() != 0) {
+    return true;
+  }
+  const auto content_repo = process_context_->getContentRepository();
+  if (content_repo->getMaxAppendableClaimSize() == 0) {
+    // the repository does not pack contents
+    return false;
+  }
+  // the claims recovered from the FlowFile repository are not marked, so compare the content with the whole claim
+  const auto committed = content_repo->read(*claim);
+  uint64_t claim_size = committed ? committed->size() : 0;
+  if (extended_claims_.count(claim) > 0) {
+    claim_size += content_session_->write(claim, ContentSession::WriteMode::APPEND)->size();
+  }
+  return flow->getSize() != claim_size;
+}
+
+std::shared_ptr<ResourceClaim> ProcessSession::getPackedClaim() {
+  const auto content_repo = process_context_->getContentRepository();
+  const uint64_t max_appendable_size = content_repo->getMaxAppendableClaimSize();
+  if (max_appendable_size == 0 || packing_) {
+    return nullptr;
+  }
+  if (packed_claim_ && (packed_claim_flow_files_ >= content_repo->getMaxFlowFilesPerClaim()
+      || content_session_->write(packed_claim_, ContentSession::WriteMode::APPEND)->size() >= max_appendable_size)) {
+    packed_claim_.reset();
+  }
+  if (!packed_claim_) {
+    packed_claim_ = content_session_->create();
+    packed_claim_flow_files_ = 0;
+    packed_claim_->setPacked();
+  }
+  return packed_claim_;
+}
+
+void ProcessSession::unpackContent(const std::shared_ptr<core::FlowFile> &flow) {
+  // the committed part of a claim not created by this session is read from the repository, it holds the whole content of the FlowFile
+  std::shared_ptr<io::BaseStream> input = content_session_->owns(flow->getResourceClaim())
+      ? content_session_->readOwned(flow->getResourceClaim())
+      : process_context_->getContentRepository()->read(*flow->getResourceClaim());
+  std::shared_ptr<ResourceClaim> claim = content_session_->create();
+  std::shared_ptr<io::BaseStream> output = content_session_->write(claim);
+  if (nullptr == input || nullptr == output) {
+    throw Exception(FILE_OPERATION_EXCEPTION, "Failed to open flowfile content for unpacking");
+  }
+  input->seek(flow->getOffset());
+  std::vector<uint8_t> buffer(getpagesize());
+  uint64_t remaining = flow->getSize();
+  while (remaining > 0) {
+    const int len = gsl::narrow<int>(std::min<uint64_t>(remaining, buffer.size()));
+    if (input->read(buffer.data(), len) != len || output->write(buffer.data(), len) != len) {
+      throw Exception(FILE_OPERATION_EXCEPTION, "Failed to unpack flowfile content");
+    }
+    remaining -= len;
+  }
+  logger_->log_debug("Moved content of %s out of packed claim %s", flow->getUUIDStr(), flow->getResourceClaim()->getContentFullPath());
+  flow->setOffset(0);
+  flow->setResourceClaim(claim);
+}
+
+void ProcessSession::releasePackedClaims() {
+  packed_claim_.reset();
+  packed_claim_flow_files_ = 0;
+  extended_claims_.clear();
+}
+
 int ProcessSession::read(const std::shared_ptr<core::FlowFile> &flow, InputStreamCallback *callback) {
   try {
     std::shared_ptr<ResourceClaim> claim = nullptr;
@@ -299,7 +417,11 @@ int ProcessSession::read(const std::shared_ptr<core::FlowFile> &flow, InputStrea
       throw Exception(FILE_OPERATION_EXCEPTION, "Failed to open flowfile content for read");
     }
 
-    stream->seek(flow->getOffset());
+    if (flow->getOffset() != 0 || flow->getSize() < stream->size()) {
+      // the claim holds other contents as well
+      stream = std::make_shared<io::StreamSlice>(stream, flow->getOffset(), flow->getSize());
+    }
+    stream->seek(0);
 
     auto ret = callback->process(stream);
     if (ret < 0) {
@@ -355,10 +477,8 @@ void ProcessSession::importFrom(io::InputStream &stream, const std::shared_ptr<c
         flow->getOffset(), flow->getSize(), flow->getResourceClaim()->getContentFullPath(), flow->getUUIDStr());
 
     content_stream->close();
-    std::stringstream details;
-    details << process_context_->getProcessorNode()->getName() << " modify flow record content " << flow->getUUIDStr();
     auto endTime = utils::timeutils::getTimeMillis();
-    provenance_report_->modifyContent(flow, details.str(), endTime - startTime);
+    provenance_report_->modifyContent(flow, endTime - startTime);
   } catch (std::exception &exception) {
     logger_->log_debug("Caught Exception %s", exception.what());
     throw;
@@ -419,10 +539,8 @@ void ProcessSession::import(std::string source, const std::shared_ptr<FlowFile>
         input.close();
         if (!keepSource)
           std::remove(source.c_str());
-        std::stringstream details;
-        details << process_context_->getProcessorNode()->getName() << " modify flow record content " << flow->getUUIDStr();
         auto endTime = utils::timeutils::getTimeMillis();
-        provenance_report_->modifyContent(flow, details.str(), endTime - startTime);
+        provenance_report_->modifyContent(flow, endTime - startTime);
       } else {
         stream->close();
         input.close();
@@ -444,6 +562,7 @@ void ProcessSession::import(const std::string& source, std::vector<std::shared_p
   std::shared_ptr<ResourceClaim> claim;
   std::shared_ptr<io::BaseStream> stream;
   std::shared_ptr<core::FlowFile> flowFile;
+  uint64_t contentOffset = 0;
 
   std::vector<uint8_t> buffer(getpagesize());
   try {
@@ -492,7 +611,16 @@ void ProcessSession::import(const std::string& source, std::vector<std::shared_p
         /* Create claim and stream if needed and append data */
         if (claim == nullptr) {
           startTime = utils::timeutils::getTimeMillis();
-          claim = content_session_->create();
+          claim = getPackedClaim();
+          if (claim != nullptr) {
+            std::shared_ptr<io::BaseStream> claimStream = content_session_->write(claim, ContentSession::WriteMode::APPEND);
+            if (claimStream != nullptr) {
+              contentOffset = claimStream->size();
+              stream = std::make_shared<io::StreamSlice>(claimStream, contentOffset, 0);
+            }
+          } else {
+            claim = content_session_->create();
+          }
         }
         if (stream == nullptr) {
           stream = content_session_->write(claim);
@@ -513,20 +641,23 @@ void ProcessSession::import(const std::string& source, std::vector<std::shared_p
         }
         flowFile = create();
         flowFile->setSize(stream->size());
-        flowFile->setOffset(0);
+        flowFile->setOffset(contentOffset);
         flowFile->setResourceClaim(claim);
+        if (claim == packed_claim_) {
+          ++packed_claim_flow_files_;
+        }
         logging::LOG_DEBUG(logger_) << "Import offset " << flowFile->getOffset() << " length " << flowFile->getSize() << " content " << flowFile->getResourceClaim()->getContentFullPath()
                                     << ", FlowFile UUID " << flowFile->getUUIDStr();
         stream->close();
-        std::string details = process_context_->getProcessorNode()->getName() + " modify flow record content " + flowFile->getUUIDStr();
         uint64_t endTime = utils::timeutils::getTimeMillis();
-        provenance_report_->modifyContent(flowFile, details, endTime - startTime);
+        provenance_report_->modifyContent(flowFile, endTime - startTime);
         flows.push_back(flowFile);
 
         /* Reset these to start processing the next FlowFile with a clean slate */
         flowFile.reset();
         stream.reset();
         claim.reset();
+        contentOffset = 0;
 
         /* Skip delimiter */
         begin = delimiterPos + 1;
@@ -676,6 +807,7 @@ ProcessSession::RouteResult ProcessSession::routeFlowFile(const std::shared_ptr<
 }
 
 void ProcessSession::commit() {
+  const auto commit_start = std::chrono::steady_clock::now();
   try {
     // First we clone the flow record based on the transferred relationship for updated flow record
     for (auto && it : _updatedFlowFiles) {
@@ -747,10 +879,20 @@ void ProcessSession::commit() {
     ensureNonNullResourceClaim(connectionQueues);
 
     content_session_->commit();
+    releasePackedClaims();
 
     persistFlowFilesBeforeTransfer(connectionQueues, _updatedFlowFiles);
 
+    // the provenance events read the FlowFiles in place, so they are persisted before the FlowFiles are handed over to other sessions
+    provenance_report_->commit();
+
+    uint64_t flow_files_out = 0;
+    uint64_t bytes_out = 0;
     for (auto& cq : connectionQueues) {
+      for (const auto& file : cq.second) {
+        bytes_out += file->getSize();
+      }
+      flow_files_out += cq.second.size();
       auto connection = std::dynamic_pointer_cast<Connection>(cq.first);
       if (connection) {
         connection->multiPut(cq.second);
@@ -761,6 +903,14 @@ void ProcessSession::commit() {
       }
     }
 
+    if (const auto processor = std::dynamic_pointer_cast<Processor>(process_context_->getProcessorNode()->getProcessor())) {
+      uint64_t bytes_in = 0;
+      for (const auto& it : _updatedFlowFiles) {
+        bytes_in += it.second.snapshot->getSize();
+      }
+      processor->getProfile().recordCommit(std::chrono::steady_clock::now() - commit_start, _updatedFlowFiles.size(), bytes_in, flow_files_out, bytes_out);
+    }
+
     // All done
     _updatedFlowFiles.clear();
     _addedFlowFiles.clear();
@@ -768,8 +918,6 @@ void ProcessSession::commit() {
     _deletedFlowFiles.clear();
 
     _transferRelationship.clear();
-    // persistent the provenance report
-    this->provenance_report_->commit();
     logger_->log_trace("ProcessSession committed for %s", process_context_->getProcessorNode()->getName());
   } catch (std::exception &exception) {
     logger_->log_debug("Caught Exception %s", exception.what());
@@ -816,6 +964,8 @@ void ProcessSession::rollback() {
     }
 
     content_session_->rollback();
+    releasePackedClaims();
+    provenance_report_->rollback();
 
     _clonedFlowFiles.clear();
     _addedFlowFiles.clear();
@@ -839,6 +989,8 @@ void ProcessSession::persistFlowFilesBeforeTransfer(
 
   auto flowFileRepo = process_context_->getFlowFileRepository();
   auto contentRepo = process_context_->getContentRepository();
+  // the content must outlive a restart before the FlowFiles referencing it do
+  const bool durable = flowFileRepo->isDurable() && contentRepo != nullptr;
 
   for (auto& transaction : transactionMap) {
     const std::shared_ptr<Connectable>& target = transaction.first;
@@ -850,6 +1002,9 @@ void ProcessSession::persistFlowFilesBeforeTransfer(
         // the receiver will drop this FF
         continue;
       }
+      if (durable && ff->getResourceClaim()) {
+        contentRepo->makeDurable(*ff->getResourceClaim());
+      }
 
       std::unique_ptr<io::BufferStream> stream(new io::BufferStream());
       std::static_pointer_cast<FlowFileRecord>(ff)->Serialize(*stream);
@@ -885,6 +1040,7 @@ void ProcessSession::persistFlowFilesBeforeTransfer(
       auto claim = ff->getResourceClaim();
       // increment on behalf of the persisted instance
       if (claim) claim->increaseFlowFileRecordOwnedCount();
+      flowFileRepo->registerContentClaim(ff->getUUIDStr(), claim);
       auto originalClaim = original ? original->getResourceClaim() : nullptr;
       // decrement on behalf of the overridden instance if any
       if (originalClaim) originalClaim->decreaseFlowFileRecordOwnedCount();
@@ -923,30 +1079,9 @@ std::shared_ptr<core::FlowFile> ProcessSession::get() {
   do {
     std::set<std::shared_ptr<core::FlowFile> > expired;
     std::shared_ptr<core::FlowFile> ret = current->poll(expired);
-    if (!expired.empty()) {
-      // Remove expired flow record
-      for (const auto& record : expired) {
-        std::stringstream details;
-        details << process_context_->getProcessorNode()->getName() << " expire flow record " << record->getUUIDStr();
-        provenance_report_->expire(record, details.str());
-        // there is no rolling back expired FlowFiles
-        if (record->isStored() && process_context_->getFlowFileRepository()->Delete(record->getUUIDStr())) {
-          record->setStoredToRepository(false);
-        }
-      }
-    }
+    expire(expired);
     if (ret) {
-      // add the flow record to the current process session update map
-      ret->setDeleted(false);
-      std::shared_ptr<FlowFile> snapshot = std::make_shared<FlowFileRecord>();
-      *snapshot = *ret;
-      logger_->log_debug("Create Snapshot FlowFile with UUID %s", snapshot->getUUIDStr());
-      utils::Identifier uuid = ret->getUUID();
-      _updatedFlowFiles[uuid] = {ret, snapshot};
-      auto flow_version = process_context_->getProcessorNode()->getFlowIdentifier();
-      if (flow_version != nullptr) {
-        ret->setAttribute(SpecialFlowAttribute::FLOW_ID, flow_version->getFlowId());
-      }
+      addPolledFlowFile(ret);
       return ret;
     }
     current = std::static_pointer_cast<Connection>(process_context_->getProcessorNode()->pickIncomingConnection());
@@ -955,8 +1090,64 @@ std::shared_ptr<core::FlowFile> ProcessSession::get() {
   return nullptr;
 }
 
+std::vector<std::shared_ptr<core::FlowFile>> ProcessSession::get(size_t max, uint64_t maxBytes) {
+  std::vector<std::shared_ptr<core::FlowFile>> flowFiles;
+  std::shared_ptr<Connectable> first = process_context_->getProcessorNode()->pickIncomingConnection();
+
+  if (first == nullptr) {
+    logger_->log_trace("Get is null for %s", process_context_->getProcessorNode()->getName());
+    return flowFiles;
+  }
+
+  std::shared_ptr<Connection> current = std::static_pointer_cast<Connection>(first);
+  uint64_t bytes = 0;
+
+  do {
+    std::set<std::shared_ptr<core::FlowFile> > expired;
+    const size_t begin = flowFiles.size();
+    current->pollBatch(flowFiles, max - flowFiles.size(), maxBytes - bytes, expired);
+    expire(expired);
+    for (auto it = flowFiles.begin() + begin; it != flowFiles.end(); ++it) {
+      bytes += (*it)->getSize();
+      addPolledFlowFile(*it);
+    }
+    if (flowFiles.size() >= max || bytes >= maxBytes) {
+      break;
+    }
+    current = std::static_pointer_cast<Connection>(process_context_->getProcessorNode()->pickIncomingConnection());
+  } while (current != nullptr && current != first);
+
+  return flowFiles;
+}
+
+void ProcessSession::expire(const std::set<std::shared_ptr<core::FlowFile>> &expired) {
+  // Remove expired flow record
+  for (const auto& record : expired) {
+    provenance_report_->expire(record);
+    // there is no rolling back expired FlowFiles
+    if (record->isStored() && process_context_->getFlowFileRepository()->Delete(record->getUUIDStr())) {
+      record->setStoredToRepository(false);
+    }
+  }
+}
+
+void ProcessSession::addPolledFlowFile(const std::shared_ptr<core::FlowFile> &flow) {
+  // add the flow record to the current process session update map
+  flow->setDeleted(false);
+  std::shared_ptr<FlowFile> snapshot = std::make_shared<FlowFileRecord>();
+  *snapshot = *flow;
+  logger_->log_debug("Create Snapshot FlowFile with UUID %s", snapshot->getUUIDStr());
+  utils::Identifier uuid = flow->getUUID();
+  _updatedFlowFiles[uuid] = {flow, snapshot};
+  auto flow_version = process_context_->getProcessorNode()->getFlowIdentifier();
+  if (flow_version != nullptr) {
+    flow->setAttribute(SpecialFlowAttribute::FLOW_ID, flow_version->getFlowId());
+  }
+}
+
 void ProcessSession::flushContent() {
   content_session_->commit();
+  releasePackedClaims();
 }
 
 bool ProcessSession::outgoingConnectionsFull(const std::string& relationship) {
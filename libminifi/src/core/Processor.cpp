@@ -20,6 +20,7 @@
 #include "core/Processor.h"
 
 #include <time.h>
+#include <algorithm>
 
 #include <chrono>
 #include <functional>
@@ -283,6 +284,28 @@ bool Processor::isWorkAvailable() {
   return hasWork;
 }
 
+Processor::IncomingQueueStatus Processor::getIncomingQueueStatus() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  IncomingQueueStatus status;
+  for (const auto &conn : _incomingConnections) {
+    auto connection = std::dynamic_pointer_cast<Connection>(conn);
+    if (!connection) {
+      continue;
+    }
+    const uint64_t size = connection->getQueueSize();
+    const uint64_t data_size = connection->getQueueDataSize();
+    status.size += size;
+    status.data_size += data_size;
+    if (connection->getMaxQueueSize() > 0) {
+      status.fill_ratio = (std::max)(status.fill_ratio, static_cast<double>(size) / connection->getMaxQueueSize());
+    }
+    if (connection->getMaxQueueDataSize() > 0) {
+      status.fill_ratio = (std::max)(status.fill_ratio, static_cast<double>(data_size) / connection->getMaxQueueDataSize());
+    }
+  }
+  return status;
+}
+
 // must hold the graphMutex
 void Processor::updateReachability(const std::lock_guard<std::mutex>& graph_lock, bool force) {
   bool didChange = force;
@@ -24,6 +24,7 @@
 #include "core/Repository.h"
 #include "core/ClassLoader.h"
 #include "core/repository/FileSystemRepository.h"
+#include "core/repository/TieredContentRepository.h"
 #include "core/repository/VolatileFlowFileRepository.h"
 #include "core/repository/VolatileProvenanceRepository.h"
 
@@ -92,6 +93,8 @@ std::shared_ptr<core::ContentRepository> createContentRepository(const std::stri
       return std::make_shared<core::repository::VolatileContentRepository>(repo_name);
     } else if (class_name_lc == "filesystemrepository") {
       return std::make_shared<core::repository::FileSystemRepository>(repo_name);
+    } else if (class_name_lc == "tieredcontentrepository") {
+      return std::make_shared<core::repository::TieredContentRepository>(repo_name);
     }
     if (fail_safe) {
       return std::make_shared<core::repository::VolatileContentRepository>("fail_safe");
@@ -0,0 +1,213 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/StreamingContentSession.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "core/ContentRepository.h"
+#include "ResourceClaim.h"
+#include "io/BaseStream.h"
+#include "Exception.h"
+#include "utils/gsl.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+
+StreamingContentSession::StagingStream::StagingStream(std::shared_ptr<io::BaseStream> target, size_t buffer_size)
+    : target_(std::move(target)),
+      buffer_size_(buffer_size) {
+  buffer_.reserve(buffer_size_);
+}
+
+int StreamingContentSession::StagingStream::write(const uint8_t* value, int len) {
+  gsl_Expects(len >= 0);
+  if (failed_ || target_ == nullptr) {
+    return -1;
+  }
+  const size_t length = gsl::narrow<size_t>(len);
+  if (buffer_.size() + length > buffer_size_) {
+    if (!flush()) {
+      return -1;
+    }
+    if (length >= buffer_size_) {
+      // no point in copying it into the buffer
+      if (target_->write(value, len) != len) {
+        failed_ = true;
+        return -1;
+      }
+      size_ += length;
+      return len;
+    }
+  }
+  buffer_.insert(buffer_.end(), value, value + length);
+  size_ += length;
+  return len;
+}
+
+void StreamingContentSession::StagingStream::seek(uint64_t offset) {
+  if (offset < size_) {
+    throw Exception(REPOSITORY_EXCEPTION, "Cannot seek back into staged content, it can only be appended to");
+  }
+}
+
+void StreamingContentSession::StagingStream::close() {
+  flush();
+}
+
+bool StreamingContentSession::StagingStream::flush() {
+  if (failed_ || target_ == nullptr) {
+    return false;
+  }
+  if (buffer_.empty()) {
+    return true;
+  }
+  const int length = gsl::narrow<int>(buffer_.size());
+  if (target_->write(buffer_.data(), length) != length) {
+    failed_ = true;
+    return false;
+  }
+  buffer_.clear();
+  return true;
+}
+
+bool StreamingContentSession::StagingStream::finish() {
+  const bool success = flush();
+  if (target_) {
+    target_->close();
+    target_.reset();
+  }
+  return success;
+}
+
+StreamingContentSession::StreamingContentSession(std::shared_ptr<ContentRepository> repository, size_t buffer_size)
+    : ContentSession(std::move(repository)),
+      buffer_size_(buffer_size) {}
+
+StreamingContentSession::~StreamingContentSession() {
+  try {
+    rollback();
+  } catch (...) {
+  }
+}
+
+StreamingContentSession::StagedResource StreamingContentSession::stage(const std::shared_ptr<ResourceClaim>& resourceId, bool append) {
+  StagedResource resource;
+  resource.staging = repository_->createStagingClaim(resourceId, append);
+  auto stream = repository_->write(*resource.staging);
+  if (stream == nullptr) {
+    throw Exception(REPOSITORY_EXCEPTION, "Couldn't open the staging resource for write: " + resource.staging->getContentFullPath());
+  }
+  resource.stream = std::make_shared<StagingStream>(std::move(stream), buffer_size_);
+  return resource;
+}
+
+void StreamingContentSession::discard(StagedResource& resource) {
+  if (resource.stream) {
+    resource.stream->finish();
+    resource.stream.reset();
+  }
+  repository_->remove(*resource.staging);
+}
+
+std::shared_ptr<ResourceClaim> StreamingContentSession::create() {
+  std::shared_ptr<ResourceClaim> claim = std::make_shared<ResourceClaim>(repository_);
+  stagedResources_[claim] = stage(claim, false);
+  return claim;
+}
+
+std::shared_ptr<io::BaseStream> StreamingContentSession::write(const std::shared_ptr<ResourceClaim>& resourceId, WriteMode mode) {
+  auto it = stagedResources_.find(resourceId);
+  if (it == stagedResources_.end()) {
+    if (mode == WriteMode::OVERWRITE) {
+      throw Exception(REPOSITORY_EXCEPTION, "Can only overwrite owned resource");
+    }
+    auto extension = stagedExtensions_.find(resourceId);
+    if (extension == stagedExtensions_.end()) {
+      extension = stagedExtensions_.insert(std::make_pair(resourceId, stage(resourceId, true))).first;
+    }
+    return extension->second.stream;
+  }
+  if (mode == WriteMode::OVERWRITE) {
+    discard(it->second);
+    it->second = stage(resourceId, false);
+  }
+  return it->second.stream;
+}
+
+std::shared_ptr<io::BaseStream> StreamingContentSession::read(const std::shared_ptr<ResourceClaim>& resourceId) {
+  if (stagedResources_.find(resourceId) != stagedResources_.end() || stagedExtensions_.find(resourceId) != stagedExtensions_.end()) {
+    throw Exception(REPOSITORY_EXCEPTION, "Can only read non-modified resource");
+  }
+  return repository_->read(*resourceId);
+}
+
+std::shared_ptr<io::BaseStream> StreamingContentSession::readOwned(const std::shared_ptr<ResourceClaim>& resourceId) {
+  auto it = stagedResources_.find(resourceId);
+  if (it == stagedResources_.end()) {
+    throw Exception(REPOSITORY_EXCEPTION, "Can only read owned resource");
+  }
+  // make the buffered part of the content visible in the staging claim
+  it->second.stream->close();
+  return repository_->read(*it->second.staging);
+}
+
+bool StreamingContentSession::owns(const std::shared_ptr<ResourceClaim>& resourceId) const {
+  return stagedResources_.find(resourceId) != stagedResources_.end();
+}
+
+void StreamingContentSession::publish(std::map<std::shared_ptr<ResourceClaim>, StagedResource>& resources, bool append) {
+  for (auto it = resources.begin(); it != resources.end(); it = resources.erase(it)) {
+    StagedResource& resource = it->second;
+    const bool complete = resource.stream->finish();
+    resource.stream.reset();
+    if (!complete) {
+      throw Exception(REPOSITORY_EXCEPTION, "Failed to stage resource: " + it->first->getContentFullPath());
+    }
+    if (!repository_->publish(*resource.staging, *it->first, append)) {
+      throw Exception(REPOSITORY_EXCEPTION, std::string(append ? "Failed to append to resource: " : "Failed to write new resource: ") + it->first->getContentFullPath());
+    }
+  }
+}
+
+void StreamingContentSession::commit() {
+  publish(stagedResources_, false);
+  publish(stagedExtensions_, true);
+}
+
+void StreamingContentSession::rollback() {
+  for (auto& resource : stagedResources_) {
+    discard(resource.second);
+  }
+  for (auto& resource : stagedExtensions_) {
+    discard(resource.second);
+  }
+  stagedResources_.clear();
+  stagedExtensions_.clear();
+}
+
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -22,6 +22,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 
+#include <cinttypes>
 #include <vector>
 #include <queue>
 #include <map>
@@ -41,6 +42,7 @@
 #include "core/ProcessContext.h"
 #include "core/ProcessSession.h"
 #include "provenance/Provenance.h"
+#include "provenance/ProvenanceQuery.h"
 #include "FlowController.h"
 #include "utils/gsl.h"
 
@@ -52,6 +54,7 @@ namespace core {
 namespace reporting {
 
 const char *SiteToSiteProvenanceReportingTask::ProvenanceAppStr = "MiNiFi Flow";
+const char *SiteToSiteProvenanceReportingTask::CURSOR_STATE_KEY = "provenance.cursor";
 
 void SiteToSiteProvenanceReportingTask::initialize() {
   RemoteProcessorGroupPort::initialize();
@@ -95,6 +98,59 @@ void appendJsonStr(const utils::SmallString<N>& value, rapidjson::Value& parent,
   parent.PushBack(valueVal, alloc);
 }
 
+void appendJsonRecord(provenance::ProvenanceEventRecord &record, rapidjson::Value &array, rapidjson::Document::AllocatorType &alloc) {
+  rapidjson::Value recordJson(rapidjson::kObjectType);
+  rapidjson::Value updatedAttributesJson(rapidjson::kObjectType);
+  rapidjson::Value parentUuidJson(rapidjson::kArrayType);
+  rapidjson::Value childUuidJson(rapidjson::kArrayType);
+
+  recordJson.AddMember("timestampMillis", record.getEventTime(), alloc);
+  recordJson.AddMember("durationMillis", record.getEventDuration(), alloc);
+  recordJson.AddMember("lineageStart", record.getlineageStartDate(), alloc);
+  recordJson.AddMember("entitySize", record.getFileSize(), alloc);
+  recordJson.AddMember("entityOffset", record.getFileOffset(), alloc);
+
+  recordJson.AddMember("entityType", "org.apache.nifi.flowfile.FlowFile", alloc);
+
+  recordJson.AddMember("eventId", getStringValue(record.getEventId().to_string(), alloc), alloc);
+  recordJson.AddMember("eventType", getStringValue(provenance::ProvenanceEventRecord::ProvenanceEventTypeStr[record.getEventType()], alloc), alloc);
+  recordJson.AddMember("details", getStringValue(record.getDetails(), alloc), alloc);
+  recordJson.AddMember("componentId", getStringValue(record.getComponentId(), alloc), alloc);
+  recordJson.AddMember("componentType", getStringValue(record.getComponentType(), alloc), alloc);
+  recordJson.AddMember("entityId", getStringValue(record.getFlowFileUuid().to_string(), alloc), alloc);
+  recordJson.AddMember("transitUri", getStringValue(record.getTransitUri(), alloc), alloc);
+  recordJson.AddMember("remoteIdentifier", getStringValue(record.getSourceSystemFlowFileIdentifier(), alloc), alloc);
+  recordJson.AddMember("alternateIdentifier", getStringValue(record.getAlternateIdentifierUri(), alloc), alloc);
+
+  for (auto attr : record.getAttributes()) {
+    setJsonStr(attr.first, attr.second, updatedAttributesJson, alloc);
+  }
+  recordJson.AddMember("updatedAttributes", updatedAttributesJson, alloc);
+
+  for (auto parentUUID : record.getParentUuids()) {
+    appendJsonStr(parentUUID.to_string(), parentUuidJson, alloc);
+  }
+  recordJson.AddMember("parentIds", parentUuidJson, alloc);
+
+  for (auto childUUID : record.getChildrenUuids()) {
+    appendJsonStr(childUUID.to_string(), childUuidJson, alloc);
+  }
+  recordJson.AddMember("childIds", childUuidJson, alloc);
+
+  rapidjson::Value applicationVal;
+  applicationVal.SetString(SiteToSiteProvenanceReportingTask::ProvenanceAppStr, gsl::narrow<rapidjson::SizeType>(std::strlen(SiteToSiteProvenanceReportingTask::ProvenanceAppStr)));
+  recordJson.AddMember("application", applicationVal, alloc);
+
+  array.PushBack(recordJson, alloc);
+}
+
+std::string toJsonReport(const rapidjson::Document &array) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  array.Accept(writer);
+  return buffer.GetString();
+}
+
 void SiteToSiteProvenanceReportingTask::getJsonReport(const std::shared_ptr<core::ProcessContext>& /*context*/, const std::shared_ptr<core::ProcessSession>& /*session*/,
                                                       std::vector<std::shared_ptr<core::SerializableComponent>> &records, std::string &report) {
   rapidjson::Document array(rapidjson::kArrayType);
@@ -105,68 +161,45 @@ void SiteToSiteProvenanceReportingTask::getJsonReport(const std::shared_ptr<core
     if (nullptr == record) {
       break;
     }
-
-    rapidjson::Value recordJson(rapidjson::kObjectType);
-    rapidjson::Value updatedAttributesJson(rapidjson::kObjectType);
-    rapidjson::Value parentUuidJson(rapidjson::kArrayType);
-    rapidjson::Value childUuidJson(rapidjson::kArrayType);
-
-    recordJson.AddMember("timestampMillis", record->getEventTime(), alloc);
-    recordJson.AddMember("durationMillis", record->getEventDuration(), alloc);
-    recordJson.AddMember("lineageStart", record->getlineageStartDate(), alloc);
-    recordJson.AddMember("entitySize", record->getFileSize(), alloc);
-    recordJson.AddMember("entityOffset", record->getFileOffset(), alloc);
-
-    recordJson.AddMember("entityType", "org.apache.nifi.flowfile.FlowFile", alloc);
-
-    recordJson.AddMember("eventId", getStringValue(record->getEventId().to_string(), alloc), alloc);
-    recordJson.AddMember("eventType", getStringValue(provenance::ProvenanceEventRecord::ProvenanceEventTypeStr[record->getEventType()], alloc), alloc);
-    recordJson.AddMember("details", getStringValue(record->getDetails(), alloc), alloc);
-    recordJson.AddMember("componentId", getStringValue(record->getComponentId(), alloc), alloc);
-    recordJson.AddMember("componentType", getStringValue(record->getComponentType(), alloc), alloc);
-    recordJson.AddMember("entityId", getStringValue(record->getFlowFileUuid().to_string(), alloc), alloc);
-    recordJson.AddMember("transitUri", getStringValue(record->getTransitUri(), alloc), alloc);
-    recordJson.AddMember("remoteIdentifier", getStringValue(record->getSourceSystemFlowFileIdentifier(), alloc), alloc);
-    recordJson.AddMember("alternateIdentifier", getStringValue(record->getAlternateIdentifierUri(), alloc), alloc);
-
-    for (auto attr : record->getAttributes()) {
-      setJsonStr(attr.first, attr.second, updatedAttributesJson, alloc);
-    }
-    recordJson.AddMember("updatedAttributes", updatedAttributesJson, alloc);
-
-    for (auto parentUUID : record->getParentUuids()) {
-      appendJsonStr(parentUUID.to_string(), parentUuidJson, alloc);
-    }
-    recordJson.AddMember("parentIds", parentUuidJson, alloc);
-
-    for (auto childUUID : record->getChildrenUuids()) {
-      appendJsonStr(childUUID.to_string(), childUuidJson, alloc);
-    }
-    recordJson.AddMember("childIds", childUuidJson, alloc);
-
-    rapidjson::Value applicationVal;
-    applicationVal.SetString(ProvenanceAppStr, gsl::narrow<rapidjson::SizeType>(std::strlen(ProvenanceAppStr)));
-    recordJson.AddMember("application", applicationVal, alloc);
-
-    array.PushBack(recordJson, alloc);
+    appendJsonRecord(*record, array, alloc);
   }
 
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  array.Accept(writer);
-
-  report = buffer.GetString();
+  report = toJsonReport(array);
 }
 
-void SiteToSiteProvenanceReportingTask::onSchedule(const std::shared_ptr<core::ProcessContext>& /*context*/, const std::shared_ptr<core::ProcessSessionFactory>& /*sessionFactory*/) {
+void SiteToSiteProvenanceReportingTask::onSchedule(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSessionFactory>& /*sessionFactory*/) {
+  cursor_ = 0;
+  state_manager_ = context->getStateManager();
+  if (state_manager_ == nullptr) {
+    logger_->log_warn("No state manager, the provenance events are reported again from the oldest one after a restart");
+    return;
+  }
+  core::CoreComponentState state;
+  if (state_manager_->get(state)) {
+    const auto it = state.find(CURSOR_STATE_KEY);
+    if (it != state.end()) {
+      try {
+        cursor_ = std::stoull(it->second);
+      } catch (const std::exception&) {
+        logger_->log_error("Invalid provenance reporting cursor %s, reporting from the oldest event", it->second);
+      }
+    }
+  }
+  logger_->log_debug("Reporting the provenance events from cursor %" PRIu64, cursor_);
 }
 
 void SiteToSiteProvenanceReportingTask::onTrigger(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session) {
   logger_->log_debug("SiteToSiteProvenanceReportingTask -- onTrigger");
-  std::vector<std::shared_ptr<core::SerializableComponent>> records;
   logging::LOG_DEBUG(logger_) << "batch size " << batch_size_ << " records";
-  size_t deserialized = batch_size_;
   std::shared_ptr<core::Repository> repo = context->getProvenanceRepository();
+  auto queryable_repo = std::dynamic_pointer_cast<provenance::QueryableProvenanceRepository>(repo);
+  if (queryable_repo) {
+    reportFromCursor(context, session, *queryable_repo);
+    return;
+  }
+
+  std::vector<std::shared_ptr<core::SerializableComponent>> records;
+  size_t deserialized = batch_size_;
   std::function<std::shared_ptr<core::SerializableComponent>()> constructor = []() {return std::make_shared<provenance::ProvenanceEventRecord>();};
   if (!repo->DeSerialize(records, deserialized, constructor) && deserialized == 0) {
     return;
@@ -200,6 +233,60 @@ void SiteToSiteProvenanceReportingTask::onTrigger(const std::shared_ptr<core::Pr
   returnProtocol(std::move(protocol_));
 }
 
+void SiteToSiteProvenanceReportingTask::reportFromCursor(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session,
+                                                         provenance::QueryableProvenanceRepository &repo) {
+  // the events are kept in the repository for their retention, only the cursor moves forward
+  rapidjson::Document array(rapidjson::kArrayType);
+  rapidjson::Document::AllocatorType &alloc = array.GetAllocator();
+  const uint64_t next_cursor = repo.readEventsFrom(cursor_, gsl::narrow<size_t>(batch_size_), [&array, &alloc](provenance::ProvenanceEventRecord &record) {
+    appendJsonRecord(record, array, alloc);
+  });
+  if (array.Empty()) {
+    // only skipped entries, if any
+    saveCursor(next_cursor);
+    return;
+  }
+  logging::LOG_DEBUG(logger_) << "Captured " << array.Size() << " records from cursor " << cursor_;
+  if (!transmitReport(context, session, toJsonReport(array))) {
+    // the events are reported again on the next trigger
+    return;
+  }
+  saveCursor(next_cursor);
+}
+
+bool SiteToSiteProvenanceReportingTask::transmitReport(const std::shared_ptr<core::ProcessContext> &context, const std::shared_ptr<core::ProcessSession> &session,
+                                                       const std::string &report) {
+  auto protocol_ = getNextProtocol(true);
+  if (!protocol_) {
+    context->yield();
+    return false;
+  }
+
+  try {
+    std::map<std::string, std::string> attributes;
+    if (!protocol_->transmitPayload(context, session, report, attributes)) {
+      context->yield();
+      returnProtocol(std::move(protocol_));
+      return false;
+    }
+  } catch (...) {
+    return false;
+  }
+
+  returnProtocol(std::move(protocol_));
+  return true;
+}
+
+void SiteToSiteProvenanceReportingTask::saveCursor(uint64_t cursor) {
+  if (cursor == cursor_) {
+    return;
+  }
+  cursor_ = cursor;
+  if (state_manager_ != nullptr && !state_manager_->set({{CURSOR_STATE_KEY, std::to_string(cursor_)}})) {
+    logger_->log_error("Failed to store the provenance reporting cursor %" PRIu64, cursor_);
+  }
+}
+
 } /* namespace reporting */
 } /* namespace core */
 } /* namespace minifi */
@@ -17,10 +17,13 @@
  */
 
 #include "core/repository/FileSystemRepository.h"
+#include <cstdio>
 #include <memory>
 #include <string>
+#include "core/Property.h"
 #include "io/FileStream.h"
 #include "utils/file/FileUtils.h"
+#include "utils/StringUtils.h"
 
 namespace org {
 namespace apache {
@@ -37,6 +40,17 @@ bool FileSystemRepository::initialize(const std::shared_ptr<minifi::Configure> &
     directory_ = configuration->getHome();
   }
   utils::file::FileUtils::create_dir(directory_);
+  initializeSessionOptions(*configuration);
+  if (configuration->get(Configure::nifi_content_claim_max_appendable_size, value)) {
+    core::Property::StringToInt(value, max_appendable_claim_size_);
+  }
+  if (configuration->get(Configure::nifi_content_claim_max_flow_files, value)) {
+    uint64_t max_flow_files = 0;
+    if (core::Property::StringToInt(value, max_flow_files) && max_flow_files > 0) {
+      max_flow_files_per_claim_ = max_flow_files;
+    }
+  }
+  removeStagedContent();
   return true;
 }
 void FileSystemRepository::stop() {
@@ -55,6 +69,28 @@ std::shared_ptr<io::BaseStream> FileSystemRepository::read(const minifi::Resourc
   return std::make_shared<io::FileStream>(claim.getContentFullPath(), 0, false);
 }
 
+bool FileSystemRepository::publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) {
+  if (append || staging.getContentFullPath() == target.getContentFullPath()) {
+    return ContentRepository::publish(staging, target, append);
+  }
+  if (std::rename(staging.getContentFullPath().c_str(), target.getContentFullPath().c_str()) != 0) {
+    logger_->log_error("Failed to publish %s as %s", staging.getContentFullPath(), target.getContentFullPath());
+    return false;
+  }
+  return true;
+}
+
+void FileSystemRepository::removeStagedContent() {
+  utils::file::FileUtils::list_dir(directory_, [this](const std::string& dir, const std::string& filename) {
+    if (utils::StringUtils::endsWith(filename, STAGING_EXTENSION)) {
+      const std::string path = utils::file::FileUtils::concat_path(dir, filename);
+      logger_->log_debug("Removing incomplete staged content %s", path);
+      std::remove(path.c_str());
+    }
+    return true;
+  }, logger_, false);
+}
+
 bool FileSystemRepository::remove(const minifi::ResourceClaim &claim) {
   logger_->log_debug("Deleting resource %s", claim.getContentFullPath());
   std::remove(claim.getContentFullPath().c_str());
@@ -0,0 +1,434 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/repository/TieredContentRepository.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/Property.h"
+#include "core/RepositoryFactory.h"
+#include "io/BaseStream.h"
+#include "io/StreamPipe.h"
+#include "utils/gsl.h"
+#include "utils/StringUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace core {
+namespace repository {
+
+constexpr const char *TieredContentRepository::DEFAULT_BACKEND;
+constexpr uint64_t TieredContentRepository::DEFAULT_MEMORY_MAX_SIZE;
+constexpr uint64_t TieredContentRepository::DEFAULT_MEMORY_WATERMARK_PERCENT;
+constexpr uint64_t TieredContentRepository::DEFAULT_CLAIM_MAX_SIZE;
+constexpr uint64_t TieredContentRepository::DEFAULT_SPILL_AGE_MS;
+
+/**
+ * Reads and writes the content of an entry in memory. Once the entry is spilled, the content written is appended
+ * to the claim on the backend, while reading goes on from the content in memory, which is kept until the stream is destroyed.
+ */
+class TieredContentRepository::MemoryStream : public io::BaseStream {
+ public:
+  MemoryStream(std::shared_ptr<TieredContentRepository> repository, std::shared_ptr<Entry> entry)
+      : repository_(std::move(repository)),
+        entry_(std::move(entry)),
+        offset_(0) {
+  }
+
+  ~MemoryStream() override {
+    std::lock_guard<std::mutex> lock(entry_->mutex);
+    repository_->releaseStream(*entry_);
+  }
+
+  using BaseStream::read;
+  using BaseStream::write;
+
+  void seek(uint64_t offset) override {
+    offset_ = gsl::narrow<size_t>(offset);
+  }
+
+  size_t size() const override {
+    std::lock_guard<std::mutex> lock(entry_->mutex);
+    return entry_->data.size();
+  }
+
+  int read(uint8_t *buf, int buflen) override {
+    gsl_Expects(buflen >= 0);
+    std::lock_guard<std::mutex> lock(entry_->mutex);
+    if (offset_ >= entry_->data.size()) {
+      return 0;
+    }
+    const size_t len = (std::min)(static_cast<size_t>(buflen), entry_->data.size() - offset_);
+    std::memcpy(buf, entry_->data.data() + offset_, len);
+    offset_ += len;
+    return gsl::narrow<int>(len);
+  }
+
+  int write(const uint8_t *value, int size) override {
+    gsl_Expects(size >= 0);
+    if (backend_stream_ == nullptr) {
+      {
+        std::lock_guard<std::mutex> lock(entry_->mutex);
+        if (entry_->tier == Tier::REMOVED) {
+          return -1;
+        }
+        if (entry_->tier == Tier::MEMORY) {
+          const size_t new_size = entry_->data.size() + size;
+          if (new_size <= repository_->claim_max_size_ && repository_->memory_usage_ + size <= repository_->memory_max_size_) {
+            entry_->data.insert(entry_->data.end(), value, value + size);
+            entry_->size = new_size;
+            if ((repository_->memory_usage_ += size) > repository_->memory_watermark_) {
+              repository_->condition_.notify_one();
+            }
+            return size;
+          }
+          // the claim outgrew the memory tier
+          if (!repository_->spill(*entry_)) {
+            return -1;
+          }
+        }
+      }
+      backend_stream_ = repository_->backend_->write(minifi::ResourceClaim(entry_->path, nullptr), true);
+      if (backend_stream_ == nullptr) {
+        return -1;
+      }
+    }
+    return backend_stream_->write(value, size);
+  }
+
+ private:
+  std::shared_ptr<TieredContentRepository> repository_;
+  std::shared_ptr<Entry> entry_;
+  size_t offset_;
+  // the content written once the entry is spilled is appended to this stream
+  std::shared_ptr<io::BaseStream> backend_stream_;
+};
+
+TieredContentRepository::TieredContentRepository(std::string name)
+    : core::CoreComponent(std::move(name)),
+      memory_max_size_(DEFAULT_MEMORY_MAX_SIZE),
+      memory_watermark_(DEFAULT_MEMORY_MAX_SIZE / 100 * DEFAULT_MEMORY_WATERMARK_PERCENT),
+      claim_max_size_(DEFAULT_CLAIM_MAX_SIZE),
+      spill_age_(DEFAULT_SPILL_AGE_MS),
+      running_(false),
+      memory_usage_(0),
+      spilled_count_(0),
+      logger_(logging::LoggerFactory<TieredContentRepository>::getLogger()) {
+}
+
+TieredContentRepository::~TieredContentRepository() {
+  stop();
+}
+
+bool TieredContentRepository::initialize(const std::shared_ptr<minifi::Configure> &configuration) {
+  std::string value;
+  std::string backend_class = DEFAULT_BACKEND;
+  if (configuration->get(Configure::nifi_content_repository_tiered_backend, value) && !value.empty()) {
+    backend_class = value;
+  }
+  if (utils::StringUtils::equalsIgnoreCase(backend_class, "TieredContentRepository")) {
+    logger_->log_error("The backend of the tiered content repository cannot be another tiered content repository");
+    return false;
+  }
+  try {
+    backend_ = core::createContentRepository(backend_class, false, getName());
+  } catch (const std::runtime_error&) {
+    backend_ = nullptr;
+  }
+  if (backend_ == nullptr || !backend_->initialize(configuration)) {
+    logger_->log_error("Could not initialize %s as the backend of the tiered content repository", backend_class);
+    return false;
+  }
+  directory_ = backend_->getStoragePath();
+  initializeSessionOptions(*configuration);
+  // packing the contents into shared claims is up to the backend
+  max_appendable_claim_size_ = backend_->getMaxAppendableClaimSize();
+  max_flow_files_per_claim_ = backend_->getMaxFlowFilesPerClaim();
+
+  if (configuration->get(Configure::nifi_content_repository_tiered_memory_max_size, value)) {
+    uint64_t max_size = 0;
+    if (core::Property::StringToInt(value, max_size) && max_size > 0) {
+      memory_max_size_ = max_size;
+    } else {
+      logger_->log_warn("Invalid maximum memory size of the tiered content repository: %s", value);
+    }
+  }
+  uint64_t watermark_percent = DEFAULT_MEMORY_WATERMARK_PERCENT;
+  if (configuration->get(Configure::nifi_content_repository_tiered_memory_watermark, value)) {
+    uint64_t percent = 0;
+    if (core::Property::StringToInt(value, percent) && percent <= 100) {
+      watermark_percent = percent;
+    } else {
+      logger_->log_warn("Invalid memory watermark of the tiered content repository: %s", value);
+    }
+  }
+  memory_watermark_ = memory_max_size_ / 100 * watermark_percent;
+  if (configuration->get(Configure::nifi_content_repository_tiered_claim_max_size, value)) {
+    uint64_t max_size = 0;
+    if (core::Property::StringToInt(value, max_size)) {
+      claim_max_size_ = max_size;
+    } else {
+      logger_->log_warn("Invalid maximum claim size of the tiered content repository: %s", value);
+    }
+  }
+  if (configuration->get(Configure::nifi_content_repository_tiered_spill_age, value)) {
+    uint64_t age = 0;
+    core::TimeUnit unit;
+    if (core::Property::StringToTime(value, age, unit) && core::Property::ConvertTimeUnitToMS(age, unit, age)) {
+      spill_age_ = std::chrono::milliseconds(age);
+    } else {
+      logger_->log_warn("Invalid spill age of the tiered content repository: %s", value);
+    }
+  }
+  logger_->log_info("Keeping at most %" PRIu64 " bytes of content in memory in front of %s, spilling above %" PRIu64 " bytes, claims larger than %" PRIu64
+                    " bytes and claims older than %" PRId64 " ms", memory_max_size_, backend_class, memory_watermark_, claim_max_size_, static_cast<int64_t>(spill_age_.count()));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_) {
+    running_ = true;
+    thread_ = std::thread(&TieredContentRepository::run, this);
+  }
+  return true;
+}
+
+void TieredContentRepository::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (backend_) {
+    backend_->stop();
+  }
+}
+
+std::shared_ptr<io::BaseStream> TieredContentRepository::write(const minifi::ResourceClaim &claim, bool append) {
+  const std::string &path = claim.getContentFullPath();
+  std::shared_ptr<Entry> entry = findEntry(path);
+  if (entry == nullptr) {
+    if (append && backend_->exists(claim)) {
+      return backend_->write(claim, true);
+    }
+    entry = createEntry(path);
+  }
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  if (entry->tier != Tier::MEMORY) {
+    return backend_->write(claim, append);
+  }
+  if (!append) {
+    memory_usage_ -= entry->size.exchange(0);
+    entry->data.clear();
+  }
+  ++entry->open_streams;
+  return std::make_shared<MemoryStream>(std::static_pointer_cast<TieredContentRepository>(sharedFromThis()), entry);
+}
+
+std::shared_ptr<io::BaseStream> TieredContentRepository::read(const minifi::ResourceClaim &claim) {
+  std::shared_ptr<io::BaseStream> stream = readMemory(claim);
+  return stream ? stream : backend_->read(claim);
+}
+
+bool TieredContentRepository::publish(const minifi::ResourceClaim &staging, const minifi::ResourceClaim &target, bool append) {
+  if (staging.getContentFullPath() == target.getContentFullPath()) {
+    return true;
+  }
+  {
+    // the stream keeps the staged content in memory even if it is spilled meanwhile
+    std::shared_ptr<io::BaseStream> input = readMemory(staging);
+    if (input == nullptr) {
+      // the staged content was spilled, only the backend can tell how it is staged
+      makeDurable(target);
+      if (!backend_->publish(staging, target, append)) {
+        return false;
+      }
+    } else {
+      std::shared_ptr<io::BaseStream> output = write(target, append);
+      if (output == nullptr || minifi::internal::pipe(input, output) < 0) {
+        return false;
+      }
+    }
+  }
+  // drops the entry of the staged content, the backend has already removed it if it was spilled
+  remove(staging);
+  return true;
+}
+
+bool TieredContentRepository::remove(const minifi::ResourceClaim &claim) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(claim.getContentFullPath());
+    if (it != entries_.end()) {
+      entry = it->second;
+      entries_.erase(it);
+    }
+  }
+  if (entry) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    const bool in_memory = entry->tier == Tier::MEMORY;
+    if (in_memory) {
+      memory_usage_ -= entry->size.exchange(0);
+    }
+    entry->tier = Tier::REMOVED;
+    if (entry->open_streams == 0) {
+      std::vector<uint8_t>().swap(entry->data);
+    }
+    if (in_memory) {
+      logger_->log_debug("Removed %s from memory", claim.getContentFullPath());
+      return true;
+    }
+  }
+  return backend_->remove(claim);
+}
+
+bool TieredContentRepository::exists(const minifi::ResourceClaim &claim) {
+  std::shared_ptr<Entry> entry = findEntry(claim.getContentFullPath());
+  if (entry) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->tier == Tier::MEMORY) {
+      return true;
+    }
+  }
+  return backend_->exists(claim);
+}
+
+void TieredContentRepository::makeDurable(const minifi::ResourceClaim &claim) {
+  std::shared_ptr<Entry> entry = findEntry(claim.getContentFullPath());
+  if (entry) {
+    spillEntry(entry);
+  }
+}
+
+std::shared_ptr<io::BaseStream> TieredContentRepository::readMemory(const minifi::ResourceClaim &claim) {
+  std::shared_ptr<Entry> entry = findEntry(claim.getContentFullPath());
+  if (entry) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->tier == Tier::MEMORY) {
+      ++entry->open_streams;
+      return std::make_shared<MemoryStream>(std::static_pointer_cast<TieredContentRepository>(sharedFromThis()), entry);
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<TieredContentRepository::Entry> TieredContentRepository::findEntry(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(path);
+  return it != entries_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<TieredContentRepository::Entry> TieredContentRepository::createEntry(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::shared_ptr<Entry> &entry = entries_[path];
+  if (entry == nullptr) {
+    entry = std::make_shared<Entry>(path);
+    // the entries removed or spilled out of order are dropped once they reach the front, unless there are too many of them
+    if (spill_order_.size() > 2 * entries_.size() + 1024) {
+      spill_order_.erase(std::remove_if(spill_order_.begin(), spill_order_.end(), [](const std::weak_ptr<Entry> &ptr) {
+        return ptr.expired();
+      }), spill_order_.end());
+    }
+    spill_order_.push_back(entry);
+  }
+  return entry;
+}
+
+bool TieredContentRepository::spill(Entry &entry) {
+  if (entry.tier != Tier::MEMORY) {
+    return false;
+  }
+  const int size = gsl::narrow<int>(entry.data.size());
+  {
+    auto stream = backend_->write(minifi::ResourceClaim(entry.path, nullptr), false);
+    if (stream == nullptr || (size > 0 && stream->write(entry.data.data(), size) != size)) {
+      logger_->log_error("Failed to spill %s to the backend", entry.path);
+      return false;
+    }
+  }
+  entry.tier = Tier::BACKEND;
+  memory_usage_ -= entry.size.exchange(0);
+  ++spilled_count_;
+  if (entry.open_streams == 0) {
+    std::vector<uint8_t>().swap(entry.data);
+  }
+  logger_->log_debug("Spilled %s of %d bytes to the backend", entry.path, size);
+  return true;
+}
+
+bool TieredContentRepository::spillEntry(const std::shared_ptr<Entry> &entry) {
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  return spill(*entry);
+}
+
+void TieredContentRepository::releaseStream(Entry &entry) {
+  if (--entry.open_streams == 0 && entry.tier != Tier::MEMORY) {
+    std::vector<uint8_t>().swap(entry.data);
+  }
+}
+
+void TieredContentRepository::run() {
+  const std::chrono::milliseconds check_period = spill_age_.count() > 0 ? (std::min)(spill_age_, std::chrono::milliseconds(1000)) : std::chrono::milliseconds(1000);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    condition_.wait_for(lock, check_period, [this] {
+      return !running_ || (memory_usage_ > memory_watermark_ && !spill_order_.empty());
+    });
+    if (!running_) {
+      break;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    uint64_t memory_usage = memory_usage_;
+    std::vector<std::shared_ptr<Entry>> expired;
+    while (!spill_order_.empty()) {
+      std::shared_ptr<Entry> entry = spill_order_.front().lock();
+      if (entry) {
+        const bool too_old = spill_age_.count() > 0 && now - entry->created >= spill_age_;
+        if (!too_old && memory_usage <= memory_watermark_) {
+          break;
+        }
+        memory_usage -= (std::min)(memory_usage, static_cast<uint64_t>(entry->size));
+        expired.push_back(std::move(entry));
+      }
+      spill_order_.pop_front();
+    }
+    lock.unlock();
+    for (const auto &entry : expired) {
+      spillEntry(entry);
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace repository
+}  // namespace core
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
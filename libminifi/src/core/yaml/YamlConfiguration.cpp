@@ -19,6 +19,7 @@
 #include <memory>
 #include <vector>
 #include <set>
+#include <string>
 #include <cinttypes>
 
 #include "core/yaml/YamlConfiguration.h"
@@ -26,6 +27,7 @@
 #include "core/yaml/YamlConnectionParser.h"
 #include "core/state/Value.h"
 #include "Defaults.h"
+#include "utils/OsUtils.h"
 
 #ifdef YAML_CONFIGURATION_USE_REGEX
 #include <regex>
@@ -103,8 +105,10 @@ std::unique_ptr<core::ProcessGroup> YamlConfiguration::createProcessGroup(const
   return group;
 }
 
-std::unique_ptr<core::ProcessGroup> YamlConfiguration::parseProcessGroupYaml(const YAML::Node& headerNode, const YAML::Node& yamlNode, bool is_root) {
+std::unique_ptr<core::ProcessGroup> YamlConfiguration::parseProcessGroupYaml(const YAML::Node& headerNode, const YAML::Node& yamlNode, bool is_root,
+    const std::string& parent_thread_pool) {
   auto group = createProcessGroup(headerNode, is_root);
+  group->setThreadPoolName(headerNode["thread pool"] ? headerNode["thread pool"].as<std::string>() : parent_thread_pool);
   YAML::Node processorsNode = yamlNode[CONFIG_YAML_PROCESSORS_KEY];
   YAML::Node connectionsNode = yamlNode[yaml::YamlConnectionParser::CONFIG_YAML_CONNECTIONS_KEY];
   YAML::Node remoteProcessingGroupsNode = [&] {
@@ -126,7 +130,7 @@ std::unique_ptr<core::ProcessGroup> YamlConfiguration::parseProcessGroupYaml(con
   if (childProcessGroupNodeSeq && childProcessGroupNodeSeq.IsSequence()) {
     for (YAML::const_iterator it = childProcessGroupNodeSeq.begin(); it != childProcessGroupNodeSeq.end(); ++it) {
       YAML::Node childProcessGroupNode = it->as<YAML::Node>();
-      group->addProcessGroup(parseProcessGroupYaml(childProcessGroupNode, childProcessGroupNode));
+      group->addProcessGroup(parseProcessGroupYaml(childProcessGroupNode, childProcessGroupNode, false, group->getThreadPoolName()));
     }
   }
   return group;
@@ -137,6 +141,7 @@ std::unique_ptr<core::ProcessGroup> YamlConfiguration::getYamlRoot(const YAML::N
     YAML::Node provenanceReportNode = rootYamlNode[CONFIG_YAML_PROVENANCE_REPORT_KEY];
 
     parseControllerServices(controllerServiceNode);
+    parseThreadPoolsYaml(rootYamlNode[CONFIG_YAML_THREAD_POOLS_KEY]);
     // Create the root process group
     std::unique_ptr<core::ProcessGroup> root = parseRootProcessGroupYaml(rootYamlNode);
     parseProvenanceReportingYaml(provenanceReportNode, root.get());
@@ -230,6 +235,11 @@ void YamlConfiguration::parseProcessorNodeYaml(const YAML::Node& processorsNode,
       logger_->log_debug("parseProcessorNode: max concurrent tasks => [%s]", procCfg.maxConcurrentTasks);
     }
 
+    if (procNode["min concurrent tasks"]) {
+      procCfg.minConcurrentTasks = procNode["min concurrent tasks"].as<std::string>();
+      logger_->log_debug("parseProcessorNode: min concurrent tasks => [%s]", procCfg.minConcurrentTasks);
+    }
+
     if (procNode["penalization period"]) {
       procCfg.penalizationPeriod = procNode["penalization period"].as<std::string>();
       logger_->log_debug("parseProcessorNode: penalization period => [%s]", procCfg.penalizationPeriod);
@@ -240,6 +250,40 @@ void YamlConfiguration::parseProcessorNodeYaml(const YAML::Node& processorsNode,
       logger_->log_debug("parseProcessorNode: yield period => [%s]", procCfg.yieldPeriod);
     }
 
+    if (procNode["thread pool"]) {
+      procCfg.threadPool = procNode["thread pool"].as<std::string>();
+      logger_->log_debug("parseProcessorNode: thread pool => [%s]", procCfg.threadPool);
+    } else {
+      procCfg.threadPool = parentGroup->getThreadPoolName();
+    }
+
+    if (procNode["cpu affinity"]) {
+      if (procNode["thread pool"]) {
+        throw std::invalid_argument("Processor " + procCfg.name + " cannot have both a thread pool and a cpu affinity");
+      }
+      // the processor gets a thread pool of its own named after its id, with a thread for each of its concurrent tasks
+      core::ThreadPoolDefinition definition;
+      definition.name = core::ThreadPoolDefinition::getProcessorPoolName(procCfg.id);
+      int32_t max_threads = 1;
+      if (core::Property::StringToInt(procCfg.maxConcurrentTasks, max_threads) && max_threads > 1) {
+        definition.max_threads = max_threads;
+      }
+      definition.cpu_affinity = utils::OsUtils::parseCpuList(procNode["cpu affinity"].as<std::string>());
+      for (const auto& existing : thread_pool_definitions_) {
+        if (existing.name == definition.name) {
+          throw std::invalid_argument("Processor " + procCfg.name + " has the same id " + procCfg.id + " as another pinned processor");
+        }
+      }
+      logger_->log_debug("parseProcessorNode: cpu affinity => [%s]", procNode["cpu affinity"].as<std::string>());
+      procCfg.threadPool = definition.name;
+      thread_pool_definitions_.push_back(std::move(definition));
+    }
+
+    if (procNode["provenance granularity"]) {
+      procCfg.provenanceGranularity = procNode["provenance granularity"].as<std::string>();
+      logger_->log_debug("parseProcessorNode: provenance granularity => [%s]", procCfg.provenanceGranularity);
+    }
+
     if (procNode["run duration nanos"]) {
       procCfg.runDurationNanos = procNode["run duration nanos"].as<std::string>();
       logger_->log_debug("parseProcessorNode: run duration nanos => [%s]", procCfg.runDurationNanos);
@@ -307,6 +351,12 @@ void YamlConfiguration::parseProcessorNodeYaml(const YAML::Node& processorsNode,
       processor->setMaxConcurrentTasks((uint8_t) maxConcurrentTasks);
     }
 
+    int32_t minConcurrentTasks;
+    if (core::Property::StringToInt(procCfg.minConcurrentTasks, minConcurrentTasks)) {
+      logger_->log_debug("parseProcessorNode: minConcurrentTasks => [%d]", minConcurrentTasks);
+      processor->setMinConcurrentTasks((uint8_t) minConcurrentTasks);
+    }
+
     if (core::Property::StringToInt(procCfg.runDurationNanos, runDurationNanos)) {
       logger_->log_debug("parseProcessorNode: runDurationNanos => [%d]", runDurationNanos);
       processor->setRunDurationNano((uint64_t) runDurationNanos);
@@ -321,6 +371,12 @@ void YamlConfiguration::parseProcessorNodeYaml(const YAML::Node& processorsNode,
 
     processor->setAutoTerminatedRelationships(autoTerminatedRelationships);
 
+    processor->setThreadPoolName(procCfg.threadPool);
+
+    if (!procCfg.provenanceGranularity.empty()) {
+      processor->setProvenanceGranularity(provenance::parseProvenanceGranularity(procCfg.provenanceGranularity));
+    }
+
     parentGroup->addProcessor(processor);
   }
 }
@@ -470,6 +526,17 @@ void YamlConfiguration::parseProvenanceReportingYaml(const YAML::Node& reportNod
 
   YAML::Node node = reportNode.as<YAML::Node>();
 
+  // a fixed id keeps the state of the task, i.e. the cursor of the events reported so far, across restarts
+  if (node["id"]) {
+    auto idStr = node["id"].as<std::string>();
+    auto id = utils::Identifier::parse(idStr);
+    if (!id) {
+      throw std::invalid_argument("Invalid provenance reporting task id " + idStr);
+    }
+    logger_->log_debug("ProvenanceReportingTask id %s", idStr);
+    processor->setUUID(*id);
+  }
+
   yaml::checkRequiredField(&node, "scheduling strategy", logger_,
   CONFIG_YAML_PROVENANCE_REPORT_KEY);
   auto schedulingStrategyStr = node["scheduling strategy"].as<std::string>();
@@ -585,6 +652,35 @@ void YamlConfiguration::parseControllerServices(const YAML::Node& controllerServ
   }
 }
 
+void YamlConfiguration::parseThreadPoolsYaml(const YAML::Node& threadPoolsNode) {
+  thread_pool_definitions_.clear();
+  if (!threadPoolsNode) {
+    return;
+  }
+  if (!threadPoolsNode.IsSequence()) {
+    throw std::invalid_argument("The Thread Pools configuration node must be a sequence");
+  }
+  for (const auto& threadPoolNode : threadPoolsNode) {
+    yaml::checkRequiredField(&threadPoolNode, "name", logger_, CONFIG_YAML_THREAD_POOLS_KEY);
+    yaml::checkRequiredField(&threadPoolNode, "max threads", logger_, CONFIG_YAML_THREAD_POOLS_KEY);
+    core::ThreadPoolDefinition definition;
+    definition.name = threadPoolNode["name"].as<std::string>();
+    if (core::ThreadPoolDefinition::isProcessorPoolName(definition.name)) {
+      throw std::invalid_argument("Thread pool " + definition.name + " uses the prefix " + core::ThreadPoolDefinition::getProcessorPoolPrefix()
+          + " reserved for the thread pools of the pinned processors");
+    }
+    definition.max_threads = threadPoolNode["max threads"].as<int>();
+    if (definition.max_threads <= 0) {
+      throw std::invalid_argument("Thread pool " + definition.name + " must have at least one thread");
+    }
+    if (threadPoolNode["cpu affinity"]) {
+      definition.cpu_affinity = utils::OsUtils::parseCpuList(threadPoolNode["cpu affinity"].as<std::string>());
+    }
+    logger_->log_debug("parseThreadPoolsYaml: name => [%s], max threads => [%d]", definition.name, definition.max_threads);
+    thread_pool_definitions_.push_back(std::move(definition));
+  }
+}
+
 void YamlConfiguration::parseConnectionYaml(const YAML::Node& connectionsNode, core::ProcessGroup* parent) {
   if (!parent) {
     logger_->log_error("parseProcessNode: no parent group was provided");
@@ -621,6 +717,7 @@ void YamlConfiguration::parseConnectionYaml(const YAML::Node& connectionsNode, c
     connection->setDestinationUUID(connectionParser.getDestinationUUIDFromYaml());
     connection->setFlowExpirationDuration(connectionParser.getFlowFileExpirationFromYaml());
     connection->setDropEmptyFlowFiles(connectionParser.getDropEmptyFromYaml());
+    connection->setPrioritizers(connectionParser.getPrioritizersFromYaml());
 
     parent->addConnection(connection);
   }
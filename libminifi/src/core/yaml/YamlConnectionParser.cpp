@@ -174,6 +174,31 @@ bool YamlConnectionParser::getDropEmptyFromYaml() const {
   return false;
 }
 
+std::vector<std::shared_ptr<core::FlowFilePrioritizer>> YamlConnectionParser::getPrioritizersFromYaml() const {
+  std::vector<std::shared_ptr<core::FlowFilePrioritizer>> prioritizers;
+  auto addPrioritizer = [&] (const std::string& prioritizer_name) {
+    auto prioritizer = core::FlowFilePrioritizer::create(prioritizer_name);
+    if (!prioritizer) {
+      const std::string error_msg = "Unknown prioritizer " + prioritizer_name + " in connection " + name_;
+      logger_->log_error(error_msg.c_str());
+      throw std::invalid_argument(error_msg);
+    }
+    logger_->log_debug("parseConnection: prioritizer => [%s]", prioritizer_name);
+    prioritizers.push_back(std::move(prioritizer));
+  };
+  const YAML::Node prioritizers_node = connectionNode_["prioritizers"];
+  if (prioritizers_node) {
+    if (prioritizers_node.IsSequence()) {
+      for (const auto& prioritizer : prioritizers_node) {
+        addPrioritizer(prioritizer.as<std::string>());
+      }
+    } else {
+      addPrioritizer(prioritizers_node.as<std::string>());
+    }
+  }
+  return prioritizers;
+}
+
 }  // namespace yaml
 }  // namespace core
 }  // namespace minifi
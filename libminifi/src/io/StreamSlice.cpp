@@ -0,0 +1,65 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+
+#include "io/StreamSlice.h"
+#include "utils/gsl.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace io {
+
+StreamSlice::StreamSlice(std::shared_ptr<BaseStream> stream, uint64_t offset, uint64_t size)
+    : stream_(std::move(stream)),
+      offset_(offset),
+      size_(size) {
+}
+
+int StreamSlice::write(const uint8_t *value, int len) {
+  const int ret = stream_->write(value, len);
+  if (ret > 0) {
+    size_ += ret;
+  }
+  return ret;
+}
+
+int StreamSlice::read(uint8_t *value, int len) {
+  gsl_Expects(len >= 0);
+  if (position_ >= size_) {
+    return 0;
+  }
+  len = gsl::narrow<int>(std::min<uint64_t>(len, size_ - position_));
+  const int ret = stream_->read(value, len);
+  if (ret > 0) {
+    position_ += ret;
+  }
+  return ret;
+}
+
+void StreamSlice::seek(uint64_t offset) {
+  position_ = std::min(offset, size_);
+  stream_->seek(offset_ + position_);
+}
+
+} /* namespace io */
+} /* namespace minifi */
+} /* namespace nifi */
+} /* namespace apache */
+} /* namespace org */
@@ -18,9 +18,13 @@
 
 #include "provenance/Provenance.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 #include <list>
 
@@ -29,7 +33,10 @@
 #include "core/logging/Logger.h"
 #include "core/Relationship.h"
 #include "FlowController.h"
+#include "provenance/ProvenanceQuery.h"
 #include "utils/gsl.h"
+#include "utils/GeneralUtils.h"
+#include "utils/StringUtils.h"
 
 namespace org {
 namespace apache {
@@ -87,153 +94,113 @@ bool ProvenanceEventRecord::DeSerialize(const std::shared_ptr<core::Serializable
   return ret;
 }
 
-bool ProvenanceEventRecord::Serialize(org::apache::nifi::minifi::io::BufferStream& outStream) {
-  int ret;
-
-  ret = outStream.write(this->uuid_);
-  if (ret <= 0) {
-    return false;
-  }
+namespace {
 
-  uint32_t eventType = this->_eventType;
-  ret = outStream.write(eventType);
-  if (ret != 4) {
+// the fields of an event before its attributes, in the order DeSerialize reads them
+bool writeEventHeader(io::BufferStream &outStream, const utils::Identifier &event_id, ProvenanceEventRecord::ProvenanceEventType event_type, uint64_t event_time,
+                      uint64_t entry_date, uint64_t duration, uint64_t lineage_start_date, const std::string &component_id, const std::string &component_type,
+                      const utils::Identifier &flow_uuid, const std::string &details) {
+  if (outStream.write(event_id) <= 0) {
     return false;
   }
-
-  ret = outStream.write(this->_eventTime);
-  if (ret != 8) {
+  const uint32_t type = event_type;
+  if (outStream.write(type) != 4) {
     return false;
   }
-
-  ret = outStream.write(this->_entryDate);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(this->_eventDuration);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(this->_lineageStartDate);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(this->_componentId);
-  if (ret <= 0) {
+  if (outStream.write(event_time) != 8 || outStream.write(entry_date) != 8 || outStream.write(duration) != 8 || outStream.write(lineage_start_date) != 8) {
     return false;
   }
+  return outStream.write(component_id) > 0 && outStream.write(component_type) > 0 && outStream.write(flow_uuid) > 0 && outStream.write(details) > 0;
+}
 
-  ret = outStream.write(this->_componentType);
-  if (ret <= 0) {
+template<typename AttributeMap>
+bool writeEventAttributes(io::BufferStream &outStream, const AttributeMap &attributes) {
+  const uint32_t numAttributes = gsl::narrow<uint32_t>(attributes.size());
+  if (outStream.write(numAttributes) != 4) {
     return false;
   }
-
-  ret = outStream.write(this->flow_uuid_);
-  if (ret <= 0) {
-    return false;
+  for (const auto& itAttribute : attributes) {
+    if (outStream.write(itAttribute.first) <= 0 || outStream.write(itAttribute.second) <= 0) {
+      return false;
+    }
   }
+  return true;
+}
 
-  ret = outStream.write(this->_details);
-  if (ret <= 0) {
-    return false;
-  }
+bool writeEventContent(io::BufferStream &outStream, const std::string &content_full_path, uint64_t size, uint64_t offset, const std::string &source_queue_identifier) {
+  return outStream.write(content_full_path) > 0 && outStream.write(size) == 8 && outStream.write(offset) == 8 && outStream.write(source_queue_identifier) > 0;
+}
 
-  // write flow attributes
-  uint32_t numAttributes = gsl::narrow<uint32_t>(this->_attributes.size());
-  ret = outStream.write(numAttributes);
-  if (ret != 4) {
+bool writeUuids(io::BufferStream &outStream, const std::vector<utils::Identifier> &uuids) {
+  const uint32_t uuids_count = gsl::narrow<uint32_t>(uuids.size());
+  if (outStream.write(uuids_count) != 4) {
     return false;
   }
-
-  for (const auto& itAttribute : _attributes) {
-    ret = outStream.write(itAttribute.first);
-    if (ret <= 0) {
-      return false;
-    }
-    ret = outStream.write(itAttribute.second);
-    if (ret <= 0) {
+  for (const auto& uuid : uuids) {
+    if (outStream.write(uuid) <= 0) {
       return false;
     }
   }
+  return true;
+}
 
-  ret = outStream.write(this->_contentFullPath);
-  if (ret <= 0) {
-    return false;
-  }
-
-  ret = outStream.write(this->_size);
-  if (ret != 8) {
-    return false;
-  }
-
-  ret = outStream.write(this->_offset);
-  if (ret != 8) {
-    return false;
-  }
+// the fields specific to the type of the event
+// whether the parents and children of the event are serialized
+bool hasLineage(ProvenanceEventRecord::ProvenanceEventType event_type) {
+  return event_type == ProvenanceEventRecord::FORK || event_type == ProvenanceEventRecord::CLONE || event_type == ProvenanceEventRecord::JOIN;
+}
 
-  ret = outStream.write(this->_sourceQueueIdentifier);
-  if (ret <= 0) {
-    return false;
+bool writeEventLineage(io::BufferStream &outStream, ProvenanceEventRecord::ProvenanceEventType event_type, const std::vector<utils::Identifier> &parent_uuids,
+                       const std::vector<utils::Identifier> &children_uuids, const std::string &transit_uri, const std::string &source_system_flow_file_identifier) {
+  if (hasLineage(event_type)) {
+    return writeUuids(outStream, parent_uuids) && writeUuids(outStream, children_uuids);
+  } else if (event_type == ProvenanceEventRecord::SEND || event_type == ProvenanceEventRecord::FETCH) {
+    return outStream.write(transit_uri) > 0;
+  } else if (event_type == ProvenanceEventRecord::RECEIVE) {
+    return outStream.write(transit_uri) > 0 && outStream.write(source_system_flow_file_identifier) > 0;
   }
+  return true;
+}
 
-  if (this->_eventType == ProvenanceEventRecord::FORK || this->_eventType == ProvenanceEventRecord::CLONE || this->_eventType == ProvenanceEventRecord::JOIN) {
-    // write UUIDs
-    uint32_t parent_uuids_count = gsl::narrow<uint32_t>(this->_parentUuids.size());
-    ret = outStream.write(parent_uuids_count);
-    if (ret != 4) {
-      return false;
-    }
-    for (const auto& parentUUID : _parentUuids) {
-      ret = outStream.write(parentUUID);
-      if (ret <= 0) {
-        return false;
-      }
-    }
-    uint32_t children_uuids_count = gsl::narrow<uint32_t>(this->_childrenUuids.size());
-    ret = outStream.write(children_uuids_count);
-    if (ret != 4) {
-      return false;
-    }
-    for (const auto& childUUID : _childrenUuids) {
-      ret = outStream.write(childUUID);
-      if (ret <= 0) {
-        return false;
-      }
-    }
-  } else if (this->_eventType == ProvenanceEventRecord::SEND || this->_eventType == ProvenanceEventRecord::FETCH) {
-    ret = outStream.write(this->_transitUri);
-    if (ret <= 0) {
-      return false;
-    }
-  } else if (this->_eventType == ProvenanceEventRecord::RECEIVE) {
-    ret = outStream.write(this->_transitUri);
-    if (ret <= 0) {
-      return false;
-    }
-    ret = outStream.write(this->_sourceSystemFlowFileIdentifier);
-    if (ret <= 0) {
-      return false;
-    }
-  }
+}  // namespace
 
-  return true;
+bool ProvenanceEventRecord::Serialize(org::apache::nifi::minifi::io::BufferStream& outStream) {
+  return writeEventHeader(outStream, uuid_, _eventType, _eventTime, _entryDate, _eventDuration, _lineageStartDate, _componentId, _componentType, flow_uuid_, _details)
+      && writeEventAttributes(outStream, _attributes)
+      && writeEventContent(outStream, _contentFullPath, _size, _offset, _sourceQueueIdentifier)
+      && writeEventLineage(outStream, _eventType, _parentUuids, _childrenUuids, _transitUri, _sourceSystemFlowFileIdentifier);
 }
 
 bool ProvenanceEventRecord::Serialize(const std::shared_ptr<core::SerializableComponent> &repo) {
-  org::apache::nifi::minifi::io::BufferStream outStream;
+  std::vector<std::pair<std::string, std::unique_ptr<io::BufferStream>>> data;
+  data.emplace_back(getUUIDStr(), utils::make_unique<io::BufferStream>());
+  io::BufferStream &outStream = *data.back().second;
 
   Serialize(outStream);
 
   // Persist to the DB
-  if (!repo->Serialize(getUUIDStr(), const_cast<uint8_t*>(outStream.getBuffer()), outStream.size())) {
+  const auto indexing_repo = std::dynamic_pointer_cast<QueryableProvenanceRepository>(repo);
+  const bool stored = indexing_repo ? indexing_repo->MultiPut(data, {getIndex()})
+      : repo->Serialize(getUUIDStr(), const_cast<uint8_t*>(outStream.getBuffer()), outStream.size());
+  if (!stored) {
     logger_->log_error("NiFi Provenance Store event %s size %llu fail", getUUIDStr(), outStream.size());
   }
   return true;
 }
 
+ProvenanceEventIndex ProvenanceEventRecord::getIndex() {
+  ProvenanceEventIndex index;
+  index.event_time = _eventTime;
+  index.flow_file_uuid = flow_uuid_;
+  if (hasLineage(_eventType)) {
+    index.lineage_uuids = _parentUuids;
+    index.lineage_uuids.insert(index.lineage_uuids.end(), _childrenUuids.begin(), _childrenUuids.end());
+  }
+  index.component_id = _componentId;
+  index.event_type = _eventType;
+  return index;
+}
+
 bool ProvenanceEventRecord::DeSerialize(const uint8_t *buffer, const size_t bufferSize) {
   int ret;
 
@@ -380,6 +347,217 @@ bool ProvenanceEventRecord::DeSerialize(const uint8_t *buffer, const size_t buff
   return true;
 }
 
+std::shared_ptr<utils::IdGenerator> ProvenanceReporter::id_generator_ = utils::IdGenerator::getIdGenerator();
+
+ProvenanceReporter::ProvenanceReporter(std::shared_ptr<core::Repository> repo, std::string componentId, std::string componentType, ProvenanceGranularity granularity)
+    : _componentId(std::move(componentId)),
+      _componentType(std::move(componentType)),
+      logger_(logging::LoggerFactory<ProvenanceReporter>::getLogger()),
+      repo_(std::move(repo)),
+      indexing_repo_(dynamic_cast<QueryableProvenanceRepository*>(repo_.get())),
+      granularity_(granularity),
+      captured_count_(0),
+      committed_count_(0) {
+}
+
+ProvenanceGranularity parseProvenanceGranularity(const std::string &value) {
+  const std::string granularity = utils::StringUtils::trim(value);
+  if (utils::StringUtils::equalsIgnoreCase(granularity, "none")) {
+    return ProvenanceGranularity::NONE;
+  } else if (utils::StringUtils::equalsIgnoreCase(granularity, "summary")) {
+    return ProvenanceGranularity::SUMMARY;
+  } else if (utils::StringUtils::equalsIgnoreCase(granularity, "full")) {
+    return ProvenanceGranularity::FULL;
+  }
+  throw std::invalid_argument("Invalid provenance granularity " + value + ", expected none, summary or full");
+}
+
+ProvenanceReporter::CapturedEvent *ProvenanceReporter::allocate(ProvenanceEventRecord::ProvenanceEventType eventType, const std::shared_ptr<core::FlowFile> &flow) {
+  if (granularity_ == ProvenanceGranularity::NONE || repo_->isNoop()) {
+    return nullptr;
+  }
+  if (captured_count_ == captured_.size()) {
+    captured_.emplace_back();
+  }
+  CapturedEvent &event = captured_[captured_count_++];
+  event.type = eventType;
+  event.id = utils::Identifier();
+  event.event_time = utils::timeutils::getTimeMillis();
+  event.duration = 0;
+  event.flow_file = flow;
+  snapshot(event);
+  event.details_format = DetailsFormat::TEXT;
+  event.details.clear();
+  event.attribute_value.clear();
+  event.transit_uri.clear();
+  event.source_system_flow_file_identifier.clear();
+  event.relationship.clear();
+  return &event;
+}
+
+ProvenanceReporter::CapturedEvent *ProvenanceReporter::allocateModification(ProvenanceEventRecord::ProvenanceEventType eventType, const std::shared_ptr<core::FlowFile> &flow) {
+  if (granularity_ != ProvenanceGranularity::SUMMARY) {
+    return allocate(eventType, flow);
+  }
+  const size_t none = (std::numeric_limits<size_t>::max)();
+  auto &folded = modifications_.emplace(flow.get(), std::make_pair(none, none)).first->second;
+  size_t &index = eventType == ProvenanceEventRecord::CONTENT_MODIFIED ? folded.second : folded.first;
+  // the events already in the repository are not folded into
+  if (index != none && index >= committed_count_ && index < captured_count_ && captured_[index].flow_file == flow) {
+    CapturedEvent &event = captured_[index];
+    event.event_time = utils::timeutils::getTimeMillis();
+    snapshot(event);
+    return &event;
+  }
+  CapturedEvent *event = allocate(eventType, flow);
+  if (event) {
+    index = captured_count_ - 1;
+  }
+  return event;
+}
+
+void ProvenanceReporter::snapshot(CapturedEvent &event) {
+  core::FlowFile &flow = *event.flow_file;
+  event.attributes = flow.getAttributeSnapshot();
+  event.size = flow.getSize();
+  event.offset = flow.getOffset();
+  event.claim = flow.getResourceClaim();
+  event.connection = flow.getConnection();
+}
+
+void ProvenanceReporter::release(CapturedEvent &event) {
+  event.flow_file.reset();
+  event.attributes.reset();
+  event.claim.reset();
+  event.connection.reset();
+  event.parents.clear();
+  event.children.clear();
+}
+
+void ProvenanceReporter::clear() {
+  for (size_t i = 0; i < captured_count_; ++i) {
+    // release the FlowFiles and their state, the rest of the slot is overwritten when it is reused
+    release(captured_[i]);
+  }
+  captured_count_ = 0;
+  committed_count_ = 0;
+  modifications_.clear();
+  _events.clear();
+}
+
+void ProvenanceReporter::rollback() {
+  for (size_t i = committed_count_; i < captured_count_; ++i) {
+    release(captured_[i]);
+  }
+  captured_count_ = committed_count_;
+  modifications_.clear();
+}
+
+void ProvenanceReporter::formatDetails(const CapturedEvent &event, std::string &details) const {
+  switch (event.details_format) {
+    case DetailsFormat::TEXT:
+      details = event.details;
+      break;
+    case DetailsFormat::CREATE:
+      details.assign(_componentId).append(" creates flow record ").append(event.flow_file->getUUIDStr().c_str());
+      break;
+    case DetailsFormat::MODIFY_ATTRIBUTE:
+      details.assign(_componentId).append(" modify flow record ").append(event.flow_file->getUUIDStr().c_str())
+          .append(" attribute ").append(event.details).append(":").append(event.attribute_value);
+      break;
+    case DetailsFormat::REMOVE_ATTRIBUTE:
+      details.assign(_componentId).append(" remove flow record ").append(event.flow_file->getUUIDStr().c_str()).append(" attribute ").append(event.details);
+      break;
+    case DetailsFormat::MODIFY_CONTENT:
+      details.assign(_componentId).append(" modify flow record content ").append(event.flow_file->getUUIDStr().c_str());
+      break;
+    case DetailsFormat::EXPIRE:
+      details.assign(_componentId).append(" expire flow record ").append(event.flow_file->getUUIDStr().c_str());
+      break;
+    case DetailsFormat::DROP:
+      details.assign("Discard reason: ").append(event.details);
+      break;
+    case DetailsFormat::REMOVE:
+      details.assign("Discard reason: ").append(_componentId).append(" drop flow record ").append(event.flow_file->getUUIDStr().c_str());
+      break;
+  }
+}
+
+const utils::Identifier &ProvenanceReporter::getEventId(CapturedEvent &event) {
+  if (event.id.isNil()) {
+    event.id = id_generator_->generate();
+  }
+  return event.id;
+}
+
+std::shared_ptr<ProvenanceEventRecord> ProvenanceReporter::toRecord(CapturedEvent &event) {
+  auto record = std::make_shared<ProvenanceEventRecord>(event.type, _componentId, _componentType);
+  record->setEventId(getEventId(event));
+  record->fromFlowFile(event.flow_file);
+  record->setAttributes({event.attributes->begin(), event.attributes->end()});
+  record->setFileSize(event.size);
+  record->setFileOffset(event.offset);
+  record->setContentFullPath(event.claim ? event.claim->getContentFullPath() : std::string());
+  record->setSourceQueueIdentifier(event.connection ? event.connection->getName() : std::string());
+  record->setEventTime(event.event_time);
+  record->setEventDuration(event.duration);
+  std::string details;
+  formatDetails(event, details);
+  record->setDetails(details);
+  record->setTransitUri(event.transit_uri);
+  record->setSourceSystemFlowFileIdentifier(event.source_system_flow_file_identifier);
+  record->setRelationship(event.relationship);
+  for (const auto &parent : event.parents) {
+    record->addParentFlowFile(parent);
+  }
+  for (const auto &child : event.children) {
+    record->addChildFlowFile(child);
+  }
+  return record;
+}
+
+bool ProvenanceReporter::serialize(CapturedEvent &event, io::BufferStream &stream) {
+  const core::FlowFile &flow = *event.flow_file;
+  formatDetails(event, details_buffer_);
+  parent_uuids_buffer_.clear();
+  for (const auto &parent : event.parents) {
+    parent_uuids_buffer_.push_back(parent->getUUID());
+  }
+  children_uuids_buffer_.clear();
+  for (const auto &child : event.children) {
+    children_uuids_buffer_.push_back(child->getUUID());
+  }
+  return writeEventHeader(stream, getEventId(event), event.type, event.event_time, flow.getEntryDate(), event.duration, flow.getlineageStartDate(),
+                          _componentId, _componentType, flow.getUUID(), details_buffer_)
+      && writeEventAttributes(stream, *event.attributes)
+      && writeEventContent(stream, event.claim ? event.claim->getContentFullPath() : std::string(), event.size, event.offset,
+                           event.connection ? event.connection->getName() : std::string())
+      && writeEventLineage(stream, event.type, parent_uuids_buffer_, children_uuids_buffer_, event.transit_uri, event.source_system_flow_file_identifier);
+}
+
+void ProvenanceReporter::index(const CapturedEvent &event, ProvenanceEventIndex &index) const {
+  index.event_time = event.event_time;
+  index.flow_file_uuid = event.flow_file->getUUID();
+  if (hasLineage(event.type)) {
+    for (const auto &parent : event.parents) {
+      index.lineage_uuids.push_back(parent->getUUID());
+    }
+    for (const auto &child : event.children) {
+      index.lineage_uuids.push_back(child->getUUID());
+    }
+  }
+  index.component_id = _componentId;
+  index.event_type = event.type;
+}
+
+std::set<std::shared_ptr<ProvenanceEventRecord>> ProvenanceReporter::getEvents() {
+  std::set<std::shared_ptr<ProvenanceEventRecord>> events = _events;
+  for (size_t i = 0; i < captured_count_; ++i) {
+    events.insert(toRecord(captured_[i]));
+  }
+  return events;
+}
+
 void ProvenanceReporter::commit() {
   if (repo_->isNoop()) {
     return;
@@ -391,22 +569,67 @@ void ProvenanceReporter::commit() {
   }
 
   std::vector<std::pair<std::string, std::unique_ptr<io::BufferStream>>> flowData;
+  flowData.reserve(_events.size() + captured_count_ - committed_count_);
+  indexes_buffer_.clear();
 
   for (auto& event : _events) {
     std::unique_ptr<io::BufferStream> stramptr(new io::BufferStream());
     event->Serialize(*stramptr.get());
 
     flowData.emplace_back(event->getUUIDStr(), std::move(stramptr));
+    if (indexing_repo_) {
+      indexes_buffer_.push_back(event->getIndex());
+    }
+  }
+  _events.clear();
+
+  const size_t first_pooled = flowData.size();
+  for (size_t i = committed_count_; i < captured_count_; ++i) {
+    std::unique_ptr<io::BufferStream> stream;
+    if (stream_pool_.empty()) {
+      stream = utils::make_unique<io::BufferStream>();
+    } else {
+      stream = std::move(stream_pool_.back());
+      stream_pool_.pop_back();
+      stream->initialize();
+    }
+    if (!serialize(captured_[i], *stream)) {
+      logger_->log_error("Failed to serialize provenance event of FlowFile %s", captured_[i].flow_file->getUUIDStr());
+      stream_pool_.push_back(std::move(stream));
+      continue;
+    }
+    flowData.emplace_back(captured_[i].id.to_string(), std::move(stream));
+    if (indexing_repo_) {
+      indexes_buffer_.emplace_back();
+      index(captured_[i], indexes_buffer_.back());
+    }
+  }
+  committed_count_ = captured_count_;
+  if (indexing_repo_) {
+    indexing_repo_->MultiPut(flowData, indexes_buffer_);
+  } else {
+    repo_->MultiPut(flowData);
+  }
+
+  // the buffers of the captured events are kept for the next commit
+  for (size_t i = first_pooled; i < flowData.size(); ++i) {
+    stream_pool_.push_back(std::move(flowData[i].second));
   }
-  repo_->MultiPut(flowData);
 }
 
 void ProvenanceReporter::create(std::shared_ptr<core::FlowFile> flow, std::string detail) {
   auto event = allocate(ProvenanceEventRecord::CREATE, flow);
 
   if (event) {
-    event->setDetails(detail);
-    add(event);
+    event->details = std::move(detail);
+  }
+}
+
+void ProvenanceReporter::create(const std::shared_ptr<core::FlowFile> &flow) {
+  auto event = allocate(ProvenanceEventRecord::CREATE, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::CREATE;
   }
 }
 
@@ -414,29 +637,56 @@ void ProvenanceReporter::route(std::shared_ptr<core::FlowFile> flow, core::Relat
   auto event = allocate(ProvenanceEventRecord::ROUTE, flow);
 
   if (event) {
-    event->setDetails(detail);
-    event->setRelationship(relation.getName());
-    event->setEventDuration(processingDuration);
-    add(event);
+    event->details = std::move(detail);
+    event->relationship = relation.getName();
+    event->duration = processingDuration;
   }
 }
 
 void ProvenanceReporter::modifyAttributes(std::shared_ptr<core::FlowFile> flow, std::string detail) {
-  auto event = allocate(ProvenanceEventRecord::ATTRIBUTES_MODIFIED, flow);
+  auto event = allocateModification(ProvenanceEventRecord::ATTRIBUTES_MODIFIED, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::TEXT;
+    event->details = std::move(detail);
+  }
+}
+
+void ProvenanceReporter::modifyAttribute(const std::shared_ptr<core::FlowFile> &flow, const std::string &key, const std::string &value) {
+  auto event = allocateModification(ProvenanceEventRecord::ATTRIBUTES_MODIFIED, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::MODIFY_ATTRIBUTE;
+    event->details = key;
+    event->attribute_value = value;
+  }
+}
+
+void ProvenanceReporter::removeAttribute(const std::shared_ptr<core::FlowFile> &flow, const std::string &key) {
+  auto event = allocateModification(ProvenanceEventRecord::ATTRIBUTES_MODIFIED, flow);
 
   if (event) {
-    event->setDetails(detail);
-    add(event);
+    event->details_format = DetailsFormat::REMOVE_ATTRIBUTE;
+    event->details = key;
   }
 }
 
 void ProvenanceReporter::modifyContent(std::shared_ptr<core::FlowFile> flow, std::string detail, uint64_t processingDuration) {
-  auto event = allocate(ProvenanceEventRecord::CONTENT_MODIFIED, flow);
+  auto event = allocateModification(ProvenanceEventRecord::CONTENT_MODIFIED, flow);
 
   if (event) {
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    add(event);
+    event->details_format = DetailsFormat::TEXT;
+    event->details = std::move(detail);
+    event->duration += processingDuration;
+  }
+}
+
+void ProvenanceReporter::modifyContent(const std::shared_ptr<core::FlowFile> &flow, uint64_t processingDuration) {
+  auto event = allocateModification(ProvenanceEventRecord::CONTENT_MODIFIED, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::MODIFY_CONTENT;
+    event->duration += processingDuration;
   }
 }
 
@@ -444,9 +694,8 @@ void ProvenanceReporter::clone(std::shared_ptr<core::FlowFile> parent, std::shar
   auto event = allocate(ProvenanceEventRecord::CLONE, parent);
 
   if (event) {
-    event->addChildFlowFile(child);
-    event->addParentFlowFile(parent);
-    add(event);
+    event->children.push_back(std::move(child));
+    event->parents.push_back(std::move(parent));
   }
 }
 
@@ -454,15 +703,14 @@ void ProvenanceReporter::join(std::vector<std::shared_ptr<core::FlowFile> > pare
   auto event = allocate(ProvenanceEventRecord::JOIN, child);
 
   if (event) {
-    event->addChildFlowFile(child);
-    std::vector<std::shared_ptr<core::FlowFile> >::iterator it;
-    for (it = parents.begin(); it != parents.end(); it++) {
-      std::shared_ptr<core::FlowFile> record = *it;
-      event->addParentFlowFile(record);
+    event->children.push_back(child);
+    for (auto &parent : parents) {
+      if (std::find(event->parents.begin(), event->parents.end(), parent) == event->parents.end()) {
+        event->parents.push_back(std::move(parent));
+      }
     }
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    add(event);
+    event->details = std::move(detail);
+    event->duration = processingDuration;
   }
 }
 
@@ -470,15 +718,14 @@ void ProvenanceReporter::fork(std::vector<std::shared_ptr<core::FlowFile> > chil
   auto event = allocate(ProvenanceEventRecord::FORK, parent);
 
   if (event) {
-    event->addParentFlowFile(parent);
-    std::vector<std::shared_ptr<core::FlowFile> >::iterator it;
-    for (it = child.begin(); it != child.end(); it++) {
-      std::shared_ptr<core::FlowFile> record = *it;
-      event->addChildFlowFile(record);
+    event->parents.push_back(parent);
+    for (auto &record : child) {
+      if (std::find(event->children.begin(), event->children.end(), record) == event->children.end()) {
+        event->children.push_back(std::move(record));
+      }
     }
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    add(event);
+    event->details = std::move(detail);
+    event->duration = processingDuration;
   }
 }
 
@@ -486,8 +733,15 @@ void ProvenanceReporter::expire(std::shared_ptr<core::FlowFile> flow, std::strin
   auto event = allocate(ProvenanceEventRecord::EXPIRE, flow);
 
   if (event) {
-    event->setDetails(detail);
-    add(event);
+    event->details = std::move(detail);
+  }
+}
+
+void ProvenanceReporter::expire(const std::shared_ptr<core::FlowFile> &flow) {
+  auto event = allocate(ProvenanceEventRecord::EXPIRE, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::EXPIRE;
   }
 }
 
@@ -495,9 +749,16 @@ void ProvenanceReporter::drop(std::shared_ptr<core::FlowFile> flow, std::string
   auto event = allocate(ProvenanceEventRecord::DROP, flow);
 
   if (event) {
-    std::string dropReason = "Discard reason: " + reason;
-    event->setDetails(dropReason);
-    add(event);
+    event->details_format = DetailsFormat::DROP;
+    event->details = std::move(reason);
+  }
+}
+
+void ProvenanceReporter::drop(const std::shared_ptr<core::FlowFile> &flow) {
+  auto event = allocate(ProvenanceEventRecord::DROP, flow);
+
+  if (event) {
+    event->details_format = DetailsFormat::REMOVE;
   }
 }
 
@@ -505,14 +766,16 @@ void ProvenanceReporter::send(std::shared_ptr<core::FlowFile> flow, std::string
   auto event = allocate(ProvenanceEventRecord::SEND, flow);
 
   if (event) {
-    event->setTransitUri(transitUri);
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    if (!force) {
-      add(event);
-    } else {
+    event->transit_uri = std::move(transitUri);
+    event->details = std::move(detail);
+    event->duration = processingDuration;
+    if (force) {
+      // persisted right away instead of with the session
+      auto record = toRecord(*event);
+      release(*event);
+      --captured_count_;
       if (!repo_->isFull())
-        event->Serialize(repo_);
+        record->Serialize(repo_);
     }
   }
 }
@@ -521,11 +784,10 @@ void ProvenanceReporter::receive(std::shared_ptr<core::FlowFile> flow, std::stri
   auto event = allocate(ProvenanceEventRecord::RECEIVE, flow);
 
   if (event) {
-    event->setTransitUri(transitUri);
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    event->setSourceSystemFlowFileIdentifier(sourceSystemFlowFileIdentifier);
-    add(event);
+    event->transit_uri = std::move(transitUri);
+    event->details = std::move(detail);
+    event->duration = processingDuration;
+    event->source_system_flow_file_identifier = std::move(sourceSystemFlowFileIdentifier);
   }
 }
 
@@ -533,10 +795,9 @@ void ProvenanceReporter::fetch(std::shared_ptr<core::FlowFile> flow, std::string
   auto event = allocate(ProvenanceEventRecord::FETCH, flow);
 
   if (event) {
-    event->setTransitUri(transitUri);
-    event->setDetails(detail);
-    event->setEventDuration(processingDuration);
-    add(event);
+    event->transit_uri = std::move(transitUri);
+    event->details = std::move(detail);
+    event->duration = processingDuration;
   }
 }
 
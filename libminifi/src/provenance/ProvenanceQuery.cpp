@@ -0,0 +1,154 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "provenance/ProvenanceQuery.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "core/Property.h"
+#include "utils/StringUtils.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace provenance {
+
+constexpr size_t ProvenanceQuery::DEFAULT_MAX_RESULTS;
+
+namespace {
+
+uint64_t parseUnsigned(const std::string &name, const std::string &value) {
+  size_t parsed = 0;
+  uint64_t result = 0;
+  try {
+    result = std::stoull(value, &parsed);
+  } catch (const std::exception&) {
+    parsed = 0;
+  }
+  if (parsed == 0 || parsed != value.size()) {
+    throw std::invalid_argument("Invalid " + name + " in provenance query: " + value);
+  }
+  return result;
+}
+
+}  // namespace
+
+ProvenanceQuery ProvenanceQuery::parse(const std::map<std::string, std::string> &arguments, uint64_t now_millis) {
+  ProvenanceQuery query;
+  for (const auto &argument : arguments) {
+    const std::string &name = argument.first;
+    const std::string value = utils::StringUtils::trim(argument.second);
+    if (name == "flowfile") {
+      query.flow_file_uuid = utils::Identifier::parse(value);
+      if (!query.flow_file_uuid) {
+        throw std::invalid_argument("Invalid FlowFile UUID in provenance query: " + value);
+      }
+    } else if (name == "lineage") {
+      if (!utils::StringUtils::StringToBool(value, query.lineage)) {
+        throw std::invalid_argument("Invalid lineage flag in provenance query: " + value);
+      }
+    } else if (name == "component") {
+      query.component_id = value;
+    } else if (name == "type") {
+      for (int type = ProvenanceEventRecord::CREATE; type <= ProvenanceEventRecord::REPLAY; ++type) {
+        if (utils::StringUtils::equalsIgnoreCase(value, ProvenanceEventRecord::ProvenanceEventTypeStr[type])) {
+          query.event_type = static_cast<ProvenanceEventRecord::ProvenanceEventType>(type);
+        }
+      }
+      if (!query.event_type) {
+        throw std::invalid_argument("Invalid event type in provenance query: " + value);
+      }
+    } else if (name == "since") {
+      int64_t period = 0;
+      core::TimeUnit unit;
+      if (!core::Property::StringToTime(value, period, unit) || !core::Property::ConvertTimeUnitToMS(period, unit, period) || period < 0) {
+        throw std::invalid_argument("Invalid time period in provenance query: " + value);
+      }
+      query.start_time = now_millis > static_cast<uint64_t>(period) ? now_millis - static_cast<uint64_t>(period) : 0;
+    } else if (name == "start") {
+      query.start_time = parseUnsigned(name, value);
+    } else if (name == "end") {
+      query.end_time = parseUnsigned(name, value);
+    } else if (name == "limit") {
+      query.max_results = gsl::narrow<size_t>(parseUnsigned(name, value));
+    } else {
+      throw std::invalid_argument("Unknown provenance query argument: " + name);
+    }
+  }
+  if (query.lineage && !query.flow_file_uuid) {
+    throw std::invalid_argument("The lineage of a provenance query needs a FlowFile");
+  }
+  return query;
+}
+
+ProvenanceQuery ProvenanceQuery::parse(const std::string &query, uint64_t now_millis) {
+  std::map<std::string, std::string> arguments;
+  for (const auto &argument : utils::StringUtils::split(query, "&")) {
+    if (utils::StringUtils::trim(argument).empty()) {
+      continue;
+    }
+    const auto separator = argument.find('=');
+    if (separator == std::string::npos) {
+      throw std::invalid_argument("Invalid provenance query argument: " + argument);
+    }
+    arguments[utils::StringUtils::trim(argument.substr(0, separator))] = argument.substr(separator + 1);
+  }
+  return parse(arguments, now_millis);
+}
+
+bool ProvenanceQuery::matches(ProvenanceEventRecord &event) const {
+  if (event.getEventTime() < start_time || event.getEventTime() >= end_time) {
+    return false;
+  }
+  if (component_id && event.getComponentId() != *component_id) {
+    return false;
+  }
+  if (event_type && event.getEventType() != *event_type) {
+    return false;
+  }
+  if (flow_file_uuid && !lineage) {
+    if (event.getFlowFileUuid() == *flow_file_uuid) {
+      return true;
+    }
+    const auto parents = event.getParentUuids();
+    const auto children = event.getChildrenUuids();
+    return std::find(parents.begin(), parents.end(), *flow_file_uuid) != parents.end()
+        || std::find(children.begin(), children.end(), *flow_file_uuid) != children.end();
+  }
+  return true;
+}
+
+std::string toQueryResultLine(ProvenanceEventRecord &event) {
+  std::stringstream line;
+  line << event.getEventTime() << " " << ProvenanceEventRecord::ProvenanceEventTypeStr[event.getEventType()]
+      << " " << event.getComponentType() << " " << event.getComponentId()
+      << " flowfile=" << event.getFlowFileUuid().to_string() << " event=" << event.getUUIDStr();
+  if (!event.getDetails().empty()) {
+    line << " " << event.getDetails();
+  }
+  return line.str();
+}
+
+}  // namespace provenance
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
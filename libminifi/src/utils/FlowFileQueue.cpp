@@ -17,54 +17,102 @@
 
 #include "utils/FlowFileQueue.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace org {
 namespace apache {
 namespace nifi {
 namespace minifi {
 namespace utils {
 
-bool FlowFileQueue::FlowFilePenaltyExpirationComparator::operator()(const value_type& left, const value_type& right) {
+bool FlowFileQueue::PrioritizerComparator::operator()(const QueuedFlowFile& left, const QueuedFlowFile& right) const {
+  for (const auto& prioritizer : *prioritizers_) {
+    const int result = prioritizer->compare(*left.flow_file, *right.flow_file);
+    if (result != 0) {
+      return result > 0;
+    }
+  }
+  return left.sequence_number > right.sequence_number;
+}
+
+bool FlowFileQueue::FlowFilePenaltyExpirationComparator::operator()(const value_type& left, const value_type& right) const {
   // this is operator< implemented using > so that top() is the element with the smallest key (earliest expiration)
   // rather than the element with the largest key, which is the default for std::priority_queue
   return left->getPenaltyExpiration() > right->getPenaltyExpiration();
 }
 
+void FlowFileQueue::setPrioritizers(std::vector<std::shared_ptr<core::FlowFilePrioritizer>> prioritizers) {
+  prioritizers_ = std::move(prioritizers);
+  std::make_heap(queue_.begin(), queue_.end(), PrioritizerComparator{prioritizers_});
+}
+
 FlowFileQueue::value_type FlowFileQueue::pop() {
   if (empty()) {
     throw std::logic_error{"pop() called on an empty FlowFileQueue"};
   }
 
-  value_type next_flow_file = queue_.top();
-  queue_.pop();
+  releaseExpiredPenalties();
+  if (queue_.empty()) {
+    // nothing can be processed yet, hand out the FlowFile whose penalty expires first
+    value_type next_flow_file = penalized_.top();
+    penalized_.pop();
+    return next_flow_file;
+  }
+
+  std::pop_heap(queue_.begin(), queue_.end(), PrioritizerComparator{prioritizers_});
+  value_type next_flow_file = std::move(queue_.back().flow_file);
+  queue_.pop_back();
   return next_flow_file;
 }
 
 void FlowFileQueue::push(const value_type& element) {
-  if (!element->isPenalized()) {
-    element->penalize(std::chrono::milliseconds{0});
-  }
-
-  queue_.push(element);
+  push(value_type{element});
 }
 
 void FlowFileQueue::push(value_type&& element) {
-  if (!element->isPenalized()) {
-    element->penalize(std::chrono::milliseconds{0});
+  if (element->isPenalized()) {
+    penalized_.push(std::move(element));
+  } else {
+    enqueue(std::move(element), next_sequence_number_++);
   }
+}
 
-  queue_.push(std::move(element));
+uint64_t FlowFileQueue::reserve() {
+  return next_sequence_number_++;
+}
+
+void FlowFileQueue::pushReserved(value_type element, uint64_t sequence_number) {
+  if (element->isPenalized()) {
+    penalized_.push(std::move(element));
+  } else {
+    enqueue(std::move(element), sequence_number);
+  }
 }
 
 bool FlowFileQueue::isWorkAvailable() const {
-  return !queue_.empty() && !queue_.top()->isPenalized();
+  return !queue_.empty() || (!penalized_.empty() && !penalized_.top()->isPenalized());
 }
 
 bool FlowFileQueue::empty() const {
-  return queue_.empty();
+  return queue_.empty() && penalized_.empty();
 }
 
 size_t FlowFileQueue::size() const {
-  return queue_.size();
+  return queue_.size() + penalized_.size();
+}
+
+void FlowFileQueue::enqueue(value_type element, uint64_t sequence_number) {
+  queue_.push_back(QueuedFlowFile{std::move(element), sequence_number});
+  std::push_heap(queue_.begin(), queue_.end(), PrioritizerComparator{prioritizers_});
+}
+
+void FlowFileQueue::releaseExpiredPenalties() {
+  // FlowFiles whose penalty has expired are queued again, behind the ones already waiting
+  while (!penalized_.empty() && !penalized_.top()->isPenalized()) {
+    enqueue(penalized_.top(), next_sequence_number_++);
+    penalized_.pop();
+  }
 }
 
 }  // namespace utils
@@ -22,8 +22,12 @@
 #include <map>
 
 #include "utils/gsl.h"
+#include "utils/StringUtils.h"
 
 #ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sstream>
 #endif
 
@@ -39,6 +43,8 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <pwd.h>
+#include <sys/resource.h>
+#include <time.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <fstream>
@@ -201,6 +207,170 @@ uint64_t OsUtils::getMemoryUsage() {
   throw std::runtime_error("getMemoryUsage() is not implemented for this platform");
 }
 
+std::chrono::nanoseconds OsUtils::getProcessCpuTime() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+    return std::chrono::nanoseconds(0);
+  }
+  const auto to_100ns = [](const FILETIME &time) {
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+  };
+  return std::chrono::nanoseconds((to_100ns(kernel_time) + to_100ns(user_time)) * 100);
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+      + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+std::chrono::nanoseconds OsUtils::getCurrentThreadCpuTime() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+    return std::chrono::nanoseconds(0);
+  }
+  const auto to_100ns = [](const FILETIME &time) {
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+  };
+  return std::chrono::nanoseconds((to_100ns(kernel_time) + to_100ns(user_time)) * 100);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#else
+  return std::chrono::nanoseconds(0);
+#endif
+}
+
+std::vector<int> OsUtils::parseCpuList(const std::string &cpu_list) {
+  std::vector<int> cpus;
+  for (const auto &item : StringUtils::split(cpu_list, ",")) {
+    const std::string range = StringUtils::trim(item);
+    if (range.empty()) {
+      continue;
+    }
+    const auto parseCpu = [](const std::string &str) {
+      size_t parsed = 0;
+      const int cpu = std::stoi(str, &parsed);
+      if (parsed != str.size()) {
+        throw std::invalid_argument("trailing characters");
+      }
+      return cpu;
+    };
+    const auto dash = range.find('-');
+    try {
+      const int first = parseCpu(StringUtils::trim(range.substr(0, dash)));
+      const int last = dash == std::string::npos ? first : parseCpu(StringUtils::trim(range.substr(dash + 1)));
+      if (first < 0 || last < first) {
+        throw std::invalid_argument("invalid range");
+      }
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception&) {
+      throw std::invalid_argument("Invalid CPU list: " + cpu_list);
+    }
+  }
+  return cpus;
+}
+
+bool OsUtils::setCurrentThreadAffinity(const std::vector<int> &cpus) {
+  if (cpus.empty()) {
+    return false;
+  }
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#elif defined(_WIN32)
+  DWORD_PTR mask = 0;
+  for (int cpu : cpus) {
+    if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+      mask |= DWORD_PTR{1} << cpu;
+    }
+  }
+  return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+  return false;
+#endif
+}
+
+void OsUtils::setCurrentThreadName(const std::string &name) {
+#if defined(__linux__)
+  // the kernel limits thread names to 16 bytes including the terminating zero, keep the worker index of long names
+  static const size_t MAX_LENGTH = 15;
+  std::string thread_name = name;
+  if (thread_name.size() > MAX_LENGTH) {
+    const auto index = thread_name.rfind('#');
+    const std::string suffix = index != std::string::npos && thread_name.size() - index < MAX_LENGTH ? thread_name.substr(index) : "";
+    thread_name = thread_name.substr(0, MAX_LENGTH - suffix.size()) + suffix;
+  }
+  pthread_setname_np(pthread_self(), thread_name.c_str());
+#else
+  (void)name;
+#endif
+}
+
+std::vector<OsUtils::ThreadCpuUsage> OsUtils::getThreadCpuUsage() {
+  std::vector<ThreadCpuUsage> threads;
+#if defined(__linux__)
+  DIR *task_dir = opendir("/proc/self/task");
+  if (task_dir == nullptr) {
+    return threads;
+  }
+  const auto close_dir = gsl::finally([task_dir] { closedir(task_dir); });
+  static const long ticks_per_second = sysconf(_SC_CLK_TCK);  // NOLINT(runtime/int)
+  if (ticks_per_second <= 0) {
+    return threads;
+  }
+  while (dirent *entry = readdir(task_dir)) {
+    if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+      continue;
+    }
+    std::ifstream stat_file(std::string("/proc/self/task/") + entry->d_name + "/stat");
+    std::string stat;
+    if (!std::getline(stat_file, stat)) {
+      // the thread exited in the meantime
+      continue;
+    }
+    // the name is in parentheses and may contain spaces or parentheses itself
+    const auto name_begin = stat.find('(');
+    const auto name_end = stat.rfind(')');
+    if (name_begin == std::string::npos || name_end == std::string::npos || name_end < name_begin) {
+      continue;
+    }
+    // the fields after the name start with the state (3rd field), utime and stime are the 14th and 15th fields
+    std::istringstream fields(stat.substr(name_end + 1));
+    std::string field;
+    for (int i = 3; i < 14 && fields >> field; ++i) {
+    }
+    uint64_t user_ticks = 0;
+    uint64_t system_ticks = 0;
+    if (!(fields >> user_ticks >> system_ticks)) {
+      continue;
+    }
+    ThreadCpuUsage usage;
+    usage.id = std::stoull(entry->d_name);
+    usage.name = stat.substr(name_begin + 1, name_end - name_begin - 1);
+    usage.cpu_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(static_cast<double>(user_ticks + system_ticks) / static_cast<double>(ticks_per_second)));
+    threads.push_back(usage);
+  }
+#endif
+  return threads;
+}
+
 }  // namespace utils
 }  // namespace minifi
 }  // namespace nifi
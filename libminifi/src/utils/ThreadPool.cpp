@@ -14,9 +14,9 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-
 #include "utils/ThreadPool.h"
 #include "core/state/UpdateController.h"
+#include "utils/OsUtils.h"
 
 namespace org {
 namespace apache {
@@ -27,9 +27,21 @@ namespace utils {
 template<typename T>
 void ThreadPool<T>::run_tasks(std::shared_ptr<WorkerThread> thread) {
   thread->is_running_ = true;
+  const size_t queue_index = thread->queue_index_;
+  OsUtils::setCurrentThreadName(thread->name_);
+  if (!cpu_affinity_.empty()) {
+    // best effort, the thread can still do its work on any CPU if the platform does not support this
+    OsUtils::setCurrentThreadAffinity(cpu_affinity_);
+  }
   while (running_.load()) {
     if (UNLIKELY(thread_reduction_count_ > 0)) {
       if (--thread_reduction_count_ >= 0) {
+        {
+          std::lock_guard<std::mutex> lock(thread_queue_mutex_);
+          free_work_queues_.push_back(queue_index);
+        }
+        // the tasks left in our queue are up for grabs
+        notifyWorkers();
         deceased_thread_queue_.enqueue(thread);
         thread->is_running_ = false;
         break;
@@ -38,88 +50,204 @@ void ThreadPool<T>::run_tasks(std::shared_ptr<WorkerThread> thread) {
       }
     }
 
-    Worker<T> task;
-    if (worker_queue_.dequeueWait(task)) {
-      {
-        std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-        if (!task_status_[task.getIdentifier()]) {
-          continue;
-        } else if (!worker_queue_.isRunning()) {
-          worker_queue_.enqueue(std::move(task));
-          continue;
-        }
-      }
-      if (task.run()) {
-        if (task.getNextExecutionTime() <= std::chrono::steady_clock::now()) {
-          // it can be rescheduled again as soon as there is a worker available
-          worker_queue_.enqueue(std::move(task));
-          continue;
-        }
-        // Task will be put to the delayed queue as next exec time is in the future
-        std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-        bool need_to_notify =
-            delayed_worker_queue_.empty() ||
-                task.getNextExecutionTime() < delayed_worker_queue_.top().getNextExecutionTime();
-
-        delayed_worker_queue_.push(std::move(task));
-        if (need_to_notify) {
-          delayed_task_available_.notify_all();
-        }
-      }
-    } else {
-      // The threadpool is running, but the ConcurrentQueue is stopped -> shouldn't happen during normal conditions
-      // Might happen during startup or shutdown for a very short time
-      if (running_.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ScheduledTask task;
+    if (!dequeue(queue_index, task)) {
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      ++idle_workers_;
+      work_available_.wait(lock, [this] {
+        return !running_.load() || thread_reduction_count_ > 0 || (!paused_.load() && queued_tasks_.load() > 0);
+      });
+      --idle_workers_;
+      continue;
+    }
+    if (!task.state->running_.load()) {
+      continue;
+    }
+    if (task.worker.run()) {
+      if (task.worker.getNextExecutionTime() <= std::chrono::steady_clock::now()) {
+        // it can be rescheduled again as soon as there is a worker available
+        enqueue(std::move(task), queue_index);
+        continue;
       }
+      // Task will be put to the timer wheel as next exec time is in the future
+      delay(std::move(task), queue_index);
     }
   }
   current_workers_--;
 }
 
+template<typename T>
+void ThreadPool<T>::enqueue(ScheduledTask &&task, utils::optional<size_t> queue_index) {
+  {
+    // only the tasks queued from outside the pool can race with resizing the work queues
+    std::unique_lock<std::mutex> resize_lock(work_queues_mutex_, std::defer_lock);
+    if (!queue_index) {
+      resize_lock.lock();
+    }
+    const size_t index = queue_index ? *queue_index : next_queue_++ % work_queues_.size();
+    WorkQueue &queue = *work_queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    queue.tasks_.push_back(std::move(task));
+  }
+  ++queued_tasks_;
+  if (idle_workers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    work_available_.notify_one();
+  }
+}
+
+template<typename T>
+bool ThreadPool<T>::dequeue(size_t queue_index, ScheduledTask &task) {
+  if (paused_.load() || queued_tasks_.load() == 0) {
+    return false;
+  }
+  // our own queue is served in FIFO order, so that the tasks rescheduled by this thread take turns
+  {
+    WorkQueue &queue = *work_queues_[queue_index];
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    if (!queue.tasks_.empty()) {
+      task = std::move(queue.tasks_.front());
+      queue.tasks_.pop_front();
+      --queued_tasks_;
+      return true;
+    }
+  }
+  // steal from the back of the others
+  for (size_t i = 1; i < work_queues_.size(); ++i) {
+    WorkQueue &queue = *work_queues_[(queue_index + i) % work_queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex_);
+    if (!queue.tasks_.empty()) {
+      task = std::move(queue.tasks_.back());
+      queue.tasks_.pop_back();
+      --queued_tasks_;
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename T>
+void ThreadPool<T>::delay(ScheduledTask &&task, size_t queue_index) {
+  std::shared_ptr<TaskState> state = task.state;
+  const auto execution_time = task.worker.getNextExecutionTime();
+  uint64_t ticket = 0;
+  bool woken_up = false;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex_);
+    if (!state->running_.load()) {
+      return;
+    }
+    if (state->wake_up_pending_) {
+      state->wake_up_pending_ = false;
+      woken_up = true;
+    } else {
+      ticket = next_ticket_++;
+      state->delayed_.emplace(ticket, std::move(task.worker));
+    }
+  }
+  if (woken_up) {
+    // it has been woken up while running, so it must not wait
+    task.worker.resetNextExecutionTime();
+    enqueue(std::move(task), queue_index);
+    return;
+  }
+  if (execution_time == (std::chrono::steady_clock::time_point::max)()) {
+    // parked, only wakeUp() runs it again
+    return;
+  }
+  std::lock_guard<std::mutex> lock(timer_mutex_);
+  timer_wheel_.schedule(DelayedTask{std::move(state), ticket}, execution_time);
+  if (execution_time < timer_wakeup_time_) {
+    delayed_task_available_.notify_one();
+  }
+}
+
+template<typename T>
+void ThreadPool<T>::notifyWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+  }
+  work_available_.notify_all();
+}
+
 template<typename T>
 void ThreadPool<T>::manage_delayed_queue() {
+  std::vector<DelayedTask> expired_tasks;
+  std::unique_lock<std::mutex> lock(timer_mutex_);
   while (running_) {
-    std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-
-    // Put the tasks ready to run in the worker queue
-    while (!delayed_worker_queue_.empty() &&
-        delayed_worker_queue_.top().getNextExecutionTime() <= std::chrono::steady_clock::now()) {
-      // I'm very sorry for this - committee must has been seriously drunk when the interface of prio queue was submitted.
-      Worker<T> task = std::move(const_cast<Worker<T>&>(delayed_worker_queue_.top()));
-      delayed_worker_queue_.pop();
-      worker_queue_.enqueue(std::move(task));
+    timer_wheel_.advance(std::chrono::steady_clock::now(), [&expired_tasks](DelayedTask &&task) {
+      expired_tasks.push_back(std::move(task));
+    });
+    if (!expired_tasks.empty()) {
+      lock.unlock();
+      // Put the tasks ready to run in the work queues, unless they have been stopped or woken up already
+      for (auto &expired_task : expired_tasks) {
+        const auto &state = expired_task.state;
+        Worker<T> worker;
+        {
+          std::lock_guard<std::mutex> state_lock(state->mutex_);
+          const auto it = state->delayed_.find(expired_task.ticket);
+          if (it == state->delayed_.end()) {
+            continue;
+          }
+          worker = std::move(it->second);
+          state->delayed_.erase(it);
+        }
+        enqueue(ScheduledTask{state, std::move(worker)});
+      }
+      expired_tasks.clear();
+      lock.lock();
+      continue;
     }
-    if (delayed_worker_queue_.empty()) {
-      delayed_task_available_.wait(lock);
+    const auto next_expiration = timer_wheel_.getNextExpiration();
+    if (next_expiration) {
+      timer_wakeup_time_ = *next_expiration;
+      delayed_task_available_.wait_until(lock, *next_expiration);
     } else {
-      auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-          delayed_worker_queue_.top().getNextExecutionTime() - std::chrono::steady_clock::now());
-      delayed_task_available_.wait_for(lock, std::max(wait_time, std::chrono::milliseconds(1)));
+      timer_wakeup_time_ = (std::chrono::steady_clock::time_point::max)();
+      delayed_task_available_.wait(lock);
     }
+    // we are awake, no need to notify us until the next wait
+    timer_wakeup_time_ = (std::chrono::steady_clock::time_point::min)();
   }
 }
 
 template<typename T>
 bool ThreadPool<T>::execute(Worker<T> &&task, std::future<T> &future) {
-  {
-    std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-    task_status_[task.getIdentifier()] = true;
-  }
+  std::shared_ptr<TaskState> state = getTaskState(task.getIdentifier());
+  state->running_ = true;
   future = std::move(task.getPromise()->get_future());
-  worker_queue_.enqueue(std::move(task));
+  enqueue(ScheduledTask{std::move(state), std::move(task)});
 
   task_count_++;
 
   return true;
 }
 
+template<typename T>
+TaskHandle ThreadPool<T>::getTaskHandle(const TaskId &identifier) {
+  std::lock_guard<std::mutex> lock(task_states_mutex_);
+  const auto inserted = task_handles_.emplace(identifier, task_states_.size());
+  if (inserted.second) {
+    task_states_.push_back(std::make_shared<TaskState>());
+  }
+  return inserted.first->second;
+}
+
+template<typename T>
+std::shared_ptr<typename ThreadPool<T>::TaskState> ThreadPool<T>::getTaskState(const TaskId &identifier) {
+  const TaskHandle handle = getTaskHandle(identifier);
+  std::lock_guard<std::mutex> lock(task_states_mutex_);
+  return task_states_[handle];
+}
+
 template<typename T>
 void ThreadPool<T>::manageWorkers() {
   for (int i = 0; i < max_worker_threads_; i++) {
     std::stringstream thread_name;
     thread_name << name_ << " #" << i;
     auto worker_thread = std::make_shared<WorkerThread>(thread_name.str());
+    worker_thread->queue_index_ = i;
     worker_thread->thread_ = createThread(std::bind(&ThreadPool::run_tasks, this, worker_thread));
     thread_queue_.push_back(worker_thread);
     current_workers_++;
@@ -144,23 +272,31 @@ void ThreadPool<T>::manageWorkers() {
           auto max = thread_manager_->getMaxConcurrentTasks();
           auto differential = current_workers_ - max;
           thread_reduction_count_ += differential;
+          notifyWorkers();
         } else if (thread_manager_->shouldReduce()) {
-          if (current_workers_ > 1)
+          if (current_workers_ > 1) {
             thread_reduction_count_++;
+            notifyWorkers();
+          }
           thread_manager_->reduce();
         } else if (thread_manager_->canIncrease() && max_worker_threads_ > current_workers_) {  // increase slowly
-          std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-          auto worker_thread = std::make_shared<WorkerThread>();
-          worker_thread->thread_ = createThread(std::bind(&ThreadPool::run_tasks, this, worker_thread));
-          if (daemon_threads_) {
-            worker_thread->thread_.detach();
+          std::unique_lock<std::mutex> lock(thread_queue_mutex_);
+          if (!free_work_queues_.empty()) {
+            const size_t queue_index = free_work_queues_.back();
+            auto worker_thread = std::make_shared<WorkerThread>(name_ + " #" + std::to_string(queue_index));
+            worker_thread->queue_index_ = queue_index;
+            free_work_queues_.pop_back();
+            worker_thread->thread_ = createThread(std::bind(&ThreadPool::run_tasks, this, worker_thread));
+            if (daemon_threads_) {
+              worker_thread->thread_.detach();
+            }
+            thread_queue_.push_back(worker_thread);
+            current_workers_++;
           }
-          thread_queue_.push_back(worker_thread);
-          current_workers_++;
         }
         std::shared_ptr<WorkerThread> thread_ref;
         while (deceased_thread_queue_.tryDequeue(thread_ref)) {
-          std::unique_lock<std::mutex> lock(worker_queue_mutex_);
+          std::unique_lock<std::mutex> lock(thread_queue_mutex_);
           if (thread_ref->thread_.joinable())
             thread_ref->thread_.join();
           thread_queue_.erase(std::remove(thread_queue_.begin(), thread_queue_.end(), thread_ref), thread_queue_.end());
@@ -188,32 +324,120 @@ void ThreadPool<T>::start() {
   std::lock_guard<std::recursive_mutex> lock(manager_mutex_);
   if (!running_) {
     running_ = true;
-    worker_queue_.start();
+    paused_ = false;
+    resizeWorkQueues();
     manager_thread_ = std::thread(&ThreadPool::manageWorkers, this);
 
-    std::lock_guard<std::mutex> quee_lock(worker_queue_mutex_);
+    std::lock_guard<std::mutex> timer_lock(timer_mutex_);
     delayed_scheduler_thread_ = std::thread(&ThreadPool<T>::manage_delayed_queue, this);
   }
 }
 
+template<typename T>
+void ThreadPool<T>::resizeWorkQueues() {
+  const size_t queue_count = static_cast<size_t>((std::max)(max_worker_threads_, 1));
+  {
+    std::lock_guard<std::mutex> lock(thread_queue_mutex_);
+    free_work_queues_.clear();
+  }
+  std::lock_guard<std::mutex> resize_lock(work_queues_mutex_);
+  if (work_queues_.size() == queue_count) {
+    return;
+  }
+  // keep the tasks submitted before starting
+  std::deque<ScheduledTask> tasks;
+  for (auto &queue : work_queues_) {
+    std::lock_guard<std::mutex> queue_lock(queue->mutex_);
+    std::move(queue->tasks_.begin(), queue->tasks_.end(), std::back_inserter(tasks));
+  }
+  work_queues_.clear();
+  for (size_t i = 0; i < queue_count; ++i) {
+    work_queues_.push_back(utils::make_unique<WorkQueue>());
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    work_queues_[i % queue_count]->tasks_.push_back(std::move(tasks[i]));
+  }
+}
+
 template<typename T>
 void ThreadPool<T>::stopTasks(const TaskId &identifier) {
-  std::unique_lock<std::mutex> lock(worker_queue_mutex_);
-  task_status_[identifier] = false;
+  std::shared_ptr<TaskState> state;
+  {
+    std::lock_guard<std::mutex> lock(task_states_mutex_);
+    const auto iter = task_handles_.find(identifier);
+    if (iter == task_handles_.end()) {
+      return;
+    }
+    state = task_states_[iter->second];
+  }
+  stopTasks(*state);
+}
+
+template<typename T>
+void ThreadPool<T>::stopTasks(TaskState &state) {
+  state.running_ = false;
+  // the delayed tasks are dropped right away, the queued ones when they are dequeued
+  std::lock_guard<std::mutex> lock(state.mutex_);
+  state.delayed_.clear();
+  state.wake_up_pending_ = false;
+}
+
+template<typename T>
+void ThreadPool<T>::wakeUp(const TaskId &identifier) {
+  TaskHandle handle;
+  {
+    std::lock_guard<std::mutex> lock(task_states_mutex_);
+    const auto iter = task_handles_.find(identifier);
+    if (iter == task_handles_.end()) {
+      return;
+    }
+    handle = iter->second;
+  }
+  wakeUp(handle);
+}
+
+template<typename T>
+void ThreadPool<T>::wakeUp(TaskHandle handle) {
+  std::shared_ptr<TaskState> state;
+  {
+    std::lock_guard<std::mutex> lock(task_states_mutex_);
+    if (handle >= task_states_.size()) {
+      return;
+    }
+    state = task_states_[handle];
+  }
+  if (!state->running_.load()) {
+    return;
+  }
+  std::vector<Worker<T>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex_);
+    if (state->delayed_.empty()) {
+      state->wake_up_pending_ = true;
+      return;
+    }
+    // the entries left in the timer wheel will find nothing to run when they expire
+    for (auto &delayed_task : state->delayed_) {
+      tasks.push_back(std::move(delayed_task.second));
+    }
+    state->delayed_.clear();
+  }
+  for (auto &task : tasks) {
+    task.resetNextExecutionTime();
+    enqueue(ScheduledTask{state, std::move(task)});
+  }
 }
 
 template<typename T>
 void ThreadPool<T>::resume() {
-  if (!worker_queue_.isRunning()) {
-    worker_queue_.start();
+  if (paused_.exchange(false)) {
+    notifyWorkers();
   }
 }
 
 template<typename T>
 void ThreadPool<T>::pause() {
-  if (worker_queue_.isRunning()) {
-    worker_queue_.stop();
-  }
+  paused_ = true;
 }
 
 template<typename T>
@@ -224,11 +448,19 @@ void ThreadPool<T>::shutdown() {
 
     drain();
 
-    task_status_.clear();
+    {
+      std::lock_guard<std::mutex> states_lock(task_states_mutex_);
+      for (const auto &state : task_states_) {
+        stopTasks(*state);
+      }
+    }
     if (manager_thread_.joinable()) {
       manager_thread_.join();
     }
 
+    {
+      std::lock_guard<std::mutex> timer_lock(timer_mutex_);
+    }
     delayed_task_available_.notify_all();
     if (delayed_scheduler_thread_.joinable()) {
       delayed_scheduler_thread_.join();
@@ -241,11 +473,16 @@ void ThreadPool<T>::shutdown() {
 
     thread_queue_.clear();
     current_workers_ = 0;
-    while (!delayed_worker_queue_.empty()) {
-      delayed_worker_queue_.pop();
+    {
+      std::lock_guard<std::mutex> timer_lock(timer_mutex_);
+      timer_wheel_.clear();
     }
 
-    worker_queue_.clear();
+    for (auto &queue : work_queues_) {
+      std::lock_guard<std::mutex> queue_lock(queue->mutex_);
+      queue->tasks_.clear();
+    }
+    queued_tasks_ = 0;
   }
 }
 
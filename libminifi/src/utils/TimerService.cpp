@@ -0,0 +1,153 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/TimerService.h"
+
+#include <cinttypes>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "core/logging/LoggerConfiguration.h"
+
+namespace org {
+namespace apache {
+namespace nifi {
+namespace minifi {
+namespace utils {
+
+TimerService::TimerService(std::string name)
+    : name_(std::move(name)),
+      running_(false),
+      next_id_(1),
+      firing_(0),
+      wakeup_time_((Clock::time_point::max)()),
+      logger_(core::logging::LoggerFactory<TimerService>::getLogger()) {
+}
+
+TimerService::~TimerService() {
+  stop();
+}
+
+void TimerService::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  thread_ = std::thread(&TimerService::run, this);
+  logger_->log_debug("Started timer service %s", name_);
+}
+
+void TimerService::stop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return;
+    }
+    running_ = false;
+    thread = std::move(thread_);
+  }
+  condition_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+  logger_->log_debug("Stopped timer service %s", name_);
+}
+
+TimerService::TimerId TimerService::schedule(Clock::time_point deadline, Callback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const TimerId id = next_id_++;
+  timers_.emplace(id, std::make_shared<Callback>(std::move(callback)));
+  timer_wheel_.schedule(Expiration{id, deadline}, deadline);
+  if (deadline < wakeup_time_) {
+    condition_.notify_all();
+  }
+  return id;
+}
+
+void TimerService::cancel(TimerId id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  timers_.erase(id);
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    condition_.wait(lock, [this, id] { return firing_ != id; });
+  }
+}
+
+size_t TimerService::getTimerCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return timers_.size();
+}
+
+void TimerService::run() {
+  std::vector<Expiration> expired;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    timer_wheel_.advance(Clock::now(), [&expired](Expiration &&expiration) {
+      expired.push_back(std::move(expiration));
+    });
+    for (const auto &expiration : expired) {
+      const auto timer = timers_.find(expiration.id);
+      if (timer == timers_.end()) {
+        // cancelled
+        continue;
+      }
+      const std::shared_ptr<Callback> callback = timer->second;
+      firing_ = expiration.id;
+      lock.unlock();
+      const auto now = Clock::now();
+      lateness_.record(now > expiration.deadline ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - expiration.deadline).count()) : 0);
+      utils::optional<Clock::time_point> next_deadline;
+      try {
+        next_deadline = (*callback)(expiration.deadline);
+      } catch (const std::exception &exception) {
+        logger_->log_error("Timer %" PRIu64 " of %s failed and is cancelled: %s", expiration.id, name_, exception.what());
+      } catch (...) {
+        logger_->log_error("Timer %" PRIu64 " of %s failed and is cancelled", expiration.id, name_);
+      }
+      lock.lock();
+      firing_ = 0;
+      if (next_deadline && timers_.count(expiration.id) > 0) {
+        timer_wheel_.schedule(Expiration{expiration.id, *next_deadline}, *next_deadline);
+      } else {
+        timers_.erase(expiration.id);
+      }
+      condition_.notify_all();
+    }
+    if (!expired.empty()) {
+      expired.clear();
+      continue;
+    }
+    const auto next_expiration = timer_wheel_.getNextExpiration();
+    wakeup_time_ = next_expiration ? *next_expiration : (Clock::time_point::max)();
+    if (next_expiration) {
+      condition_.wait_until(lock, *next_expiration);
+    } else {
+      condition_.wait(lock);
+    }
+    // we are awake, no need to notify us until the next wait
+    wakeup_time_ = (Clock::time_point::min)();
+  }
+}
+
+}  // namespace utils
+}  // namespace minifi
+}  // namespace nifi
+}  // namespace apache
+}  // namespace org
@@ -0,0 +1,161 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef NDEBUG
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CustomProcessors.h"
+#include "EventDrivenSchedulingAgent.h"
+#include "TestControllerWithFlow.h"
+
+namespace {
+
+const int CHAIN_LENGTH = 10;
+
+std::string processorId(int index) {
+  std::stringstream id;
+  id << "2438e3c8-015a-1001-79ca-83af40ec2" << (100 + index);
+  return id.str();
+}
+
+// A flow with structure:
+//
+// [Generator] ---> [P1] ---> [P2] ---> ... ---> [P10]
+//
+// where P1..P10 are event driven
+std::string createChainFlowYaml() {
+  std::stringstream yaml;
+  yaml << R"(
+Flow Controller:
+  name: MiNiFi Flow
+  id: 2438e3c8-015a-1001-79ca-83af40ec1990
+Processors:
+  - name: Generator
+    id: 2438e3c8-015a-1001-79ca-83af40ec1991
+    class: org.apache.nifi.processors.TestFlowFileGenerator
+    max concurrent tasks: 1
+    scheduling strategy: TIMER_DRIVEN
+    scheduling period: 200 ms
+    penalization period: 300 ms
+    yield period: 100 ms
+    run duration nanos: 0
+    auto-terminated relationships list:
+)";
+  for (int i = 1; i <= CHAIN_LENGTH; ++i) {
+    yaml << "  - name: P" << i << "\n"
+         << "    id: " << processorId(i) << "\n"
+         << R"(    class: org.apache.nifi.processors.TestProcessor
+    max concurrent tasks: 1
+    scheduling strategy: EVENT_DRIVEN
+    penalization period: 300 ms
+    yield period: 100 ms
+    run duration nanos: 0
+    auto-terminated relationships list:
+)";
+    if (i == CHAIN_LENGTH) {
+      yaml << "      - apple\n";
+    }
+    yaml << R"(    Properties:
+      AppleProbability: 100
+      BananaProbability: 0
+)";
+  }
+  yaml << "\nConnections:\n";
+  for (int i = 1; i <= CHAIN_LENGTH; ++i) {
+    yaml << "  - name: C" << i << "\n"
+         << "    id: " << processorId(CHAIN_LENGTH + i) << "\n"
+         << "    source name: " << (i == 1 ? std::string("Generator") : "P" + std::to_string(i - 1)) << "\n"
+         << "    destination name: P" << i << "\n"
+         << "    source relationship name: " << (i == 1 ? "success" : "apple") << "\n"
+         << R"(    max work queue size: 100
+    max work queue data size: 1 MB
+    flowfile expiration: 0
+)";
+  }
+  yaml << R"(
+Remote Processing Groups:
+
+Controller Services:
+)";
+  return yaml.str();
+}
+
+struct ChainLatency {
+  std::chrono::nanoseconds average{0};
+  std::chrono::nanoseconds max{0};
+};
+
+// the latency from the generator to the last processor of the chain
+ChainLatency measureChainLatency(int flow_file_count) {
+  TestControllerWithFlow testController(createChainFlowYaml().c_str());
+  auto root = testController.root_;
+
+  auto procGenerator = std::static_pointer_cast<org::apache::nifi::minifi::processors::TestFlowFileGenerator>(root->findProcessorByName("Generator"));
+  auto procLast = std::static_pointer_cast<org::apache::nifi::minifi::processors::TestProcessor>(root->findProcessorByName("P" + std::to_string(CHAIN_LENGTH)));
+
+  std::mutex mutex;
+  std::vector<std::chrono::steady_clock::time_point> generated;
+  std::vector<std::chrono::steady_clock::time_point> arrived;
+  procGenerator->onTriggerCb_ = [&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    generated.push_back(std::chrono::steady_clock::now());
+  };
+  procLast->onTriggerCb_ = [&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    arrived.push_back(std::chrono::steady_clock::now());
+  };
+
+  testController.startFlow();
+
+  int tryCount = 0;
+  // the generator is triggered every 200 ms
+  while (tryCount++ < 2 * flow_file_count + 50 && procLast->trigger_count.load() < flow_file_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  REQUIRE(arrived.size() >= static_cast<size_t>(flow_file_count));
+  // the first flow file might be generated before the whole chain is scheduled
+  ChainLatency latency;
+  std::chrono::nanoseconds total_latency{0};
+  for (size_t i = 1; i < static_cast<size_t>(flow_file_count); ++i) {
+    const auto flow_file_latency = std::chrono::duration_cast<std::chrono::nanoseconds>(arrived[i] - generated[i]);
+    total_latency += flow_file_latency;
+    latency.max = (std::max)(latency.max, flow_file_latency);
+  }
+  latency.average = total_latency / (flow_file_count - 1);
+  return latency;
+}
+
+}  // namespace
+
+TEST_CASE("Event driven processors are woken up by incoming flow files", "[EventDrivenChain]") {
+  const ChainLatency latency = measureChainLatency(6);
+  // without being woken up, every hop could take up to MAX_PARK_TIME_MS
+  REQUIRE(latency.max < std::chrono::milliseconds(MAX_PARK_TIME_MS));
+}
+
+TEST_CASE("Event driven processors hand over flow files within a millisecond per hop", "[.][benchmark]") {
+  const ChainLatency latency = measureChainLatency(50);
+  REQUIRE(latency.average < CHAIN_LENGTH * std::chrono::milliseconds(1));
+  REQUIRE(latency.max < std::chrono::milliseconds(MAX_PARK_TIME_MS));
+}
@@ -0,0 +1,151 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef NDEBUG
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CustomProcessors.h"
+#include "TestControllerWithFlow.h"
+
+namespace {
+
+const std::chrono::milliseconds MEASUREMENT_PERIOD{1000};
+
+// A flow with structure:
+//
+// [Generator] ---> [Sink]
+//
+// where both processors are scheduled every 100 ms and run for the given duration in each slot
+std::string createFlowYaml(uint64_t run_duration_nanos) {
+  std::stringstream yaml;
+  yaml << R"(
+Flow Controller:
+  name: MiNiFi Flow
+  id: 2438e3c8-015a-1001-79ca-83af40ec1990
+Processors:
+  - name: Generator
+    id: 2438e3c8-015a-1001-79ca-83af40ec1991
+    class: org.apache.nifi.processors.TestFlowFileGenerator
+    max concurrent tasks: 1
+    scheduling strategy: TIMER_DRIVEN
+    scheduling period: 100 ms
+    penalization period: 300 ms
+    yield period: 100 ms
+    run duration nanos: )" << run_duration_nanos << R"(
+    auto-terminated relationships list:
+    Properties:
+      File Size: 10 B
+      Batch Size: 1
+  - name: Sink
+    id: 2438e3c8-015a-1001-79ca-83af40ec1992
+    class: org.apache.nifi.processors.TestProcessor
+    max concurrent tasks: 1
+    scheduling strategy: TIMER_DRIVEN
+    scheduling period: 100 ms
+    penalization period: 300 ms
+    yield period: 100 ms
+    run duration nanos: )" << run_duration_nanos << R"(
+    auto-terminated relationships list:
+      - apple
+    Properties:
+      AppleProbability: 100
+      BananaProbability: 0
+
+Connections:
+  - name: Gen
+    id: 2438e3c8-015a-1001-79ca-83af40ec1993
+    source name: Generator
+    destination name: Sink
+    source relationship name: success
+    max work queue size: 10000
+    max work queue data size: 10 MB
+    flowfile expiration: 0
+
+Remote Processing Groups:
+
+Controller Services:
+)";
+  return yaml.str();
+}
+
+struct Measurement {
+  double triggers_per_second;
+  double flow_files_per_second;
+  uint64_t generator_commits;
+  uint64_t generated_flow_files;
+};
+
+Measurement measure(uint64_t run_duration_nanos) {
+  TestControllerWithFlow testController(createFlowYaml(run_duration_nanos).c_str());
+  auto procGenerator = std::static_pointer_cast<org::apache::nifi::minifi::processors::TestFlowFileGenerator>(testController.root_->findProcessorByName("Generator"));
+
+  testController.startFlow();
+  const auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(MEASUREMENT_PERIOD);
+  testController.controller_->stop();
+  const int triggers = procGenerator->trigger_count.load();
+  const auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - start);
+  const auto& profile = procGenerator->getProfile();
+  return {triggers / elapsed.count(), profile.getFlowFilesOut() / elapsed.count(), profile.getCommitLatency().getCount(), profile.getFlowFilesOut()};
+}
+
+}  // namespace
+
+TEST_CASE("Processors are triggered repeatedly within their run duration", "[RunDuration]") {
+  std::map<uint64_t, double> throughput;
+  for (const uint64_t run_duration_nanos : {0ULL, 25000000ULL}) {
+    throughput[run_duration_nanos] = measure(run_duration_nanos).triggers_per_second;
+  }
+
+  // without a run duration the generator is triggered once per scheduling period
+  REQUIRE(throughput[0] <= 1000.0 * 2 / 100);
+  REQUIRE(throughput[25000000] > throughput[0]);
+}
+
+TEST_CASE("The triggers of a batching processor within its run duration share one session commit", "[RunDuration]") {
+  SECTION("without a run duration each trigger is committed on its own") {
+    const Measurement measurement = measure(0);
+    REQUIRE(measurement.generator_commits > 0);
+    // a Batch Size of 1 generates one FlowFile per trigger
+    REQUIRE(measurement.generated_flow_files == measurement.generator_commits);
+  }
+
+  SECTION("within a run duration a commit covers several triggers") {
+    const Measurement measurement = measure(25000000);
+    REQUIRE(measurement.generator_commits > 0);
+    REQUIRE(measurement.generated_flow_files >= 2 * measurement.generator_commits);
+  }
+}
+
+TEST_CASE("The throughput of a processor grows with its run duration", "[.][benchmark]") {
+  const std::vector<uint64_t> run_durations_nanos{0, 25000000, 100000000};
+  std::vector<double> flow_files_per_second;
+  for (const uint64_t run_duration_nanos : run_durations_nanos) {
+    flow_files_per_second.push_back(measure(run_duration_nanos).flow_files_per_second);
+  }
+
+  for (size_t i = 1; i < flow_files_per_second.size(); ++i) {
+    // with some room for the noise
+    REQUIRE(flow_files_per_second[i] >= 0.9 * flow_files_per_second[i - 1]);
+  }
+  REQUIRE(flow_files_per_second.back() > flow_files_per_second.front());
+}
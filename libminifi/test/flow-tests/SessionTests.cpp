@@ -16,6 +16,11 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "../TestBase.h"
 #include "core/repository/VolatileFlowFileRepository.h"
 #include "../../extensions/rocksdb-repos/DatabaseContentRepository.h"
@@ -82,4 +87,183 @@ TEST_CASE("Import null data") {
   session.commit();
 }
 
+class StringWriteCallback : public minifi::OutputStreamCallback {
+ public:
+  explicit StringWriteCallback(std::string data) : data_(std::move(data)) {}
+
+  int64_t process(const std::shared_ptr<minifi::io::BaseStream>& stream) override {
+    return stream->write(reinterpret_cast<const uint8_t*>(data_.data()), gsl::narrow<int>(data_.size()));
+  }
+
+ private:
+  std::string data_;
+};
+
+class StringReadCallback : public minifi::InputStreamCallback {
+ public:
+  int64_t process(const std::shared_ptr<minifi::io::BaseStream>& stream) override {
+    std::vector<uint8_t> buffer(stream->size());
+    const int ret = stream->read(buffer.data(), gsl::narrow<int>(buffer.size()));
+    data_.assign(buffer.begin(), buffer.end());
+    return ret;
+  }
+
+  std::string data_;
+};
+
+TEST_CASE("Small contents are packed into a shared claim") {
+  TestController testController;
+  char format[] = "/var/tmp/test.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+  const auto content_dir = utils::file::FileUtils::concat_path(dir, "content_repository");
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_dbcontent_repository_directory_default, content_dir);
+  config->set(minifi::Configure::nifi_content_claim_max_appendable_size, "1 MB");
+  config->set(minifi::Configure::nifi_content_claim_max_flow_files, "3");
+  SECTION("Buffering ContentSession") {}
+  SECTION("Streaming ContentSession") {
+    config->set(minifi::Configure::nifi_content_repository_session_streaming, "true");
+  }
+
+  auto prov_repo = std::make_shared<core::Repository>();
+  std::shared_ptr<core::Repository> ff_repository = std::make_shared<core::repository::VolatileFlowFileRepository>();
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::FileSystemRepository>();
+  ff_repository->initialize(config);
+  content_repo->initialize(config);
+
+  auto processor = std::make_shared<core::Processor>("dummy");
+  auto output = std::make_shared<minifi::Connection>(ff_repository, content_repo, "output");
+  output->addRelationship({"out", ""});
+  output->setSourceUUID(processor->getUUID());
+  processor->addConnection(output);
+  auto node = std::make_shared<core::ProcessorNode>(processor);
+  auto context = std::make_shared<core::ProcessContext>(node, nullptr, prov_repo, ff_repository, content_repo);
+
+  std::vector<std::shared_ptr<core::FlowFile>> flowFiles;
+  {
+    core::ProcessSession session(context);
+    for (int i = 0; i < 4; ++i) {
+      auto flowFile = session.create();
+      StringWriteCallback callback("content" + std::to_string(i));
+      session.write(flowFile, &callback);
+      session.transfer(flowFile, {"out", ""});
+      flowFiles.push_back(flowFile);
+    }
+    StringWriteCallback appendCallback("+appended");
+    // the first content is followed by other contents in its claim
+    session.append(flowFiles[0], &appendCallback);
+    // the last content is the only one in its claim so far
+    session.append(flowFiles[3], &appendCallback);
+    session.commit();
+  }
+
+  REQUIRE(flowFiles[1]->getResourceClaim() == flowFiles[2]->getResourceClaim());
+  REQUIRE(flowFiles[1]->getOffset() == 8);
+  REQUIRE(flowFiles[0]->getResourceClaim() != flowFiles[1]->getResourceClaim());
+  REQUIRE(flowFiles[0]->getOffset() == 0);
+  REQUIRE(flowFiles[3]->getResourceClaim() != flowFiles[1]->getResourceClaim());
+
+  size_t file_count = 0;
+  utils::file::FileUtils::list_dir(content_dir, [&](const std::string&, const std::string&) {
+    ++file_count;
+    return true;
+  }, testController.getLogger(), false);
+  REQUIRE(file_count == 3);
+
+  const auto readAll = [&](const std::vector<std::string>& expected) {
+    core::ProcessSession session(context);
+    for (size_t i = 0; i < flowFiles.size(); ++i) {
+      StringReadCallback callback;
+      session.read(flowFiles[i], &callback);
+      REQUIRE(callback.data_ == expected[i]);
+    }
+  };
+  readAll({"content0+appended", "content1", "content2", "content3+appended"});
+
+  {
+    // the claims packed by the previous session are committed, appending must not spill into the neighbouring contents
+    core::ProcessSession session(context);
+    const auto shared_claim = flowFiles[1]->getResourceClaim();
+    StringWriteCallback appendCallback("+again");
+    session.append(flowFiles[1], &appendCallback);
+    session.append(flowFiles[1], &appendCallback);
+    session.append(flowFiles[3], &appendCallback);
+    session.commit();
+    REQUIRE(flowFiles[1]->getResourceClaim() != shared_claim);
+    REQUIRE(flowFiles[1]->getOffset() == 0);
+    REQUIRE(flowFiles[2]->getResourceClaim() == shared_claim);
+  }
+  readAll({"content0+appended", "content1+again+again", "content2", "content3+appended+again"});
+}
+
+struct SmallContentWrites {
+  size_t files;
+  double files_per_second;
+  double flow_files_per_second;
+};
+
+// writes small contents in sessions of 100 flow files, counting the content files created
+SmallContentWrites measureSmallContentWrites(TestController& testController, bool packing) {
+  const int SESSION_COUNT = 100;
+  const int FLOW_FILES_PER_SESSION = 100;
+  char format[] = "/var/tmp/test.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+  const auto content_dir = utils::file::FileUtils::concat_path(dir, "content_repository");
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_dbcontent_repository_directory_default, content_dir);
+  if (packing) {
+    config->set(minifi::Configure::nifi_content_claim_max_appendable_size, "1 MB");
+    config->set(minifi::Configure::nifi_content_claim_max_flow_files, std::to_string(FLOW_FILES_PER_SESSION));
+  }
+
+  auto prov_repo = std::make_shared<core::Repository>();
+  std::shared_ptr<core::Repository> ff_repository = std::make_shared<core::repository::VolatileFlowFileRepository>();
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::FileSystemRepository>();
+  ff_repository->initialize(config);
+  content_repo->initialize(config);
+
+  auto processor = std::make_shared<core::Processor>("dummy");
+  auto output = std::make_shared<minifi::Connection>(ff_repository, content_repo, "output");
+  output->addRelationship({"out", ""});
+  output->setSourceUUID(processor->getUUID());
+  processor->addConnection(output);
+  auto node = std::make_shared<core::ProcessorNode>(processor);
+  auto context = std::make_shared<core::ProcessContext>(node, nullptr, prov_repo, ff_repository, content_repo);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SESSION_COUNT; ++i) {
+    core::ProcessSession session(context);
+    for (int j = 0; j < FLOW_FILES_PER_SESSION; ++j) {
+      auto flowFile = session.create();
+      StringWriteCallback callback("a small content");
+      session.write(flowFile, &callback);
+      session.transfer(flowFile, {"out", ""});
+    }
+    session.commit();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  // the flow files are still queued, so none of the files have been removed
+  size_t file_count = 0;
+  utils::file::FileUtils::list_dir(content_dir, [&](const std::string&, const std::string&) {
+    ++file_count;
+    return true;
+  }, testController.getLogger(), false);
+  REQUIRE(SESSION_COUNT * FLOW_FILES_PER_SESSION == output->getQueueSize());
+  return {file_count, file_count / elapsed.count(), SESSION_COUNT * FLOW_FILES_PER_SESSION / elapsed.count()};
+}
+
+TEST_CASE("Packing small contents creates fewer files and writes them faster", "[.][benchmark]") {
+  TestController testController;
+  const SmallContentWrites unpacked = measureSmallContentWrites(testController, false);
+  const SmallContentWrites packed = measureSmallContentWrites(testController, true);
+
+  // a file per session instead of a file per flow file
+  REQUIRE(packed.files * 50 <= unpacked.files);
+  REQUIRE(packed.files_per_second < unpacked.files_per_second);
+  REQUIRE(packed.flow_files_per_second >= unpacked.flow_files_per_second);
+}
+
 }  // namespace
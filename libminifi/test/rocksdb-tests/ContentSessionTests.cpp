@@ -23,18 +23,25 @@
 #include "FileSystemRepository.h"
 #include "VolatileContentRepository.h"
 #include "DatabaseContentRepository.h"
+#include "TieredContentRepository.h"
 #include "FlowFileRecord.h"
 #include "../TestBase.h"
 #include "utils/gsl.h"
+#include "utils/file/FileUtils.h"
 
 template<typename ContentRepositoryClass>
 class ContentSessionController : public TestController {
  public:
-  ContentSessionController() {
+  explicit ContentSessionController(bool streaming = false) {
     char format[] = "/var/tmp/content_repo.XXXXXX";
     std::string contentRepoPath = createTempDirectory(format);
     auto config = std::make_shared<minifi::Configure>();
     config->set(minifi::Configure::nifi_dbcontent_repository_directory_default, contentRepoPath);
+    if (streaming) {
+      config->set(minifi::Configure::nifi_content_repository_session_streaming, "true");
+      // small enough for the written content to be flushed to the staging area
+      config->set(minifi::Configure::nifi_content_repository_session_buffer_size, "4 B");
+    }
     contentRepository = std::make_shared<ContentRepositoryClass>();
     contentRepository->initialize(config);
   }
@@ -70,8 +77,8 @@ const std::shared_ptr<minifi::io::BaseStream>& operator>>(const std::shared_ptr<
 //  seems like the current version of Catch2 does not support templated tests
 //  we should update instead of creating make-shift macros
 template<typename ContentRepositoryClass>
-void test_template() {
-  ContentSessionController<ContentRepositoryClass> controller;
+void test_template(bool streaming = false) {
+  ContentSessionController<ContentRepositoryClass> controller(streaming);
   std::shared_ptr<core::ContentRepository> contentRepository = controller.contentRepository;
 
 
@@ -150,4 +157,80 @@ TEST_CASE("ContentSession behavior") {
   SECTION("DatabaseContentRepository") {
     test_template<core::repository::DatabaseContentRepository>();
   }
+  SECTION("TieredContentRepository") {
+    test_template<core::repository::TieredContentRepository>();
+  }
+}
+
+TEST_CASE("Streaming ContentSession behavior") {
+  SECTION("FileSystemRepository") {
+    test_template<core::repository::FileSystemRepository>(true);
+  }
+  SECTION("DatabaseContentRepository") {
+    test_template<core::repository::DatabaseContentRepository>(true);
+  }
+  SECTION("TieredContentRepository") {
+    test_template<core::repository::TieredContentRepository>(true);
+  }
+}
+
+TEST_CASE("Streaming ContentSession does not leave staged content behind") {
+  ContentSessionController<core::repository::FileSystemRepository> controller(true);
+  std::shared_ptr<core::ContentRepository> contentRepository = controller.contentRepository;
+
+  std::shared_ptr<minifi::ResourceClaim> claim;
+  {
+    auto session = contentRepository->createSession();
+    claim = session->create();
+    session->write(claim) << "staged content";
+    session->commit();
+  }
+  {
+    auto session = contentRepository->createSession();
+    session->write(claim, core::ContentSession::WriteMode::APPEND) << " never committed";
+  }
+
+  std::string content;
+  contentRepository->read(*claim) >> content;
+  REQUIRE(content == "staged content");
+
+  auto files = utils::file::FileUtils::list_dir_all(contentRepository->getStoragePath(), controller.getLogger(), false);
+  REQUIRE(files.size() == 1);
+  REQUIRE(files[0].second == utils::file::FileUtils::get_child_path(claim->getContentFullPath()));
+}
+
+TEST_CASE("Streaming ContentSession stages appends in chunks") {
+  ContentSessionController<core::repository::DatabaseContentRepository> controller(true);
+  std::shared_ptr<core::ContentRepository> contentRepository = controller.contentRepository;
+
+  std::shared_ptr<minifi::ResourceClaim> claim;
+  {
+    auto session = contentRepository->createSession();
+    claim = session->create();
+    session->write(claim) << "data";
+    session->commit();
+  }
+
+  auto session = contentRepository->createSession();
+  auto stream = session->write(claim, core::ContentSession::WriteMode::APPEND);
+  for (int i = 0; i < 10; ++i) {
+    // the 4 byte buffer holds a single write, so each of them is staged as a chunk of its own
+    stream << "-" + std::to_string(i) + "-";
+  }
+  REQUIRE_THROWS(stream->seek(0));
+  REQUIRE_NOTHROW(stream->seek(stream->size()));
+
+  SECTION("Commit") {
+    session->commit();
+    std::string content;
+    contentRepository->read(*claim) >> content;
+    REQUIRE(content == "data-0--1--2--3--4--5--6--7--8--9-");
+  }
+
+  SECTION("Rollback") {
+    session->rollback();
+    std::string content;
+    contentRepository->read(*claim) >> content;
+    REQUIRE(content == "data");
+  }
 }
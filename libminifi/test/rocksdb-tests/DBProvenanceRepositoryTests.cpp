@@ -16,12 +16,18 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "FlowFileRecord.h"
 #include "ProvenanceRepository.h"
+#include "provenance/ProvenanceQuery.h"
 #include "../TestBase.h"
 
 #define TEST_PROVENANCE_STORAGE_SIZE (1024*100)  // 100 KB
@@ -119,3 +125,284 @@ TEST_CASE("Test time limit", "[timeLimitTest]") {
 
   verifyMaxKeyCount(provdb, 400);
 }
+
+TEST_CASE("Test provenance queries", "[provenanceQuery]") {
+  using minifi::provenance::ProvenanceEventRecord;
+  using minifi::provenance::ProvenanceQuery;
+  TestController testController;
+
+  char dirtemplate[] = "/var/tmp/db.XXXXXX";
+  auto temp_dir = testController.createTempDirectory(dirtemplate);
+  REQUIRE(!temp_dir.empty());
+
+  auto provdb = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", temp_dir,
+      MAX_PROVENANCE_ENTRY_LIFE_TIME, TEST_MAX_PROVENANCE_STORAGE_SIZE, 1000);
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, temp_dir);
+  REQUIRE(provdb->initialize(configuration));
+
+  auto parent = std::make_shared<minifi::FlowFileRecord>();
+  auto first_child = std::make_shared<minifi::FlowFileRecord>();
+  auto second_child = std::make_shared<minifi::FlowFileRecord>();
+  auto unrelated = std::make_shared<minifi::FlowFileRecord>();
+  std::vector<std::shared_ptr<ProvenanceEventRecord>> events;
+  const auto record = [&](ProvenanceEventRecord::ProvenanceEventType type, const std::string &component, std::shared_ptr<core::FlowFile> flow_file) {
+    // distinct event times
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    auto event = std::make_shared<ProvenanceEventRecord>(type, component, "Processor");
+    event->fromFlowFile(flow_file);
+    events.push_back(event);
+    return event;
+  };
+  record(ProvenanceEventRecord::RECEIVE, "getfile", parent);
+  auto fork = record(ProvenanceEventRecord::FORK, "split", parent);
+  fork->addChildFlowFile(first_child);
+  fork->addChildFlowFile(second_child);
+  record(ProvenanceEventRecord::SEND, "putsftp", first_child);
+  record(ProvenanceEventRecord::RECEIVE, "getfile", unrelated);
+  // the events are put in reverse order, they are still returned in the order of their event times
+  for (auto it = events.rbegin(); it != events.rend(); ++it) {
+    REQUIRE((*it)->Serialize(provdb));
+  }
+
+  const auto ids = [](const std::vector<std::shared_ptr<ProvenanceEventRecord>> &result) {
+    std::vector<std::string> event_ids;
+    for (const auto &event : result) {
+      event_ids.push_back(event->getUUIDStr());
+    }
+    return event_ids;
+  };
+  const auto expected = [&events](std::initializer_list<size_t> indexes) {
+    std::vector<std::string> event_ids;
+    for (size_t index : indexes) {
+      event_ids.push_back(events[index]->getUUIDStr());
+    }
+    return event_ids;
+  };
+
+  SECTION("by FlowFile") {
+    ProvenanceQuery query;
+    query.flow_file_uuid = first_child->getUUID();
+    REQUIRE(expected({1, 2}) == ids(provdb->query(query)));
+  }
+  SECTION("by the lineage of a FlowFile") {
+    ProvenanceQuery query;
+    query.flow_file_uuid = first_child->getUUID();
+    query.lineage = true;
+    REQUIRE(expected({0, 1, 2}) == ids(provdb->query(query)));
+    query.event_type = ProvenanceEventRecord::RECEIVE;
+    REQUIRE(expected({0}) == ids(provdb->query(query)));
+  }
+  SECTION("by component") {
+    ProvenanceQuery query;
+    query.component_id = "getfile";
+    REQUIRE(expected({0, 3}) == ids(provdb->query(query)));
+    query.max_results = 1;
+    REQUIRE(expected({0}) == ids(provdb->query(query)));
+  }
+  SECTION("by event type") {
+    ProvenanceQuery query;
+    query.event_type = ProvenanceEventRecord::SEND;
+    REQUIRE(expected({2}) == ids(provdb->query(query)));
+  }
+  SECTION("by event time") {
+    ProvenanceQuery query;
+    query.start_time = events[1]->getEventTime();
+    query.end_time = events[3]->getEventTime();
+    REQUIRE(expected({1, 2}) == ids(provdb->query(query)));
+    query.component_id = "getfile";
+    REQUIRE(provdb->query(query).empty());
+  }
+  SECTION("by event id") {
+    ProvenanceEventRecord event;
+    event.setEventId(events[2]->getEventId());
+    REQUIRE(event.DeSerialize(provdb));
+    REQUIRE(event.getComponentId() == "putsftp");
+  }
+}
+
+TEST_CASE("Test reading provenance events from a cursor", "[provenanceCursor]") {
+  using minifi::provenance::ProvenanceEventRecord;
+  TestController testController;
+
+  char dirtemplate[] = "/var/tmp/db.XXXXXX";
+  auto temp_dir = testController.createTempDirectory(dirtemplate);
+  REQUIRE(!temp_dir.empty());
+
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, temp_dir);
+  auto provdb = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", temp_dir,
+      MAX_PROVENANCE_ENTRY_LIFE_TIME, TEST_MAX_PROVENANCE_STORAGE_SIZE, 1000);
+  REQUIRE(provdb->initialize(configuration));
+
+  std::vector<std::string> put_ids;
+  const auto put = [&](size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      ProvenanceEventRecord event(ProvenanceEventRecord::CREATE, "component", "Processor");
+      std::shared_ptr<core::FlowFile> flow_file = std::make_shared<minifi::FlowFileRecord>();
+      event.fromFlowFile(flow_file);
+      REQUIRE(event.Serialize(provdb));
+      put_ids.push_back(event.getUUIDStr());
+    }
+  };
+  std::vector<std::string> read_ids;
+  const auto read = [&](uint64_t cursor, size_t max_events) {
+    return provdb->readEventsFrom(cursor, max_events, [&read_ids](ProvenanceEventRecord &event) {
+      read_ids.push_back(event.getUUIDStr());
+    });
+  };
+
+  put(25);
+  uint64_t cursor = 0;
+  cursor = read(cursor, 10);
+  REQUIRE(10 == read_ids.size());
+  cursor = read(cursor, 10);
+  cursor = read(cursor, 10);
+  REQUIRE(put_ids == read_ids);
+  REQUIRE(cursor == read(cursor, 10));
+
+  // the events are still there for the queries, and the events put after the cursor are read next
+  REQUIRE(provdb->query(minifi::provenance::ProvenanceQuery{}).size() == 25);
+  put(5);
+  cursor = read(cursor, 10);
+  REQUIRE(put_ids == read_ids);
+
+  SECTION("the cursor stays valid after a restart") {
+    provdb.reset();
+    provdb = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", temp_dir,
+        MAX_PROVENANCE_ENTRY_LIFE_TIME, TEST_MAX_PROVENANCE_STORAGE_SIZE, 1000);
+    REQUIRE(provdb->initialize(configuration));
+    REQUIRE(cursor == read(cursor, 10));
+    put(3);
+    read(cursor, 10);
+    REQUIRE(put_ids == read_ids);
+  }
+}
+
+TEST_CASE("Test the index entries are dropped along with their events", "[provenanceCursor]") {
+  using minifi::provenance::ProvenanceEventRecord;
+  TestController testController;
+
+  char dirtemplate[] = "/var/tmp/db.XXXXXX";
+  auto temp_dir = testController.createTempDirectory(dirtemplate);
+  REQUIRE(!temp_dir.empty());
+
+  // 100 KB, going to exceed the size limit
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, temp_dir);
+  auto provdb = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", temp_dir,
+      MAX_PROVENANCE_ENTRY_LIFE_TIME, TEST_PROVENANCE_STORAGE_SIZE, 1000);
+  REQUIRE(provdb->initialize(configuration));
+
+  const size_t event_count = 500;
+  for (size_t i = 0; i < event_count; ++i) {
+    ProvenanceEventRecord event(ProvenanceEventRecord::CREATE, "component", "Processor");
+    std::shared_ptr<core::FlowFile> flow_file = std::make_shared<minifi::FlowFileRecord>();
+    flow_file->setAttribute("payload", std::string(10240, 'x'));
+    event.fromFlowFile(flow_file);
+    REQUIRE(event.Serialize(provdb));
+  }
+  // wait for the compaction to settle
+  uint64_t stored_count = provdb->getKeyCount();
+  for (int i = 0; i < 50; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const uint64_t count = provdb->getKeyCount();
+    if (count < event_count && count == stored_count) {
+      break;
+    }
+    stored_count = count;
+  }
+  REQUIRE(stored_count < event_count);
+
+  minifi::provenance::ProvenanceQuery all;
+  all.max_results = event_count;
+  const auto stored = provdb->query(all);
+  REQUIRE(stored_count == stored.size());
+  std::vector<std::string> read_ids;
+  provdb->readEventsFrom(0, event_count, [&read_ids](ProvenanceEventRecord &event) {
+    read_ids.push_back(event.getUUIDStr());
+  });
+  // none of the stored events is skipped by the cursor or missing from the lookup by id
+  REQUIRE(stored.size() == read_ids.size());
+  for (const auto &event : stored) {
+    REQUIRE(std::find(read_ids.begin(), read_ids.end(), event->getUUIDStr()) != read_ids.end());
+    std::string value;
+    REQUIRE(provdb->Get(event->getUUIDStr(), value));
+  }
+}
+
+TEST_CASE("Test the sequence numbers go on once the events have expired", "[provenanceCursor]") {
+  using minifi::provenance::ProvenanceEventRecord;
+  TestController testController;
+
+  char dirtemplate[] = "/var/tmp/db.XXXXXX";
+  auto temp_dir = testController.createTempDirectory(dirtemplate);
+  REQUIRE(!temp_dir.empty());
+
+  auto configuration = std::make_shared<org::apache::nifi::minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_provenance_repository_directory_default, temp_dir);
+  const auto open = [&]() {
+    auto provdb = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", temp_dir,
+        MAX_PROVENANCE_ENTRY_LIFE_TIME, TEST_MAX_PROVENANCE_STORAGE_SIZE, 1000);
+    REQUIRE(provdb->initialize(configuration));
+    return provdb;
+  };
+  const auto put = [](const std::shared_ptr<minifi::provenance::ProvenanceRepository> &provdb) {
+    ProvenanceEventRecord event(ProvenanceEventRecord::CREATE, "component", "Processor");
+    std::shared_ptr<core::FlowFile> flow_file = std::make_shared<minifi::FlowFileRecord>();
+    event.fromFlowFile(flow_file);
+    REQUIRE(event.Serialize(provdb));
+    return event.getUUIDStr();
+  };
+
+  auto provdb = open();
+  put(provdb);
+  put(provdb);
+  const uint64_t cursor = provdb->readEventsFrom(0, 10, [](ProvenanceEventRecord&) {});
+  REQUIRE(2 == cursor);
+  provdb.reset();
+
+  // the events are gone, as if they had expired, the next ones are still read from the cursor
+  {
+    std::vector<rocksdb::ColumnFamilyDescriptor> column_families{
+        rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions()),
+        rocksdb::ColumnFamilyDescriptor("events", rocksdb::ColumnFamilyOptions())};
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+    rocksdb::DB* db;
+    REQUIRE(rocksdb::DB::Open(rocksdb::DBOptions(), temp_dir, column_families, &handles, &db).ok());
+    std::unique_ptr<rocksdb::DB> db_guard(db);
+    REQUIRE(db->DropColumnFamily(handles[1]).ok());
+    for (auto handle : handles) {
+      REQUIRE(db->DestroyColumnFamilyHandle(handle).ok());
+    }
+  }
+  provdb = open();
+  REQUIRE(0 == provdb->getKeyCount());
+  const std::string id = put(provdb);
+  std::vector<std::string> read_ids;
+  const uint64_t next_cursor = provdb->readEventsFrom(cursor, 10, [&read_ids](ProvenanceEventRecord &event) {
+    read_ids.push_back(event.getUUIDStr());
+  });
+  REQUIRE(3 == next_cursor);
+  REQUIRE(std::vector<std::string>{id} == read_ids);
+}
+
+TEST_CASE("Test parsing provenance queries", "[provenanceQuery]") {
+  using minifi::provenance::ProvenanceEventRecord;
+  using minifi::provenance::ProvenanceQuery;
+  const uint64_t now = 100000000;
+
+  const auto query = ProvenanceQuery::parse("component=getfile&type=send&since=1 hour&limit=5", now);
+  REQUIRE(query.component_id);
+  REQUIRE("getfile" == *query.component_id);
+  REQUIRE(query.event_type);
+  REQUIRE(ProvenanceEventRecord::SEND == *query.event_type);
+  REQUIRE(now - 3600 * 1000 == query.start_time);
+  REQUIRE(5 == query.max_results);
+  REQUIRE_FALSE(query.flow_file_uuid);
+
+  REQUIRE_THROWS_AS(ProvenanceQuery::parse("type=teleport", now), std::invalid_argument&);
+  REQUIRE_THROWS_AS(ProvenanceQuery::parse("lineage=true", now), std::invalid_argument&);
+  REQUIRE_THROWS_AS(ProvenanceQuery::parse("flowfile=potato", now), std::invalid_argument&);
+  REQUIRE_THROWS_AS(ProvenanceQuery::parse("owner=me", now), std::invalid_argument&);
+}
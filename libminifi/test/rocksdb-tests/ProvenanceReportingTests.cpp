@@ -0,0 +1,175 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/repository/VolatileContentRepository.h"
+#include "core/reporting/SiteToSiteProvenanceReportingTask.h"
+#include "FlowFileRecord.h"
+#include "ProvenanceRepository.h"
+#include "../unit/ProvenanceTestHelper.h"
+#include "../TestBase.h"
+
+namespace {
+
+using minifi::core::reporting::SiteToSiteProvenanceReportingTask;
+
+// records the reports instead of sending them to a remote port
+class RecordingReportingTask : public SiteToSiteProvenanceReportingTask {
+ public:
+  RecordingReportingTask(const utils::Identifier &uuid, const std::shared_ptr<minifi::Configure> &configuration)
+      : SiteToSiteProvenanceReportingTask(minifi::io::StreamFactory::getInstance(configuration), configuration) {
+    setUUID(uuid);
+  }
+
+  std::vector<std::string> reports;
+  bool fail = false;
+
+ protected:
+  bool transmitReport(const std::shared_ptr<core::ProcessContext>& /*context*/, const std::shared_ptr<core::ProcessSession>& /*session*/, const std::string &report) override {
+    if (fail) {
+      return false;
+    }
+    reports.push_back(report);
+    return true;
+  }
+};
+
+class ProvenanceReportingTestController : public TestController {
+ public:
+  ProvenanceReportingTestController()
+      : configuration_(std::make_shared<minifi::Configure>()),
+        task_uuid_(utils::IdGenerator::getIdGenerator()->generate()) {
+    char state_format[] = "/var/tmp/provreportstate.XXXXXX";
+    state_dir_ = createTempDirectory(state_format);
+    char provenance_format[] = "/var/tmp/provreportrepo.XXXXXX";
+    const std::string provenance_dir = createTempDirectory(provenance_format);
+    provenance_repo_ = std::make_shared<minifi::provenance::ProvenanceRepository>("TestProvRepo", provenance_dir,
+        MAX_PROVENANCE_ENTRY_LIFE_TIME, 100 * 1024 * 1024, 1000);
+    configuration_->set(minifi::Configure::nifi_provenance_repository_directory_default, provenance_dir);
+    REQUIRE(provenance_repo_->initialize(configuration_));
+    restart();
+  }
+
+  // a new plan and task, with the same id and state storage as the previous ones
+  void restart() {
+    // the task keeps the state storage open
+    task.reset();
+    plan_.reset();
+    auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+    content_repo->initialize(configuration_);
+    plan_ = std::make_shared<TestPlan>(content_repo, std::make_shared<TestRepository>(), provenance_repo_,
+        std::make_shared<minifi::state::response::FlowVersion>("test", "test", "test"), configuration_, state_dir_.c_str());
+    task = std::make_shared<RecordingReportingTask>(task_uuid_, configuration_);
+    task->setBatchSize(2);
+    plan_->addProcessor(task, "reporter");
+  }
+
+  std::string putEvent() {
+    provenance::ProvenanceEventRecord event(provenance::ProvenanceEventRecord::CREATE, "component", "Processor");
+    std::shared_ptr<core::FlowFile> flow_file = std::make_shared<minifi::FlowFileRecord>();
+    event.fromFlowFile(flow_file);
+    REQUIRE(event.Serialize(provenance_repo_));
+    return event.getEventId().to_string();
+  }
+
+  void trigger() {
+    plan_->runProcessor(task);
+  }
+
+  std::string getCursor() {
+    core::CoreComponentState state;
+    if (!plan_->getProcessContextForProcessor(task)->getStateManager()->get(state)) {
+      return "";
+    }
+    return state[SiteToSiteProvenanceReportingTask::CURSOR_STATE_KEY];
+  }
+
+  std::shared_ptr<RecordingReportingTask> task;
+
+ private:
+  std::shared_ptr<minifi::Configure> configuration_;
+  utils::Identifier task_uuid_;
+  std::string state_dir_;
+  std::shared_ptr<minifi::provenance::ProvenanceRepository> provenance_repo_;
+  std::shared_ptr<TestPlan> plan_;
+};
+
+bool contains(const std::string &report, const std::string &event_id) {
+  return report.find(event_id) != std::string::npos;
+}
+
+}  // namespace
+
+TEST_CASE("The provenance reporting task reports the events in batches from its cursor", "[provenanceReporting]") {
+  ProvenanceReportingTestController controller;
+  const std::vector<std::string> event_ids{controller.putEvent(), controller.putEvent(), controller.putEvent()};
+
+  controller.trigger();
+  REQUIRE(1 == controller.task->reports.size());
+  REQUIRE(contains(controller.task->reports[0], event_ids[0]));
+  REQUIRE(contains(controller.task->reports[0], event_ids[1]));
+  REQUIRE_FALSE(contains(controller.task->reports[0], event_ids[2]));
+  REQUIRE("2" == controller.getCursor());
+
+  controller.trigger();
+  REQUIRE(2 == controller.task->reports.size());
+  REQUIRE(contains(controller.task->reports[1], event_ids[2]));
+  REQUIRE("3" == controller.getCursor());
+
+  // nothing new to report
+  controller.trigger();
+  REQUIRE(2 == controller.task->reports.size());
+  REQUIRE("3" == controller.getCursor());
+}
+
+TEST_CASE("The provenance reporting task does not move its cursor after a failed transmit", "[provenanceReporting]") {
+  ProvenanceReportingTestController controller;
+  const std::vector<std::string> event_ids{controller.putEvent(), controller.putEvent()};
+
+  controller.task->fail = true;
+  controller.trigger();
+  REQUIRE(controller.task->reports.empty());
+  REQUIRE(controller.getCursor().empty());
+
+  controller.task->fail = false;
+  controller.trigger();
+  REQUIRE(1 == controller.task->reports.size());
+  REQUIRE(contains(controller.task->reports[0], event_ids[0]));
+  REQUIRE(contains(controller.task->reports[0], event_ids[1]));
+  REQUIRE("2" == controller.getCursor());
+}
+
+TEST_CASE("The provenance reporting task continues from its stored cursor after a restart", "[provenanceReporting]") {
+  ProvenanceReportingTestController controller;
+  const std::vector<std::string> event_ids{controller.putEvent(), controller.putEvent(), controller.putEvent()};
+
+  controller.trigger();
+  REQUIRE(1 == controller.task->reports.size());
+
+  controller.restart();
+  REQUIRE(controller.task->reports.empty());
+  controller.trigger();
+  REQUIRE(1 == controller.task->reports.size());
+  REQUIRE_FALSE(contains(controller.task->reports[0], event_ids[0]));
+  REQUIRE_FALSE(contains(controller.task->reports[0], event_ids[1]));
+  REQUIRE(contains(controller.task->reports[0], event_ids[2]));
+  REQUIRE("3" == controller.getCursor());
+}
@@ -156,3 +156,111 @@ TEST_CASE("Test Provenance record serialization NoOp", "[Testprovenance::Provena
   record2.setEventId(eventId);
   REQUIRE(record2.DeSerialize(testRepository) == false);
 }
+
+TEST_CASE("Test the events captured by the provenance reporter", "[provenanceReporter]") {
+  using provenance::ProvenanceEventRecord;
+  auto repository = std::make_shared<TestRepository>();
+  auto parent = std::make_shared<minifi::FlowFileRecord>();
+  auto child = std::make_shared<minifi::FlowFileRecord>();
+  parent->setAttribute("potato", "potatoe");
+
+  const auto read = [&repository](const utils::Identifier &event_id) {
+    ProvenanceEventRecord event;
+    event.setEventId(event_id);
+    REQUIRE(event.DeSerialize(repository));
+    return event.getDetails();
+  };
+
+  SECTION("the events are serialized like the records they stand for") {
+    provenance::ProvenanceReporter reporter(repository, "proc", "type");
+    reporter.create(parent);
+    parent->setAttribute("tomato", "tomatoe");
+    reporter.modifyAttribute(parent, "tomato", "tomatoe");
+    parent->setSize(10);
+    reporter.clone(parent, child);
+    // after the last event, none of them sees it
+    parent->setAttribute("later", "on");
+    reporter.commit();
+    REQUIRE(3 == repository->getRepoMap().size());
+
+    for (const auto &expected : reporter.getEvents()) {
+      ProvenanceEventRecord event;
+      event.setEventId(expected->getEventId());
+      REQUIRE(event.DeSerialize(repository));
+      REQUIRE(expected->getEventType() == event.getEventType());
+      REQUIRE(expected->getEventTime() == event.getEventTime());
+      REQUIRE(expected->getDetails() == event.getDetails());
+      REQUIRE(parent->getUUID() == event.getFlowFileUuid());
+      REQUIRE(expected->getAttributes() == event.getAttributes());
+      REQUIRE(expected->getFileSize() == event.getFileSize());
+      REQUIRE(expected->getChildrenUuids() == event.getChildrenUuids());
+      REQUIRE(expected->getParentUuids() == event.getParentUuids());
+      // each event records the FlowFile as it was when the event happened
+      if (event.getEventType() == ProvenanceEventRecord::CREATE) {
+        REQUIRE(event.getDetails() == "proc creates flow record " + std::string(parent->getUUIDStr()));
+        REQUIRE((std::map<std::string, std::string>{{"potato", "potatoe"}}) == event.getAttributes());
+        REQUIRE(0 == event.getFileSize());
+      } else if (event.getEventType() == ProvenanceEventRecord::ATTRIBUTES_MODIFIED) {
+        REQUIRE(event.getDetails() == "proc modify flow record " + std::string(parent->getUUIDStr()) + " attribute tomato:tomatoe");
+        REQUIRE((std::map<std::string, std::string>{{"potato", "potatoe"}, {"tomato", "tomatoe"}}) == event.getAttributes());
+        REQUIRE(0 == event.getFileSize());
+      } else {
+        REQUIRE(ProvenanceEventRecord::CLONE == event.getEventType());
+        REQUIRE(std::vector<utils::Identifier>{child->getUUID()} == event.getChildrenUuids());
+        REQUIRE((std::map<std::string, std::string>{{"potato", "potatoe"}, {"tomato", "tomatoe"}}) == event.getAttributes());
+        REQUIRE(10 == event.getFileSize());
+      }
+    }
+
+    // only the events captured since are committed again
+    reporter.drop(child);
+    reporter.commit();
+    REQUIRE(4 == repository->getRepoMap().size());
+  }
+  SECTION("the events captured since the last commit are rolled back") {
+    provenance::ProvenanceReporter reporter(repository, "proc", "type");
+    reporter.create(parent);
+    reporter.commit();
+    reporter.modifyContent(parent, 10);
+    reporter.rollback();
+    reporter.commit();
+    REQUIRE(1 == repository->getRepoMap().size());
+    REQUIRE(1 == reporter.getEvents().size());
+  }
+  SECTION("summary granularity folds the modifications of a FlowFile") {
+    provenance::ProvenanceReporter reporter(repository, "proc", "type", provenance::ProvenanceGranularity::SUMMARY);
+    reporter.modifyAttribute(parent, "tomato", "tomatoe");
+    reporter.removeAttribute(parent, "potato");
+    reporter.modifyContent(parent, 10);
+    reporter.modifyContent(parent, 5);
+    reporter.modifyContent(child, 1);
+    const auto events = reporter.getEvents();
+    REQUIRE(3 == events.size());
+    for (const auto &event : events) {
+      if (event->getEventType() == ProvenanceEventRecord::ATTRIBUTES_MODIFIED) {
+        REQUIRE(event->getDetails() == "proc remove flow record " + std::string(parent->getUUIDStr()) + " attribute potato");
+      } else if (event->getFlowFileUuid() == parent->getUUID()) {
+        REQUIRE(15 == event->getEventDuration());
+      }
+    }
+    reporter.commit();
+    for (const auto &event : events) {
+      REQUIRE(event->getDetails() == read(event->getEventId()));
+    }
+  }
+  SECTION("no granularity captures nothing") {
+    provenance::ProvenanceReporter reporter(repository, "proc", "type", provenance::ProvenanceGranularity::NONE);
+    reporter.create(parent);
+    reporter.receive(parent, "nifi://localhost", "source", "received", 1);
+    reporter.commit();
+    REQUIRE(reporter.getEvents().empty());
+    REQUIRE(repository->getRepoMap().empty());
+  }
+}
+
+TEST_CASE("Test parsing the provenance granularity", "[provenanceReporter]") {
+  REQUIRE(provenance::ProvenanceGranularity::NONE == provenance::parseProvenanceGranularity("none"));
+  REQUIRE(provenance::ProvenanceGranularity::SUMMARY == provenance::parseProvenanceGranularity(" Summary"));
+  REQUIRE(provenance::ProvenanceGranularity::FULL == provenance::parseProvenanceGranularity("FULL"));
+  REQUIRE_THROWS_AS(provenance::parseProvenanceGranularity("some"), std::invalid_argument&);
+}
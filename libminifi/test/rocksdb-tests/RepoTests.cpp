@@ -19,11 +19,15 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "core/Core.h"
 #include "core/repository/AtomicRepoEntries.h"
+#include "core/repository/TieredContentRepository.h"
 #include "core/RepositoryFactory.h"
 #include "FlowFileRecord.h"
 #include "FlowFileRepository.h"
@@ -197,6 +201,42 @@ TEST_CASE("Test Delete Content ", "[TestFFR4]") {
   LogTestController::getInstance().reset();
 }
 
+TEST_CASE("Deleting a flowfile stored without its content claim registered reads the claim back", "[TestFFR4]") {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto repository = std::make_shared<core::repository::FlowFileRepository>("ff", REPOTEST_FLOWFILE_CHECKPOINT_DIR, dir, 0, 0, 1);
+  std::shared_ptr<core::ContentRepository> content_repo = std::make_shared<core::repository::FileSystemRepository>();
+  repository->initialize(std::make_shared<minifi::Configure>());
+  repository->loadComponent(content_repo);
+
+  const std::string content_path = utils::file::FileUtils::concat_path(dir, "tstFile.ext");
+  std::ofstream{content_path} << "tempFile";
+
+  {
+    auto claim = std::make_shared<minifi::ResourceClaim>(content_path, content_repo);
+    minifi::FlowFileRecord record;
+    record.setResourceClaim(claim);
+    record.addAttribute("keyA", "valueA");
+
+    // store the record the way a previous version of the repository did, bypassing the claim registration of Persist
+    minifi::io::BufferStream stream;
+    REQUIRE(record.Serialize(stream));
+    REQUIRE(repository->Put(record.getUUIDStr(), stream.getBuffer(), stream.size()));
+    claim->increaseFlowFileRecordOwnedCount();
+
+    REQUIRE(repository->Delete(record.getUUIDStr()));
+    claim->decreaseFlowFileRecordOwnedCount();
+    repository->flush();
+    repository->stop();
+  }
+
+  REQUIRE_FALSE(std::ifstream{content_path}.good());
+
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+}
+
 TEST_CASE("Test Validate Checkpoint ", "[TestFFR5]") {
   TestController testController;
   utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
@@ -430,4 +470,303 @@ TEST_CASE("Flush deleted flowfiles before shutdown", "[TestFFR7]") {
   }
 }
 
+TEST_CASE("Stored flowfiles are recovered by multiple threads", "[TestFFR8]") {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_flowfile_repository_directory_default, utils::file::FileUtils::concat_path(dir, "flowfile_repository"));
+  config->set(minifi::Configure::nifi_flowfile_repository_recovery_threads, "4");
+
+  auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  auto connection = std::make_shared<minifi::Connection>(nullptr, nullptr, "Connection");
+  auto other_connection = std::make_shared<minifi::Connection>(nullptr, nullptr, "OtherConnection");
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap{{connection->getUUIDStr(), connection}, {other_connection->getUUIDStr(), other_connection}};
+
+  {
+    auto ff_repository = std::make_shared<core::repository::FlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+    REQUIRE(ff_repository->initialize(config));
+    ff_repository->loadComponent(content_repo);
+    for (int keyIdx = 0; keyIdx < 1000; ++keyIdx) {
+      auto file = std::make_shared<minifi::FlowFileRecord>();
+      file->setConnection(keyIdx % 4 == 0 ? other_connection : connection);
+      REQUIRE(file->Persist(ff_repository));
+    }
+  }
+
+  auto ff_repository = std::make_shared<core::repository::FlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+  ff_repository->setConnectionMap(connectionMap);
+  REQUIRE(ff_repository->initialize(config));
+  ff_repository->loadComponent(content_repo);
+  ff_repository->start();
+
+  using org::apache::nifi::minifi::utils::verifyEventHappenedInPollTime;
+  const bool restored = verifyEventHappenedInPollTime(std::chrono::seconds(5), [&] { return connection->getQueueSize() == 750 && other_connection->getQueueSize() == 250; },
+      std::chrono::milliseconds(20));
+  REQUIRE(restored);
+  const bool finished = verifyEventHappenedInPollTime(std::chrono::seconds(1), [&] { return !ff_repository->isRecovering(); }, std::chrono::milliseconds(20));
+  REQUIRE(finished);
+  REQUIRE(1000 == ff_repository->getRecoveredCount());
+  ff_repository->stop();
+
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+}
+
+TEST_CASE("Concurrent single flowfile sessions are committed in groups", "[TestFFR9]") {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_flowfile_repository_directory_default, utils::file::FileUtils::concat_path(dir, "flowfile_repository"));
+  config->set(minifi::Configure::nifi_flowfile_repository_group_commit_window, "2 ms");
+
+  auto ff_repository = std::make_shared<core::repository::FlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+  REQUIRE(ff_repository->initialize(config));
+  ff_repository->loadComponent(std::make_shared<core::repository::VolatileContentRepository>());
+
+  constexpr int THREAD_COUNT = 32;
+  constexpr int SESSIONS_PER_THREAD = 50;
+  std::vector<std::vector<std::string>> keys(THREAD_COUNT);
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int threadIdx = 0; threadIdx < THREAD_COUNT; ++threadIdx) {
+    threads.emplace_back([&, threadIdx] {
+      for (int sessionIdx = 0; sessionIdx < SESSIONS_PER_THREAD; ++sessionIdx) {
+        minifi::FlowFileRecord record;
+        record.addAttribute("session", std::to_string(sessionIdx));
+        std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>> data;
+        data.emplace_back(record.getUUIDStr(), utils::make_unique<minifi::io::BufferStream>());
+        record.Serialize(*data.back().second);
+        if (!ff_repository->MultiPut(data)) {
+          ++failures;
+        }
+        keys[threadIdx].push_back(record.getUUIDStr());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(0 == failures);
+  for (const auto& thread_keys : keys) {
+    for (const auto& key : thread_keys) {
+      std::string value;
+      REQUIRE(ff_repository->Get(key, value));
+    }
+  }
+
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+}
+
+// the sessions of a single flowfile committed per second by 32 threads
+double measureSingleFlowFileSessionsPerSecond(const std::string& group_commit_window) {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_flowfile_repository_directory_default, utils::file::FileUtils::concat_path(dir, "flowfile_repository"));
+  config->set(minifi::Configure::nifi_flowfile_repository_group_commit_window, group_commit_window);
+
+  auto ff_repository = std::make_shared<core::repository::FlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+  REQUIRE(ff_repository->initialize(config));
+  ff_repository->loadComponent(std::make_shared<core::repository::VolatileContentRepository>());
+
+  constexpr int THREAD_COUNT = 32;
+  constexpr int SESSIONS_PER_THREAD = 500;
+  std::atomic<int> failures{0};
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int threadIdx = 0; threadIdx < THREAD_COUNT; ++threadIdx) {
+    threads.emplace_back([&] {
+      for (int sessionIdx = 0; sessionIdx < SESSIONS_PER_THREAD; ++sessionIdx) {
+        minifi::FlowFileRecord record;
+        std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>> data;
+        data.emplace_back(record.getUUIDStr(), utils::make_unique<minifi::io::BufferStream>());
+        record.Serialize(*data.back().second);
+        if (!ff_repository->MultiPut(data)) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(0 == failures);
+
+  ff_repository.reset();
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+  return THREAD_COUNT * SESSIONS_PER_THREAD / elapsed.count();
+}
+
+TEST_CASE("Throughput of concurrent single flowfile sessions with and without a group commit window", "[.][benchmark]") {
+  const double without_window = measureSingleFlowFileSessionsPerSecond("0 ms");
+  const double with_window = measureSingleFlowFileSessionsPerSecond("2 ms");
+
+  // a session waits for one window at most, which lets 32 threads commit 16 sessions per millisecond, half of that is left for the writes
+  REQUIRE(with_window >= 32 / 0.002 / 2);
+  // the writes saved by the grouping make up for most of the time spent waiting
+  REQUIRE(with_window >= without_window / 2);
+}
+
+class FailingWriterFlowFileRepository : public core::repository::FlowFileRepository {
+ public:
+  FailingWriterFlowFileRepository(const std::string& name, const std::string& checkpoint_dir)
+      : core::SerializableComponent(name),
+        FlowFileRepository(name, checkpoint_dir) {
+  }
+
+  // adds an operation to the batch, then fails
+  bool commitFailingWrite(const std::string& key) {
+    return commit([&key](rocksdb::WriteBatch& batch) {
+      batch.Put(key, "partial");
+      return false;
+    });
+  }
+};
+
+TEST_CASE("A writer failing to append to the group commit fails alone", "[TestFFR10]") {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_flowfile_repository_directory_default, utils::file::FileUtils::concat_path(dir, "flowfile_repository"));
+  config->set(minifi::Configure::nifi_flowfile_repository_group_commit_window, "50 ms");
+
+  auto ff_repository = std::make_shared<FailingWriterFlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+  REQUIRE(ff_repository->initialize(config));
+
+  constexpr int THREAD_COUNT = 8;
+  std::vector<int> results(THREAD_COUNT);
+  std::vector<std::thread> threads;
+  for (int threadIdx = 0; threadIdx < THREAD_COUNT; ++threadIdx) {
+    threads.emplace_back([&, threadIdx] {
+      const std::string key = "key" + std::to_string(threadIdx);
+      // every other writer fails, the others are likely to share a batch with one of them
+      if (threadIdx % 2 == 0) {
+        results[threadIdx] = ff_repository->commitFailingWrite(key);
+      } else {
+        results[threadIdx] = ff_repository->Put(key, reinterpret_cast<const uint8_t*>("value"), 5);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int threadIdx = 0; threadIdx < THREAD_COUNT; ++threadIdx) {
+    const bool failing = threadIdx % 2 == 0;
+    REQUIRE(results[threadIdx] == (failing ? 0 : 1));
+    std::string value;
+    REQUIRE(ff_repository->Get("key" + std::to_string(threadIdx), value) == !failing);
+  }
+
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+}
+
+// tells whether the content was on disk whenever the records were stored
+class ContentCheckingFlowFileRepository : public core::repository::FlowFileRepository {
+ public:
+  ContentCheckingFlowFileRepository(const std::string& name, const std::string& checkpoint_dir)
+      : core::SerializableComponent(name),
+        FlowFileRepository(name, checkpoint_dir) {
+  }
+
+  bool MultiPut(const std::vector<std::pair<std::string, std::unique_ptr<minifi::io::BufferStream>>>& data) override {
+    ++put_count;
+    for (const auto& path : content_paths) {
+      content_on_disk = content_on_disk && utils::file::FileUtils::exists(path);
+    }
+    return FlowFileRepository::MultiPut(data);
+  }
+
+  std::vector<std::string> content_paths;
+  int put_count = 0;
+  bool content_on_disk = true;
+};
+
+TEST_CASE("The content kept in memory is made durable before the flowfiles referencing it are stored", "[TestFFR11]") {
+  TestController testController;
+  char format[] = "/var/tmp/testRepo.XXXXXX";
+  auto dir = testController.createTempDirectory(format);
+
+  auto config = std::make_shared<minifi::Configure>();
+  config->set(minifi::Configure::nifi_dbcontent_repository_directory_default, utils::file::FileUtils::concat_path(dir, "content_repository"));
+  config->set(minifi::Configure::nifi_flowfile_repository_directory_default, utils::file::FileUtils::concat_path(dir, "flowfile_repository"));
+  // only the session spills the content to the backend
+  config->set(minifi::Configure::nifi_content_repository_tiered_memory_max_size, "1 MB");
+  config->set(minifi::Configure::nifi_content_repository_tiered_claim_max_size, "1 KB");
+  config->set(minifi::Configure::nifi_content_repository_tiered_spill_age, "0 ms");
+
+  core::Relationship inputRel{"Input", "dummy"};
+  utils::Identifier input_uuid;
+  {
+    auto content_repo = std::make_shared<core::repository::TieredContentRepository>();
+    REQUIRE(content_repo->initialize(config));
+    auto ff_repository = std::make_shared<ContentCheckingFlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+    REQUIRE(ff_repository->initialize(config));
+    ff_repository->loadComponent(content_repo);
+
+    auto input = std::make_shared<minifi::Connection>(ff_repository, content_repo, "Input");
+    input->setRelationship(inputRel);
+    input_uuid = input->getUUID();
+    auto processor = std::make_shared<core::Processor>("dummy");
+    input->setSourceUUID(processor->getUUID());
+    processor->addConnection(input);
+    auto node = std::make_shared<core::ProcessorNode>(processor);
+    auto context = std::make_shared<core::ProcessContext>(node, nullptr, std::make_shared<TestRepository>(), ff_repository, content_repo);
+
+    core::ProcessSession session(context);
+    auto flow = session.create();
+    std::string data = "banana";
+    minifi::io::BufferStream content(reinterpret_cast<const uint8_t*>(data.c_str()), gsl::narrow<int>(data.length()));
+    session.importFrom(content, flow);
+    session.transfer(flow, inputRel);
+    REQUIRE(flow->getResourceClaim());
+    const std::string content_path = flow->getResourceClaim()->getContentFullPath();
+    REQUIRE_FALSE(utils::file::FileUtils::exists(content_path));
+    ff_repository->content_paths.push_back(content_path);
+
+    session.commit();
+    REQUIRE(ff_repository->put_count > 0);
+    REQUIRE(ff_repository->content_on_disk);
+    REQUIRE(1 == content_repo->getSpilledCount());
+  }
+
+  // the repositories of the restarted agent know nothing of the content kept in memory before
+  auto content_repo = std::make_shared<core::repository::TieredContentRepository>();
+  REQUIRE(content_repo->initialize(config));
+  auto input = std::make_shared<minifi::Connection>(nullptr, nullptr, "Input", input_uuid);
+  auto ff_repository = std::make_shared<core::repository::FlowFileRepository>("flowFileRepository", REPOTEST_FLOWFILE_CHECKPOINT_DIR);
+  std::map<std::string, std::shared_ptr<core::Connectable>> connectionMap{{input->getUUIDStr(), input}};
+  ff_repository->setConnectionMap(connectionMap);
+  REQUIRE(ff_repository->initialize(config));
+  ff_repository->loadComponent(content_repo);
+  ff_repository->start();
+
+  std::set<std::shared_ptr<core::FlowFile>> expired;
+  std::shared_ptr<core::FlowFile> restored;
+  using org::apache::nifi::minifi::utils::verifyEventHappenedInPollTime;
+  const bool restarted = verifyEventHappenedInPollTime(std::chrono::seconds(5), [&] {
+    restored = input->poll(expired);
+    return restored != nullptr;
+  }, std::chrono::milliseconds(20));
+  REQUIRE(restarted);
+  REQUIRE(restored->getResourceClaim());
+  auto stream = content_repo->read(*restored->getResourceClaim());
+  REQUIRE(stream);
+  stream->seek(restored->getOffset());
+  std::string read(restored->getSize(), '\0');
+  REQUIRE(stream->read(reinterpret_cast<uint8_t*>(&read[0]), gsl::narrow<int>(read.size())) == gsl::narrow<int>(read.size()));
+  REQUIRE("banana" == read);
+  ff_repository->stop();
+
+  utils::file::FileUtils::delete_dir(REPOTEST_FLOWFILE_CHECKPOINT_DIR, true);
+}
+
 }  // namespace
@@ -18,9 +18,11 @@
 #include <memory>
 
 #include "../../include/core/state/nodes/ProcessMetrics.h"
+#include "../../include/core/state/nodes/ProcessorProfileMetrics.h"
 #include "../../include/core/state/nodes/QueueMetrics.h"
 #include "../../include/core/state/nodes/RepositoryMetrics.h"
 #include "../../include/core/state/nodes/SystemMetrics.h"
+#include "../../include/core/state/nodes/ThreadPoolMetrics.h"
 #include "../TestBase.h"
 #include "io/ClientSocket.h"
 #include "core/Processor.h"
@@ -229,3 +231,77 @@ TEST_CASE("RepositorymetricsHaveRepo", "[c2m4]") {
     REQUIRE("0" == size.value);
   }
 }
+
+TEST_CASE("ThreadPoolMetricsTest", "[c2m6]") {
+  minifi::state::response::ThreadPoolMetrics metrics;
+
+  REQUIRE("ThreadPoolMetrics" == metrics.getName());
+  REQUIRE(0 == metrics.serialize().size());
+
+  utils::ThreadPool<utils::TaskRescheduleInfo> io_pool(4, false, nullptr, "io");
+  utils::ThreadPool<utils::TaskRescheduleInfo> cpu_pool(2, false, nullptr, "cpu");
+  metrics.setThreadPools({&io_pool, &cpu_pool});
+
+  const auto serialized = metrics.serialize();
+  REQUIRE(2 == serialized.size());
+
+  const auto& io = serialized.at(0);
+  REQUIRE("io" == io.name);
+  REQUIRE(4 == io.children.size());
+  REQUIRE("maxthreads" == io.children.at(0).name);
+  REQUIRE("4" == io.children.at(0).value.to_string());
+  REQUIRE("runningthreads" == io.children.at(1).name);
+  REQUIRE("0" == io.children.at(1).value.to_string());
+  REQUIRE("queuedtasks" == io.children.at(2).name);
+  REQUIRE("0" == io.children.at(2).value.to_string());
+  REQUIRE("delayedtasks" == io.children.at(3).name);
+  REQUIRE("0" == io.children.at(3).value.to_string());
+
+  REQUIRE("cpu" == serialized.at(1).name);
+  REQUIRE("2" == serialized.at(1).children.at(0).value.to_string());
+}
+
+TEST_CASE("ProcessorProfileMetricsTest", "[c2m7]") {
+  minifi::state::response::ProcessorProfileMetrics metrics;
+
+  REQUIRE("ProcessorProfileMetrics" == metrics.getName());
+  REQUIRE(0 == metrics.serialize().size());
+
+  const auto processor = std::make_shared<core::Processor>("profiled");
+  processor->getProfile().recordTrigger(std::chrono::microseconds(10), std::chrono::microseconds(4));
+  processor->getProfile().recordTrigger(std::chrono::microseconds(30), std::chrono::microseconds(6));
+  processor->getProfile().recordCommit(std::chrono::microseconds(5), 2, 100, 3, 150);
+  processor->setConcurrentTasks(3);
+  metrics.setProcessors({processor});
+
+  const auto serialized = metrics.serialize();
+  REQUIRE(1 == serialized.size());
+  const auto& profile = serialized.at(0);
+  REQUIRE("profiled" == profile.name);
+  REQUIRE(9 == profile.children.size());
+  REQUIRE("uuid" == profile.children.at(0).name);
+
+  const auto& trigger_latency = profile.children.at(1);
+  REQUIRE("triggerlatency" == trigger_latency.name);
+  REQUIRE("count" == trigger_latency.children.at(0).name);
+  REQUIRE("2" == trigger_latency.children.at(0).value.to_string());
+  REQUIRE("total" == trigger_latency.children.at(1).name);
+  REQUIRE("40000" == trigger_latency.children.at(1).value.to_string());
+  REQUIRE("max" == trigger_latency.children.at(6).name);
+  REQUIRE("30000" == trigger_latency.children.at(6).value.to_string());
+
+  REQUIRE("cputime" == profile.children.at(2).name);
+  REQUIRE("10000" == profile.children.at(2).children.at(1).value.to_string());
+  REQUIRE("commitlatency" == profile.children.at(3).name);
+  REQUIRE("1" == profile.children.at(3).children.at(0).value.to_string());
+  REQUIRE("flowfilesin" == profile.children.at(4).name);
+  REQUIRE("2" == profile.children.at(4).value.to_string());
+  REQUIRE("bytesin" == profile.children.at(5).name);
+  REQUIRE("100" == profile.children.at(5).value.to_string());
+  REQUIRE("flowfilesout" == profile.children.at(6).name);
+  REQUIRE("3" == profile.children.at(6).value.to_string());
+  REQUIRE("bytesout" == profile.children.at(7).name);
+  REQUIRE("150" == profile.children.at(7).value.to_string());
+  REQUIRE("concurrenttasks" == profile.children.at(8).name);
+  REQUIRE("3" == profile.children.at(8).value.to_string());
+}
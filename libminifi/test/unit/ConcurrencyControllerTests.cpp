@@ -0,0 +1,73 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <memory>
+
+#include "../TestBase.h"
+#include "ConcurrencyController.h"
+#include "properties/Configure.h"
+
+namespace minifi = org::apache::nifi::minifi;
+
+namespace {
+minifi::ConcurrencyController::Sample makeSample(double fill_ratio, uint64_t queue_size, std::chrono::nanoseconds latency, double cpu_utilization = 0.0) {
+  minifi::ConcurrencyController::Sample sample;
+  sample.queue.fill_ratio = fill_ratio;
+  sample.queue.size = queue_size;
+  sample.trigger_latency = latency;
+  sample.cpu_utilization = cpu_utilization;
+  return sample;
+}
+}  // namespace
+
+TEST_CASE("ConcurrencyController grows the concurrency of processors with a filling queue", "[concurrency.grow]") {
+  const auto configuration = std::make_shared<minifi::Configure>();
+  minifi::ConcurrencyController controller(configuration);
+  REQUIRE(controller.getPeriod() == minifi::ConcurrencyController::DEFAULT_PERIOD);
+
+  // the queue is above the high watermark
+  REQUIRE(controller.decide(2, 1, 8, makeSample(0.6, 6000, std::chrono::microseconds(1))) == 3);
+  // the queue is short, but the backlog would take 2 seconds to process
+  REQUIRE(controller.decide(2, 1, 8, makeSample(0.2, 200, std::chrono::milliseconds(20))) == 3);
+  // never above the maximum
+  REQUIRE(controller.decide(8, 1, 8, makeSample(0.9, 9000, std::chrono::milliseconds(1))) == 8);
+}
+
+TEST_CASE("ConcurrencyController shrinks the concurrency of idle processors", "[concurrency.shrink]") {
+  const auto configuration = std::make_shared<minifi::Configure>();
+  minifi::ConcurrencyController controller(configuration);
+
+  REQUIRE(controller.decide(4, 1, 8, makeSample(0.0, 0, std::chrono::nanoseconds(0))) == 3);
+  REQUIRE(controller.decide(4, 1, 8, makeSample(0.05, 50, std::chrono::microseconds(100))) == 3);
+  // never below the minimum
+  REQUIRE(controller.decide(2, 2, 8, makeSample(0.0, 0, std::chrono::nanoseconds(0))) == 2);
+  // between the watermarks the concurrency is kept
+  REQUIRE(controller.decide(4, 1, 8, makeSample(0.3, 300, std::chrono::microseconds(100))) == 4);
+}
+
+TEST_CASE("ConcurrencyController backs off while the CPU is saturated", "[concurrency.cpu]") {
+  const auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(minifi::Configure::nifi_flow_engine_adaptive_concurrency_period, "500 ms");
+  configuration->set(minifi::Configure::nifi_flow_engine_adaptive_concurrency_max_cpu, "50");
+  minifi::ConcurrencyController controller(configuration);
+  REQUIRE(controller.getPeriod() == std::chrono::milliseconds(500));
+
+  REQUIRE(controller.decide(4, 1, 8, makeSample(0.9, 9000, std::chrono::milliseconds(1), 0.6)) == 3);
+  REQUIRE(controller.decide(4, 1, 8, makeSample(0.9, 9000, std::chrono::milliseconds(1), 0.4)) == 5);
+}
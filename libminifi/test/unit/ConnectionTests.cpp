@@ -14,6 +14,13 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include "Connection.h"
 
 #include "../TestBase.h"
@@ -82,3 +89,401 @@ TEST_CASE("Connection::poll() works correctly", "[poll]") {
     REQUIRE(nullptr == connection->poll(expired_flow_files));
   }
 }
+
+TEST_CASE("Connection::pollBatch() works correctly", "[pollBatch]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+  std::vector<std::shared_ptr<core::FlowFile>> flow_files;
+
+  std::vector<std::shared_ptr<core::FlowFile>> queued_flow_files;
+  for (int i = 0; i < 5; ++i) {
+    const auto flow_file = std::make_shared<core::FlowFile>();
+    flow_file->setSize(10);
+    connection->put(flow_file);
+    queued_flow_files.push_back(flow_file);
+  }
+  const auto penalized_flow_file = std::make_shared<core::FlowFile>();
+  penalized_flow_file->penalize(std::chrono::seconds{10});
+  connection->put(penalized_flow_file);
+
+  SECTION("pollBatch() stops at the requested number of flow files") {
+    REQUIRE(3 == connection->pollBatch(flow_files, 3, std::numeric_limits<uint64_t>::max(), expired_flow_files));
+    REQUIRE(3 == connection->getQueueSize());
+    REQUIRE(30 == connection->getQueueDataSize());
+  }
+
+  SECTION("pollBatch() stops once the size of the flow files reaches the requested size") {
+    REQUIRE(2 == connection->pollBatch(flow_files, 10, 15, expired_flow_files));
+    REQUIRE(2 == flow_files.size());
+  }
+
+  SECTION("pollBatch() does not return penalized flow files") {
+    REQUIRE(5 == connection->pollBatch(flow_files, 10, std::numeric_limits<uint64_t>::max(), expired_flow_files));
+    REQUIRE(std::set<std::shared_ptr<core::FlowFile>>(queued_flow_files.begin(), queued_flow_files.end()) == std::set<std::shared_ptr<core::FlowFile>>(flow_files.begin(), flow_files.end()));
+    REQUIRE(0 == connection->pollBatch(flow_files, 10, std::numeric_limits<uint64_t>::max(), expired_flow_files));
+    REQUIRE(1 == connection->getQueueSize());
+  }
+
+  REQUIRE(expired_flow_files.empty());
+}
+
+TEST_CASE("Connection swaps out the flow files queued beyond the swap threshold", "[swap]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  connection->setSwapThreshold(2);
+  std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+
+  std::set<std::string> queued_uuids;
+  for (int i = 0; i < 5; ++i) {
+    const auto flow_file = std::make_shared<minifi::FlowFileRecord>();
+    flow_file->setSize(10);
+    flow_file->setAttribute("index", std::to_string(i));
+    REQUIRE(flow_file->Persist(flow_repo));
+    flow_file->setStoredToRepository(true);
+    connection->put(flow_file);
+    queued_uuids.insert(flow_file->getUUIDStr());
+  }
+  const auto not_persisted_flow_file = std::make_shared<minifi::FlowFileRecord>();
+  connection->put(not_persisted_flow_file);
+  queued_uuids.insert(not_persisted_flow_file->getUUIDStr());
+
+  REQUIRE(6 == connection->getQueueSize());
+  REQUIRE(3 == connection->getSwappedQueueSize());
+  REQUIRE(50 == connection->getQueueDataSize());
+
+  std::set<std::string> polled_uuids;
+  while (const auto flow_file = connection->poll(expired_flow_files)) {
+    polled_uuids.insert(flow_file->getUUIDStr());
+    if (flow_file != not_persisted_flow_file) {
+      REQUIRE(flow_file->getAttribute("index"));
+      REQUIRE(10 == flow_file->getSize());
+      REQUIRE(flow_file->isStored());
+    }
+  }
+  REQUIRE(queued_uuids == polled_uuids);
+  REQUIRE(connection->isEmpty());
+  REQUIRE(0 == connection->getQueueDataSize());
+}
+
+TEST_CASE("Connection orders the swapped in flow files by its prioritizers", "[swap]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  connection->setSwapThreshold(2);
+  connection->setPrioritizers({std::make_shared<core::LargestFlowFileFirstPrioritizer>()});
+  std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+
+  for (uint64_t size = 1; size <= 4; ++size) {
+    const auto flow_file = std::make_shared<minifi::FlowFileRecord>();
+    flow_file->setSize(size);
+    REQUIRE(flow_file->Persist(flow_repo));
+    flow_file->setStoredToRepository(true);
+    connection->put(flow_file);
+  }
+  REQUIRE(2 == connection->getSwappedQueueSize());
+
+  std::vector<uint64_t> polled_sizes;
+  std::vector<std::shared_ptr<core::FlowFile>> flow_files;
+  while (connection->pollBatch(flow_files, 1, std::numeric_limits<uint64_t>::max(), expired_flow_files) > 0) {
+    polled_sizes.push_back(flow_files.back()->getSize());
+  }
+  // the prioritizers order the flow files in memory, the swapped out ones once swapped in
+  REQUIRE((std::vector<uint64_t>{2, 1, 4, 3} == polled_sizes));
+}
+
+TEST_CASE("Connection drains the swapped out flow files without swapping them in", "[swap]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  connection->setSwapThreshold(2);
+
+  std::vector<std::string> uuids;
+  for (int i = 0; i < 5; ++i) {
+    const auto flow_file = std::make_shared<minifi::FlowFileRecord>();
+    flow_file->setSize(10);
+    REQUIRE(flow_file->Persist(flow_repo));
+    flow_file->setStoredToRepository(true);
+    connection->put(flow_file);
+    uuids.push_back(flow_file->getUUIDStr());
+  }
+  REQUIRE(3 == connection->getSwappedQueueSize());
+
+  connection->drain(true);
+  REQUIRE(connection->isEmpty());
+  REQUIRE(0 == connection->getQueueDataSize());
+  REQUIRE(0 == connection->getSwappedQueueSize());
+  for (const auto& uuid : uuids) {
+    std::string value;
+    REQUIRE_FALSE(flow_repo->Get(uuid, value));
+  }
+}
+
+namespace {
+// The source of a connection, throttled while the connection is full
+class ThrottledSource : public core::Connectable {
+ public:
+  ThrottledSource() : core::Connectable("throttled_source") {}
+
+  void setConnection(std::shared_ptr<minifi::Connection> connection) {
+    connection_ = std::move(connection);
+  }
+  void yield() override {}
+  bool isRunning() override { return true; }
+  bool isWorkAvailable() override { return false; }
+  bool isThrottledByBackpressure() const override {
+    return connection_->isFull();
+  }
+
+ private:
+  std::shared_ptr<minifi::Connection> connection_;
+};
+}  // namespace
+
+TEST_CASE("Connection wakes up its source parked on back pressure once it drained below the resume threshold", "[backpressure]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  connection->setMaxQueueSize(10);
+  const auto source = std::make_shared<ThrottledSource>();
+  source->setConnection(connection);
+  connection->setSource(source);
+  int wake_ups = 0;
+  source->setWakeUpCallback([&wake_ups] { ++wake_ups; });
+  std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+
+  for (int i = 0; i < 10; ++i) {
+    connection->put(std::make_shared<core::FlowFile>());
+  }
+  REQUIRE(source->isThrottledByBackpressure());
+  REQUIRE(source->parkOnBackPressure());
+
+  // below the back pressure threshold, but not below the resume threshold yet
+  REQUIRE(connection->poll(expired_flow_files));
+  REQUIRE_FALSE(connection->isFull());
+  REQUIRE(0 == wake_ups);
+
+  std::vector<std::shared_ptr<core::FlowFile>> flow_files;
+  REQUIRE(1 == connection->pollBatch(flow_files, 1, (std::numeric_limits<uint64_t>::max)(), expired_flow_files));
+  REQUIRE(1 == wake_ups);
+
+  // only woken up once per park
+  connection->drain(false);
+  REQUIRE(1 == wake_ups);
+
+  // the back pressure was relieved before the source could park
+  for (int i = 0; i < 10; ++i) {
+    connection->put(std::make_shared<core::FlowFile>());
+  }
+  REQUIRE(source->isThrottledByBackpressure());
+  connection->drain(false);
+  REQUIRE_FALSE(source->parkOnBackPressure());
+  REQUIRE(1 == wake_ups);
+}
+
+TEST_CASE("Connection hands every flow file put by concurrent producers to exactly one consumer", "[contention]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const int PRODUCERS = 8;
+  const int FLOW_FILES_PER_PRODUCER = 5000;
+
+  for (const int consumers : {1, 2, 4}) {
+    const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+    std::atomic<bool> producers_done{false};
+
+    std::vector<std::thread> consumer_threads;
+    std::vector<std::vector<std::shared_ptr<core::FlowFile>>> consumed(consumers);
+    for (int i = 0; i < consumers; ++i) {
+      consumer_threads.emplace_back([&, i] {
+        std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+        while (!producers_done || !connection->isEmpty()) {
+          if (!connection->isWorkAvailable()) {
+            std::this_thread::yield();
+            continue;
+          }
+          connection->pollBatch(consumed[i], 100, std::numeric_limits<uint64_t>::max(), expired_flow_files);
+        }
+      });
+    }
+    std::vector<std::thread> producer_threads;
+    for (int i = 0; i < PRODUCERS; ++i) {
+      producer_threads.emplace_back([&, i] {
+        for (int j = 0; j < FLOW_FILES_PER_PRODUCER; ++j) {
+          const auto flow_file = std::make_shared<core::FlowFile>();
+          flow_file->setSize(1);
+          flow_file->setAttribute("producer", std::to_string(i));
+          flow_file->setAttribute("index", std::to_string(j));
+          connection->put(flow_file);
+          // the checks made by the source processors before triggering must not wait for the consumers
+          connection->isFull();
+        }
+      });
+    }
+    for (auto& thread : producer_threads) {
+      thread.join();
+    }
+    producers_done = true;
+    for (auto& thread : consumer_threads) {
+      thread.join();
+    }
+
+    size_t consumed_count = 0;
+    std::set<std::shared_ptr<core::FlowFile>> unique_flow_files;
+    for (const auto& flow_files : consumed) {
+      consumed_count += flow_files.size();
+      unique_flow_files.insert(flow_files.begin(), flow_files.end());
+    }
+    if (consumers == 1) {
+      // a single consumer polls the flow files of each producer in the order they were put
+      std::vector<int> next_index(PRODUCERS, 0);
+      int out_of_order = 0;
+      for (const auto& flow_file : consumed[0]) {
+        int& expected = next_index[std::stoi(*flow_file->getAttribute("producer"))];
+        if (std::stoi(*flow_file->getAttribute("index")) != expected++) {
+          ++out_of_order;
+        }
+      }
+      REQUIRE(0 == out_of_order);
+    }
+    REQUIRE(PRODUCERS * FLOW_FILES_PER_PRODUCER == consumed_count);
+    REQUIRE(consumed_count == unique_flow_files.size());
+    REQUIRE(0 == connection->getQueueSize());
+    REQUIRE(0 == connection->getQueueDataSize());
+  }
+}
+
+TEST_CASE("Connection polls the flow files put by several producers in the order they were put", "[contention]") {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+  const int PRODUCERS = 4;
+  const int FLOW_FILES = 20000;
+
+  // the producers take turns, so that each put happens before the next one
+  std::atomic<int> turn{0};
+  std::vector<std::thread> producer_threads;
+  for (int i = 0; i < PRODUCERS; ++i) {
+    producer_threads.emplace_back([&, i] {
+      for (int index = i; index < FLOW_FILES; index += PRODUCERS) {
+        while (turn.load() != index) {
+          std::this_thread::yield();
+        }
+        const auto flow_file = std::make_shared<core::FlowFile>();
+        flow_file->setAttribute("index", std::to_string(index));
+        connection->put(flow_file);
+        turn.store(index + 1);
+      }
+    });
+  }
+
+  std::vector<std::shared_ptr<core::FlowFile>> consumed;
+  std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+  while (consumed.size() < static_cast<size_t>(FLOW_FILES)) {
+    if (connection->pollBatch(consumed, 100, std::numeric_limits<uint64_t>::max(), expired_flow_files) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& thread : producer_threads) {
+    thread.join();
+  }
+
+  int out_of_order = 0;
+  for (int i = 0; i < FLOW_FILES; ++i) {
+    if (std::stoi(*consumed[i]->getAttribute("index")) != i) {
+      ++out_of_order;
+    }
+  }
+  REQUIRE(0 == out_of_order);
+}
+
+namespace {
+// the flow files per second moved through a connection from the producers to the consumers, each producer putting the given number of flow files
+double measureConnectionThroughput(int producers, int consumers, int flow_files_per_producer) {
+  const auto flow_repo = std::make_shared<TestRepository>();
+  const auto content_repo = std::make_shared<core::repository::VolatileContentRepository>();
+  content_repo->initialize(std::make_shared<minifi::Configure>());
+  const auto id_generator = utils::IdGenerator::getIdGenerator();
+  const auto connection = std::make_shared<minifi::Connection>(flow_repo, content_repo, "test_connection", id_generator->generate(), id_generator->generate(), id_generator->generate());
+
+  // created beforehand, so that only the connection is measured
+  std::vector<std::vector<std::shared_ptr<core::FlowFile>>> flow_files(producers);
+  for (auto& producer_flow_files : flow_files) {
+    for (int i = 0; i < flow_files_per_producer; ++i) {
+      producer_flow_files.push_back(std::make_shared<core::FlowFile>());
+      producer_flow_files.back()->setSize(1);
+    }
+  }
+
+  std::atomic<bool> producers_done{false};
+  std::atomic<size_t> consumed_count{0};
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> consumer_threads;
+  for (int i = 0; i < consumers; ++i) {
+    consumer_threads.emplace_back([&] {
+      std::vector<std::shared_ptr<core::FlowFile>> consumed;
+      std::set<std::shared_ptr<core::FlowFile>> expired_flow_files;
+      while (!producers_done || !connection->isEmpty()) {
+        consumed.clear();
+        if (connection->pollBatch(consumed, 100, std::numeric_limits<uint64_t>::max(), expired_flow_files) == 0) {
+          std::this_thread::yield();
+        }
+        consumed_count += consumed.size();
+      }
+    });
+  }
+  std::vector<std::thread> producer_threads;
+  for (int i = 0; i < producers; ++i) {
+    producer_threads.emplace_back([&, i] {
+      for (const auto& flow_file : flow_files[i]) {
+        connection->put(flow_file);
+        connection->isFull();
+      }
+    });
+  }
+  for (auto& thread : producer_threads) {
+    thread.join();
+  }
+  producers_done = true;
+  for (auto& thread : consumer_threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  REQUIRE(static_cast<size_t>(producers) * flow_files_per_producer == consumed_count.load());
+  return consumed_count.load() / elapsed.count();
+}
+}  // namespace
+
+TEST_CASE("Connection throughput with many producers and 1 to 4 consumers", "[.][benchmark]") {
+  const int PRODUCERS = 20;
+  const int FLOW_FILES_PER_PRODUCER = 50000;
+
+  const double single_consumer_throughput = measureConnectionThroughput(PRODUCERS, 1, FLOW_FILES_PER_PRODUCER);
+  for (const int consumers : {2, 3, 4}) {
+    // more consumers polling must not slow the producers down
+    REQUIRE(measureConnectionThroughput(PRODUCERS, consumers, FLOW_FILES_PER_PRODUCER) > single_consumer_throughput / 2);
+  }
+}
@@ -157,3 +157,66 @@ TEST_CASE("Force pop on FlowFileQueue returns the flow files, whether penalized
   REQUIRE(queue.pop() == penalized_flow_file);
   REQUIRE(queue.empty());
 }
+
+TEST_CASE("FlowFiles are popped from the FlowFileQueue in the order of its prioritizers", "[FlowFileQueue][prioritizers]") {
+  utils::FlowFileQueue queue;
+  queue.setPrioritizers({std::make_shared<core::PriorityAttributePrioritizer>()});
+
+  const auto no_priority = std::make_shared<core::FlowFile>();
+  queue.push(no_priority);
+  const auto text_priority = std::make_shared<core::FlowFile>();
+  text_priority->setAttribute(core::SpecialFlowAttribute::priority, "abc");
+  queue.push(text_priority);
+  const auto low_priority = std::make_shared<core::FlowFile>();
+  low_priority->setAttribute(core::SpecialFlowAttribute::priority, "10");
+  queue.push(low_priority);
+  const auto high_priority = std::make_shared<core::FlowFile>();
+  high_priority->setAttribute(core::SpecialFlowAttribute::priority, "2");
+  queue.push(high_priority);
+  const auto other_high_priority = std::make_shared<core::FlowFile>();
+  other_high_priority->setAttribute(core::SpecialFlowAttribute::priority, "2");
+  queue.push(other_high_priority);
+
+  REQUIRE(queue.pop() == high_priority);
+  REQUIRE(queue.pop() == other_high_priority);
+  REQUIRE(queue.pop() == low_priority);
+  REQUIRE(queue.pop() == text_priority);
+  REQUIRE(queue.pop() == no_priority);
+  REQUIRE(queue.empty());
+}
+
+TEST_CASE("Setting the prioritizers reorders the FlowFiles already in the FlowFileQueue", "[FlowFileQueue][prioritizers]") {
+  utils::FlowFileQueue queue;
+  const auto small_flow_file = std::make_shared<core::FlowFile>();
+  small_flow_file->setSize(10);
+  const auto large_flow_file = std::make_shared<core::FlowFile>();
+  large_flow_file->setSize(1000);
+  queue.push(small_flow_file);
+  queue.push(large_flow_file);
+
+  queue.setPrioritizers({std::make_shared<core::LargestFlowFileFirstPrioritizer>()});
+  REQUIRE(queue.pop() == large_flow_file);
+  REQUIRE(queue.pop() == small_flow_file);
+}
+
+TEST_CASE("Penalized flow files are not popped before prioritized ones until their penalty expires", "[FlowFileQueue][prioritizers]") {
+  utils::FlowFileQueue queue;
+  queue.setPrioritizers({std::make_shared<core::PriorityAttributePrioritizer>()});
+  const auto penalized_flow_file = std::make_shared<core::FlowFile>();
+  penalized_flow_file->setAttribute(core::SpecialFlowAttribute::priority, "1");
+  penalized_flow_file->penalize(std::chrono::milliseconds{10});
+  queue.push(penalized_flow_file);
+  const auto flow_file = std::make_shared<core::FlowFile>();
+  flow_file->setAttribute(core::SpecialFlowAttribute::priority, "5");
+  queue.push(flow_file);
+  const auto other_flow_file = std::make_shared<core::FlowFile>();
+  other_flow_file->setAttribute(core::SpecialFlowAttribute::priority, "6");
+  queue.push(other_flow_file);
+
+  REQUIRE(queue.pop() == flow_file);
+  REQUIRE(utils::verifyEventHappenedInPollTime(std::chrono::seconds{1}, PenaltyHasExpired{penalized_flow_file}, std::chrono::milliseconds{10}));
+  REQUIRE(queue.isWorkAvailable());
+  REQUIRE(queue.pop() == penalized_flow_file);
+  REQUIRE(queue.pop() == other_flow_file);
+  REQUIRE(queue.empty());
+}
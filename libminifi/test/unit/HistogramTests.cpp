@@ -0,0 +1,86 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "../TestBase.h"
+#include "utils/Histogram.h"
+
+namespace utils = org::apache::nifi::minifi::utils;
+
+TEST_CASE("Histogram of an empty range", "[histogram.empty]") {
+  utils::Histogram histogram;
+  REQUIRE(0 == histogram.getCount());
+  REQUIRE(0 == histogram.getMean());
+  REQUIRE(0 == histogram.getMax());
+  REQUIRE(0 == histogram.getPercentile(99));
+}
+
+TEST_CASE("Histogram percentiles are within the bucket precision", "[histogram.percentiles]") {
+  utils::Histogram histogram;
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  REQUIRE(1000 == histogram.getCount());
+  REQUIRE(500500 == histogram.getSum());
+  REQUIRE(500 == histogram.getMean());
+  REQUIRE(1000 == histogram.getMax());
+
+  const uint64_t p50 = histogram.getPercentile(50);
+  REQUIRE(p50 >= 500);
+  REQUIRE(p50 <= 500 * 9 / 8);
+  const uint64_t p90 = histogram.getPercentile(90);
+  REQUIRE(p90 >= 900);
+  REQUIRE(p90 <= 900 * 9 / 8);
+  REQUIRE(1000 == histogram.getPercentile(100));
+}
+
+TEST_CASE("Histogram counts small values exactly and covers the whole range", "[histogram.range]") {
+  utils::Histogram histogram;
+  histogram.record(0);
+  histogram.record(3);
+  histogram.record(std::numeric_limits<uint64_t>::max());
+  REQUIRE(0 == histogram.getPercentile(1));
+  REQUIRE(3 == histogram.getPercentile(50));
+  REQUIRE(std::numeric_limits<uint64_t>::max() == histogram.getPercentile(100));
+
+  histogram.reset();
+  REQUIRE(0 == histogram.getCount());
+  REQUIRE(0 == histogram.getPercentile(100));
+}
+
+TEST_CASE("Histogram can be recorded from multiple threads", "[histogram.concurrency]") {
+  utils::Histogram histogram;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&histogram] {
+      for (uint64_t value = 0; value < 10000; ++value) {
+        histogram.record(value);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(40000 == histogram.getCount());
+  REQUIRE(9999 == histogram.getMax());
+  REQUIRE(4 * (9999 * 10000 / 2) == histogram.getSum());
+}
@@ -102,3 +102,79 @@ TEST_CASE("ProcessSession::rollback penalizes affected flowfiles", "[rollback]")
   next_flow_file_to_be_processed = process_session.get();
   REQUIRE(next_flow_file_to_be_processed == flow_file_3);
 }
+
+TEST_CASE("ProcessSession::get can get a batch of flowfiles", "[get]") {
+  Fixture fixture;
+  core::ProcessSession &process_session = fixture.processSession();
+
+  for (int i = 0; i < 5; ++i) {
+    process_session.transfer(process_session.create(), Success);
+  }
+  process_session.commit();
+
+  auto flow_files = process_session.get(3);
+  REQUIRE(3 == flow_files.size());
+  const auto rest = process_session.get(10);
+  REQUIRE(2 == rest.size());
+  REQUIRE(process_session.get(10).empty());
+  flow_files.insert(flow_files.end(), rest.begin(), rest.end());
+
+  process_session.rollback();
+  for (const auto& flow_file : flow_files) {
+    REQUIRE(flow_file->isPenalized());
+  }
+  REQUIRE(process_session.get(10).empty());
+}
+
+TEST_CASE("ProcessSession::rollback restores the attributes of the flowfiles", "[rollback]") {
+  Fixture fixture;
+  core::ProcessSession &process_session = fixture.processSession();
+
+  const auto flow_file = process_session.create();
+  flow_file->setAttribute("kept", "original");
+  flow_file->setAttribute("updated", "original");
+  flow_file->setAttribute("removed", "original");
+  process_session.transfer(flow_file, Success);
+  process_session.commit();
+
+  const auto next_flow_file = process_session.get();
+  REQUIRE(next_flow_file == flow_file);
+  process_session.putAttribute(next_flow_file, "updated", "modified");
+  process_session.removeAttribute(next_flow_file, "removed");
+  process_session.putAttribute(next_flow_file, "added", "modified");
+  REQUIRE(next_flow_file->getAttribute("updated") == utils::optional<std::string>{"modified"});
+
+  process_session.rollback();
+  REQUIRE(flow_file->getAttribute("kept") == utils::optional<std::string>{"original"});
+  REQUIRE(flow_file->getAttribute("updated") == utils::optional<std::string>{"original"});
+  REQUIRE(flow_file->getAttribute("removed") == utils::optional<std::string>{"original"});
+  REQUIRE_FALSE(flow_file->getAttribute("added"));
+}
+
+// hidden from the default run, time it with --durations yes
+TEST_CASE("ProcessSession snapshots of flowfiles with 50 attributes share the attributes", "[.][benchmark]") {
+  Fixture fixture;
+  core::ProcessSession &process_session = fixture.processSession();
+
+  const auto flow_file = process_session.create();
+  for (int i = 0; i < 50; ++i) {
+    flow_file->setAttribute("attribute" + std::to_string(i), std::string(64, 'a'));
+  }
+  process_session.transfer(flow_file, Success);
+  process_session.commit();
+
+  const auto* attributes = &flow_file->getAttributeMap();
+  int iterations = 0;
+  for (; iterations < 100000; ++iterations) {
+    const auto next_flow_file = process_session.get();
+    if (next_flow_file != flow_file) {
+      break;
+    }
+    process_session.transfer(next_flow_file, Success);
+    process_session.commit();
+  }
+  REQUIRE(100000 == iterations);
+  // neither the snapshots taken by get nor their release copied the attributes
+  REQUIRE(attributes == &flow_file->getAttributeMap());
+  REQUIRE(50 == flow_file->getAttributes().size());
+}
@@ -16,10 +16,16 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
 #include <utility>
 #include <future>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../TestBase.h"
+#include "utils/GeneralUtils.h"
 #include "utils/ThreadPool.h"
 
 bool function() {
@@ -94,3 +100,55 @@ TEST_CASE("ThreadPoolTest2", "[TPT2]") {
   fut.wait();
   REQUIRE(20 == fut.get());
 }
+
+TEST_CASE("ThreadPool wakes up a delayed task before its execution time", "[TPT3]") {
+  std::atomic<int> runs{0};
+  utils::ThreadPool<utils::TaskRescheduleInfo> pool(2);
+  std::function<utils::TaskRescheduleInfo()> f_ex = [&runs] {
+    return ++runs == 1 ? utils::TaskRescheduleInfo::RetryIn(std::chrono::hours(1)) : utils::TaskRescheduleInfo::Done();
+  };
+  utils::Worker<utils::TaskRescheduleInfo> functor(f_ex, "id", utils::make_unique<utils::ComplexMonitor>());
+  pool.start();
+  std::future<utils::TaskRescheduleInfo> fut;
+  REQUIRE(true == pool.execute(std::move(functor), fut));
+
+  while (runs.load() == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // no matter whether the task has reached the delayed queue yet, it must not wait for an hour
+  pool.wakeUp("id");
+  REQUIRE(std::future_status::ready == fut.wait_for(std::chrono::seconds(5)));
+  REQUIRE(2 == runs.load());
+}
+
+TEST_CASE("ThreadPool scheduling overhead", "[.][benchmark]") {
+  const int task_count = 64;
+  const int runs_per_task = 1000;
+  double single_thread_runs_per_second = 0;
+  for (int thread_count : {1, 2, 4, 8, 16, 32, 64}) {
+    utils::ThreadPool<utils::TaskRescheduleInfo> pool(thread_count);
+    pool.start();
+    std::vector<std::future<utils::TaskRescheduleInfo>> futures;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < task_count; ++i) {
+      int runs = 0;
+      std::function<utils::TaskRescheduleInfo()> f_ex = [runs] () mutable {
+        return ++runs < runs_per_task ? utils::TaskRescheduleInfo::RetryImmediately() : utils::TaskRescheduleInfo::Done();
+      };
+      utils::Worker<utils::TaskRescheduleInfo> functor(f_ex, "id" + std::to_string(i), utils::make_unique<utils::ComplexMonitor>());
+      std::future<utils::TaskRescheduleInfo> fut;
+      REQUIRE(true == pool.execute(std::move(functor), fut));
+      futures.push_back(std::move(fut));
+    }
+    for (auto &fut : futures) {
+      REQUIRE(fut.get().finished_);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double runs_per_second = task_count * runs_per_task / elapsed.count();
+    if (thread_count == 1) {
+      single_thread_runs_per_second = runs_per_second;
+    }
+    // more workers contending for the queue must not make the rescheduling collapse
+    REQUIRE(runs_per_second > single_thread_runs_per_second / 4);
+  }
+}
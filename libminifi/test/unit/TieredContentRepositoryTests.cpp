@@ -0,0 +1,184 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../TestBase.h"
+#include "core/repository/TieredContentRepository.h"
+#include "properties/Configure.h"
+#include "ResourceClaim.h"
+#include "utils/file/FileUtils.h"
+#include "utils/gsl.h"
+
+namespace {
+
+class TieredContentRepositoryController : public TestController {
+ public:
+  TieredContentRepositoryController(const std::string& memory_max_size, const std::string& claim_max_size, const std::string& spill_age) {
+    char format[] = "/var/tmp/tiered_content_repo.XXXXXX";
+    auto configuration = std::make_shared<minifi::Configure>();
+    configuration->set(minifi::Configure::nifi_dbcontent_repository_directory_default, createTempDirectory(format));
+    configuration->set(minifi::Configure::nifi_content_repository_tiered_memory_max_size, memory_max_size);
+    configuration->set(minifi::Configure::nifi_content_repository_tiered_memory_watermark, "50");
+    configuration->set(minifi::Configure::nifi_content_repository_tiered_claim_max_size, claim_max_size);
+    configuration->set(minifi::Configure::nifi_content_repository_tiered_spill_age, spill_age);
+    repository = std::make_shared<core::repository::TieredContentRepository>();
+    REQUIRE(repository->initialize(configuration));
+  }
+
+  ~TieredContentRepositoryController() {
+    repository->stop();
+  }
+
+  std::shared_ptr<minifi::ResourceClaim> write(const std::string& content, bool append = false, std::shared_ptr<minifi::ResourceClaim> claim = nullptr) {
+    if (claim == nullptr) {
+      claim = std::make_shared<minifi::ResourceClaim>(repository);
+    }
+    auto stream = repository->write(*claim, append);
+    REQUIRE(stream->write(reinterpret_cast<const uint8_t*>(content.data()), gsl::narrow<int>(content.size())) == gsl::narrow<int>(content.size()));
+    return claim;
+  }
+
+  std::string read(const minifi::ResourceClaim& claim) {
+    auto stream = repository->read(claim);
+    REQUIRE(stream != nullptr);
+    std::string content;
+    uint8_t buffer[4096];
+    int ret = 0;
+    while ((ret = stream->read(buffer, sizeof(buffer))) > 0) {
+      content.append(reinterpret_cast<const char*>(buffer), ret);
+    }
+    return content;
+  }
+
+  bool waitForSpill(uint64_t count) {
+    for (int i = 0; i < 100 && repository->getSpilledCount() < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return repository->getSpilledCount() >= count;
+  }
+
+  std::shared_ptr<core::repository::TieredContentRepository> repository;
+};
+
+bool onDisk(const minifi::ResourceClaim& claim) {
+  return utils::file::FileUtils::exists(claim.getContentFullPath());
+}
+
+}  // namespace
+
+TEST_CASE("TieredContentRepository keeps small claims in memory", "[tieredcontentrepository]") {
+  TieredContentRepositoryController controller("1 MB", "1 KB", "0 ms");
+  auto claim = controller.write("hello");
+  controller.write(" tiers", true, claim);
+  REQUIRE(11 == controller.repository->getMemoryUsage());
+  REQUIRE_FALSE(onDisk(*claim));
+  REQUIRE(controller.repository->exists(*claim));
+  REQUIRE("hello tiers" == controller.read(*claim));
+
+  SECTION("a claim removed while in memory never reaches the backend") {
+    REQUIRE(controller.repository->remove(*claim));
+    REQUIRE_FALSE(controller.repository->exists(*claim));
+    REQUIRE(0 == controller.repository->getMemoryUsage());
+    REQUIRE(0 == controller.repository->getSpilledCount());
+  }
+
+  SECTION("a claim made durable is spilled and read back from the backend") {
+    controller.repository->makeDurable(*claim);
+    REQUIRE(onDisk(*claim));
+    REQUIRE(0 == controller.repository->getMemoryUsage());
+    REQUIRE("hello tiers" == controller.read(*claim));
+    controller.write("!", true, claim);
+    REQUIRE("hello tiers!" == controller.read(*claim));
+    REQUIRE(controller.repository->remove(*claim));
+    REQUIRE_FALSE(onDisk(*claim));
+  }
+}
+
+TEST_CASE("TieredContentRepository spills the claims outgrowing the memory tier", "[tieredcontentrepository]") {
+  TieredContentRepositoryController controller("1 MB", "16 B", "0 ms");
+  auto claim = controller.write("0123456789");
+  REQUIRE_FALSE(onDisk(*claim));
+  controller.write("0123456789", true, claim);
+  REQUIRE(onDisk(*claim));
+  REQUIRE(1 == controller.repository->getSpilledCount());
+  REQUIRE(0 == controller.repository->getMemoryUsage());
+  REQUIRE("01234567890123456789" == controller.read(*claim));
+}
+
+TEST_CASE("TieredContentRepository spills the claims in the background", "[tieredcontentrepository]") {
+  SECTION("once they are older than the spill age") {
+    TieredContentRepositoryController controller("1 MB", "1 KB", "100 ms");
+    auto claim = controller.write("aging");
+    REQUIRE(controller.waitForSpill(1));
+    REQUIRE(onDisk(*claim));
+    REQUIRE("aging" == controller.read(*claim));
+  }
+
+  SECTION("once the memory usage exceeds the watermark, starting with the oldest claims") {
+    TieredContentRepositoryController controller("100 B", "1 KB", "0 ms");
+    auto oldest = controller.write(std::string(20, 'a'));
+    auto older = controller.write(std::string(20, 'b'));
+    auto newest = controller.write(std::string(20, 'c'));
+    REQUIRE(controller.waitForSpill(1));
+    REQUIRE(onDisk(*oldest));
+    REQUIRE_FALSE(onDisk(*older));
+    REQUIRE_FALSE(onDisk(*newest));
+    REQUIRE(1 == controller.repository->getSpilledCount());
+    REQUIRE(40 == controller.repository->getMemoryUsage());
+    REQUIRE(std::string(20, 'a') == controller.read(*oldest));
+  }
+}
+
+TEST_CASE("TieredContentRepository keeps the content of an open stream when its claim is spilled", "[tieredcontentrepository]") {
+  TieredContentRepositoryController controller("1 MB", "1 KB", "0 ms");
+  auto claim = controller.write("spilled while reading");
+  auto stream = controller.repository->read(*claim);
+  controller.repository->makeDurable(*claim);
+  REQUIRE(onDisk(*claim));
+  std::string content(100, '\0');
+  const int ret = stream->read(reinterpret_cast<uint8_t*>(&content[0]), gsl::narrow<int>(content.size()));
+  REQUIRE("spilled while reading" == content.substr(0, ret));
+}
+
+TEST_CASE("TieredContentRepository publishes staged content from either tier", "[tieredcontentrepository]") {
+  TieredContentRepositoryController controller("1 MB", "16 B", "0 ms");
+  auto target = controller.write("data");
+  auto staging = controller.repository->createStagingClaim(target, true);
+
+  SECTION("staged in memory") {
+    controller.write("-staged", false, staging);
+    REQUIRE_FALSE(onDisk(*staging));
+    REQUIRE(controller.repository->publish(*staging, *target, true));
+    REQUIRE("data-staged" == controller.read(*target));
+    REQUIRE_FALSE(onDisk(*target));
+  }
+
+  SECTION("staged on the backend") {
+    controller.write("-staged beyond the claim size", false, staging);
+    REQUIRE(onDisk(*staging));
+    REQUIRE(controller.repository->publish(*staging, *target, true));
+    REQUIRE("data-staged beyond the claim size" == controller.read(*target));
+    REQUIRE_FALSE(onDisk(*staging));
+  }
+
+  REQUIRE_FALSE(controller.repository->exists(*staging));
+}
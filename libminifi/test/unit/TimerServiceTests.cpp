@@ -0,0 +1,136 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../TestBase.h"
+#include "utils/GeneralUtils.h"
+#include "utils/OsUtils.h"
+#include "utils/ThreadPool.h"
+#include "utils/TimerService.h"
+
+using Clock = utils::TimerService::Clock;
+
+TEST_CASE("TimerService fires the timers in the order of their deadlines", "[timerservice.order]") {
+  utils::TimerService timer_service;
+  timer_service.start();
+  std::mutex mutex;
+  std::vector<int> fired;
+  const auto now = Clock::now();
+  for (int i : {3, 1, 2}) {
+    timer_service.schedule(now + std::chrono::milliseconds(20 * i), [&mutex, &fired, i](Clock::time_point deadline) -> utils::optional<Clock::time_point> {
+      REQUIRE(Clock::now() >= deadline);
+      std::lock_guard<std::mutex> lock(mutex);
+      fired.push_back(i);
+      return utils::nullopt;
+    });
+  }
+  REQUIRE(3 == timer_service.getTimerCount());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  REQUIRE((std::vector<int>{1, 2, 3}) == fired);
+  REQUIRE(0 == timer_service.getTimerCount());
+  REQUIRE(3 == timer_service.getLateness().getCount());
+}
+
+TEST_CASE("TimerService fires a timer until it is cancelled", "[timerservice.cancel]") {
+  utils::TimerService timer_service;
+  timer_service.start();
+  std::atomic<int> fired{0};
+  const auto id = timer_service.schedule(Clock::now(), [&fired](Clock::time_point deadline) -> utils::optional<Clock::time_point> {
+    ++fired;
+    return deadline + std::chrono::milliseconds(5);
+  });
+  while (fired < 5) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  timer_service.cancel(id);
+  const int fired_before_cancel = fired;
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  REQUIRE(fired_before_cancel == fired);
+  REQUIRE(0 == timer_service.getTimerCount());
+
+  SECTION("a timer can cancel itself") {
+    std::atomic<int> self_fired{0};
+    auto self_id = std::make_shared<std::atomic<utils::TimerService::TimerId>>(0);
+    utils::TimerService* service = &timer_service;
+    *self_id = timer_service.schedule(Clock::now() + std::chrono::milliseconds(10), [&self_fired, self_id, service](Clock::time_point deadline) -> utils::optional<Clock::time_point> {
+      ++self_fired;
+      service->cancel(*self_id);
+      return deadline + std::chrono::milliseconds(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(1 == self_fired);
+  }
+}
+
+TEST_CASE("TimerService wakes up parked tasks of a ThreadPool", "[.][benchmark]") {
+  // every timer stands for a cron scheduled processor, firing each 100 ms instead of each minute
+  const int timer_count = 1000;
+  const std::chrono::milliseconds period(100);
+  const std::chrono::seconds measurement_period(2);
+
+  utils::ThreadPool<utils::TaskRescheduleInfo> pool(4);
+  pool.start();
+  utils::TimerService timer_service;
+  timer_service.start();
+
+  std::atomic<uint64_t> runs{0};
+  std::vector<utils::TimerService::TimerId> timers;
+  const auto start = Clock::now();
+  const auto cpu_start = utils::OsUtils::getProcessCpuTime();
+  for (int i = 0; i < timer_count; ++i) {
+    const std::string id = "task" + std::to_string(i);
+    std::function<utils::TaskRescheduleInfo()> f_ex = [&runs] {
+      ++runs;
+      return utils::TaskRescheduleInfo::Park();
+    };
+    std::future<utils::TaskRescheduleInfo> future;
+    REQUIRE(pool.execute(utils::Worker<utils::TaskRescheduleInfo>(f_ex, id, utils::make_unique<utils::ComplexMonitor>()), future));
+    const utils::TaskHandle handle = pool.getTaskHandle(id);
+    timers.push_back(timer_service.schedule(start + period * (i + 1) / timer_count,
+        [&pool, handle, period](Clock::time_point deadline) -> utils::optional<Clock::time_point> {
+      pool.wakeUp(handle);
+      return deadline + period;
+    }));
+  }
+  std::this_thread::sleep_for(measurement_period);
+  for (const auto timer : timers) {
+    timer_service.cancel(timer);
+  }
+  const std::chrono::duration<double> elapsed = Clock::now() - start;
+  const auto cpu_time = utils::OsUtils::getProcessCpuTime() - cpu_start;
+  pool.shutdown();
+
+  const auto& lateness = timer_service.getLateness();
+  const uint64_t expected_fires = timer_count * (std::chrono::duration_cast<std::chrono::milliseconds>(measurement_period) / period);
+  REQUIRE(lateness.getCount() >= expected_fires * 9 / 10);
+  // every task ran once when submitted and then once per fire at most
+  REQUIRE(runs.load() <= timer_count + lateness.getCount());
+  // the timers fire well within their period and the service does not spin while waiting for them
+  REQUIRE(lateness.getPercentile(99) < static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(period).count()));
+  REQUIRE(cpu_time < std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+}
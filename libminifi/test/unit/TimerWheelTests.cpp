@@ -0,0 +1,86 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <vector>
+
+#include "../TestBase.h"
+#include "utils/TimerWheel.h"
+
+namespace utils = org::apache::nifi::minifi::utils;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> advance(utils::TimerWheel<int>& wheel, Clock::time_point now) {
+  std::vector<int> expired;
+  wheel.advance(now, [&expired](int item) { expired.push_back(item); });
+  return expired;
+}
+}  // namespace
+
+TEST_CASE("TimerWheel expires items not before their deadlines, in order", "[timerwheel.order]") {
+  const auto origin = Clock::now();
+  utils::TimerWheel<int> wheel(origin);
+  wheel.schedule(3, origin + std::chrono::seconds(10));
+  wheel.schedule(1, origin + std::chrono::milliseconds(5));
+  wheel.schedule(2, origin + std::chrono::milliseconds(100));
+  REQUIRE(3 == wheel.size());
+
+  REQUIRE(advance(wheel, origin + std::chrono::milliseconds(4)).empty());
+  REQUIRE(std::vector<int>{1} == advance(wheel, origin + std::chrono::milliseconds(5)));
+  REQUIRE(advance(wheel, origin + std::chrono::milliseconds(99)).empty());
+  REQUIRE(std::vector<int>{2} == advance(wheel, origin + std::chrono::milliseconds(9999)));
+  REQUIRE(std::vector<int>{3} == advance(wheel, origin + std::chrono::seconds(10)));
+  REQUIRE(wheel.empty());
+}
+
+TEST_CASE("TimerWheel handles deadlines on every level and beyond its range", "[timerwheel.levels]") {
+  const auto origin = Clock::now();
+  utils::TimerWheel<int> wheel(origin);
+  const std::vector<std::chrono::milliseconds> delays{
+    std::chrono::milliseconds(64), std::chrono::milliseconds(4095), std::chrono::milliseconds(4096),
+    std::chrono::minutes(3), std::chrono::hours(2), std::chrono::hours(30)};
+  for (size_t i = 0; i < delays.size(); ++i) {
+    wheel.schedule(static_cast<int>(i), origin + delays[i]);
+  }
+  for (size_t i = 0; i < delays.size(); ++i) {
+    REQUIRE(advance(wheel, origin + delays[i] - std::chrono::milliseconds(1)).empty());
+    REQUIRE(std::vector<int>{static_cast<int>(i)} == advance(wheel, origin + delays[i]));
+  }
+  REQUIRE(wheel.empty());
+}
+
+TEST_CASE("TimerWheel reports when it has to be advanced next", "[timerwheel.next]") {
+  const auto origin = Clock::now();
+  utils::TimerWheel<int> wheel(origin);
+  REQUIRE_FALSE(wheel.getNextExpiration());
+
+  wheel.schedule(1, origin + std::chrono::milliseconds(10));
+  REQUIRE(origin + std::chrono::milliseconds(10) == *wheel.getNextExpiration());
+
+  // an item in an upper level needs the wheel to be advanced when its slot is cascaded
+  wheel.schedule(2, origin + std::chrono::seconds(1));
+  advance(wheel, origin + std::chrono::milliseconds(10));
+  REQUIRE(origin + std::chrono::milliseconds(64) == *wheel.getNextExpiration());
+
+  // past deadlines expire at the next tick
+  wheel.schedule(3, origin);
+  REQUIRE(origin + std::chrono::milliseconds(11) == *wheel.getNextExpiration());
+  REQUIRE(std::vector<int>{3} == advance(wheel, origin + std::chrono::milliseconds(11)));
+}
@@ -0,0 +1,216 @@
+/**
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../TestBase.h"
+#include "core/repository/VolatileRepository.h"
+#include "properties/Configure.h"
+
+namespace {
+
+class TestVolatileRepository : public core::repository::VolatileRepository<std::string> {
+ public:
+  explicit TestVolatileRepository(const std::string& name = "test")
+      : core::SerializableComponent(name),
+        VolatileRepository(name) {
+  }
+
+  void run() override {
+  }
+
+  std::vector<std::string> getDropped() {
+    std::lock_guard<std::mutex> lock(dropped_mutex_);
+    return dropped_;
+  }
+
+ protected:
+  void emplace(core::repository::RepoValue<std::string>& old_value) override {
+    std::lock_guard<std::mutex> lock(dropped_mutex_);
+    dropped_.push_back(old_value.getKey());
+  }
+
+ private:
+  std::mutex dropped_mutex_;
+  std::vector<std::string> dropped_;
+};
+
+std::shared_ptr<TestVolatileRepository> createRepository(uint64_t max_count, uint64_t max_bytes = 0) {
+  auto configuration = std::make_shared<minifi::Configure>();
+  configuration->set(std::string(minifi::Configure::nifi_volatile_repository_options) + "test.max.count", std::to_string(max_count));
+  configuration->set(std::string(minifi::Configure::nifi_volatile_repository_options) + "test.max.bytes", std::to_string(max_bytes));
+  auto repository = std::make_shared<TestVolatileRepository>();
+  REQUIRE(repository->initialize(configuration));
+  return repository;
+}
+
+bool put(TestVolatileRepository& repository, const std::string& key, const std::string& value) {
+  return repository.Put(key, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+}  // namespace
+
+TEST_CASE("VolatileRepository gets and deletes the entries by key", "[volatilerepository.index]") {
+  auto repository = createRepository(100);
+  REQUIRE(put(*repository, "one", "1"));
+  REQUIRE(put(*repository, "two", "22"));
+  REQUIRE(put(*repository, "three", "333"));
+  REQUIRE(6 == repository->getRepoSize());
+
+  std::string value;
+  REQUIRE(repository->Get("two", value));
+  REQUIRE("22" == value);
+  REQUIRE_FALSE(repository->Get("two", value));
+  REQUIRE(repository->Delete("one"));
+  REQUIRE_FALSE(repository->Delete("one"));
+  REQUIRE(3 == repository->getRepoSize());
+  REQUIRE((std::vector<std::string>{"one"}) == repository->getDropped());
+
+  SECTION("putting an existing key replaces its value") {
+    REQUIRE(put(*repository, "three", "3"));
+    REQUIRE(1 == repository->getRepoSize());
+    value.clear();
+    REQUIRE(repository->Get("three", value));
+    REQUIRE("3" == value);
+    REQUIRE(0 == repository->getEvictedCount());
+  }
+}
+
+TEST_CASE("VolatileRepository evicts the oldest entries once every slot is taken", "[volatilerepository.evict]") {
+  auto repository = createRepository(3);
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(put(*repository, "key" + std::to_string(i), "value"));
+  }
+  REQUIRE(2 == repository->getEvictedCount());
+  REQUIRE(10 == repository->getEvictedSize());
+  REQUIRE((std::vector<std::string>{"key0", "key1"}) == repository->getDropped());
+
+  std::string value;
+  REQUIRE_FALSE(repository->Get("key0", value));
+  REQUIRE_FALSE(repository->Get("key1", value));
+  for (int i = 2; i < 5; ++i) {
+    REQUIRE(repository->Get("key" + std::to_string(i), value));
+  }
+
+  SECTION("the slots freed by Get are reused before evicting") {
+    REQUIRE(put(*repository, "key5", "value"));
+    REQUIRE(put(*repository, "key6", "value"));
+    REQUIRE(2 == repository->getEvictedCount());
+  }
+}
+
+TEST_CASE("VolatileRepository evicts the oldest entries once the maximum size is exceeded", "[volatilerepository.evict]") {
+  auto repository = createRepository(100, 100);
+  const std::string value(40, 'x');
+  REQUIRE(put(*repository, "key0", value));
+  REQUIRE(put(*repository, "key1", value));
+  REQUIRE(0 == repository->getEvictedCount());
+  REQUIRE(put(*repository, "key2", value));
+  REQUIRE(1 == repository->getEvictedCount());
+  REQUIRE((std::vector<std::string>{"key0"}) == repository->getDropped());
+  REQUIRE(80 == repository->getRepoSize());
+}
+
+TEST_CASE("VolatileRepository is not limited to 65536 slots", "[volatilerepository.slots]") {
+  const int count = 70000;
+  auto repository = createRepository(count);
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(put(*repository, "key" + std::to_string(i), "v"));
+  }
+  REQUIRE(0 == repository->getEvictedCount());
+  std::string value;
+  REQUIRE(repository->Get("key0", value));
+  REQUIRE(repository->Get("key" + std::to_string(count - 1), value));
+}
+
+TEST_CASE("VolatileRepository can be used from multiple threads", "[volatilerepository.concurrency]") {
+  const int thread_count = 4;
+  const int keys_per_thread = 1000;
+  auto repository = createRepository(thread_count * keys_per_thread / 2);
+  std::atomic<int> found{0};
+  std::atomic<int> mismatched{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&repository, &found, &mismatched, t, keys_per_thread] {
+      for (int i = 0; i < keys_per_thread; ++i) {
+        const std::string key = std::to_string(t) + "-" + std::to_string(i);
+        put(*repository, key, key);
+        std::string value;
+        if (repository->Get(key, value)) {
+          ++found;
+          if (key != value) {
+            ++mismatched;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  REQUIRE(0 == mismatched);
+  // every entry was either read back or evicted by another thread
+  REQUIRE(thread_count * keys_per_thread == found + repository->getEvictedCount());
+  REQUIRE(0 == repository->getRepoSize());
+}
+
+TEST_CASE("VolatileRepository puts, gets and deletes entries in constant time", "[.][benchmark]") {
+  using Clock = std::chrono::steady_clock;
+  const std::string value(16, 'x');
+  std::chrono::nanoseconds smallest_per_entry{0};
+  for (int count : {10000, 100000, 1000000}) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (int i = 0; i < count; ++i) {
+      keys.push_back("key" + std::to_string(i));
+    }
+    auto repository = createRepository(count);
+
+    const auto start = Clock::now();
+    for (const auto& key : keys) {
+      put(*repository, key, value);
+    }
+    std::string read;
+    int found = 0;
+    for (int i = 0; i < count; i += 2) {
+      read.clear();
+      found += repository->Get(keys[i], read) ? 1 : 0;
+    }
+    for (int i = 1; i < count; i += 2) {
+      found += repository->Delete(keys[i]) ? 1 : 0;
+    }
+    const auto end = Clock::now();
+
+    REQUIRE(count == found);
+    REQUIRE(0 == repository->getEvictedCount());
+    REQUIRE(0 == repository->getRepoSize());
+
+    // a put, a get or a delete for every entry; a linear lookup would be a hundred times slower for a hundred times the entries
+    const auto per_entry = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) / count;
+    if (smallest_per_entry.count() == 0) {
+      smallest_per_entry = per_entry;
+    }
+    REQUIRE(per_entry < smallest_per_entry * 10);
+  }
+}
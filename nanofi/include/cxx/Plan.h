@@ -72,7 +72,7 @@ namespace {
       // create a flow file.
       auto path = claim->getContentFullPath();
       auto ffr = create_ff_object_na(path.c_str(), path.length(), ff->getSize());
-      ffr->attributes = ff->getAttributesPtr();
+      ffr->attributes = new minifi::core::FlowFile::AttributeMap(ff->getAttributeMap());
       ffr->ffp = static_cast<void*>(new std::shared_ptr<minifi::core::FlowFile>(ff));
       auto content_repo_ptr = static_cast<std::shared_ptr<minifi::core::ContentRepository>*>(ffr->crp);
       *content_repo_ptr = cr_ptr;
@@ -354,10 +354,9 @@ void free_flowfile(flow_file_record *ff) {
     }
     delete content_repo_ptr;
   }
-  if (ff->ffp == nullptr) {
-    auto map = static_cast<AttributeMap*>(ff->attributes);
-    delete map;
-  } else {
+  auto map = static_cast<AttributeMap*>(ff->attributes);
+  delete map;
+  if (ff->ffp != nullptr) {
     auto ff_sptr = reinterpret_cast<std::shared_ptr<core::FlowFile>*>(ff->ffp);
     delete ff_sptr;
   }
@@ -640,7 +639,8 @@ flow_file_record* flowfile_to_record(std::shared_ptr<core::FlowFile> ff, const s
   auto path = claim->getContentFullPath();
   auto ffr = create_ff_object_na(path.c_str(), path.length(), ff->getSize());
   ffr->ffp = static_cast<void*>(new std::shared_ptr<core::FlowFile>(ff));
-  ffr->attributes = ff->getAttributesPtr();
+  // the record works on a copy of the attributes, written back to the flow file when it is transferred
+  ffr->attributes = new AttributeMap(ff->getAttributeMap());
   auto content_repo_ptr = static_cast<std::shared_ptr<minifi::core::ContentRepository>*>(ffr->crp);
   *content_repo_ptr = crp;
   return ffr;
@@ -791,6 +791,17 @@ int transfer_to_relationship(flow_file_record * ffr, processor_session * ps, con
     return -1;
   }
   auto ff_sptr = reinterpret_cast<std::shared_ptr<core::FlowFile>*>(ffr->ffp);
+  auto attribute_map = static_cast<AttributeMap*>(ffr->attributes);
+  if (attribute_map) {
+    for (const auto& kv : (*ff_sptr)->getAttributes()) {
+      if (attribute_map->find(kv.first) == attribute_map->end()) {
+        ps->removeAttribute(*ff_sptr, kv.first);
+      }
+    }
+    for (const auto& kv : *attribute_map) {
+      ps->putAttribute(*ff_sptr, kv.first, kv.second);
+    }
+  }
   ps->transfer(*ff_sptr, core::Relationship(relationship, "desc"));
   return 0;
 }